@@ -32,6 +32,7 @@ LOCAL_SRC_FILES := \
     AudioSource.cpp \
     BoundingBox.cpp \
     BoundingSphere.cpp \
+    BoundingVolumeTree.cpp \
     Bundle.cpp \
     Button.cpp \
     Camera.cpp \
@@ -72,6 +73,7 @@ LOCAL_SRC_FILES := \
     Model.cpp \
     Node.cpp \
     ParticleEmitter.cpp \
+    ParticleEmitterPool.cpp \
     Pass.cpp \
     PhysicsCharacter.cpp \
     PhysicsCollisionObject.cpp \
@@ -96,8 +98,10 @@ LOCAL_SRC_FILES := \
     Ray.cpp \
     Rectangle.cpp \
     Ref.cpp \
+    RenderQueue.cpp \
     RenderState.cpp \
     RenderTarget.cpp \
+    ResourceLoader.cpp \
     Scene.cpp \
     SceneLoader.cpp \
     ScreenDisplayer.cpp \
@@ -117,12 +121,14 @@ LOCAL_SRC_FILES := \
     ThemeStyle.cpp \
     TileSet.cpp \
     Transform.cpp \
+    UniformBuffer.cpp \
     Vector2.cpp \
     Vector3.cpp \
     Vector4.cpp \
     VertexAttributeBinding.cpp \
     VertexFormat.cpp \
     VerticalLayout.cpp \
+    WorkerPool.cpp \
     lua/lua_AbsoluteLayout.cpp \
     lua/lua_AIAgent.cpp \
     lua/lua_AIAgentListener.cpp \
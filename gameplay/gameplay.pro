@@ -30,6 +30,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/BoundingBox.inl \
     src/BoundingSphere.cpp \
     src/BoundingSphere.inl \
+    src/BoundingVolumeTree.cpp \
     src/Bundle.cpp \
     src/Button.cpp \
     src/Camera.cpp \
@@ -75,6 +76,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Model.cpp \
     src/Node.cpp \
     src/ParticleEmitter.cpp \
+    src/ParticleEmitterPool.cpp \
     src/Pass.cpp \
     src/PhysicsCharacter.cpp \
     src/PhysicsCollisionObject.cpp \
@@ -106,8 +108,10 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/Ray.inl \
     src/Rectangle.cpp \
     src/Ref.cpp \
+    src/RenderQueue.cpp \
     src/RenderState.cpp \
     src/RenderTarget.cpp \
+    src/ResourceLoader.cpp \
     src/Scene.cpp \
     src/SceneLoader.cpp \
     src/ScreenDisplayer.cpp \
@@ -128,6 +132,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/ThemeStyle.cpp \
     src/TileSet.cpp \
     src/Transform.cpp \
+    src/UniformBuffer.cpp \
     src/Vector2.cpp \
     src/Vector2.inl \
     src/Vector3.cpp \
@@ -137,6 +142,7 @@ SOURCES += src/AbsoluteLayout.cpp \
     src/VertexAttributeBinding.cpp \
     src/VertexFormat.cpp \
     src/VerticalLayout.cpp \
+    src/WorkerPool.cpp \
     src/lua/lua_all_bindings.cpp \
     src/lua/lua_AbsoluteLayout.cpp \
     src/lua/lua_AIAgent.cpp \
@@ -290,6 +296,7 @@ HEADERS += src/AbsoluteLayout.h \
     src/Base.h \
     src/BoundingBox.h \
     src/BoundingSphere.h \
+    src/BoundingVolumeTree.h \
     src/Bundle.h \
     src/Button.h \
     src/Camera.h \
@@ -333,6 +340,7 @@ HEADERS += src/AbsoluteLayout.h \
     src/Mouse.h \
     src/Node.h \
     src/ParticleEmitter.h \
+    src/ParticleEmitterPool.h \
     src/Pass.h \
     src/PhysicsCharacter.h \
     src/PhysicsCollisionObject.h \
@@ -356,8 +364,10 @@ HEADERS += src/AbsoluteLayout.h \
     src/Ray.h \
     src/Rectangle.h \
     src/Ref.h \
+    src/RenderQueue.h \
     src/RenderState.h \
     src/RenderTarget.h \
+    src/ResourceLoader.h \
     src/Scene.h \
     src/SceneLoader.h \
     src/ScreenDisplayer.h \
@@ -380,12 +390,14 @@ HEADERS += src/AbsoluteLayout.h \
     src/TimeListener.h \
     src/Touch.h \
     src/Transform.h \
+    src/UniformBuffer.h \
     src/Vector2.h \
     src/Vector3.h \
     src/Vector4.h \
     src/VertexAttributeBinding.h \
     src/VertexFormat.h \
     src/VerticalLayout.h \
+    src/WorkerPool.h \
     src/lua/lua_AbsoluteLayout.h \
     src/lua/lua_AIAgent.h \
     src/lua/lua_AIAgentListener.h \
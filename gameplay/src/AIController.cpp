@@ -6,7 +6,7 @@ namespace gameplay
 {
 
 AIController::AIController()
-    : _paused(false), _firstMessage(NULL), _firstAgent(NULL)
+    : _paused(false), _messageSequence(0), _firstAgent(NULL)
 {
 }
 
@@ -29,16 +29,15 @@ void AIController::finalize()
         SAFE_RELEASE(temp);
     }
     _firstAgent = NULL;
+    _agentIndex.clear();
 
     // Remove all messages
-    AIMessage* message = _firstMessage;
-    while (message)
+    for (size_t i = 0, count = _messageQueue.size(); i < count; ++i)
     {
-        AIMessage* temp = message;
-        message = message->_next;
-        AIMessage::destroy(temp);
+        AIMessage::destroy(_messageQueue[i].message);
     }
-    _firstMessage = NULL;
+    _messageQueue.clear();
+    AIMessage::clearPool();
 }
 
 void AIController::pause()
@@ -86,10 +85,14 @@ void AIController::sendMessage(AIMessage* message, float delay)
     }
     else
     {
-        // Queue for later delivery
-        if (_firstMessage)
-            message->_next = _firstMessage;
-        _firstMessage = message;
+        // Queue for later delivery, ordered by delivery time
+        message->_deliveryTime = Game::getInstance()->getGameTime() + delay;
+        PendingMessage pending;
+        pending.deliveryTime = message->_deliveryTime;
+        pending.sequence = _messageSequence++;
+        pending.message = message;
+        _messageQueue.push_back(pending);
+        std::push_heap(_messageQueue.begin(), _messageQueue.end(), deliversAfter);
     }
 }
 
@@ -100,28 +103,15 @@ void AIController::update(float elapsedTime)
 
     static Game* game = Game::getInstance();
 
-    // Send all pending messages that have expired
-    AIMessage* prevMsg = NULL;
-    AIMessage* msg = _firstMessage;
-    while (msg)
+    // Send all pending messages that have expired, earliest first. Each message is
+    // popped before delivery since handlers may queue new messages.
+    double gameTime = game->getGameTime();
+    while (!_messageQueue.empty() && _messageQueue.front().deliveryTime <= gameTime)
     {
-        // If the message delivery time has expired, send it (this also deletes it)
-        if (msg->getDeliveryTime() >= game->getGameTime())
-        {
-            // Link the message out of our list
-            if (prevMsg)
-                prevMsg->_next = msg->_next;
-
-            AIMessage* temp = msg;
-            msg = msg->_next;
-            temp->_next = NULL;
-            sendMessage(temp);
-        }
-        else
-        {
-            prevMsg = msg;
-            msg = msg->_next;
-        }
+        std::pop_heap(_messageQueue.begin(), _messageQueue.end(), deliversAfter);
+        AIMessage* message = _messageQueue.back().message;
+        _messageQueue.pop_back();
+        sendMessage(message);
     }
 
     // Update all enabled agents
@@ -143,6 +133,9 @@ void AIController::addAgent(AIAgent* agent)
         agent->_next = _firstAgent;
 
     _firstAgent = agent;
+
+    // The most recently added agent is found first, matching the order of the agent list.
+    _agentIndex[agent->getId()] = agent;
 }
 
 void AIController::removeAgent(AIAgent* agent)
@@ -160,6 +153,7 @@ void AIController::removeAgent(AIAgent* agent)
                 _firstAgent = agent->_next;
 
             agent->_next = NULL;
+            unindexAgent(agent, agent->getId());
             agent->release();
             break;
         }
@@ -169,20 +163,46 @@ void AIController::removeAgent(AIAgent* agent)
     }
 }
 
-AIAgent* AIController::findAgent(const char* id) const
+void AIController::updateAgentId(AIAgent* agent, const char* oldId)
 {
-    GP_ASSERT(id);
+    GP_ASSERT(agent);
+    GP_ASSERT(oldId);
 
-    AIAgent* agent = _firstAgent;
-    while (agent)
-    {
-        if (strcmp(id, agent->getId()) == 0)
-            return agent;
+    unindexAgent(agent, oldId);
+    _agentIndex[agent->getId()] = agent;
+}
 
-        agent = agent->_next;
+void AIController::unindexAgent(AIAgent* agent, const char* id)
+{
+    std::unordered_map<std::string, AIAgent*>::iterator itr = _agentIndex.find(id);
+    if (itr == _agentIndex.end() || itr->second != agent)
+        return;
+
+    // Another agent may share this ID, so fall back to the first remaining one in list order.
+    for (AIAgent* other = _firstAgent; other != NULL; other = other->_next)
+    {
+        if (other != agent && strcmp(id, other->getId()) == 0)
+        {
+            itr->second = other;
+            return;
+        }
     }
+    _agentIndex.erase(itr);
+}
+
+bool AIController::deliversAfter(const PendingMessage& a, const PendingMessage& b)
+{
+    if (a.deliveryTime != b.deliveryTime)
+        return a.deliveryTime > b.deliveryTime;
+    return a.sequence > b.sequence;
+}
+
+AIAgent* AIController::findAgent(const char* id) const
+{
+    GP_ASSERT(id);
 
-    return NULL;
+    std::unordered_map<std::string, AIAgent*>::const_iterator itr = _agentIndex.find(id);
+    return itr != _agentIndex.end() ? itr->second : NULL;
 }
 
 }
@@ -96,9 +96,42 @@ private:
 
     void removeAgent(AIAgent* agent);
 
+    /**
+     * Re-indexes an agent whose node ID changed.
+     *
+     * @param agent The agent.
+     * @param oldId The ID the agent was indexed under.
+     */
+    void updateAgentId(AIAgent* agent, const char* oldId);
+
+    /**
+     * Removes an agent from the ID index, falling back to the next agent with the same ID.
+     */
+    void unindexAgent(AIAgent* agent, const char* id);
+
+    /**
+     * Defines a message waiting in the delayed message queue.
+     */
+    struct PendingMessage
+    {
+        /** The game time at which the message is delivered. */
+        double deliveryTime;
+        /** The order in which the message was queued (keeps delivery FIFO for equal times). */
+        unsigned int sequence;
+        /** The message. */
+        AIMessage* message;
+    };
+
+    /**
+     * Orders the pending message heap so that the earliest delivery is at its front.
+     */
+    static bool deliversAfter(const PendingMessage& a, const PendingMessage& b);
+
     bool _paused;
-    AIMessage* _firstMessage;
+    std::vector<PendingMessage> _messageQueue;
+    unsigned int _messageSequence;
     AIAgent* _firstAgent;
+    std::unordered_map<std::string, AIAgent*> _agentIndex;
 
 };
 
@@ -4,8 +4,15 @@
 namespace gameplay
 {
 
+// Maximum number of destroyed messages kept for reuse
+#define AIMESSAGE_POOL_MAX 256
+
+// Free list of destroyed messages (linked through AIMessage::_next)
+static AIMessage* __messagePool = NULL;
+static unsigned int __messagePoolSize = 0;
+
 AIMessage::AIMessage()
-    : _id(0), _deliveryTime(0), _parameters(NULL), _parameterCount(0), _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
+    : _id(0), _deliveryTime(0), _parameters(NULL), _parameterCount(0), _parameterCapacity(0), _messageType(MESSAGE_TYPE_CUSTOM), _next(NULL)
 {
 }
 
@@ -16,19 +23,66 @@ AIMessage::~AIMessage()
 
 AIMessage* AIMessage::create(unsigned int id, const char* sender, const char* receiver, unsigned int parameterCount)
 {
-    AIMessage* message = new AIMessage();
+    AIMessage* message = __messagePool;
+    if (message)
+    {
+        __messagePool = message->_next;
+        --__messagePoolSize;
+        message->_next = NULL;
+    }
+    else
+    {
+        message = new AIMessage();
+    }
+
     message->_id = id;
-    message->_sender = sender;
-    message->_receiver = receiver;
+    message->_sender = sender ? sender : "";
+    message->_receiver = receiver ? receiver : "";
     message->_parameterCount = parameterCount;
-    if (parameterCount > 0)
+
+    // Pooled messages keep their parameter array, so it only grows.
+    if (parameterCount > message->_parameterCapacity)
+    {
+        SAFE_DELETE_ARRAY(message->_parameters);
         message->_parameters = new AIMessage::Parameter[parameterCount];
+        message->_parameterCapacity = parameterCount;
+    }
     return message;
 }
 
 void AIMessage::destroy(AIMessage* message)
 {
-    SAFE_DELETE(message);
+    if (message == NULL)
+        return;
+
+    if (__messagePoolSize >= AIMESSAGE_POOL_MAX)
+    {
+        SAFE_DELETE(message);
+        return;
+    }
+
+    // Reset the message and keep it (with its parameter array) for reuse by create().
+    for (unsigned int i = 0; i < message->_parameterCount; ++i)
+    {
+        message->_parameters[i].clear();
+    }
+    message->_parameterCount = 0;
+    message->_deliveryTime = 0;
+    message->_messageType = MESSAGE_TYPE_CUSTOM;
+    message->_next = __messagePool;
+    __messagePool = message;
+    ++__messagePoolSize;
+}
+
+void AIMessage::clearPool()
+{
+    while (__messagePool)
+    {
+        AIMessage* message = __messagePool;
+        __messagePool = message->_next;
+        SAFE_DELETE(message);
+    }
+    __messagePoolSize = 0;
 }
 
 unsigned int AIMessage::getId() const
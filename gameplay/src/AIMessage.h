@@ -267,12 +267,18 @@ private:
 
     void clearParameter(unsigned int index);
 
+    /**
+     * Deletes the destroyed messages kept for reuse by create().
+     */
+    static void clearPool();
+
     unsigned int _id;
     std::string _sender;
     std::string _receiver;
     double _deliveryTime;
     Parameter* _parameters;
     unsigned int _parameterCount;
+    unsigned int _parameterCapacity;
     MessageType _messageType;
     AIMessage* _next;
 
@@ -15,6 +15,7 @@ AnimationClip::AnimationClip(const char* id, Animation* animation, unsigned long
     : _id(id), _animation(animation), _startTime(startTime), _endTime(endTime), _duration(_endTime - _startTime), 
       _stateBits(0x00), _repeatCount(1.0f), _loopBlendTime(0), _activeDuration(_duration * _repeatCount), _speed(1.0f), _timeStarted(0), 
       _elapsedTime(0), _crossFadeToClip(NULL), _crossFadeOutElapsed(0), _crossFadeOutDuration(0), _blendWeight(1.0f),
+      _evaluatedPercentComplete(0.0f), _evaluatedLoopBlendTime(0), _evaluatedAhead(false),
       _beginListeners(NULL), _endListeners(NULL), _listeners(NULL), _listenerItr(NULL)
 {
     GP_REGISTER_SCRIPT_EVENTS();
@@ -28,6 +29,7 @@ AnimationClip::AnimationClip(const char* id, Animation* animation, unsigned long
         GP_ASSERT(_animation->_channels[i]->getCurve());
         _values.push_back(new AnimationValue(_animation->_channels[i]->getCurve()->getComponentCount()));
     }
+    _curveCursors.resize(_values.size());
 }
 
 AnimationClip::~AnimationClip()
@@ -433,29 +435,12 @@ bool AnimationClip::update(float elapsedTime)
     }
 
     // Current time within a loop of the clip
-    float currentTime = 0.0f;
-
-    // Check to see if clip is complete.
-    if (_repeatCount != REPEAT_INDEFINITE && ((_speed >= 0.0f && _elapsedTime >= _activeDuration) || (_speed <= 0.0f && _elapsedTime <= 0.0f)))
+    bool complete;
+    float currentTime = getCurrentTime(_elapsedTime, &complete);
+    if (complete)
     {
         // We finished our active duration (including repeats), so clamp to our end value.
         resetClipStateBit(CLIP_IS_STARTED_BIT);
-
-        // Ensure we end off at the endpoints of our clip (-speed==0, +speed==_duration)
-        currentTime = _speed < 0.0f ? 0.0f : _duration;
-    }
-    else
-    {
-        // If _duration == 0, we have a "pose". Just set currentTime to 0.
-        if (_duration == 0)
-        {
-            currentTime = 0.0f;
-        }
-        else
-        {
-            // Animation is running normally.
-            currentTime = fmodf(_elapsedTime, _duration + _loopBlendTime);
-        }
     }
 
     // Notify any listeners of Animation events.
@@ -494,14 +479,7 @@ bool AnimationClip::update(float elapsedTime)
 
     // Add back in start time, and divide by the total animation's duration to get the actual percentage complete
     GP_ASSERT(_animation);
-
-    // Compute percentage complete for the current loop (prevent a divide by zero if _duration==0).
-    // Note that we don't use (currentTime/(_duration+_loopBlendTime)). That's because we want a
-    // % value that is outside the 0-1 range for loop smoothing/blending purposes.
-    float percentComplete = _duration == 0 ? 1 : currentTime / (float)_duration;
-
-    if (_loopBlendTime == 0.0f)
-        percentComplete = MATH_CLAMP(percentComplete, 0.0f, 1.0f);
+    float percentComplete = getPercentComplete(currentTime);
 
     // If we're cross fading, compute blend weights
     if (isClipStateBitSet(CLIP_IS_FADING_OUT_BIT))
@@ -551,29 +529,24 @@ bool AnimationClip::update(float elapsedTime)
         }
     }
     
-    // Evaluate this clip.
+    // Evaluate this clip, unless its values were evaluated ahead of the update for the same time.
+    if (!_evaluatedAhead || _evaluatedPercentComplete != percentComplete || _evaluatedLoopBlendTime != _loopBlendTime)
+        evaluate(percentComplete);
+    _evaluatedAhead = false;
+
     Animation::Channel* channel = NULL;
-    AnimationValue* value = NULL;
     AnimationTarget* target = NULL;
     size_t channelCount = _animation->_channels.size();
-    float percentageStart = (float)_startTime / (float)_animation->_duration;
-    float percentageEnd = (float)_endTime / (float)_animation->_duration;
-    float percentageBlend = (float)_loopBlendTime / (float)_animation->_duration;
     for (size_t i = 0; i < channelCount; i++)
     {
         channel = _animation->_channels[i];
         GP_ASSERT(channel);
         target = channel->_target;
         GP_ASSERT(target);
-        value = _values[i];
-        GP_ASSERT(value);
-
-        // Evaluate the point on Curve
-        GP_ASSERT(channel->getCurve());
-        channel->getCurve()->evaluate(percentComplete, percentageStart, percentageEnd, percentageBlend, value->_value);
+        GP_ASSERT(_values[i]);
 
         // Set the animation value on the target property.
-        target->setAnimationPropertyValue(channel->_propertyId, value, _blendWeight);
+        target->setAnimationPropertyValue(channel->_propertyId, _values[i], _blendWeight);
     }
 
     // When ended. Probably should move to it's own method so we can call it when the clip is ended early.
@@ -586,6 +559,90 @@ bool AnimationClip::update(float elapsedTime)
     return false;
 }
 
+void AnimationClip::evaluateAhead(float elapsedTime)
+{
+    // Clips that are paused, stopping or starting change state when they are updated,
+    // so they are evaluated by update() itself.
+    _evaluatedAhead = false;
+    if (isClipStateBitSet(CLIP_IS_PAUSED_BIT) || isClipStateBitSet(CLIP_IS_MARKED_FOR_REMOVAL_BIT) ||
+        isClipStateBitSet(CLIP_IS_RESTARTED_BIT) || !isClipStateBitSet(CLIP_IS_STARTED_BIT))
+    {
+        return;
+    }
+
+    // Predict the time update() computes, as long as nothing changes the clip before then.
+    float clipElapsedTime = _elapsedTime + elapsedTime * _speed;
+    if (_repeatCount == REPEAT_INDEFINITE && clipElapsedTime <= 0)
+        clipElapsedTime = _activeDuration + clipElapsedTime;
+
+    bool complete;
+    evaluate(getPercentComplete(getCurrentTime(clipElapsedTime, &complete)));
+    _evaluatedAhead = true;
+}
+
+void AnimationClip::evaluate(float percentComplete)
+{
+    GP_ASSERT(_animation);
+    GP_ASSERT(_curveCursors.size() == _animation->_channels.size());
+
+    _evaluatedPercentComplete = percentComplete;
+    _evaluatedLoopBlendTime = _loopBlendTime;
+
+    Animation::Channel* channel = NULL;
+    size_t channelCount = _animation->_channels.size();
+    float percentageStart = (float)_startTime / (float)_animation->_duration;
+    float percentageEnd = (float)_endTime / (float)_animation->_duration;
+    float percentageBlend = (float)_loopBlendTime / (float)_animation->_duration;
+    _curves.resize(channelCount);
+    _curveValues.resize(channelCount);
+    for (size_t i = 0; i < channelCount; i++)
+    {
+        channel = _animation->_channels[i];
+        GP_ASSERT(channel);
+        GP_ASSERT(channel->getCurve());
+        GP_ASSERT(_values[i]);
+        _curves[i] = channel->getCurve();
+        _curveValues[i] = _values[i]->_value;
+    }
+
+    // Evaluate the points on the Curves together, starting the keyframe searches from the channels' cursors.
+    if (channelCount > 0)
+        Curve::evaluate((unsigned int)channelCount, &_curves[0], percentComplete, percentageStart, percentageEnd, percentageBlend, &_curveValues[0], &_curveCursors[0]);
+}
+
+float AnimationClip::getCurrentTime(float elapsedTime, bool* complete) const
+{
+    GP_ASSERT(complete);
+
+    // Check to see if clip is complete.
+    *complete = _repeatCount != REPEAT_INDEFINITE && ((_speed >= 0.0f && elapsedTime >= _activeDuration) || (_speed <= 0.0f && elapsedTime <= 0.0f));
+    if (*complete)
+    {
+        // Ensure we end off at the endpoints of our clip (-speed==0, +speed==_duration)
+        return _speed < 0.0f ? 0.0f : _duration;
+    }
+
+    // If _duration == 0, we have a "pose". Just set currentTime to 0.
+    if (_duration == 0)
+        return 0.0f;
+
+    // Animation is running normally.
+    return fmodf(elapsedTime, _duration + _loopBlendTime);
+}
+
+float AnimationClip::getPercentComplete(float currentTime) const
+{
+    // Compute percentage complete for the current loop (prevent a divide by zero if _duration==0).
+    // Note that we don't use (currentTime/(_duration+_loopBlendTime)). That's because we want a
+    // % value that is outside the 0-1 range for loop smoothing/blending purposes.
+    float percentComplete = _duration == 0 ? 1 : currentTime / (float)_duration;
+
+    if (_loopBlendTime == 0.0f)
+        percentComplete = MATH_CLAMP(percentComplete, 0.0f, 1.0f);
+
+    return percentComplete;
+}
+
 void AnimationClip::onBegin()
 {
     this->addRef();
@@ -352,6 +352,37 @@ private:
      */
     bool update(float elapsedTime);
 
+    /**
+     * Evaluates the clip's curves for the time the next update() with the given elapsed
+     * time will compute, unless the clip is paused, stopping or starting.
+     *
+     * This only reads the clip and writes values owned by it, so distinct clips can be
+     * evaluated ahead on worker threads. update() reuses the values when the listeners
+     * and clips updated before it leave the clip's time unchanged, and evaluates them
+     * again otherwise.
+     */
+    void evaluateAhead(float elapsedTime);
+
+    /**
+     * Evaluates the curves of every channel of the clip into its animation values.
+     *
+     * @param percentComplete The percentage of the current loop to evaluate.
+     */
+    void evaluate(float percentComplete);
+
+    /**
+     * Gets the time within the current loop of the clip for the given elapsed time.
+     *
+     * @param elapsedTime The time elapsed since the clip started.
+     * @param complete Set to true if the clip's active duration is complete.
+     */
+    float getCurrentTime(float elapsedTime, bool* complete) const;
+
+    /**
+     * Gets the percentage of the current loop to evaluate for the given loop time.
+     */
+    float getPercentComplete(float currentTime) const;
+
     /**
      * Handles when the AnimationClip begins.
      */
@@ -402,7 +433,13 @@ private:
     float _crossFadeOutElapsed;                         // The amount of time that has elapsed for the crossfade.
     unsigned long _crossFadeOutDuration;                // The duration of the cross fade.
     float _blendWeight;                                 // The clip's blendweight.
+    float _evaluatedPercentComplete;                    // The percentage of the loop the values were last evaluated for.
+    unsigned int _evaluatedLoopBlendTime;               // The loop blend time the values were last evaluated with.
+    bool _evaluatedAhead;                               // Whether the values were evaluated ahead of the next update.
     std::vector<AnimationValue*> _values;               // AnimationValue holder.
+    std::vector<Curve::Cursor> _curveCursors;           // The cached keyframe segment of each channel.
+    std::vector<Curve*> _curves;                        // The curve of each channel, gathered for batch evaluation.
+    std::vector<float*> _curveValues;                   // The value of each channel, gathered for batch evaluation.
     std::vector<Listener*>* _beginListeners;            // Collection of begin listeners on the clip.
     std::vector<Listener*>* _endListeners;              // Collection of end listeners on the clip.
     std::list<ListenerEvent*>* _listeners;              // Ordered collection of listeners on the clip.
@@ -3,6 +3,9 @@
 #include "Game.h"
 #include "Curve.h"
 
+// The minimum number of clips evaluated by a single worker thread
+#define ANIMATION_EVALUATE_GRAIN_SIZE 8
+
 namespace gameplay
 {
 
@@ -100,7 +103,29 @@ void AnimationController::update(float elapsedTime)
     
     Transform::suspendTransformChanged();
 
-    // Loop through running clips and call update() on them.
+    // Evaluate the curves of the running clips ahead of their update. Each clip only writes
+    // its own animation values, so this is split across the worker threads.
+    _evaluatingClips.assign(_runningClips.begin(), _runningClips.end());
+    WorkerPool* workerPool = Game::getInstance()->getWorkerPool();
+    unsigned int evaluateCount = (unsigned int)_evaluatingClips.size();
+    if (workerPool)
+    {
+        workerPool->parallelFor(evaluateCount, ANIMATION_EVALUATE_GRAIN_SIZE, [this, elapsedTime](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+                _evaluatingClips[i]->evaluateAhead(elapsedTime);
+        });
+    }
+    else
+    {
+        for (unsigned int i = 0; i < evaluateCount; ++i)
+            _evaluatingClips[i]->evaluateAhead(elapsedTime);
+    }
+    _evaluatingClips.clear();
+
+    // Loop through running clips and call update() on them. Each clip fires its listeners
+    // and script events and is then applied, in running order, and reuses the values
+    // evaluated ahead unless its time was changed in the meantime.
     std::list<AnimationClip*>::iterator clipIter = _runningClips.begin();
     while (clipIter != _runningClips.end())
     {
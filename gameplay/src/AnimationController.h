@@ -98,6 +98,7 @@ private:
     
     State _state;                                 // The current state of the AnimationController.
     std::list<AnimationClip*> _runningClips;      // A list of running AnimationClips.
+    std::vector<AnimationClip*> _evaluatingClips; // The running AnimationClips evaluated ahead of the update.
 };
 
 }
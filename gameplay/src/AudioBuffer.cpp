@@ -1,12 +1,50 @@
 #include "Base.h"
 #include "AudioBuffer.h"
+#include "AudioController.h"
 #include "FileSystem.h"
+#include "Game.h"
 
 namespace gameplay
 {
 
-// Audio buffer cache
-static std::vector<AudioBuffer*> __buffers;
+// Audio buffer cache (non-streamed buffers by path) and its least recently used order (front is most recent).
+static std::unordered_map<std::string, AudioBuffer*> __buffers;
+static std::list<AudioBuffer*> __bufferOrder;
+static size_t __cacheSize = 0;
+static size_t __cacheBudget = 0;
+
+// Compressed clips kept in memory and their least recently used order (front is most recent).
+struct CompressedClip
+{
+    std::shared_ptr<std::vector<char> > data;
+    std::list<std::string>::iterator entry;
+};
+static std::unordered_map<std::string, CompressedClip> __compressedClips;
+static std::list<std::string> __compressedOrder;
+static size_t __compressedSize = 0;
+static size_t __compressedBudget = 0;
+
+// Clips being preloaded (main thread only) and the preloads decoded by the worker pool.
+static std::set<std::string> __preloading;
+std::vector<AudioBuffer::Preload*> AudioBuffer::_preloaded;
+static std::mutex __preloadMutex;
+static std::condition_variable __preloadDone;
+static unsigned int __preloadJobs = 0;
+
+// Gets the size in bytes of a sample frame of an OpenAL buffer format.
+static unsigned int getFrameSize(ALuint format)
+{
+    switch (format)
+    {
+    case AL_FORMAT_MONO8:
+        return 1;
+    case AL_FORMAT_STEREO8:
+    case AL_FORMAT_MONO16:
+        return 2;
+    default:
+        return 4;
+    }
+}
 
 // Callbacks for loading an ogg file using Stream
 static size_t readStream(void* ptr, size_t size, size_t nmemb, void* datasource)
@@ -38,27 +76,114 @@ static long tellStream(void* datasource)
     return stream->position();
 }
 
+/**
+ * Stream reading a compressed clip kept in memory.
+ */
+class MemoryStream : public Stream
+{
+public:
+
+    MemoryStream(const std::shared_ptr<std::vector<char> >& data) : _data(data), _position(0) { }
+
+    bool canRead() { return _data.get() != NULL; }
+
+    bool canWrite() { return false; }
+
+    bool canSeek() { return _data.get() != NULL; }
+
+    void close() { _data.reset(); _position = 0; }
+
+    size_t read(void* ptr, size_t size, size_t count)
+    {
+        if (!_data.get() || size == 0)
+            return 0;
+
+        // Only read whole elements, like fread().
+        size_t available = (_data->size() - _position) / size;
+        if (count > available)
+            count = available;
+        if (count > 0)
+            memcpy(ptr, &(*_data)[_position], size * count);
+        _position += size * count;
+        return count;
+    }
+
+    char* readLine(char* str, int num)
+    {
+        if (!_data.get() || num <= 0 || _position >= _data->size())
+            return NULL;
+        int i = 0;
+        while (i < num - 1 && _position < _data->size())
+        {
+            char c = (*_data)[_position++];
+            str[i++] = c;
+            if (c == '\n')
+                break;
+        }
+        str[i] = '\0';
+        return str;
+    }
+
+    size_t write(const void* ptr, size_t size, size_t count) { return 0; }
+
+    bool eof() { return !_data.get() || _position >= _data->size(); }
+
+    size_t length() { return _data.get() ? _data->size() : 0; }
+
+    long int position() { return (long int)_position; }
+
+    bool seek(long int offset, int origin)
+    {
+        if (!_data.get())
+            return false;
+        long int position;
+        if (origin == SEEK_SET)
+            position = offset;
+        else if (origin == SEEK_CUR)
+            position = (long int)_position + offset;
+        else if (origin == SEEK_END)
+            position = (long int)_data->size() + offset;
+        else
+            return false;
+        if (position < 0 || position > (long int)_data->size())
+            return false;
+        _position = (size_t)position;
+        return true;
+    }
+
+    bool rewind() { return seek(0, SEEK_SET); }
+
+    const unsigned char* getData() { return _data.get() && !_data->empty() ? (const unsigned char*)&(*_data)[0] : NULL; }
+
+private:
+
+    std::shared_ptr<std::vector<char> > _data;
+    size_t _position;
+};
+
 AudioBuffer::AudioBuffer(const char* path, ALuint* buffer, bool streamed)
-: _filePath(path), _streamed(streamed), _buffersNeededCount(0)
+: _filePath(path), _streamed(streamed), _size(0), _retained(false), _streamFormat(0), _streamFrequency(0), _streamFrameSize(0), _ring(NULL),
+  _ringRead(0), _ringWrite(0), _decoding(false), _endOfStream(false), _looped(false)
 {
     memcpy(_alBufferQueue, buffer, sizeof(_alBufferQueue));
 }
 
 AudioBuffer::~AudioBuffer()
 {
-    // Remove the buffer from the cache.
-    unsigned int bufferCount = (unsigned int)__buffers.size();
+    // Wait for the decode in flight (if any), which uses the stream and the ring.
+    if (_streamed)
+        Game::getInstance()->getAudioController()->cancelDecode(this);
+    SAFE_DELETE_ARRAY(_ring);
 
+    // Remove the buffer from the cache.
     if (!_streamed)
     {
-        unsigned int bufferCount = (unsigned int)__buffers.size();
-        for (unsigned int i = 0; i < bufferCount; i++)
+        std::unordered_map<std::string, AudioBuffer*>::iterator itr = __buffers.find(_filePath);
+        if (itr != __buffers.end() && itr->second == this)
         {
-            if (this == __buffers[i])
-            {
-                __buffers.erase(__buffers.begin() + i);
-                break;
-            }
+            __buffers.erase(itr);
+            __bufferOrder.erase(_cacheEntry);
+            __cacheSize -= _size;
         }
     }
     else if (_streamStateOgg.get())
@@ -80,109 +205,350 @@ AudioBuffer* AudioBuffer::create(const char* path, bool streamed)
 {
     GP_ASSERT(path);
 
-    AudioBuffer* buffer = NULL;
+    std::shared_ptr<std::vector<char> > compressed;
     if (!streamed)
     {
-        unsigned int bufferCount = (unsigned int)__buffers.size();
-        for (unsigned int i = 0; i < bufferCount; i++)
+        std::unordered_map<std::string, AudioBuffer*>::iterator itr = __buffers.find(path);
+        if (itr != __buffers.end())
         {
-            buffer = __buffers[i];
+            AudioBuffer* buffer = itr->second;
             GP_ASSERT(buffer);
-            if (buffer->_filePath.compare(path) == 0)
-            {
-                buffer->addRef();
-                return buffer;
-            }
+            __bufferOrder.splice(__bufferOrder.begin(), __bufferOrder, buffer->_cacheEntry);
+            buffer->addRef();
+            return buffer;
+        }
+
+        // Decode the clip again from its compressed data if it is kept in memory.
+        std::unordered_map<std::string, CompressedClip>::iterator clip = __compressedClips.find(path);
+        if (clip != __compressedClips.end())
+        {
+            __compressedOrder.splice(__compressedOrder.begin(), __compressedOrder, clip->second.entry);
+            compressed = clip->second.data;
         }
     }
+    bool keepCompressed = compressed.get() == NULL;
+
+    // Load sound file.
+    std::unique_ptr<Stream> stream(openStream(path, streamed, compressed));
+    if (stream.get() == NULL || !stream->canRead())
+    {
+        GP_ERROR("Failed to load audio file %s.", path);
+        return NULL;
+    }
+
+    DecodedData decoded;
+    std::unique_ptr<AudioStreamStateWav> streamStateWav;
+    std::unique_ptr<AudioStreamStateOgg> streamStateOgg;
+    if (!decode(stream.get(), path, streamed, decoded, streamStateWav, streamStateOgg))
+        return NULL;
+
+    if (!streamed)
+    {
+        if (keepCompressed && compressed.get())
+        {
+            CompressedClip& clip = __compressedClips[path];
+            clip.data = compressed;
+            clip.entry = __compressedOrder.insert(__compressedOrder.begin(), path);
+            __compressedSize += compressed->size();
+        }
+        AudioBuffer* buffer = createCached(path, decoded);
+        if (buffer && buffer->_retained)
+        {
+            buffer->addRef();
+            trimCache();
+        }
+        return buffer;
+    }
+
+    // Create the full queue of buffers for streamed sounds.
     ALuint alBuffer[STREAMING_BUFFER_QUEUE_SIZE];
     memset(alBuffer, 0, sizeof(alBuffer));
-
-    // Create 1 buffer for non-streamed sounds or full queue for streamed ones.
-    unsigned int queueSize = streamed ? STREAMING_BUFFER_QUEUE_SIZE : 1;
-    for (unsigned int i = 0; i < queueSize; i++)
+    for (unsigned int i = 0; i < STREAMING_BUFFER_QUEUE_SIZE; i++)
     {
-        // Load audio data into a buffer.
         AL_CHECK(alGenBuffers(1, &alBuffer[i]));
         if (AL_LAST_ERROR())
         {
             GP_ERROR("Failed to create OpenAL buffer; alGenBuffers error: %d", AL_LAST_ERROR());
-            AL_CHECK(alDeleteBuffers(1, &alBuffer[i]));
+            for (unsigned int j = 0; j < i; j++)
+                AL_CHECK(alDeleteBuffers(1, &alBuffer[j]));
             return NULL;
         }
     }
-    
-    std::unique_ptr<AudioStreamStateWav> streamStateWav;
-    std::unique_ptr<AudioStreamStateOgg> streamStateOgg;
+    AL_CHECK(alBufferData(alBuffer[0], decoded.format, decoded.data.empty() ? NULL : &decoded.data[0], (ALsizei)decoded.data.size(), decoded.frequency));
+
+    AudioBuffer* buffer = new AudioBuffer(path, alBuffer, streamed);
+
+    buffer->_fileStream.reset(stream.release());
+    buffer->_streamStateWav.reset(streamStateWav.release());
+    buffer->_streamStateOgg.reset(streamStateOgg.release());
+    unsigned int dataSize = buffer->_streamStateWav.get() ? buffer->_streamStateWav->dataSize : buffer->_streamStateOgg->dataSize;
+    buffer->_streamFormat = decoded.format;
+    buffer->_streamFrequency = decoded.frequency;
+    buffer->_streamFrameSize = getFrameSize(buffer->_streamFormat);
+    buffer->_endOfStream = dataSize <= STREAMING_BUFFER_SIZE;
+
+    // The first block was loaded into the first OpenAL buffer; the others are free to be filled.
+    buffer->_freeBuffers.assign(alBuffer + 1, alBuffer + STREAMING_BUFFER_QUEUE_SIZE);
+    buffer->_ring = new StreamingBlock[STREAMING_RING_SIZE];
+
+    return buffer;
+}
+
+Stream* AudioBuffer::openStream(const char* path, bool streamed, std::shared_ptr<std::vector<char> >& compressed)
+{
+    GP_ASSERT(path);
+
+    if (compressed.get())
+        return new MemoryStream(compressed);
 
-    // Load sound file.
     std::unique_ptr<Stream> stream(FileSystem::open(path));
-    if (stream.get() == NULL || !stream->canRead())
+    if (stream.get() == NULL || !stream->canRead() || streamed || __compressedBudget == 0)
+        return stream.release();
+
+    // Read Ogg clips into memory to keep them compressed after they are decoded.
+    char header[4];
+    if (stream->read(header, 1, 4) != 4 || memcmp(header, "OggS", 4) != 0)
     {
-        GP_ERROR("Failed to load audio file %s.", path);
-        goto cleanup;
+        stream->rewind();
+        return stream.release();
     }
-    
+    size_t length = stream->length();
+    std::shared_ptr<std::vector<char> > data(new std::vector<char>(length));
+    stream->rewind();
+    if (length == 0 || stream->read(&(*data)[0], 1, length) != length)
+    {
+        stream->rewind();
+        return stream.release();
+    }
+    compressed = data;
+    return new MemoryStream(compressed);
+}
+
+bool AudioBuffer::decode(Stream* stream, const char* path, bool streamed, DecodedData& decoded,
+                         std::unique_ptr<AudioStreamStateWav>& streamStateWav, std::unique_ptr<AudioStreamStateOgg>& streamStateOgg)
+{
+    GP_ASSERT(stream);
+    GP_ASSERT(path);
+
     // Read the file header
     char header[12];
     if (stream->read(header, 1, 12) != 12)
     {
         GP_ERROR("Invalid header for audio file %s.", path);
-        goto cleanup;
+        return false;
     }
     
     // Check the file format
     if (memcmp(header, "RIFF", 4) == 0)
     {
-        // Fill at least one buffer with sound data.
+        // Decode at least one buffer of sound data.
         streamStateWav.reset(new AudioStreamStateWav());
-        if (!AudioBuffer::loadWav(stream.get(), alBuffer[0], streamed, streamStateWav.get()))
+        if (!AudioBuffer::loadWav(stream, decoded, streamed, streamStateWav.get()))
         {
             GP_ERROR("Invalid wave file: %s", path);
-            goto cleanup;
+            return false;
         }
     }
     else if (memcmp(header, "OggS", 4) == 0)
     {
-        // Fill at least one buffer with sound data.
+        // Decode at least one buffer of sound data.
         streamStateOgg.reset(new AudioStreamStateOgg());
-        if (!AudioBuffer::loadOgg(stream.get(), alBuffer[0], streamed, streamStateOgg.get()))
+        if (!AudioBuffer::loadOgg(stream, decoded, streamed, streamStateOgg.get()))
         {
             GP_ERROR("Invalid ogg file: %s", path);
-            goto cleanup;
+            return false;
         }
     }
     else
     {
         GP_ERROR("Unsupported audio file: %s", path);
-        goto cleanup;
+        return false;
     }
+    return true;
+}
 
-    buffer = new AudioBuffer(path, alBuffer, streamed);
+AudioBuffer* AudioBuffer::createCached(const char* path, const DecodedData& decoded)
+{
+    GP_ASSERT(path);
+    GP_ASSERT(__buffers.find(path) == __buffers.end());
 
-    buffer->_fileStream.reset(stream.release());
-    buffer->_streamStateWav.reset(streamStateWav.release());
-    buffer->_streamStateOgg.reset(streamStateOgg.release());
-    if (buffer->_streamStateWav.get())
-        buffer->_buffersNeededCount = (buffer->_streamStateWav->dataSize + STREAMING_BUFFER_SIZE - 1) / STREAMING_BUFFER_SIZE;
-    else if (buffer->_streamStateOgg.get())
-        buffer->_buffersNeededCount = (buffer->_streamStateOgg->dataSize + STREAMING_BUFFER_SIZE - 1) / STREAMING_BUFFER_SIZE;
+    ALuint alBuffer[STREAMING_BUFFER_QUEUE_SIZE];
+    memset(alBuffer, 0, sizeof(alBuffer));
+    AL_CHECK(alGenBuffers(1, &alBuffer[0]));
+    if (AL_LAST_ERROR())
+    {
+        GP_ERROR("Failed to create OpenAL buffer; alGenBuffers error: %d", AL_LAST_ERROR());
+        return NULL;
+    }
+    AL_CHECK(alBufferData(alBuffer[0], decoded.format, decoded.data.empty() ? NULL : &decoded.data[0], (ALsizei)decoded.data.size(), decoded.frequency));
+
+    // While the cache has a budget, the initial reference is the cache's own and is released on eviction.
+    AudioBuffer* buffer = new AudioBuffer(path, alBuffer, false);
+    buffer->_size = (unsigned int)decoded.data.size();
+    buffer->_retained = __cacheBudget > 0;
+    __buffers[path] = buffer;
+    buffer->_cacheEntry = __bufferOrder.insert(__bufferOrder.begin(), buffer);
+    __cacheSize += buffer->_size;
+    return buffer;
+}
 
-    if (!streamed)
-        __buffers.push_back(buffer);
+void AudioBuffer::setCacheBudget(size_t decodedBudget, size_t compressedBudget)
+{
+    __cacheBudget = decodedBudget;
+    __compressedBudget = compressedBudget;
+    trimCache();
+}
 
-    return buffer;
-    
-cleanup:
-    for (unsigned int i = 0; i < STREAMING_BUFFER_QUEUE_SIZE; i++)
+void AudioBuffer::trimCache()
+{
+    // Walk from the least recently used buffer, skipping the ones still used by sources.
+    std::list<AudioBuffer*>::iterator itr = __bufferOrder.end();
+    while (__cacheSize > __cacheBudget && itr != __bufferOrder.begin())
+    {
+        AudioBuffer* buffer = *(--itr);
+        if (buffer->_retained && buffer->getRefCount() == 1)
+        {
+            // Step past the buffer before its destructor removes it from the order.
+            ++itr;
+            SAFE_RELEASE(buffer);
+        }
+    }
+
+    while (__compressedSize > __compressedBudget && !__compressedOrder.empty())
+    {
+        std::unordered_map<std::string, CompressedClip>::iterator clip = __compressedClips.find(__compressedOrder.back());
+        GP_ASSERT(clip != __compressedClips.end());
+        __compressedSize -= clip->second.data->size();
+        __compressedClips.erase(clip);
+        __compressedOrder.pop_back();
+    }
+}
+
+void AudioBuffer::clearCache()
+{
+    // Wait for the preloads in flight, which would add to the cache.
+    std::unique_lock<std::mutex> lock(__preloadMutex);
+    __preloadDone.wait(lock, [] { return __preloadJobs == 0; });
+    for (size_t i = 0, count = _preloaded.size(); i < count; i++)
+        SAFE_DELETE(_preloaded[i]);
+    _preloaded.clear();
+    lock.unlock();
+    __preloading.clear();
+
+    // Release the cache's references; buffers still used by sources stay alive until they are released.
+    std::list<AudioBuffer*>::iterator itr = __bufferOrder.begin();
+    while (itr != __bufferOrder.end())
+    {
+        AudioBuffer* buffer = *itr++;
+        if (buffer->_retained)
+        {
+            buffer->_retained = false;
+            SAFE_RELEASE(buffer);
+        }
+    }
+
+    __compressedClips.clear();
+    __compressedOrder.clear();
+    __compressedSize = 0;
+    __cacheBudget = 0;
+    __compressedBudget = 0;
+}
+
+void AudioBuffer::preload(const char* path)
+{
+    GP_ASSERT(path);
+
+    if (__cacheBudget == 0)
+    {
+        GP_WARN("Failed to preload audio file '%s'; the audio cache has no budget.", path);
+        return;
+    }
+    std::unordered_map<std::string, AudioBuffer*>::iterator itr = __buffers.find(path);
+    if (itr != __buffers.end())
+    {
+        __bufferOrder.splice(__bufferOrder.begin(), __bufferOrder, itr->second->_cacheEntry);
+        return;
+    }
+    if (!__preloading.insert(path).second)
+        return;
+
+    Preload* preload = new Preload();
+    preload->path = path;
+    preload->loaded = false;
+    std::unordered_map<std::string, CompressedClip>::iterator clip = __compressedClips.find(path);
+    if (clip != __compressedClips.end())
+    {
+        __compressedOrder.splice(__compressedOrder.begin(), __compressedOrder, clip->second.entry);
+        preload->compressed = clip->second.data;
+    }
+
+    __preloadMutex.lock();
+    __preloadJobs++;
+    __preloadMutex.unlock();
+    Game::getInstance()->getWorkerPool()->submit(std::bind(&AudioBuffer::decodePreload, preload));
+}
+
+void AudioBuffer::decodePreload(Preload* preload)
+{
+    GP_ASSERT(preload);
+
+    std::unique_ptr<Stream> stream(openStream(preload->path.c_str(), false, preload->compressed));
+    if (stream.get() && stream->canRead())
+    {
+        std::unique_ptr<AudioStreamStateWav> streamStateWav;
+        std::unique_ptr<AudioStreamStateOgg> streamStateOgg;
+        preload->loaded = decode(stream.get(), preload->path.c_str(), false, preload->decoded, streamStateWav, streamStateOgg);
+    }
+    else
     {
-        if (alBuffer[i])
-            AL_CHECK(alDeleteBuffers(1, &alBuffer[i]));
+        GP_WARN("Failed to preload audio file '%s'.", preload->path.c_str());
+    }
+
+    __preloadMutex.lock();
+    _preloaded.push_back(preload);
+    bool done = --__preloadJobs == 0;
+    __preloadMutex.unlock();
+    if (done)
+        __preloadDone.notify_all();
+}
+
+void AudioBuffer::finishPreloads()
+{
+    std::vector<Preload*> preloaded;
+    __preloadMutex.lock();
+    preloaded.swap(_preloaded);
+    __preloadMutex.unlock();
+
+    for (size_t i = 0, count = preloaded.size(); i < count; i++)
+    {
+        Preload* preload = preloaded[i];
+        const char* path = preload->path.c_str();
+        if (preload->loaded && __buffers.find(path) == __buffers.end())
+        {
+            if (preload->compressed.get() && __compressedClips.find(path) == __compressedClips.end())
+            {
+                CompressedClip& clip = __compressedClips[path];
+                clip.data = preload->compressed;
+                clip.entry = __compressedOrder.insert(__compressedOrder.begin(), path);
+                __compressedSize += preload->compressed->size();
+            }
+            AudioBuffer* buffer = createCached(path, preload->decoded);
+            if (buffer && !buffer->_retained)
+                SAFE_RELEASE(buffer);
+        }
+        __preloading.erase(preload->path);
+        SAFE_DELETE(preload);
     }
-    return NULL;
+    if (!preloaded.empty())
+        trimCache();
 }
 
-bool AudioBuffer::loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateWav* streamState)
+bool AudioBuffer::isPreloading()
+{
+    return !__preloading.empty();
+}
+
+bool AudioBuffer::loadWav(Stream* stream, DecodedData& decoded, bool streamed, AudioStreamStateWav* streamState)
 {
     GP_ASSERT(stream);
 
@@ -326,16 +692,14 @@ bool AudioBuffer::loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStr
                     dataSize = STREAMING_BUFFER_SIZE;
             }
 
-            char* data = new char[dataSize];
-            if (stream->read(data, sizeof(char), dataSize) != dataSize)
+            decoded.data.resize(dataSize);
+            if (dataSize > 0 && stream->read(&decoded.data[0], sizeof(char), dataSize) != dataSize)
             {
                 GP_ERROR("Failed to load wave file; file is missing data.");
-                SAFE_DELETE_ARRAY(data);
                 return false;
             }
-
-            AL_CHECK( alBufferData(buffer, format, data, dataSize, frequency) );
-            SAFE_DELETE_ARRAY(data);
+            decoded.format = format;
+            decoded.frequency = frequency;
 
             // We've read the data, so return now.
             return true;
@@ -381,7 +745,7 @@ bool AudioBuffer::loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStr
     return false;
 }
 
-bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateOgg* streamState)
+bool AudioBuffer::loadOgg(Stream* stream, DecodedData& decoded, bool streamed, AudioStreamStateOgg* streamState)
 {
     GP_ASSERT(stream);
 
@@ -428,18 +792,17 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStr
             data_size = STREAMING_BUFFER_SIZE;
     }
 
-    char* data = new char[data_size];
+    decoded.data.resize(data_size);
 
     while (size < data_size)
     {
-        result = ov_read(&streamState->oggFile, data + size, data_size - size, 0, 2, 1, &section);
+        result = ov_read(&streamState->oggFile, &decoded.data[size], data_size - size, 0, 2, 1, &section);
         if (result > 0)
         {
             size += result;
         }
         else if (result < 0)
         {
-            SAFE_DELETE_ARRAY(data);
             GP_ERROR("Failed to read ogg file; file is missing data.");
             return false;
         }
@@ -451,14 +814,13 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStr
     
     if (size == 0)
     {
-        SAFE_DELETE_ARRAY(data);
         GP_ERROR("Filed to read ogg file; unable to read any data.");
         return false;
     }
 
-    AL_CHECK(alBufferData(buffer, format, data, size, info->rate));
-
-    SAFE_DELETE_ARRAY(data);
+    decoded.data.resize(size);
+    decoded.format = format;
+    decoded.frequency = info->rate;
 
     if (!streamed)
         ov_clear(&streamState->oggFile);
@@ -466,51 +828,115 @@ bool AudioBuffer::loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStr
     return true;
 }
 
-bool AudioBuffer::streamData(ALuint buffer, bool looped)
+unsigned int AudioBuffer::decodeBlock(char* data, bool looped)
 {
-    static char buffers[STREAMING_BUFFER_SIZE];
-    
+    GP_ASSERT(data);
+
+    unsigned int size = 0;
+    bool rewound = false;
     if (_streamStateWav.get())
     {
-        ALsizei bytesRead = _fileStream->read(buffers, sizeof(char), STREAMING_BUFFER_SIZE);
-        if (bytesRead != STREAMING_BUFFER_SIZE)
+        while (size < STREAMING_BUFFER_SIZE)
         {
-            if (looped)
+            // Only read up to the end of the data chunk (other chunks may follow it).
+            long end = _streamStateWav->dataStart + (long)_streamStateWav->dataSize;
+            long remaining = end - (long)_fileStream->position();
+            unsigned int count = (unsigned int)std::max(std::min(remaining, (long)(STREAMING_BUFFER_SIZE - size)), 0L);
+            unsigned int bytesRead = count > 0 ? (unsigned int)_fileStream->read(data + size, sizeof(char), count) : 0;
+            size += bytesRead;
+            if (bytesRead < count || remaining <= (long)bytesRead)
+            {
+                // Wrap around once per block at most (in case the data chunk is empty).
+                if (!looped || rewound)
+                    break;
                 _fileStream->seek(_streamStateWav->dataStart, SEEK_SET);
+                rewound = true;
+            }
         }
-        if (bytesRead > 0)
-            AL_CHECK(alBufferData(buffer, _streamStateWav->format, buffers, bytesRead, _streamStateWav->frequency));
-        
-        return bytesRead > 0 || looped;
     }
     else if (_streamStateOgg.get())
     {
         int section;
-        int result = 0;
-        ALsizei bytesRead = 0;
-
-        while (bytesRead < STREAMING_BUFFER_SIZE)
+        while (size < STREAMING_BUFFER_SIZE)
         {
-            result = ov_read(&_streamStateOgg->oggFile, buffers + bytesRead, STREAMING_BUFFER_SIZE - bytesRead, 0, 2, 1, &section);
+            long result = ov_read(&_streamStateOgg->oggFile, data + size, STREAMING_BUFFER_SIZE - size, 0, 2, 1, &section);
             if (result > 0)
             {
-                bytesRead += result;
+                size += (unsigned int)result;
+                rewound = false;
             }
             else
             {
-                if (looped)
-                    ov_pcm_seek(&_streamStateOgg->oggFile, _streamStateOgg->dataStart);
-                break;
+                if (!looped || rewound)
+                    break;
+                ov_pcm_seek(&_streamStateOgg->oggFile, _streamStateOgg->dataStart);
+                rewound = true;
             }
         }
+    }
+    return size;
+}
 
-        if (bytesRead > 0)
-            AL_CHECK(alBufferData(buffer, _streamStateOgg->format, buffers, bytesRead, _streamStateOgg->frequency));
-        
-        return (bytesRead > 0) || looped;
+void AudioBuffer::decodeAhead()
+{
+    GP_ASSERT(_ring);
+
+    AudioController* audioController = Game::getInstance()->getAudioController();
+    GP_ASSERT(audioController);
+
+    while (!_endOfStream.load() && _ringWrite.load() - _ringRead.load(std::memory_order_acquire) < STREAMING_RING_SIZE)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        StreamingBlock& block = _ring[_ringWrite.load() % STREAMING_RING_SIZE];
+        bool looped = _looped.load();
+        block.size = decodeBlock(block.data, looped);
+        if (block.size == 0 || (block.size < STREAMING_BUFFER_SIZE && !looped))
+            _endOfStream = true;
+        if (block.size > 0)
+            _ringWrite.fetch_add(1, std::memory_order_release);
+
+        std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - start;
+        audioController->addDecodeTime(duration.count());
     }
-    
-    return false;
+
+    // Allow the buffer to be queued again, then wake the streaming thread up so the blocks can be queued.
+    _decoding = false;
+    audioController->notifyStreaming();
+}
+
+void AudioBuffer::requestDecode()
+{
+    if (_endOfStream.load() || getBlockCount() >= STREAMING_RING_SIZE)
+        return;
+
+    bool decoding = false;
+    if (_decoding.compare_exchange_strong(decoding, true))
+        Game::getInstance()->getAudioController()->queueDecode(this);
+}
+
+const AudioBuffer::StreamingBlock* AudioBuffer::peekBlock() const
+{
+    unsigned int read = _ringRead.load();
+    if (read == _ringWrite.load(std::memory_order_acquire))
+        return NULL;
+    return &_ring[read % STREAMING_RING_SIZE];
+}
+
+void AudioBuffer::popBlock()
+{
+    GP_ASSERT(getBlockCount() > 0);
+    _ringRead.fetch_add(1, std::memory_order_release);
+}
+
+unsigned int AudioBuffer::getBlockCount() const
+{
+    return _ringWrite.load(std::memory_order_acquire) - _ringRead.load(std::memory_order_acquire);
+}
+
+bool AudioBuffer::isEndOfStream() const
+{
+    return _endOfStream.load();
 }
 
 }
@@ -13,10 +13,23 @@ class AudioSource;
  * Defines the actual audio buffer data.
  *
  * Currently only supports supported formats: .ogg, .wav, .au and .raw files.
+ *
+ * Streamed buffers decode ahead of playback on the audio controller's decode thread
+ * into a small ring of blocks, from which the audio controller's streaming thread
+ * refills the OpenAL buffer queue. The ring has a single producer (the decode thread,
+ * on which each buffer is queued at most once) and a single consumer (the streaming
+ * thread), so it needs no lock.
+ *
+ * Non-streamed buffers are shared through a cache keyed by path. When the audio
+ * controller is given a cache budget, the cache keeps decoded buffers alive after
+ * their last source is gone and evicts the least recently used unreferenced ones
+ * once the budget is exceeded; Ogg clips can also be kept compressed in memory
+ * (under a budget of their own) so evicted clips are decoded again without I/O.
  */
 class AudioBuffer : public Ref
 {
     friend class AudioSource;
+    friend class AudioController;
 
 private:
     
@@ -44,6 +57,27 @@ private:
      */
     static AudioBuffer* create(const char* path, bool streamed);
 
+    /**
+     * Audio data decoded from a file, ready to be copied into an OpenAL buffer.
+     */
+    struct DecodedData
+    {
+        std::vector<char> data;
+        ALuint format;
+        ALuint frequency;
+    };
+
+    /**
+     * A clip being decoded ahead of its use on the worker pool.
+     */
+    struct Preload
+    {
+        std::string path;
+        std::shared_ptr<std::vector<char> > compressed;
+        DecodedData decoded;
+        bool loaded;
+    };
+
     struct AudioStreamStateWav
     {
         long dataStart;
@@ -63,20 +97,143 @@ private:
 
     enum { STREAMING_BUFFER_QUEUE_SIZE = 3 };
     enum { STREAMING_BUFFER_SIZE = 48000 };
+    enum { STREAMING_RING_SIZE = 4 };
 
-    static bool loadWav(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateWav* streamState);
+    /**
+     * A block of decoded audio data in the decode-ahead ring.
+     */
+    struct StreamingBlock
+    {
+        char data[STREAMING_BUFFER_SIZE];
+        unsigned int size;
+    };
+
+    static bool loadWav(Stream* stream, DecodedData& decoded, bool streamed, AudioStreamStateWav* streamState);
     
-    static bool loadOgg(Stream* stream, ALuint buffer, bool streamed, AudioStreamStateOgg* streamState);
+    static bool loadOgg(Stream* stream, DecodedData& decoded, bool streamed, AudioStreamStateOgg* streamState);
 
-    bool streamData(ALuint buffer, bool looped);
+    /**
+     * Opens an audio file for decoding, reading it from the compressed data kept in
+     * memory if given, or reading it into memory to be kept if it is an Ogg clip and
+     * compressed clips are cached.
+     *
+     * @param path The path to the audio file.
+     * @param streamed Whether the file is streamed (streamed files are never kept in memory).
+     * @param compressed The compressed data of the clip; set if it was read to be kept.
+     *
+     * @return The stream, or NULL if the file could not be opened.
+     */
+    static Stream* openStream(const char* path, bool streamed, std::shared_ptr<std::vector<char> >& compressed);
+
+    /**
+     * Reads the header of an audio file and decodes its data (only the first block if streamed).
+     *
+     * @return true if the file was decoded, false otherwise.
+     */
+    static bool decode(Stream* stream, const char* path, bool streamed, DecodedData& decoded,
+                       std::unique_ptr<AudioStreamStateWav>& streamStateWav, std::unique_ptr<AudioStreamStateOgg>& streamStateOgg);
+
+    /**
+     * Creates a non-streamed buffer from decoded data and adds it to the cache.
+     */
+    static AudioBuffer* createCached(const char* path, const DecodedData& decoded);
+
+    /**
+     * Sets the budgets of the cache, in bytes (a decoded budget of zero disables keeping
+     * unreferenced buffers and a compressed budget of zero disables keeping compressed clips).
+     */
+    static void setCacheBudget(size_t decodedBudget, size_t compressedBudget);
+
+    /**
+     * Evicts the least recently used unreferenced buffers and compressed clips until
+     * the cache fits within its budgets.
+     */
+    static void trimCache();
+
+    /**
+     * Releases all the buffers and compressed clips held by the cache.
+     */
+    static void clearCache();
+
+    /**
+     * Starts decoding a clip into the cache on the worker pool.
+     */
+    static void preload(const char* path);
+
+    /**
+     * Decodes a preloaded clip (runs on a worker thread).
+     */
+    static void decodePreload(Preload* preload);
+
+    /**
+     * Creates the buffers of the clips decoded since the last call (must be called on the main thread).
+     */
+    static void finishPreloads();
+
+    /**
+     * Gets whether clips are being preloaded.
+     */
+    static bool isPreloading();
+
+    /**
+     * Decodes the next block of the stream, wrapping around to the start if looped.
+     *
+     * @return The number of bytes decoded (0 at the end of the stream).
+     */
+    unsigned int decodeBlock(char* data, bool looped);
+
+    /**
+     * Decodes blocks until the ring is full or the stream ends (runs on the audio controller's decode thread).
+     */
+    void decodeAhead();
+
+    /**
+     * Queues the buffer to be decoded ahead on the audio controller's decode thread, unless
+     * the ring is full, the stream has ended or the buffer is already queued.
+     */
+    void requestDecode();
+
+    /**
+     * Gets the oldest decoded block of the ring, or NULL if the ring is empty.
+     */
+    const StreamingBlock* peekBlock() const;
+
+    /**
+     * Removes the oldest decoded block from the ring.
+     */
+    void popBlock();
+
+    /**
+     * Gets the number of decoded blocks in the ring.
+     */
+    unsigned int getBlockCount() const;
+
+    /**
+     * Gets whether the stream has been decoded to its end (and is not looped).
+     */
+    bool isEndOfStream() const;
 
     ALuint _alBufferQueue[STREAMING_BUFFER_QUEUE_SIZE];
     std::string _filePath;
     bool _streamed;
+    unsigned int _size;
+    bool _retained;
+    std::list<AudioBuffer*>::iterator _cacheEntry;
     std::unique_ptr<Stream> _fileStream;
     std::unique_ptr<AudioStreamStateWav> _streamStateWav;
     std::unique_ptr<AudioStreamStateOgg> _streamStateOgg;
-    int _buffersNeededCount;
+    ALuint _streamFormat;
+    ALuint _streamFrequency;
+    unsigned int _streamFrameSize;
+    std::vector<ALuint> _freeBuffers;
+    StreamingBlock* _ring;
+    std::atomic<unsigned int> _ringRead;
+    std::atomic<unsigned int> _ringWrite;
+    std::atomic<bool> _decoding;
+    std::atomic<bool> _endOfStream;
+    std::atomic<bool> _looped;
+
+    static std::vector<Preload*> _preloaded;
 };
 
 }
@@ -3,12 +3,21 @@
 #include "AudioListener.h"
 #include "AudioBuffer.h"
 #include "AudioSource.h"
+#include "Game.h"
 
 namespace gameplay
 {
 
+// The longest time the streaming thread sleeps without being woken up, in seconds
+// (bounds the delay of a wake-up that arrives just before the thread waits).
+#define STREAMING_MAX_WAIT 0.25f
+
+// The shortest time the streaming thread sleeps, in seconds.
+#define STREAMING_MIN_WAIT 0.005f
+
 AudioController::AudioController() 
-: _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL), _streamingThreadActive(true)
+: _alcDevice(NULL), _alcContext(NULL), _pausingSource(NULL), _streamingThreadActive(true), _streamingPending(false),
+  _decodeThreadActive(true), _decodingBuffer(NULL), _decodeTime(0.0f)
 {
 }
 
@@ -41,6 +50,24 @@ void AudioController::initialize()
         GP_ERROR("Unable to make OpenAL context current. Error: %d\n", alcErr);
     }
     _streamingMutex.reset(new std::mutex());
+    _streamingCondition.reset(new std::condition_variable());
+    _statisticsMutex.reset(new std::mutex());
+
+    // Streams are decoded ahead on a thread of their own, so that they never wait behind the
+    // worker pool's jobs and a buffer being destroyed can block until its decode completes.
+    _decodeMutex.reset(new std::mutex());
+    _decodeCondition.reset(new std::condition_variable());
+    _decodeDone.reset(new std::condition_variable());
+    _decodeThread.reset(new std::thread(&decodeThreadProc, this));
+
+    // Budgets (in kilobytes) of the decoded clips kept after they are no longer used and of the compressed clips kept in memory.
+    Properties* config = Game::getInstance()->getConfig()->getNamespace("audio", true);
+    if (config)
+    {
+        size_t cacheSize = (size_t)std::max(config->getInt("cacheSize"), 0) * 1024;
+        size_t compressedCacheSize = (size_t)std::max(config->getInt("compressedCacheSize"), 0) * 1024;
+        AudioBuffer::setCacheBudget(cacheSize, compressedCacheSize);
+    }
 }
 
 void AudioController::finalize()
@@ -48,10 +75,23 @@ void AudioController::finalize()
     GP_ASSERT(_streamingSources.empty());
     if (_streamingThread.get())
     {
+        _streamingMutex->lock();
         _streamingThreadActive = false;
+        _streamingMutex->unlock();
+        notifyStreaming();
         _streamingThread->join();
         _streamingThread.reset(NULL);
     }
+    if (_decodeThread.get())
+    {
+        _decodeMutex->lock();
+        _decodeThreadActive = false;
+        _decodeMutex->unlock();
+        _decodeCondition->notify_one();
+        _decodeThread->join();
+        _decodeThread.reset(NULL);
+    }
+    AudioBuffer::clearCache();
 
     alcMakeContextCurrent(NULL);
     if (_alcContext)
@@ -116,6 +156,7 @@ void AudioController::update(float elapsedTime)
         AL_CHECK( alListenerfv(AL_VELOCITY, (ALfloat*)&listener->getVelocity()) );
         AL_CHECK( alListenerfv(AL_POSITION, (ALfloat*)&listener->getPosition()) );
     }
+    AudioBuffer::finishPreloads();
 }
 
 void AudioController::addPlayingSource(AudioSource* source)
@@ -134,6 +175,8 @@ void AudioController::addPlayingSource(AudioSource* source)
 
             if (startThread)
                 _streamingThread.reset(new std::thread(&streamingThreadProc, this));
+            else
+                notifyStreaming();
         }
     }
 }
@@ -158,20 +201,145 @@ void AudioController::removePlayingSource(AudioSource* source)
     } 
 }
 
+AudioController::StreamingStatistics AudioController::getStreamingStatistics() const
+{
+    if (!_statisticsMutex.get())
+        return _statistics;
+
+    std::lock_guard<std::mutex> lock(*_statisticsMutex);
+    return _statistics;
+}
+
+void AudioController::resetStreamingStatistics()
+{
+    GP_ASSERT(_statisticsMutex.get());
+
+    std::lock_guard<std::mutex> lock(*_statisticsMutex);
+    _statistics = StreamingStatistics();
+    _decodeTime = 0.0f;
+}
+
+void AudioController::notifyStreaming()
+{
+    // The flag is not set under the streaming mutex so the decode thread never waits on the
+    // streaming thread. A wake-up missed this way is only delayed until the thread's timeout.
+    _streamingPending = true;
+    _streamingCondition->notify_one();
+}
+
+void AudioController::queueDecode(AudioBuffer* buffer)
+{
+    GP_ASSERT(buffer);
+    GP_ASSERT(_decodeMutex.get());
+
+    _decodeMutex->lock();
+    _decodeQueue.push_back(buffer);
+    _decodeMutex->unlock();
+    _decodeCondition->notify_one();
+}
+
+void AudioController::cancelDecode(AudioBuffer* buffer)
+{
+    if (!_decodeMutex.get())
+        return;
+
+    std::unique_lock<std::mutex> lock(*_decodeMutex);
+    std::deque<AudioBuffer*>::iterator itr = std::find(_decodeQueue.begin(), _decodeQueue.end(), buffer);
+    if (itr != _decodeQueue.end())
+        _decodeQueue.erase(itr);
+    _decodeDone->wait(lock, [this, buffer]() { return _decodingBuffer != buffer; });
+}
+
+void AudioController::addDecodeTime(float time)
+{
+    std::lock_guard<std::mutex> lock(*_statisticsMutex);
+    _decodeTime += time;
+    _statistics.decodedBlockCount++;
+    _statistics.averageDecodeTime = _decodeTime / _statistics.decodedBlockCount;
+}
+
+void AudioController::addStreamingState(float bufferedTime, bool underrun)
+{
+    std::lock_guard<std::mutex> lock(*_statisticsMutex);
+    if (_statistics.minBufferedTime < 0.0f || bufferedTime < _statistics.minBufferedTime)
+        _statistics.minBufferedTime = bufferedTime;
+    if (underrun)
+        _statistics.underrunCount++;
+}
+
 void AudioController::streamingThreadProc(void* arg)
 {
     AudioController* controller = (AudioController*)arg;
 
+    std::unique_lock<std::mutex> lock(*controller->_streamingMutex);
     while (controller->_streamingThreadActive)
     {
-        controller->_streamingMutex->lock();
+        controller->_streamingPending = false;
+
+        // Refill the sources and find out when the first of them will have consumed a buffer.
+        float wait = STREAMING_MAX_WAIT;
+        std::set<AudioSource*>::iterator itr = controller->_streamingSources.begin();
+        for (; itr != controller->_streamingSources.end(); itr++)
+        {
+            float sourceWait = (*itr)->streamDataIfNeeded();
+            if (sourceWait >= 0.0f)
+                wait = std::min(wait, sourceWait);
+        }
+        wait = std::max(wait, STREAMING_MIN_WAIT);
+
+        {
+            std::lock_guard<std::mutex> statisticsLock(*controller->_statisticsMutex);
+            controller->_statistics.wakeCount++;
+        }
+
+        // Sleep until a buffer is consumed, blocks are decoded or the sources change.
+        controller->_streamingCondition->wait_for(lock, std::chrono::duration<float>(wait), [controller]()
+        {
+            return controller->_streamingPending.load() || !controller->_streamingThreadActive;
+        });
+    }
+}
+
+void AudioController::decodeThreadProc(void* arg)
+{
+    AudioController* controller = (AudioController*)arg;
+
+    std::unique_lock<std::mutex> lock(*controller->_decodeMutex);
+    while (true)
+    {
+        controller->_decodeCondition->wait(lock, [controller]()
+        {
+            return !controller->_decodeQueue.empty() || !controller->_decodeThreadActive;
+        });
+        if (!controller->_decodeThreadActive)
+            break;
 
-        std::for_each(controller->_streamingSources.begin(), controller->_streamingSources.end(), std::mem_fn(&AudioSource::streamDataIfNeeded));
-        
-        controller->_streamingMutex->unlock();
-   
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        AudioBuffer* buffer = controller->_decodeQueue.front();
+        controller->_decodeQueue.pop_front();
+        controller->_decodingBuffer = buffer;
+        lock.unlock();
+
+        buffer->decodeAhead();
+
+        lock.lock();
+        controller->_decodingBuffer = NULL;
+        controller->_decodeDone->notify_all();
     }
 }
 
+AudioController::StreamingStatistics::StreamingStatistics()
+    : underrunCount(0), decodedBlockCount(0), averageDecodeTime(0.0f), minBufferedTime(-1.0f), wakeCount(0)
+{
+}
+
+void AudioController::preload(const char* path)
+{
+    AudioBuffer::preload(path);
+}
+
+bool AudioController::isPreloading() const
+{
+    return AudioBuffer::isPreloading();
+}
+
 }
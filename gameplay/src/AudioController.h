@@ -4,6 +4,7 @@
 namespace gameplay
 {
 
+class AudioBuffer;
 class AudioListener;
 class AudioSource;
 
@@ -13,15 +14,69 @@ class AudioSource;
 class AudioController
 {
     friend class Game;
+    friend class AudioBuffer;
     friend class AudioSource;
 
 public:
+
+    /**
+     * Defines the statistics gathered while streaming audio sources.
+     */
+    struct StreamingStatistics
+    {
+        /**
+         * Constructor.
+         */
+        StreamingStatistics();
+
+        /** The number of times a streamed source ran out of queued data and stopped. */
+        unsigned int underrunCount;
+        /** The number of blocks decoded ahead of playback. */
+        unsigned int decodedBlockCount;
+        /** The average time taken to decode a block, in milliseconds. */
+        float averageDecodeTime;
+        /** The least audio buffered ahead of playback (queued and decoded) seen for a streamed source, in milliseconds (negative if none was seen). */
+        float minBufferedTime;
+        /** The number of times the streaming thread woke up. */
+        unsigned int wakeCount;
+    };
     
     /**
      * Destructor.
      */
     virtual ~AudioController();
 
+    /**
+     * Gets the statistics gathered while streaming since they were last reset.
+     *
+     * @return The streaming statistics.
+     */
+    StreamingStatistics getStreamingStatistics() const;
+
+    /**
+     * Resets the streaming statistics.
+     */
+    void resetStreamingStatistics();
+
+    /**
+     * Starts decoding a (non-streamed) audio file into the audio cache on the worker pool,
+     * so that creating an audio source from it later does not load it.
+     *
+     * The cache must have a budget, set by the "cacheSize" property (in kilobytes) of
+     * the "audio" namespace of the game config. Preloaded clips are evicted like any
+     * other unreferenced clip once the budget is exceeded.
+     *
+     * @param path The path to the audio file.
+     */
+    void preload(const char* path);
+
+    /**
+     * Gets whether audio files are being preloaded.
+     *
+     * @return true if audio files are being preloaded, false otherwise.
+     */
+    bool isPreloading() const;
+
 private:
     
     /**
@@ -58,8 +113,35 @@ private:
     
     void removePlayingSource(AudioSource* source);
 
+    /**
+     * Wakes the streaming thread up (called when the streamed sources change or blocks are decoded).
+     */
+    void notifyStreaming();
+
+    /**
+     * Records the time taken to decode a block.
+     */
+    void addDecodeTime(float time);
+
+    /**
+     * Records the state of a streamed source seen by the streaming thread.
+     */
+    void addStreamingState(float bufferedTime, bool underrun);
+
+    /**
+     * Queues a streamed buffer to be decoded ahead on the decode thread.
+     */
+    void queueDecode(AudioBuffer* buffer);
+
+    /**
+     * Removes a streamed buffer from the decode queue and waits for its decode in flight (if any) to complete.
+     */
+    void cancelDecode(AudioBuffer* buffer);
+
     static void streamingThreadProc(void* arg);
 
+    static void decodeThreadProc(void* arg);
+
     ALCdevice* _alcDevice;
     ALCcontext* _alcContext;
     std::set<AudioSource*> _playingSources;
@@ -69,6 +151,18 @@ private:
     bool _streamingThreadActive;
     std::unique_ptr<std::thread> _streamingThread;
     std::unique_ptr<std::mutex> _streamingMutex;
+    std::unique_ptr<std::condition_variable> _streamingCondition;
+    std::atomic<bool> _streamingPending;
+    bool _decodeThreadActive;
+    std::unique_ptr<std::thread> _decodeThread;
+    std::unique_ptr<std::mutex> _decodeMutex;
+    std::unique_ptr<std::condition_variable> _decodeCondition;
+    std::unique_ptr<std::condition_variable> _decodeDone;
+    std::deque<AudioBuffer*> _decodeQueue;
+    AudioBuffer* _decodingBuffer;
+    std::unique_ptr<std::mutex> _statisticsMutex;
+    StreamingStatistics _statistics;
+    float _decodeTime;
 };
 
 }
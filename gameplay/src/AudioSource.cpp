@@ -191,12 +191,13 @@ void AudioSource::resume()
 
 void AudioSource::stop()
 {
-    AL_CHECK( alSourceStop(_alSource) );
-
-    // Remove the source from the controller's set of currently playing sources.
+    // Remove the source from the controller's set of currently playing sources first, so the
+    // streaming thread cannot mistake the stop for an underrun and restart the source.
     AudioController* audioController = Game::getInstance()->getAudioController();
     GP_ASSERT(audioController);
     audioController->removePlayingSource(this);
+
+    AL_CHECK( alSourceStop(_alSource) );
 }
 
 void AudioSource::rewind()
@@ -217,6 +218,14 @@ void AudioSource::setLooped(bool looped)
         GP_ERROR("Failed to set audio source's looped attribute with error: %d", AL_LAST_ERROR());
     }
     _looped = looped;
+
+    // Streamed buffers wrap around to the start of the stream while decoding ahead.
+    if (isStreamed())
+    {
+        _buffer->_looped = looped;
+        if (looped)
+            _buffer->_endOfStream = false;
+    }
 }
 
 float AudioSource::getGain() const
@@ -322,43 +331,71 @@ AudioSource* AudioSource::clone(NodeCloneContext& context)
     return audioClone;
 }
 
-bool AudioSource::streamDataIfNeeded()
+float AudioSource::streamDataIfNeeded()
 {
     GP_ASSERT( isStreamed() );
-    if( getState() != PLAYING )
-        return false;
-
-    int queuedBuffers;
-    alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queuedBuffers);
- 
-    int buffersNeeded = std::min<int>(_buffer->_buffersNeededCount, AudioBuffer::STREAMING_BUFFER_QUEUE_SIZE);
-    if (queuedBuffers < buffersNeeded)
+
+    ALint state;
+    AL_CHECK( alGetSourcei(_alSource, AL_SOURCE_STATE, &state) );
+    if (state != AL_PLAYING && state != AL_STOPPED)
+        return -1.0f;
+
+    // Recycle the buffers that were played.
+    ALint processedBuffers;
+    AL_CHECK( alGetSourcei(_alSource, AL_BUFFERS_PROCESSED, &processedBuffers) );
+    while (processedBuffers-- > 0)
     {
-        while (queuedBuffers < buffersNeeded)
-        {
-            if (!_buffer->streamData(_buffer->_alBufferQueue[queuedBuffers], _looped))
-                return false;
-            
-            AL_CHECK( alSourceQueueBuffers(_alSource, 1, &_buffer->_alBufferQueue[queuedBuffers]) );
-            queuedBuffers++;
-        }
+        ALuint bufferID;
+        AL_CHECK( alSourceUnqueueBuffers(_alSource, 1, &bufferID) );
+        _buffer->_freeBuffers.push_back(bufferID);
     }
-    else
+
+    // Refill them with the blocks decoded ahead, and decode more in the background.
+    while (!_buffer->_freeBuffers.empty())
+    {
+        const AudioBuffer::StreamingBlock* block = _buffer->peekBlock();
+        if (!block)
+            break;
+
+        ALuint bufferID = _buffer->_freeBuffers.back();
+        AL_CHECK( alBufferData(bufferID, _buffer->_streamFormat, block->data, block->size, _buffer->_streamFrequency) );
+        AL_CHECK( alSourceQueueBuffers(_alSource, 1, &bufferID) );
+        _buffer->_freeBuffers.pop_back();
+        _buffer->popBlock();
+    }
+    _buffer->requestDecode();
+
+    ALint queuedBuffers;
+    ALint sampleOffset;
+    AL_CHECK( alGetSourcei(_alSource, AL_BUFFERS_QUEUED, &queuedBuffers) );
+    AL_CHECK( alGetSourcei(_alSource, AL_SAMPLE_OFFSET, &sampleOffset) );
+
+    AudioController* audioController = Game::getInstance()->getAudioController();
+    GP_ASSERT(audioController);
+    bool underrun = false;
+    if (state == AL_STOPPED)
     {
-        int processedBuffers;
-        alGetSourcei(_alSource, AL_BUFFERS_PROCESSED, &processedBuffers);
- 
-        while (processedBuffers-- > 0)
+        // The source stopped by itself: it either played the whole stream or ran out of data.
+        if (queuedBuffers == 0 && _buffer->isEndOfStream() && _buffer->getBlockCount() == 0)
+            return -1.0f;
+
+        // Restart it once it has data again (counting the underrun then, so it is only counted once).
+        if (queuedBuffers > 0)
         {
-            ALuint bufferID;
-            AL_CHECK( alSourceUnqueueBuffers(_alSource, 1, &bufferID) );
-            if (!_buffer->streamData(bufferID, _looped))
-                return false;
-            
-            AL_CHECK( alSourceQueueBuffers(_alSource, 1, &bufferID) );
+            AL_CHECK( alSourcePlay(_alSource) );
+            underrun = true;
         }
     }
-    return true;
+
+    // Blocks are full except for the last one of the stream, which is good enough for scheduling.
+    float samplesPerBlock = (float)(AudioBuffer::STREAMING_BUFFER_SIZE / _buffer->_streamFrameSize);
+    float frequency = (float)_buffer->_streamFrequency;
+    float bufferedSamples = (queuedBuffers + _buffer->getBlockCount()) * samplesPerBlock - sampleOffset;
+    audioController->addStreamingState(std::max(bufferedSamples, 0.0f) * 1000.0f / frequency, underrun);
+
+    if (queuedBuffers == 0)
+        return 0.0f;
+    return std::max(samplesPerBlock - (float)(sampleOffset % (ALint)samplesPerBlock), 0.0f) / frequency;
 }
 
 }
@@ -204,7 +204,14 @@ private:
      */
     AudioSource* clone(NodeCloneContext& context);
 
-    bool streamDataIfNeeded();
+    /**
+     * Unqueues the buffers the source has played, refills them from the decoded blocks of
+     * its buffer and restarts the source if it ran out of data (called by the streaming thread).
+     *
+     * @return The time until the source finishes playing its current buffer, in seconds,
+     *      or a negative value if the source does not need to be streamed.
+     */
+    float streamDataIfNeeded();
 
     ALuint _alSource;
     AudioBuffer* _buffer;
@@ -24,6 +24,7 @@
 #include <map>
 #include <unordered_map>
 #include <queue>
+#include <deque>
 #include <algorithm>
 #include <limits>
 #include <functional>
@@ -31,6 +32,8 @@
 #include <typeinfo>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
 #include <chrono>
 #include "Logger.h"
 
@@ -176,6 +179,14 @@ extern int strcmpnocase(const char* s1, const char* s2);
 #define M_1_PI                      0.31830988618379067154
 #endif
 
+// SIMD intrinsics for hand vectorized kernels
+#if defined(GP_USE_NEON)
+    #include <arm_neon.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+    #define GP_USE_SSE
+    #include <xmmintrin.h>
+#endif
+
 // NOMINMAX makes sure that windef.h doesn't add macros min and max
 #ifdef WIN32
     #define NOMINMAX
@@ -232,10 +243,14 @@ using std::va_list;
         #define GLEW_STATIC
         #include <GL/glew.h>
         #define GP_USE_VAO
+        #define GP_USE_UBO
+        #define GP_USE_PROGRAM_BINARY
 #elif __linux__
         #define GLEW_STATIC
         #include <GL/glew.h>
         #define GP_USE_VAO
+        #define GP_USE_UBO
+        #define GP_USE_PROGRAM_BINARY
 #elif __APPLE__
     #include "TargetConditionals.h"
     #if TARGET_OS_IPHONE || TARGET_IPHONE_SIMULATOR
@@ -0,0 +1,445 @@
+#include "Base.h"
+#include "BoundingVolumeTree.h"
+
+// Fraction of a leaf's extents that its box is enlarged by (so small moves don't change the tree)
+#define BVH_MARGIN_SCALE 0.1f
+
+// Minimum enlargement of a leaf's box, in world units
+#define BVH_MARGIN_MIN 0.05f
+
+namespace gameplay
+{
+
+static bool contains(const BoundingBox& outer, const BoundingBox& inner)
+{
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+static void merge(const BoundingBox& a, const BoundingBox& b, BoundingBox* dst)
+{
+    dst->min.set(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z));
+    dst->max.set(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z));
+}
+
+// Classifies a box against a frustum: -1 if outside, 1 if fully inside and 0 otherwise.
+static int classify(const Frustum& frustum, const BoundingBox& box)
+{
+    const Plane* planes[] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(), &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+    int result = 1;
+    for (unsigned int i = 0; i < 6; ++i)
+    {
+        float side = box.intersects(*planes[i]);
+        if (side == Plane::INTERSECTS_BACK)
+            return -1;
+        if (side == Plane::INTERSECTS_INTERSECTING)
+            result = 0;
+    }
+    return result;
+}
+
+BoundingVolumeTree::BoundingVolumeTree()
+    : _root(-1), _freeList(-1)
+{
+}
+
+BoundingVolumeTree::~BoundingVolumeTree()
+{
+}
+
+int BoundingVolumeTree::insert(Node* node, const BoundingSphere& sphere)
+{
+    GP_ASSERT(node);
+
+    int leaf = allocateNode();
+    TreeNode& n = _nodes[leaf];
+    n.node = node;
+    n.sphere = sphere;
+    n.height = 0;
+    BoundingBox box;
+    box.set(sphere);
+
+    // Enlarge the box so small movements can be absorbed by update().
+    Vector3 margin(box.max.x - box.min.x, box.max.y - box.min.y, box.max.z - box.min.z);
+    margin.x = std::max(margin.x * BVH_MARGIN_SCALE, BVH_MARGIN_MIN);
+    margin.y = std::max(margin.y * BVH_MARGIN_SCALE, BVH_MARGIN_MIN);
+    margin.z = std::max(margin.z * BVH_MARGIN_SCALE, BVH_MARGIN_MIN);
+    n.box.min.set(box.min.x - margin.x, box.min.y - margin.y, box.min.z - margin.z);
+    n.box.max.set(box.max.x + margin.x, box.max.y + margin.y, box.max.z + margin.z);
+
+    insertLeaf(leaf);
+    return leaf;
+}
+
+void BoundingVolumeTree::remove(int proxy)
+{
+    GP_ASSERT(proxy >= 0 && proxy < (int)_nodes.size());
+    GP_ASSERT(_nodes[proxy].height == 0);
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+}
+
+bool BoundingVolumeTree::update(int proxy, const BoundingSphere& sphere)
+{
+    GP_ASSERT(proxy >= 0 && proxy < (int)_nodes.size());
+    GP_ASSERT(_nodes[proxy].height == 0);
+
+    BoundingBox box;
+    box.set(sphere);
+    if (contains(_nodes[proxy].box, box))
+    {
+        _nodes[proxy].sphere = sphere;
+        return false;
+    }
+
+    Node* node = _nodes[proxy].node;
+    removeLeaf(proxy);
+    freeNode(proxy);
+
+    // Free nodes are reused last-in first-out, so the proxy is preserved.
+    int leaf = insert(node, sphere);
+    GP_ASSERT(leaf == proxy);
+    (void)leaf;
+    return true;
+}
+
+void BoundingVolumeTree::clear()
+{
+    _nodes.clear();
+    _root = -1;
+    _freeList = -1;
+}
+
+void BoundingVolumeTree::query(const Frustum& frustum, std::vector<Node*>& nodes) const
+{
+    if (_root < 0)
+        return;
+
+    _stack.clear();
+    _stack.push_back(_root);
+    while (!_stack.empty())
+    {
+        int index = _stack.back();
+        _stack.pop_back();
+        const TreeNode& n = _nodes[index];
+
+        int side = classify(frustum, n.box);
+        if (side < 0)
+            continue;
+        if (n.height == 0)
+        {
+            if (side > 0 || n.sphere.intersects(frustum))
+                nodes.push_back(n.node);
+            continue;
+        }
+        if (side > 0)
+        {
+            // Everything below a box inside the frustum is visible without further tests.
+            appendLeaves(index, nodes);
+            continue;
+        }
+        _stack.push_back(n.child1);
+        _stack.push_back(n.child2);
+    }
+}
+
+void BoundingVolumeTree::query(const BoundingBox& box, std::vector<Node*>& nodes) const
+{
+    if (_root < 0)
+        return;
+
+    _stack.clear();
+    _stack.push_back(_root);
+    while (!_stack.empty())
+    {
+        const TreeNode& n = _nodes[_stack.back()];
+        _stack.pop_back();
+        if (!n.box.intersects(box))
+            continue;
+        if (n.height == 0)
+        {
+            if (n.sphere.intersects(box))
+                nodes.push_back(n.node);
+            continue;
+        }
+        _stack.push_back(n.child1);
+        _stack.push_back(n.child2);
+    }
+}
+
+void BoundingVolumeTree::query(const BoundingSphere& sphere, std::vector<Node*>& nodes) const
+{
+    if (_root < 0)
+        return;
+
+    _stack.clear();
+    _stack.push_back(_root);
+    while (!_stack.empty())
+    {
+        const TreeNode& n = _nodes[_stack.back()];
+        _stack.pop_back();
+        if (!n.box.intersects(sphere))
+            continue;
+        if (n.height == 0)
+        {
+            if (n.sphere.intersects(sphere))
+                nodes.push_back(n.node);
+            continue;
+        }
+        _stack.push_back(n.child1);
+        _stack.push_back(n.child2);
+    }
+}
+
+void BoundingVolumeTree::query(const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits) const
+{
+    if (_root < 0)
+        return;
+
+    _stack.clear();
+    _stack.push_back(_root);
+    while (!_stack.empty())
+    {
+        const TreeNode& n = _nodes[_stack.back()];
+        _stack.pop_back();
+        float distance = n.box.intersects(ray);
+        if (distance == Ray::INTERSECTS_NONE || distance > maxDistance)
+            continue;
+        if (n.height == 0)
+        {
+            distance = n.sphere.intersects(ray);
+            if (distance != Ray::INTERSECTS_NONE && distance <= maxDistance)
+                hits.push_back(std::make_pair(distance, n.node));
+            continue;
+        }
+        _stack.push_back(n.child1);
+        _stack.push_back(n.child2);
+    }
+}
+
+int BoundingVolumeTree::allocateNode()
+{
+    int index;
+    if (_freeList >= 0)
+    {
+        index = _freeList;
+        _freeList = _nodes[index].parent;
+    }
+    else
+    {
+        index = (int)_nodes.size();
+        _nodes.push_back(TreeNode());
+    }
+
+    TreeNode& n = _nodes[index];
+    n.node = NULL;
+    n.parent = -1;
+    n.child1 = -1;
+    n.child2 = -1;
+    n.height = 0;
+    return index;
+}
+
+void BoundingVolumeTree::freeNode(int index)
+{
+    TreeNode& n = _nodes[index];
+    n.node = NULL;
+    n.height = -1;
+    n.parent = _freeList;
+    _freeList = index;
+}
+
+void BoundingVolumeTree::insertLeaf(int leaf)
+{
+    if (_root < 0)
+    {
+        _root = leaf;
+        _nodes[leaf].parent = -1;
+        return;
+    }
+
+    // Descend to the sibling that minimizes the increase in total surface area.
+    const BoundingBox leafBox = _nodes[leaf].box;
+    BoundingBox combined;
+    int index = _root;
+    while (_nodes[index].height > 0)
+    {
+        const TreeNode& n = _nodes[index];
+        float area = getSurfaceArea(n.box);
+        merge(n.box, leafBox, &combined);
+        float combinedArea = getSurfaceArea(combined);
+
+        // Cost of making a new parent for this node and the leaf, and the
+        // minimum cost inherited by pushing the leaf further down.
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        float childCosts[2];
+        int children[2] = { n.child1, n.child2 };
+        for (unsigned int i = 0; i < 2; ++i)
+        {
+            const TreeNode& child = _nodes[children[i]];
+            merge(child.box, leafBox, &combined);
+            childCosts[i] = getSurfaceArea(combined) + inheritanceCost;
+            if (child.height > 0)
+                childCosts[i] -= getSurfaceArea(child.box);
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+        index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+    }
+    int sibling = index;
+
+    // Create a new parent for the sibling and the leaf.
+    int oldParent = _nodes[sibling].parent;
+    int newParent = allocateNode();
+    TreeNode& parent = _nodes[newParent];
+    parent.parent = oldParent;
+    merge(leafBox, _nodes[sibling].box, &parent.box);
+    parent.height = _nodes[sibling].height + 1;
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    _nodes[sibling].parent = newParent;
+    _nodes[leaf].parent = newParent;
+
+    if (oldParent >= 0)
+    {
+        if (_nodes[oldParent].child1 == sibling)
+            _nodes[oldParent].child1 = newParent;
+        else
+            _nodes[oldParent].child2 = newParent;
+    }
+    else
+    {
+        _root = newParent;
+    }
+
+    // Walk back up, refitting and rebalancing the ancestors.
+    index = _nodes[leaf].parent;
+    while (index >= 0)
+    {
+        index = balance(index);
+        TreeNode& n = _nodes[index];
+        merge(_nodes[n.child1].box, _nodes[n.child2].box, &n.box);
+        n.height = 1 + std::max(_nodes[n.child1].height, _nodes[n.child2].height);
+        index = n.parent;
+    }
+}
+
+void BoundingVolumeTree::removeLeaf(int leaf)
+{
+    if (leaf == _root)
+    {
+        _root = -1;
+        return;
+    }
+
+    // Replace the leaf's parent by its sibling.
+    int parent = _nodes[leaf].parent;
+    int grandParent = _nodes[parent].parent;
+    int sibling = _nodes[parent].child1 == leaf ? _nodes[parent].child2 : _nodes[parent].child1;
+
+    if (grandParent >= 0)
+    {
+        if (_nodes[grandParent].child1 == parent)
+            _nodes[grandParent].child1 = sibling;
+        else
+            _nodes[grandParent].child2 = sibling;
+        _nodes[sibling].parent = grandParent;
+        freeNode(parent);
+
+        int index = grandParent;
+        while (index >= 0)
+        {
+            index = balance(index);
+            TreeNode& n = _nodes[index];
+            merge(_nodes[n.child1].box, _nodes[n.child2].box, &n.box);
+            n.height = 1 + std::max(_nodes[n.child1].height, _nodes[n.child2].height);
+            index = n.parent;
+        }
+    }
+    else
+    {
+        _root = sibling;
+        _nodes[sibling].parent = -1;
+        freeNode(parent);
+    }
+}
+
+int BoundingVolumeTree::balance(int a)
+{
+    // Performs a left or right rotation if the subtree at a is imbalanced, returning its new root.
+    TreeNode& A = _nodes[a];
+    if (A.height < 2)
+        return a;
+
+    int b = A.child1;
+    int c = A.child2;
+    int balance = _nodes[c].height - _nodes[b].height;
+
+    if (balance > 1 || balance < -1)
+    {
+        // Rotate the taller child (up) up.
+        int up = balance > 1 ? c : b;
+        int other = balance > 1 ? b : c;
+        TreeNode& U = _nodes[up];
+        int f = U.child1;
+        int g = U.child2;
+
+        U.child1 = a;
+        U.parent = A.parent;
+        A.parent = up;
+        if (U.parent >= 0)
+        {
+            if (_nodes[U.parent].child1 == a)
+                _nodes[U.parent].child1 = up;
+            else
+                _nodes[U.parent].child2 = up;
+        }
+        else
+        {
+            _root = up;
+        }
+
+        // Keep the taller grandchild under up and move the other one under a.
+        int keep = _nodes[f].height > _nodes[g].height ? f : g;
+        int move = keep == f ? g : f;
+        U.child2 = keep;
+        if (balance > 1)
+            A.child2 = move;
+        else
+            A.child1 = move;
+        _nodes[move].parent = a;
+
+        merge(_nodes[other].box, _nodes[move].box, &A.box);
+        A.height = 1 + std::max(_nodes[other].height, _nodes[move].height);
+        merge(A.box, _nodes[keep].box, &U.box);
+        U.height = 1 + std::max(A.height, _nodes[keep].height);
+        return up;
+    }
+    return a;
+}
+
+void BoundingVolumeTree::appendLeaves(int index, std::vector<Node*>& nodes) const
+{
+    const TreeNode& n = _nodes[index];
+    if (n.height == 0)
+    {
+        nodes.push_back(n.node);
+        return;
+    }
+    appendLeaves(n.child1, nodes);
+    appendLeaves(n.child2, nodes);
+}
+
+float BoundingVolumeTree::getSurfaceArea(const BoundingBox& box)
+{
+    float x = box.max.x - box.min.x;
+    float y = box.max.y - box.min.y;
+    float z = box.max.z - box.min.z;
+    return 2.0f * (x * y + y * z + z * x);
+}
+
+}
@@ -0,0 +1,146 @@
+#ifndef BOUNDINGVOLUMETREE_H_
+#define BOUNDINGVOLUMETREE_H_
+
+#include "BoundingBox.h"
+#include "BoundingSphere.h"
+#include "Frustum.h"
+#include "Ray.h"
+
+namespace gameplay
+{
+
+class Node;
+
+/**
+ * Defines a dynamic bounding volume hierarchy of axis-aligned boxes used by a Scene
+ * to answer culling and overlap queries without visiting every node.
+ *
+ * Each leaf stores a box that is enlarged by a margin, so a node can move a little
+ * without the tree changing. Leaves are inserted next to the sibling that minimizes
+ * the growth of the tree's surface area and the tree is kept balanced by rotations.
+ *
+ * @script{ignore}
+ */
+class BoundingVolumeTree
+{
+    friend class Scene;
+
+private:
+
+    /**
+     * Defines a node (branch or leaf) of the tree.
+     */
+    struct TreeNode
+    {
+        /** The (enlarged) box containing this node's subtree. */
+        BoundingBox box;
+        /** The exact bounds of a leaf's scene node. */
+        BoundingSphere sphere;
+        /** The scene node of a leaf (NULL for branches). */
+        Node* node;
+        /** The parent index (or the next free index when this node is free). */
+        int parent;
+        /** The first child index (-1 for leaves). */
+        int child1;
+        /** The second child index (-1 for leaves). */
+        int child2;
+        /** The height of this node's subtree (0 for leaves, -1 when free). */
+        int height;
+    };
+
+    /**
+     * Constructor.
+     */
+    BoundingVolumeTree();
+
+    /**
+     * Destructor.
+     */
+    ~BoundingVolumeTree();
+
+    /**
+     * Hidden copy constructor.
+     */
+    BoundingVolumeTree(const BoundingVolumeTree&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    BoundingVolumeTree& operator=(const BoundingVolumeTree&);
+
+    /**
+     * Inserts a leaf for the given node.
+     *
+     * @param node The scene node.
+     * @param sphere The world space bounds of the node.
+     *
+     * @return The proxy identifying the leaf.
+     */
+    int insert(Node* node, const BoundingSphere& sphere);
+
+    /**
+     * Removes a leaf.
+     *
+     * @param proxy The proxy returned by insert().
+     */
+    void remove(int proxy);
+
+    /**
+     * Updates the bounds of a leaf, re-inserting it only when the box leaves its enlarged box.
+     *
+     * @param proxy The proxy returned by insert().
+     * @param sphere The new world space bounds of the node.
+     *
+     * @return true if the leaf was re-inserted, false otherwise.
+     */
+    bool update(int proxy, const BoundingSphere& sphere);
+
+    /**
+     * Removes all leaves.
+     */
+    void clear();
+
+    /**
+     * Appends the nodes whose bounds intersect the given frustum.
+     */
+    void query(const Frustum& frustum, std::vector<Node*>& nodes) const;
+
+    /**
+     * Appends the nodes whose bounds intersect the given box.
+     */
+    void query(const BoundingBox& box, std::vector<Node*>& nodes) const;
+
+    /**
+     * Appends the nodes whose bounds intersect the given sphere.
+     */
+    void query(const BoundingSphere& sphere, std::vector<Node*>& nodes) const;
+
+    /**
+     * Appends the nodes whose bounds are hit by the given ray within maxDistance,
+     * along with the distance at which each one is entered.
+     */
+    void query(const Ray& ray, float maxDistance, std::vector<std::pair<float, Node*> >& hits) const;
+
+    int allocateNode();
+
+    void freeNode(int index);
+
+    void insertLeaf(int leaf);
+
+    void removeLeaf(int leaf);
+
+    int balance(int index);
+
+    void appendLeaves(int index, std::vector<Node*>& nodes) const;
+
+    static float getSurfaceArea(const BoundingBox& box);
+
+    std::vector<TreeNode> _nodes;
+    int _root;
+    int _freeList;
+    mutable std::vector<int> _stack;
+};
+
+}
+
+#endif
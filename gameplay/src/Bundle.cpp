@@ -36,7 +36,7 @@ namespace gameplay
 static std::vector<Bundle*> __bundleCache;
 
 Bundle::Bundle(const char* path) :
-    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _trackedNodes(NULL)
+    _path(path), _referenceCount(0), _references(NULL), _stream(NULL), _data(NULL), _trackedNodes(NULL)
 {
 }
 
@@ -141,6 +141,64 @@ bool Bundle::readArray(unsigned int* length, std::vector<T>* values, unsigned in
     return true;
 }
 
+template <class T>
+bool Bundle::readArrayView(unsigned int* length, const T** values, std::vector<T>* storage)
+{
+    GP_ASSERT(length);
+    GP_ASSERT(values);
+    GP_ASSERT(storage);
+
+    if (!read(length))
+    {
+        GP_ERROR("Failed to read the length of an array of data (to be read in place).");
+        return false;
+    }
+    *values = NULL;
+    if (*length > 0)
+    {
+        *values = (const T*)readView(*length * sizeof(T), sizeof(T));
+        if (*values == NULL)
+        {
+            storage->resize(*length);
+            if (_stream->read(&(*storage)[0], sizeof(T), *length) != *length)
+            {
+                GP_ERROR("Failed to read an array of data from bundle (to be read in place).");
+                return false;
+            }
+            *values = &(*storage)[0];
+        }
+    }
+    return true;
+}
+
+bool Bundle::skipArray(unsigned int elementSize)
+{
+    unsigned int length;
+    if (!read(&length))
+    {
+        GP_ERROR("Failed to read the length of an array of data (to be skipped).");
+        return false;
+    }
+    return length == 0 || _stream->seek((long int)(length * elementSize), SEEK_CUR);
+}
+
+const unsigned char* Bundle::readView(size_t size, size_t alignment)
+{
+    if (_data == NULL)
+        return NULL;
+
+    // The format does not pad its arrays, so arrays the CPU reads in place must be checked
+    // for alignment and are copied out when unaligned. Data that is only uploaded to the
+    // GPU is requested with an alignment of 1 and is always used in place.
+    long int position = _stream->position();
+    const unsigned char* view = _data + position;
+    if (position < 0 || ((size_t)view & (alignment - 1)) != 0 || (size_t)position + size > _stream->length())
+        return NULL;
+
+    _stream->seek((long int)size, SEEK_CUR);
+    return view;
+}
+
 static std::string readString(Stream* stream)
 {
     GP_ASSERT(stream);
@@ -185,8 +243,8 @@ Bundle* Bundle::create(const char* path)
         }
     }
 
-    // Open the bundle.
-    Stream* stream = FileSystem::open(path);
+    // Open the bundle, mapping it into memory where possible so that large arrays can be used in place.
+    Stream* stream = FileSystem::open(path, FileSystem::READ | FileSystem::MAPPED);
     if (!stream)
     {
         GP_WARN("Failed to open file '%s'.", path);
@@ -249,6 +307,7 @@ Bundle* Bundle::create(const char* path)
     bundle->_referenceCount = refCount;
     bundle->_references = refs;
     bundle->_stream = stream;
+    bundle->_data = stream->getData();
 
     return bundle;
 }
@@ -1083,17 +1142,26 @@ MeshSkin* Bundle::readMeshSkin()
     if (jointsBindPosesCount > 0)
     {
         GP_ASSERT(jointCount * 16 == jointsBindPosesCount);
-        float m[16];
-        for (unsigned int i = 0; i < jointCount; i++)
+
+        // Read all bind pose matrices at once (in place when the bundle is mapped).
+        std::vector<float> storage;
+        const float* m = (const float*)readView(jointsBindPosesCount * sizeof(float), sizeof(float));
+        if (m == NULL)
         {
-            if (!readMatrix(m))
+            storage.resize(jointsBindPosesCount);
+            if (_stream->read(&storage[0], sizeof(float), jointsBindPosesCount) != jointsBindPosesCount)
             {
-                GP_ERROR("Failed to load joint bind pose matrix (for joint with index %d) in bundle '%s'.", i, _path.c_str());
+                GP_ERROR("Failed to load joint bind pose matrices in bundle '%s'.", _path.c_str());
                 SAFE_DELETE(meshSkin);
                 SAFE_DELETE(skinData);
                 return NULL;
             }
-            skinData->inverseBindPoseMatrices.push_back(m);
+            m = &storage[0];
+        }
+        skinData->inverseBindPoseMatrices.reserve(jointCount);
+        for (unsigned int i = 0; i < jointCount; i++)
+        {
+            skinData->inverseBindPoseMatrices.push_back(Matrix(m + i * 16));
         }
     }
 
@@ -1291,49 +1359,47 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
 {
     GP_ASSERT(id);
 
-    std::vector<unsigned int> keyTimes;
-    std::vector<float> values;
-    std::vector<float> tangentsIn;
-    std::vector<float> tangentsOut;
-    std::vector<unsigned int> interpolation;
+    // Key times and values are used in place when the bundle is memory mapped; the
+    // storage vectors only receive copies when it is not (or the data is unaligned).
+    const unsigned int* keyTimes;
+    const float* values;
+    std::vector<unsigned int> keyTimesStorage;
+    std::vector<float> valuesStorage;
 
     // Length of the arrays.
     unsigned int keyTimesCount;
     unsigned int valuesCount;
-    unsigned int tangentsInCount;
-    unsigned int tangentsOutCount;
-    unsigned int interpolationCount;
 
     // Read key times.
-    if (!readArray(&keyTimesCount, &keyTimes, sizeof(unsigned int)))
+    if (!readArrayView(&keyTimesCount, &keyTimes, &keyTimesStorage))
     {
         GP_ERROR("Failed to read key times for animation '%s'.", id);
         return NULL;
     }
 
     // Read key values.
-    if (!readArray(&valuesCount, &values))
+    if (!readArrayView(&valuesCount, &values, &valuesStorage))
     {
         GP_ERROR("Failed to read key values for animation '%s'.", id);
         return NULL;
     }
 
-    // Read in-tangents.
-    if (!readArray(&tangentsInCount, &tangentsIn))
+    // Skip in-tangents.
+    if (!skipArray(sizeof(float)))
     {
         GP_ERROR("Failed to read in tangents for animation '%s'.", id);
         return NULL;
     }
 
-    // Read out-tangents.
-    if (!readArray(&tangentsOutCount, &tangentsOut))
+    // Skip out-tangents.
+    if (!skipArray(sizeof(float)))
     {
         GP_ERROR("Failed to read out tangents for animation '%s'.", id);
         return NULL;
     }
 
-    // Read interpolations.
-    if (!readArray(&interpolationCount, &interpolation, sizeof(unsigned int)))
+    // Skip interpolations.
+    if (!skipArray(sizeof(unsigned int)))
     {
         GP_ERROR("Failed to read the interpolation values for animation '%s'.", id);
         return NULL;
@@ -1342,15 +1408,17 @@ Animation* Bundle::readAnimationChannelData(Animation* animation, const char* id
     if (targetAttribute > 0)
     {
         GP_ASSERT(target);
-        GP_ASSERT(keyTimes.size() > 0 && values.size() > 0);
+        GP_ASSERT(keyTimesCount > 0 && valuesCount > 0);
+
+        // The curves copy the keys, so the (read-only) mapped data is never written.
         if (animation == NULL)
         {
             // TODO: This code currently assumes LINEAR only.
-            animation = target->createAnimation(id, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR);
+            animation = target->createAnimation(id, targetAttribute, keyTimesCount, const_cast<unsigned int*>(keyTimes), const_cast<float*>(values), Curve::LINEAR);
         }
         else
         {
-            animation->createChannel(target, targetAttribute, keyTimesCount, &keyTimes[0], &values[0], Curve::LINEAR);
+            animation->createChannel(target, targetAttribute, keyTimesCount, const_cast<unsigned int*>(keyTimes), const_cast<float*>(values), Curve::LINEAR);
         }
     }
 
@@ -1396,7 +1464,7 @@ Mesh* Bundle::loadMesh(const char* id, const char* nodeId)
     if (mesh == NULL)
     {
         GP_ERROR("Failed to create mesh '%s'.", id);
-        SAFE_DELETE_ARRAY(meshData);
+        SAFE_DELETE(meshData);
         return NULL;
     }
 
@@ -1493,12 +1561,21 @@ Bundle::MeshData* Bundle::readMeshData()
 
     GP_ASSERT(meshData->vertexFormat.getVertexSize());
     meshData->vertexCount = vertexByteCount / meshData->vertexFormat.getVertexSize();
-    meshData->vertexData = new unsigned char[vertexByteCount];
-    if (_stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+    // Vertex and index data is uploaded to the GPU (or copied), so it is used in place even if unaligned.
+    if (const unsigned char* view = readView(vertexByteCount))
     {
-        GP_ERROR("Failed to load vertex data.");
-        SAFE_DELETE(meshData);
-        return NULL;
+        meshData->vertexData = const_cast<unsigned char*>(view);
+        meshData->vertexDataMapped = true;
+    }
+    else
+    {
+        meshData->vertexData = new unsigned char[vertexByteCount];
+        if (_stream->read(meshData->vertexData, 1, vertexByteCount) != vertexByteCount)
+        {
+            GP_ERROR("Failed to load vertex data.");
+            SAFE_DELETE(meshData);
+            return NULL;
+        }
     }
 
     // Read mesh bounds (bounding box and bounding sphere).
@@ -1566,21 +1643,42 @@ Bundle::MeshData* Bundle::readMeshData()
             break;
         default:
             GP_ERROR("Unsupported index format for mesh part with index %d.", i);
+            SAFE_DELETE(meshData);
             return NULL;
         }
 
         GP_ASSERT(indexSize);
         partData->indexCount = iByteCount / indexSize;
 
-        partData->indexData = new unsigned char[iByteCount];
-        if (_stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+        if (const unsigned char* view = readView(iByteCount))
         {
-            GP_ERROR("Failed to read index data for mesh part with index %d.", i);
-            SAFE_DELETE(meshData);
-            return NULL;
+            partData->indexData = const_cast<unsigned char*>(view);
+            partData->indexDataMapped = true;
+        }
+        else
+        {
+            partData->indexData = new unsigned char[iByteCount];
+            if (_stream->read(partData->indexData, 1, iByteCount) != iByteCount)
+            {
+                GP_ERROR("Failed to read index data for mesh part with index %d.", i);
+                SAFE_DELETE(meshData);
+                return NULL;
+            }
+        }
+        if (partData->indexDataMapped && meshData->mappedBundle == NULL)
+        {
+            meshData->mappedBundle = this;
+            addRef();
         }
     }
 
+    // Data that points into our mapping must keep us (and so the mapping) alive.
+    if (meshData->vertexDataMapped && meshData->mappedBundle == NULL)
+    {
+        meshData->mappedBundle = this;
+        addRef();
+    }
+
     return meshData;
 }
 
@@ -1871,28 +1969,33 @@ Bundle::Reference::~Reference()
 }
 
 Bundle::MeshPartData::MeshPartData() :
-		primitiveType(Mesh::TRIANGLES), indexFormat(Mesh::INDEX32), indexCount(0), indexData(NULL)
+		primitiveType(Mesh::TRIANGLES), indexFormat(Mesh::INDEX32), indexCount(0), indexData(NULL), indexDataMapped(false)
 {
 }
 
 Bundle::MeshPartData::~MeshPartData()
 {
-    SAFE_DELETE_ARRAY(indexData);
+    if (!indexDataMapped)
+        SAFE_DELETE_ARRAY(indexData);
 }
 
 Bundle::MeshData::MeshData(const VertexFormat& vertexFormat)
-    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL), primitiveType(Mesh::TRIANGLES)
+    : vertexFormat(vertexFormat), vertexCount(0), vertexData(NULL), primitiveType(Mesh::TRIANGLES),
+      vertexDataMapped(false), mappedBundle(NULL)
 {
 }
 
 Bundle::MeshData::~MeshData()
 {
-    SAFE_DELETE_ARRAY(vertexData);
+    if (!vertexDataMapped)
+        SAFE_DELETE_ARRAY(vertexData);
 
     for (unsigned int i = 0; i < parts.size(); ++i)
     {
         SAFE_DELETE(parts[i]);
     }
+
+    SAFE_RELEASE(mappedBundle);
 }
 
 }
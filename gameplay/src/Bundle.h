@@ -18,6 +18,7 @@ class Bundle : public Ref
 {
     friend class PhysicsController;
     friend class SceneLoader;
+    friend class Scene;
 
 public:
 
@@ -150,6 +151,8 @@ private:
         Mesh::IndexFormat indexFormat;
         unsigned int indexCount;
         unsigned char* indexData;
+        /** Whether indexData points into the memory mapped bundle (and is not owned). Mapped data may be unaligned. */
+        bool indexDataMapped;
     };
 
     struct MeshData
@@ -164,6 +167,10 @@ private:
         BoundingSphere boundingSphere;
         Mesh::PrimitiveType primitiveType;
         std::vector<MeshPartData*> parts;
+        /** Whether vertexData points into the memory mapped bundle (and is not owned). Mapped data may be unaligned. */
+        bool vertexDataMapped;
+        /** The bundle kept alive while any data points into its mapping (or NULL). */
+        Bundle* mappedBundle;
     };
 
     Bundle(const char* path);
@@ -315,6 +322,41 @@ private:
      */
     template <class T>
     bool readArray(unsigned int* length, std::vector<T>* values, unsigned int readSize);
+
+    /**
+     * Reads an array of values and the array length from the current file position,
+     * without copying the values when the bundle is memory mapped.
+     *
+     * @param length A pointer to where the length of the array will be copied to.
+     * @param values Set to the values, either within the mapped file or within storage.
+     * @param storage The vector the values are copied to if they cannot be used in place.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    template <class T>
+    bool readArrayView(unsigned int* length, const T** values, std::vector<T>* storage);
+
+    /**
+     * Skips an array of values (and its length) at the current file position.
+     *
+     * @param elementSize The size of each element in the array.
+     *
+     * @return True if successful, false if an error occurred.
+     */
+    bool skipArray(unsigned int elementSize);
+
+    /**
+     * Gets a pointer to the data at the current file position within the memory mapped
+     * bundle and moves past it.
+     *
+     * @param size The number of bytes to read.
+     * @param alignment The alignment the data must have to be used in place (1 for data
+     *      that is only copied or uploaded to the GPU, which has no alignment requirement).
+     *
+     * @return The data, or NULL if the bundle is not mapped or the data is not aligned
+     *      (in which case the file position is unchanged).
+     */
+    const unsigned char* readView(size_t size, size_t alignment = 1);
     
     /**
      * Reads 16 floats from the current file position.
@@ -456,6 +498,7 @@ private:
     unsigned int _referenceCount;
     Reference* _references;
     Stream* _stream;
+    const unsigned char* _data;
 
     std::vector<MeshSkinData*> _meshSkins;
     std::map<std::string, Node*>* _trackedNodes;
@@ -1,4 +1,4 @@
-// Purposely not including Base.h here, or any other gameplay dependencies, so it can be reused between gameplay and gameplay-encoder.
+#include "Base.h"
 #include "Curve.h"
 #include "Quaternion.h"
 #include <cassert>
@@ -30,6 +30,9 @@ using std::strcmp;
 #define MATH_PIX2 6.28318530717958647693f
 #endif
 
+// The number of curves whose segments are located before they are interpolated by a batch evaluation.
+#define CURVE_BATCH_SIZE 64
+
 // Object deletion macro
 #ifndef SAFE_DELETE
 #define SAFE_DELETE(x) \
@@ -80,6 +83,31 @@ static inline float lerpInl(float s, float from, float to)
     return from + (to - from) * s;
 }
 
+// Linearly interpolates count components, four at a time where SIMD is available.
+static inline void lerpValues(float s, const float* from, const float* to, float* dst, unsigned int count)
+{
+    unsigned int i = 0;
+#if defined(GP_USE_SSE)
+    __m128 vs = _mm_set1_ps(s);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 a = _mm_loadu_ps(from + i);
+        __m128 b = _mm_loadu_ps(to + i);
+        _mm_storeu_ps(dst + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), vs)));
+    }
+#elif defined(GP_USE_NEON)
+    float32x4_t vs = vdupq_n_f32(s);
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4_t a = vld1q_f32(from + i);
+        float32x4_t b = vld1q_f32(to + i);
+        vst1q_f32(dst + i, vaddq_f32(a, vmulq_f32(vsubq_f32(b, a), vs)));
+    }
+#endif
+    for (; i < count; i++)
+        dst[i] = lerpInl(s, from[i], to[i]);
+}
+
 namespace gameplay
 {
 
@@ -89,36 +117,36 @@ Curve* Curve::create(unsigned int pointCount, unsigned int componentCount)
 }
 
 Curve::Curve(unsigned int pointCount, unsigned int componentCount)
-    : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL), _points(NULL)
+    : _pointCount(pointCount), _componentCount(componentCount), _componentSize(sizeof(float)*componentCount), _quaternionOffset(NULL),
+      _times(NULL), _values(NULL), _inValues(NULL), _outValues(NULL), _types(NULL)
 {
-    _points = new Point[_pointCount];
+    // Point data is kept in contiguous arrays, one per attribute.
+    _times = new float[_pointCount];
+    _values = new float[_pointCount * _componentCount];
+    _inValues = new float[_pointCount * _componentCount];
+    _outValues = new float[_pointCount * _componentCount];
+    _types = new InterpolationType[_pointCount];
     for (unsigned int i = 0; i < _pointCount; i++)
     {
-        _points[i].time = 0.0f;
-        _points[i].value = new float[_componentCount];
-        _points[i].inValue = new float[_componentCount];
-        _points[i].outValue = new float[_componentCount];
-        _points[i].type = LINEAR;
+        _times[i] = 0.0f;
+        _types[i] = LINEAR;
     }
-    _points[_pointCount - 1].time = 1.0f;
+    _times[_pointCount - 1] = 1.0f;
 }
 
 Curve::~Curve()
 {
-    SAFE_DELETE_ARRAY(_points);
+    SAFE_DELETE_ARRAY(_times);
+    SAFE_DELETE_ARRAY(_values);
+    SAFE_DELETE_ARRAY(_inValues);
+    SAFE_DELETE_ARRAY(_outValues);
+    SAFE_DELETE_ARRAY(_types);
     SAFE_DELETE_ARRAY(_quaternionOffset);
 }
 
-Curve::Point::Point()
-    : time(0.0f), value(NULL), inValue(NULL), outValue(NULL), type(LINEAR)
-{
-}
-
-Curve::Point::~Point()
+Curve::Cursor::Cursor()
+    : _index(0), _min(0), _max(0), _startTime(-1.0f), _endTime(-1.0f)
 {
-    SAFE_DELETE_ARRAY(value);
-    SAFE_DELETE_ARRAY(inValue);
-    SAFE_DELETE_ARRAY(outValue);
 }
 
 unsigned int Curve::getPointCount() const
@@ -133,25 +161,25 @@ unsigned int Curve::getComponentCount() const
 
 float Curve::getStartTime() const
 {
-    return _points[0].time;
+    return _times[0];
 }
 
 float Curve::getEndTime() const
 {
-    return _points[_pointCount-1].time;
+    return _times[_pointCount-1];
 }
 
 float Curve::getPointTime(unsigned int index) const
 {
     assert(index < _pointCount);
-    return _points[index].time;
+    return _times[index];
 }
 
 
 Curve::InterpolationType Curve::getPointInterpolation(unsigned int index) const
 {
     assert(index < _pointCount);
-    return _points[index].type;;
+    return _types[index];
 }
 
 void Curve::getPointValues(unsigned int index, float* value, float* inValue, float* outValue) const
@@ -159,13 +187,13 @@ void Curve::getPointValues(unsigned int index, float* value, float* inValue, flo
     assert(index < _pointCount);
     
     if (value)
-        memcpy(value, _points[index].value, _componentSize);
+        memcpy(value, _values + index * _componentCount, _componentSize);
     
     if (inValue)
-        memcpy(inValue, _points[index].inValue, _componentSize);
+        memcpy(inValue, _inValues + index * _componentCount, _componentSize);
     
     if (outValue)
-        memcpy(outValue, _points[index].outValue, _componentSize);
+        memcpy(outValue, _outValues + index * _componentCount, _componentSize);
 }
 
 void Curve::setPoint(unsigned int index, float time, float* value, InterpolationType type)
@@ -177,30 +205,30 @@ void Curve::setPoint(unsigned int index, float time, float* value, Interpolation
 {
     assert(index < _pointCount && time >= 0.0f && time <= 1.0f && !(_pointCount > 1 && index == 0 && time != 0.0f) && !(_pointCount != 1 && index == _pointCount - 1 && time != 1.0f));
 
-    _points[index].time = time;
-    _points[index].type = type;
+    _times[index] = time;
+    _types[index] = type;
 
     if (value)
-        memcpy(_points[index].value, value, _componentSize);
+        memcpy(_values + index * _componentCount, value, _componentSize);
 
     if (inValue)
-        memcpy(_points[index].inValue, inValue, _componentSize);
+        memcpy(_inValues + index * _componentCount, inValue, _componentSize);
 
     if (outValue)
-        memcpy(_points[index].outValue, outValue, _componentSize);
+        memcpy(_outValues + index * _componentCount, outValue, _componentSize);
 }
 
 void Curve::setTangent(unsigned int index, InterpolationType type, float* inValue, float* outValue)
 {
     assert(index < _pointCount);
 
-    _points[index].type = type;
+    _types[index] = type;
 
     if (inValue)
-        memcpy(_points[index].inValue, inValue, _componentSize);
+        memcpy(_inValues + index * _componentCount, inValue, _componentSize);
 
     if (outValue)
-        memcpy(_points[index].outValue, outValue, _componentSize);
+        memcpy(_outValues + index * _componentCount, outValue, _componentSize);
 }
 
 void Curve::evaluate(float time, float* dst) const
@@ -211,14 +239,79 @@ void Curve::evaluate(float time, float* dst) const
 }
 
 void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const
+{
+    evaluate(time, startTime, endTime, loopBlendTime, dst, NULL);
+}
+
+void Curve::evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor* cursor) const
+{
+    unsigned int from;
+    unsigned int to;
+    float t;
+    if (evaluateSegment(time, startTime, endTime, loopBlendTime, dst, cursor, &from, &to, &t))
+        interpolateLinear(t, from, to, dst);
+}
+
+void Curve::evaluate(unsigned int count, Curve* const* curves, float time, float startTime, float endTime, float loopBlendTime, float* const* dst, Cursor* cursors)
+{
+    assert(count == 0 || (curves && dst));
+
+    // The linear segments located in the current block of curves.
+    const Curve* linearCurves[CURVE_BATCH_SIZE];
+    unsigned int linearFrom[CURVE_BATCH_SIZE];
+    unsigned int linearTo[CURVE_BATCH_SIZE];
+    float linearTime[CURVE_BATCH_SIZE];
+    float* linearDst[CURVE_BATCH_SIZE];
+
+    for (unsigned int first = 0; first < count; first += CURVE_BATCH_SIZE)
+    {
+        unsigned int last = count - first < CURVE_BATCH_SIZE ? count : first + CURVE_BATCH_SIZE;
+        unsigned int linearCount = 0;
+
+        // Locate the segment of every curve, evaluating those that don't interpolate linearly.
+        for (unsigned int i = first; i < last; i++)
+        {
+            const Curve* curve = curves[i];
+            assert(curve);
+            if (curve->evaluateSegment(time, startTime, endTime, loopBlendTime, dst[i], cursors ? &cursors[i] : NULL,
+                                       &linearFrom[linearCount], &linearTo[linearCount], &linearTime[linearCount]))
+            {
+                linearCurves[linearCount] = curve;
+                linearDst[linearCount] = dst[i];
+                linearCount++;
+            }
+        }
+
+        // Blend every component of the linear segments, then slerp over their quaternions.
+        for (unsigned int i = 0; i < linearCount; i++)
+        {
+            const Curve* curve = linearCurves[i];
+            lerpValues(linearTime[i], curve->_values + linearFrom[i] * curve->_componentCount, curve->_values + linearTo[i] * curve->_componentCount,
+                       linearDst[i], curve->_componentCount);
+        }
+        for (unsigned int i = 0; i < linearCount; i++)
+        {
+            const Curve* curve = linearCurves[i];
+            if (curve->_quaternionOffset)
+            {
+                unsigned int offset = *curve->_quaternionOffset;
+                curve->interpolateQuaternion(linearTime[i], curve->_values + linearFrom[i] * curve->_componentCount + offset,
+                                             curve->_values + linearTo[i] * curve->_componentCount + offset, linearDst[i] + offset);
+            }
+        }
+    }
+}
+
+bool Curve::evaluateSegment(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor* cursor,
+                            unsigned int* fromIndex, unsigned int* toIndex, float* linearTime) const
 {
     assert(dst && startTime >= 0.0f && startTime <= endTime && endTime <= 1.0f && loopBlendTime >= 0.0f);
 
     // If there's only one point on the curve, return its value.
     if (_pointCount == 1)
     {
-        memcpy(dst, _points[0].value, _componentSize);
-        return;
+        memcpy(dst, _values, _componentSize);
+        return false;
     }
 
     unsigned int min = 0;
@@ -227,91 +320,109 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
     if (startTime > 0.0f || endTime < 1.0f)
     {
         // Evaluating a sub section of the curve
-        min = determineIndex(startTime, 0, max);
-        max = determineIndex(endTime, min, max);
+        if (cursor && cursor->_startTime == startTime && cursor->_endTime == endTime)
+        {
+            min = cursor->_min;
+            max = cursor->_max;
+        }
+        else
+        {
+            min = determineIndex(startTime, 0, max);
+            max = determineIndex(endTime, min, max);
+            if (cursor)
+            {
+                cursor->_min = min;
+                cursor->_max = max;
+                cursor->_startTime = startTime;
+                cursor->_endTime = endTime;
+            }
+        }
 
         // Convert time to fall within the subregion
-        localTime = _points[min].time + (_points[max].time - _points[min].time) * time;
+        localTime = _times[min] + (_times[max] - _times[min]) * time;
     }
 
     if (loopBlendTime == 0.0f)
     {
         // If no loop blend time is specified, clamp time to end points
-        if (localTime < _points[min].time)
-            localTime = _points[min].time;
-        else if (localTime > _points[max].time)
-            localTime = _points[max].time;
+        if (localTime < _times[min])
+            localTime = _times[min];
+        else if (localTime > _times[max])
+            localTime = _times[max];
     }
 
     // If an exact endpoint was specified, skip interpolation and return the value directly
-    if (localTime == _points[min].time)
+    if (localTime == _times[min])
     {
-        memcpy(dst, _points[min].value, _componentSize);
-        return;
+        memcpy(dst, _values + min * _componentCount, _componentSize);
+        return false;
     }
-    if (localTime == _points[max].time)
+    if (localTime == _times[max])
     {
-        memcpy(dst, _points[max].value, _componentSize);
-        return;
+        memcpy(dst, _values + max * _componentCount, _componentSize);
+        return false;
     }
 
-    Point* from;
-    Point* to;
+    unsigned int from;
+    unsigned int to;
     float scale;
     float t;
     unsigned int index;
 
-    if (localTime > _points[max].time)
+    if (localTime > _times[max])
     {
         // Looping forward
         index = max;
-        from = &_points[max];
-        to = &_points[min];
+        from = max;
+        to = min;
 
         // Calculate the fractional time between the two points.
-        t = (localTime - from->time) / loopBlendTime;
+        t = (localTime - _times[from]) / loopBlendTime;
     }
-    else if (localTime < _points[min].time)
+    else if (localTime < _times[min])
     {
         // Looping in reverse
         index = min;
-        from = &_points[min];
-        to = &_points[max];
+        from = min;
+        to = max;
 
         // Calculate the fractional time between the two points.
-        t = (from->time - localTime) / loopBlendTime;
+        t = (_times[from] - localTime) / loopBlendTime;
     }
     else
     {
-        // Locate the points we are interpolating between using a binary search.
-        index = determineIndex(localTime, min, max);
-        from = &_points[index];
-        to = &_points[index == max ? index : index+1];
+        // Locate the points we are interpolating between, starting from the cached segment.
+        index = determineIndex(localTime, min, max, cursor);
+        from = index;
+        to = index == max ? index : index+1;
 
         // Calculate the fractional time between the two points.
-        scale = (to->time - from->time);
-        t = (localTime - from->time) / scale;
+        scale = (_times[to] - _times[from]);
+        t = (localTime - _times[from]) / scale;
     }
 
+    *fromIndex = from;
+    *toIndex = to;
+
     // Calculate the value of the curve discretely if appropriate.
-    switch (from->type)
+    switch (_types[from])
     {
         case BEZIER:
         {
             interpolateBezier(t, from, to, dst);
-            return;
+            return false;
         }
         case BSPLINE:
         {
-            Point* c0;
-            Point* c1;
+            unsigned int c0;
+            unsigned int c1;
             if (index == 0)
             {
                 c0 = from;
             }
             else
             {
-                c0 = (_points + index - 1);
+                c0 = index - 1;
             }
             
             if (index == _pointCount - 2)
@@ -320,20 +431,20 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
             }
             else
             {
-                c1 = (_points + index + 2);
+                c1 = index + 2;
             }
             interpolateBSpline(t, c0, from, to, c1, dst);
-            return;
+            return false;
         }
         case FLAT:
         {
             interpolateHermiteFlat(t, from, to, dst);
-            return;
+            return false;
         }
         case HERMITE:
         {
             interpolateHermite(t, from, to, dst);
-            return;
+            return false;
         }
         case LINEAR:
         {
@@ -343,12 +454,12 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
         case SMOOTH:
         {
             interpolateHermiteSmooth(t, index, from, to, dst);
-            return;
+            return false;
         }
         case STEP:
         {
-            memcpy(dst, from->value, _componentSize);
-            return;
+            memcpy(dst, _values + from * _componentCount, _componentSize);
+            return false;
         }
         case QUADRATIC_IN:
         {
@@ -825,7 +936,8 @@ void Curve::evaluate(float time, float startTime, float endTime, float loopBlend
         }
     }
 
-    interpolateLinear(t, from, to, dst);
+    *linearTime = t;
+    return true;
 }
 
 float Curve::lerp(float t, float from, float to)
@@ -843,7 +955,7 @@ void Curve::setQuaternionOffset(unsigned int offset)
     *_quaternionOffset = offset;
 }
 
-void Curve::interpolateBezier(float s, Point* from, Point* to, float* dst) const
+void Curve::interpolateBezier(float s, unsigned int from, unsigned int to, float* dst) const
 {
     float s_2 = s * s;
     float eq0 = 1 - s;
@@ -853,10 +965,10 @@ void Curve::interpolateBezier(float s, Point* from, Point* to, float* dst) const
     float eq3 = 3 * s_2 * eq0;
     float eq4 = s_2 * s;
 
-    float* fromValue = from->value;
-    float* toValue = to->value;
-    float* outValue = from->outValue;
-    float* inValue = to->inValue;
+    const float* fromValue = _values + from * _componentCount;
+    const float* toValue = _values + to * _componentCount;
+    const float* outValue = _outValues + from * _componentCount;
+    const float* inValue = _inValues + to * _componentCount;
 
 
     if (!_quaternionOffset)
@@ -883,7 +995,7 @@ void Curve::interpolateBezier(float s, Point* from, Point* to, float* dst) const
         }
 
         // Handle quaternion component.
-        float interpTime = bezier(eq1, eq2, eq3, eq4, from->time, outValue[i], to->time, inValue[i]);
+        float interpTime = bezier(eq1, eq2, eq3, eq4, _times[from], outValue[i], _times[to], inValue[i]);
         interpolateQuaternion(interpTime, (fromValue + i), (toValue + i), (dst + i));
         
         // Handle remaining components (if any) as scalars
@@ -897,7 +1009,7 @@ void Curve::interpolateBezier(float s, Point* from, Point* to, float* dst) const
     }
 }
 
-void Curve::interpolateBSpline(float s, Point* c0, Point* c1, Point* c2, Point* c3, float* dst) const
+void Curve::interpolateBSpline(float s, unsigned int c0, unsigned int c1, unsigned int c2, unsigned int c3, float* dst) const
 {   
     float s_2 = s * s;
     float s_3 = s_2 * s;
@@ -906,10 +1018,10 @@ void Curve::interpolateBSpline(float s, Point* c0, Point* c1, Point* c2, Point*
     float eq2 = (-3 * s_3 + 3 * s_2 + 3 * s + 1) / 6.0f;
     float eq3 = s_3 / 6.0f;
 
-    float* c0Value = c0->value;
-    float* c1Value = c1->value;
-    float* c2Value = c2->value;
-    float* c3Value = c3->value;
+    const float* c0Value = _values + c0 * _componentCount;
+    const float* c1Value = _values + c1 * _componentCount;
+    const float* c2Value = _values + c2 * _componentCount;
+    const float* c3Value = _values + c3 * _componentCount;
 
     if (!_quaternionOffset)
     {
@@ -936,12 +1048,12 @@ void Curve::interpolateBSpline(float s, Point* c0, Point* c1, Point* c2, Point*
 
         // Handle quaternion component.
         float interpTime;
-        if (c0->time == c1->time)
-            interpTime = bspline(eq0, eq1, eq2, eq3, -c0->time, c1->time, c2->time, c3->time);
-        else if (c2->time == c3->time)
-            interpTime = bspline(eq0, eq1, eq2, eq3, c0->time, c1->time, c2->time, -c3->time); 
+        if (_times[c0] == _times[c1])
+            interpTime = bspline(eq0, eq1, eq2, eq3, -_times[c0], _times[c1], _times[c2], _times[c3]);
+        else if (_times[c2] == _times[c3])
+            interpTime = bspline(eq0, eq1, eq2, eq3, _times[c0], _times[c1], _times[c2], -_times[c3]); 
         else
-            interpTime = bspline(eq0, eq1, eq2, eq3, c0->time, c1->time, c2->time, c3->time);
+            interpTime = bspline(eq0, eq1, eq2, eq3, _times[c0], _times[c1], _times[c2], _times[c3]);
         interpolateQuaternion(s, (c1Value + i) , (c2Value + i), (dst + i));
             
         // Handle remaining components (if any) as scalars
@@ -955,7 +1067,7 @@ void Curve::interpolateBSpline(float s, Point* c0, Point* c1, Point* c2, Point*
     }
 }
 
-void Curve::interpolateHermite(float s, Point* from, Point* to, float* dst) const
+void Curve::interpolateHermite(float s, unsigned int from, unsigned int to, float* dst) const
 {
     // Calculate the hermite basis functions.
     float s_2 = s * s;                   // t^2
@@ -965,10 +1077,10 @@ void Curve::interpolateHermite(float s, Point* from, Point* to, float* dst) cons
     float h10 = s_3 - 2 * s_2 + s;       // basis function 2
     float h11 = s_3 - s_2;               // basis function 3
 
-    float* fromValue = from->value;
-    float* toValue = to->value;
-    float* outValue = from->outValue;
-    float* inValue = to->inValue;
+    const float* fromValue = _values + from * _componentCount;
+    const float* toValue = _values + to * _componentCount;
+    const float* outValue = _outValues + from * _componentCount;
+    const float* inValue = _inValues + to * _componentCount;
 
     if (!_quaternionOffset)
     {
@@ -994,7 +1106,7 @@ void Curve::interpolateHermite(float s, Point* from, Point* to, float* dst) cons
         }
 
         // Handle quaternion component.
-        float interpTime = hermite(h00, h01, h10, h11, from->time, outValue[i], to->time, inValue[i]);
+        float interpTime = hermite(h00, h01, h10, h11, _times[from], outValue[i], _times[to], inValue[i]);
         interpolateQuaternion(interpTime, (fromValue + i), (toValue + i), (dst + i));
         
         // Handle remaining components (if any) as scalars
@@ -1008,7 +1120,7 @@ void Curve::interpolateHermite(float s, Point* from, Point* to, float* dst) cons
     }
 }
 
-void Curve::interpolateHermiteFlat(float s, Point* from, Point* to, float* dst) const
+void Curve::interpolateHermiteFlat(float s, unsigned int from, unsigned int to, float* dst) const
 {
     // Calculate the hermite basis functions.
     float s_2 = s * s;                   // t^2
@@ -1016,8 +1128,8 @@ void Curve::interpolateHermiteFlat(float s, Point* from, Point* to, float* dst)
     float h00 = 2 * s_3 - 3 * s_2 + 1;   // basis function 0
     float h01 = -2 * s_3 + 3 * s_2;      // basis function 1
 
-    float* fromValue = from->value;
-    float* toValue = to->value;
+    const float* fromValue = _values + from * _componentCount;
+    const float* toValue = _values + to * _componentCount;
 
     if (!_quaternionOffset)
     {
@@ -1043,7 +1155,7 @@ void Curve::interpolateHermiteFlat(float s, Point* from, Point* to, float* dst)
         }
 
         // Handle quaternion component.
-        float interpTime = hermiteFlat(h00, h01, from->time, to->time);
+        float interpTime = hermiteFlat(h00, h01, _times[from], _times[to]);
         interpolateQuaternion(interpTime, (fromValue + i), (toValue + i), (dst + i));
         
         // Handle remaining components (if any) as scalars
@@ -1057,7 +1169,7 @@ void Curve::interpolateHermiteFlat(float s, Point* from, Point* to, float* dst)
     }
 }
 
-void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, Point* to, float* dst) const
+void Curve::interpolateHermiteSmooth(float s, unsigned int index, unsigned int from, unsigned int to, float* dst) const
 {
     // Calculate the hermite basis functions.
     float s_2 = s * s;                   // t^2
@@ -1070,8 +1182,8 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
     float inValue;
     float outValue;
 
-    float* fromValue = from->value;
-    float* toValue = to->value;
+    const float* fromValue = _values + from * _componentCount;
+    const float* toValue = _values + to * _componentCount;
 
     if (!_quaternionOffset)
     {
@@ -1089,7 +1201,7 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
                 }
                 else
                 {
-                    outValue = (toValue[i] - (from - 1)->value[i]) * ((from->time - (from - 1)->time) / (to->time - (from - 1)->time));
+                    outValue = (toValue[i] - _values[(from - 1) * _componentCount + i]) * ((_times[from] - _times[from - 1]) / (_times[to] - _times[from - 1]));
                 }
 
                 if (index == _pointCount - 2)
@@ -1098,7 +1210,7 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
                 }
                 else
                 {
-                    inValue = ((to + 1)->value[i] - fromValue[i]) * ((to->time - from->time) / ((to + 1)->time - from->time));
+                    inValue = (_values[(to + 1) * _componentCount + i] - fromValue[i]) * ((_times[to] - _times[from]) / (_times[to + 1] - _times[from]));
                 }
 
                 dst[i] = hermiteSmooth(h00, h01, h10, h11, fromValue[i], outValue, toValue[i], inValue);
@@ -1124,7 +1236,7 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
                 }
                 else
                 {
-                    outValue = (toValue[i] - (from - 1)->value[i]) * ((from->time - (from - 1)->time) / (to->time - (from - 1)->time));
+                    outValue = (toValue[i] - _values[(from - 1) * _componentCount + i]) * ((_times[from] - _times[from - 1]) / (_times[to] - _times[from - 1]));
                 }
 
                 if (index == _pointCount - 2)
@@ -1133,7 +1245,7 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
                 }
                 else
                 {
-                    inValue = ((to + 1)->value[i] - fromValue[i]) * ((to->time - from->time) / ((to + 1)->time - from->time));
+                    inValue = (_values[(to + 1) * _componentCount + i] - fromValue[i]) * ((_times[to] - _times[from]) / (_times[to + 1] - _times[from]));
                 }
 
                 dst[i] = hermiteSmooth(h00, h01, h10, h11, fromValue[i], outValue, toValue[i], inValue);
@@ -1143,23 +1255,23 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
         // Handle quaternion component.
         if (index == 0)
         {
-            outValue = to->time - from->time;
+            outValue = _times[to] - _times[from];
         }
         else
         {
-            outValue = (to->time - (from - 1)->time) * ((from->time - (from - 1)->time) / (to->time - (from - 1)->time));
+            outValue = (_times[to] - _times[from - 1]) * ((_times[from] - _times[from - 1]) / (_times[to] - _times[from - 1]));
         }
 
         if (index == _pointCount - 2)
         {
-            inValue = to->time - from->time;
+            inValue = _times[to] - _times[from];
         }
         else
         {
-            inValue = ((to + 1)->time - from->time) * ((to->time - from->time) / ((to + 1)->time - from->time));
+            inValue = (_times[to + 1] - _times[from]) * ((_times[to] - _times[from]) / (_times[to + 1] - _times[from]));
         }
 
-        float interpTime = hermiteSmooth(h00, h01, h10, h11, from->time, outValue, to->time, inValue);
+        float interpTime = hermiteSmooth(h00, h01, h10, h11, _times[from], outValue, _times[to], inValue);
         interpolateQuaternion(interpTime, (fromValue + i), (toValue + i), (dst + i));
         
         // Handle remaining components (if any) as scalars
@@ -1178,7 +1290,7 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
                 }
                 else
                 {
-                    outValue = (toValue[i] - (from - 1)->value[i]) * ((from->time - (from - 1)->time) / (to->time - (from - 1)->time));
+                    outValue = (toValue[i] - _values[(from - 1) * _componentCount + i]) * ((_times[from] - _times[from - 1]) / (_times[to] - _times[from - 1]));
                 }
 
                 if (index == _pointCount - 2)
@@ -1187,7 +1299,7 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
                 }
                 else
                 {
-                    inValue = ((to + 1)->value[i] - fromValue[i]) * ((to->time - from->time) / ((to + 1)->time - from->time));
+                    inValue = (_values[(to + 1) * _componentCount + i] - fromValue[i]) * ((_times[to] - _times[from]) / (_times[to + 1] - _times[from]));
                 }
 
                 dst[i] = hermiteSmooth(h00, h01, h10, h11, fromValue[i], outValue, toValue[i], inValue);
@@ -1196,49 +1308,21 @@ void Curve::interpolateHermiteSmooth(float s, unsigned int index, Point* from, P
     }
 }
 
-void Curve::interpolateLinear(float s, Point* from, Point* to, float* dst) const
+void Curve::interpolateLinear(float s, unsigned int from, unsigned int to, float* dst) const
 {
-    float* fromValue = from->value;
-    float* toValue = to->value;
+    const float* fromValue = _values + from * _componentCount;
+    const float* toValue = _values + to * _componentCount;
 
-    if (!_quaternionOffset)
-    {
-        for (unsigned int i = 0; i < _componentCount; i++)
-        {
-            if (fromValue[i] == toValue[i])
-                dst[i] = fromValue[i];
-            else
-                dst[i] = lerpInl(s, fromValue[i], toValue[i]);
-        }
-    }
-    else
+    // Interpolate every component as a scalar, then replace the quaternion component (if any).
+    lerpValues(s, fromValue, toValue, dst, _componentCount);
+    if (_quaternionOffset)
     {
-        // Interpolate any values up to the quaternion offset as scalars.
         unsigned int quaternionOffset = *_quaternionOffset;
-        unsigned int i = 0;
-        for (i = 0; i < quaternionOffset; i++)
-        {
-            if (fromValue[i] == toValue[i])
-                dst[i] = fromValue[i];
-            else
-                dst[i] = lerpInl(s, fromValue[i], toValue[i]);
-        }
-
-        // Handle quaternion component.
-        interpolateQuaternion(s, (fromValue + i), (toValue + i), (dst + i));
-        
-        // handle any remaining components as scalars
-        for (i += 4; i < _componentCount; i++)
-        {
-            if (fromValue[i] == toValue[i])
-                dst[i] = fromValue[i];
-            else
-                dst[i] = lerpInl(s, fromValue[i], toValue[i]);
-        }
+        interpolateQuaternion(s, (fromValue + quaternionOffset), (toValue + quaternionOffset), (dst + quaternionOffset));
     }
 }
 
-void Curve::interpolateQuaternion(float s, float* from, float* to, float* dst) const
+void Curve::interpolateQuaternion(float s, const float* from, const float* to, float* dst) const
 {
     // Evaluate.
     if (s >= 0)
@@ -1256,9 +1340,9 @@ int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
     {
         mid = (min + max) >> 1;
 
-        if (time >= _points[mid].time && time < _points[mid + 1].time)
+        if (time >= _times[mid] && time < _times[mid + 1])
             return mid;
-        else if (time < _points[mid].time)
+        else if (time < _times[mid])
             max = mid - 1;
         else
             min = mid + 1;
@@ -1267,6 +1351,37 @@ int Curve::determineIndex(float time, unsigned int min, unsigned int max) const
     return max;
 }
 
+int Curve::determineIndex(float time, unsigned int min, unsigned int max, Cursor* cursor) const
+{
+    if (!cursor)
+        return determineIndex(time, min, max);
+
+    // Check the cached segment first, then the ones following and preceding it.
+    unsigned int index = cursor->_index;
+    if (index >= min && index < max)
+    {
+        if (time >= _times[index])
+        {
+            if (time < _times[index + 1])
+                return index;
+            if (index + 1 < max && time < _times[index + 2])
+            {
+                cursor->_index = index + 1;
+                return index + 1;
+            }
+        }
+        else if (index > min && time >= _times[index - 1])
+        {
+            cursor->_index = index - 1;
+            return index - 1;
+        }
+    }
+
+    index = determineIndex(time, min, max);
+    cursor->_index = index;
+    return index;
+}
+
 int Curve::getInterpolationType(const char* curveId)
 {
     if (strcmp(curveId, "BEZIER") == 0)
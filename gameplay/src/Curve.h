@@ -415,46 +415,81 @@ public:
     void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst) const;
 
     /**
-     * Linear interpolation function.
-     */
-    static float lerp(float t, float from, float to);
-
-private:
-
-    /**
-     * Defines a single point within a curve.
+     * Caches the keyframe segment located by the last evaluation of a curve.
+     *
+     * Playback advances through a curve monotonically, so the segment containing the
+     * next evaluated time is almost always the cached one or its neighbour. Keeping a
+     * cursor per playback (per animation clip channel) turns the keyframe search into
+     * a constant time lookup. A cursor must only be used with a single curve.
+     *
+     * @script{ignore}
      */
-    class Point
+    class Cursor
     {
-    public:
+        friend class Curve;
 
-        /** The time of the point within the curve. */
-        float time;
-        /** The value of the point. */
-        float* value;
-        /** The value of the tangent when approaching this point (from the previous point in the curve). */
-        float* inValue;
-        /** The value of the tangent when leaving this point (towards the next point in the curve). */
-        float* outValue;
-        /** The type of interpolation to use between this point and the next point. */
-        InterpolationType type;
+    public:
 
         /**
          * Constructor.
          */
-        Point();
+        Cursor();
 
-        /**
-         * Destructor.
-         */
-        ~Point();
+    private:
 
-        /**
-         * Hidden copy assignment operator.
-         */
-        Point& operator=(const Point&);
+        unsigned int _index;        // The index of the last located segment.
+        unsigned int _min;          // The first point of the cached subregion.
+        unsigned int _max;          // The last point of the cached subregion.
+        float _startTime;           // The start time of the cached subregion (negative if none).
+        float _endTime;             // The end time of the cached subregion.
     };
 
+    /**
+     * Evaluates the curve at the given position value (between 0.0 and 1.0 inclusive)
+     * within the specified subregion of the curve, using and updating the given cursor
+     * to locate the keyframes to interpolate between.
+     *
+     * @param time The position within the subregion of the curve to evaluate the curve at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time (in milliseconds) to blend between the end points of the curve
+     *      for looping purposes when time is outside the range 0-1. A value of zero here
+     *      disables curve looping.
+     * @param dst The evaluated value of the curve at the given time.
+     * @param cursor The cursor caching the last located segment of this curve, or NULL.
+     * @script{ignore}
+     */
+    void evaluate(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor* cursor) const;
+
+    /**
+     * Evaluates a batch of curves (such as all the channels of an animation clip) at
+     * the same position value within the same subregion.
+     *
+     * The keyframe segment of every curve is located first. The curves interpolating
+     * linearly within their segment are then blended together, four components at a
+     * time with SSE or NEON where available, before any quaternions are slerped.
+     *
+     * @param count The number of curves to evaluate.
+     * @param curves The curves to evaluate.
+     * @param time The position within the subregion of the curves to evaluate them at.
+     * @param startTime Start time for the subregion (between 0.0 - 1.0).
+     * @param endTime End time for the subregion (between 0.0 - 1.0).
+     * @param loopBlendTime Time (in milliseconds) to blend between the end points of the curves
+     *      for looping purposes when time is outside the range 0-1. A value of zero here
+     *      disables curve looping.
+     * @param dst The destination of the evaluated value of each curve.
+     * @param cursors The cursor of each curve, or NULL.
+     * @script{ignore}
+     */
+    static void evaluate(unsigned int count, Curve* const* curves, float time, float startTime, float endTime, float loopBlendTime, float* const* dst, Cursor* cursors);
+
+    /**
+     * Linear interpolation function.
+     */
+    static float lerp(float t, float from, float to);
+
+private:
+
     /**
      * Constructor.
      */
@@ -486,43 +521,59 @@ private:
     /**
      * Bezier interpolation function.
      */
-    void interpolateBezier(float s, Point* from, Point* to, float* dst) const;
+    void interpolateBezier(float s, unsigned int from, unsigned int to, float* dst) const;
 
     /**
      * Bspline interpolation function.
      */
-    void interpolateBSpline(float s, Point* c0, Point* c1, Point* c2, Point* c3, float* dst) const;
+    void interpolateBSpline(float s, unsigned int c0, unsigned int c1, unsigned int c2, unsigned int c3, float* dst) const;
 
     /**
      * Hermite interpolation function.
      */
-    void interpolateHermite(float s, Point* from, Point* to, float* dst) const;
+    void interpolateHermite(float s, unsigned int from, unsigned int to, float* dst) const;
 
     /**
      * Hermite interpolation function.
      */
-    void interpolateHermiteFlat(float s, Point* from, Point* to, float* dst) const;
+    void interpolateHermiteFlat(float s, unsigned int from, unsigned int to, float* dst) const;
 
     /**
      * Hermite interpolation function.
      */
-    void interpolateHermiteSmooth(float s, unsigned int index, Point* from, Point* to, float* dst) const;
+    void interpolateHermiteSmooth(float s, unsigned int index, unsigned int from, unsigned int to, float* dst) const;
 
     /**
      * Linear interpolation function.
      */
-    void interpolateLinear(float s, Point* from, Point* to, float* dst) const;
+    void interpolateLinear(float s, unsigned int from, unsigned int to, float* dst) const;
 
     /**
      * Quaternion interpolation function.
      */
-    void interpolateQuaternion(float s, float* from, float* to, float* dst) const;
+    void interpolateQuaternion(float s, const float* from, const float* to, float* dst) const;
+
+    /**
+     * Locates the points to interpolate between for the given time within the given
+     * subregion, and evaluates the curve there unless the points are joined linearly.
+     *
+     * @return true if dst must still be linearly interpolated between the values of the
+     *      points from and to at linearTime; false if dst holds the evaluated value.
+     */
+    bool evaluateSegment(float time, float startTime, float endTime, float loopBlendTime, float* dst, Cursor* cursor,
+                         unsigned int* from, unsigned int* to, float* linearTime) const;
 
     /**
      * Determines the current keyframe to interpolate from based on the specified time.
      */
     int determineIndex(float time, unsigned int min, unsigned int max) const;
 
+    /**
+     * Determines the current keyframe to interpolate from based on the specified time,
+     * checking the segment cached in the given cursor (and its neighbours) first.
+     */
+    int determineIndex(float time, unsigned int min, unsigned int max, Cursor* cursor) const;
+
     /**
      * Sets the offset for the beginning of a Quaternion piece of data within the curve's value span at the specified
      * index. The next four components of data starting at the given index will be interpolated as a Quaternion.
@@ -545,7 +596,11 @@ private:
     unsigned int _componentCount;       // Number of components on the curve.
     unsigned int _componentSize;        // The component size (in bytes).
     unsigned int* _quaternionOffset;    // Offset for the rotation component.
-    Point* _points;                     // The points on the curve.
+    float* _times;                      // The times of the points, stored contiguously for searching.
+    float* _values;                     // The values of the points, stored contiguously.
+    float* _inValues;                   // The in tangents of the points, stored contiguously.
+    float* _outValues;                  // The out tangents of the points, stored contiguously.
+    InterpolationType* _types;          // The interpolation used from each point to the next.
 };
 
 }
@@ -1,6 +1,7 @@
 #include "Base.h"
 #include "Drawable.h"
 #include "Node.h"
+#include "RenderQueue.h"
 
 
 namespace gameplay
@@ -20,6 +21,17 @@ Node* Drawable::getNode() const
     return _node;
 }
 
+void Drawable::enqueue(RenderQueue* queue)
+{
+    GP_ASSERT(queue);
+    queue->add(this, true);
+}
+
+unsigned int Drawable::drawPart(unsigned int part, bool wireframe)
+{
+    return draw(wireframe);
+}
+
 void Drawable::setNode(Node* node)
 {
     _node = node;
@@ -6,6 +6,7 @@ namespace gameplay
 
 class Node;
 class NodeCloneContext;
+class RenderQueue;
 
 /**
  * Defines a drawable object that can be attached to a Node.
@@ -13,6 +14,7 @@ class NodeCloneContext;
 class Drawable
 {
     friend class Node;
+    friend class RenderQueue;
 
 public:
 
@@ -35,6 +37,17 @@ public:
 
     virtual unsigned int draw(bool wireframe = false) = 0;
 
+    /**
+     * Adds the draw packets of the object to a render queue.
+     *
+     * By default the object is added as a single transparent packet that is
+     * drawn with draw(), since most drawables that bind their own state
+     * (particles, sprites, text, etc.) are blended.
+     *
+     * @param queue The render queue.
+     */
+    virtual void enqueue(RenderQueue* queue);
+
     /**
      * Gets the node this drawable is attached to.
      *
@@ -44,6 +57,16 @@ public:
 
 protected:
 
+    /**
+     * Draws a part of the object after the render queue has bound the pass of
+     * the part's packet (see RenderQueue::add).
+     *
+     * @param part The index of the part to draw.
+     * @param wireframe true if you want to request to draw the wireframe only.
+     * @return The number of graphics draw calls issued.
+     */
+    virtual unsigned int drawPart(unsigned int part, bool wireframe);
+
     /**
      * Clones the drawable and returns a new drawable.
      *
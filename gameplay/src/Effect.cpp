@@ -2,9 +2,14 @@
 #include "Effect.h"
 #include "FileSystem.h"
 #include "Game.h"
+#include "UniformBuffer.h"
 
 #define OPENGL_ES_DEFINE  "OPENGL_ES"
 
+// Identifies (and versions) the files of the program binary cache.
+#define PROGRAM_CACHE_MAGIC     0x42505047
+#define PROGRAM_CACHE_VERSION   1
+
 namespace gameplay
 {
 
@@ -12,6 +17,9 @@ namespace gameplay
 static std::map<std::string, Effect*> __effectCache;
 static Effect* __currentEffect = NULL;
 
+// Slots of uniform names, shared by all effects.
+static std::unordered_map<std::string, unsigned int> __uniformSlots;
+
 Effect::Effect() : _program(0)
 {
 }
@@ -47,22 +55,9 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
     GP_ASSERT(fshPath);
 
     // Search the effect cache for an identical effect that is already loaded.
-    std::string uniqueId = vshPath;
-    uniqueId += ';';
-    uniqueId += fshPath;
-    uniqueId += ';';
-    if (defines)
-    {
-        uniqueId += defines;
-    }
-    std::map<std::string, Effect*>::const_iterator itr = __effectCache.find(uniqueId);
-    if (itr != __effectCache.end())
-    {
-        // Found an exiting effect with this id, so increase its ref count and return it.
-        GP_ASSERT(itr->second);
-        itr->second->addRef();
-        return itr->second;
-    }
+    Effect* effect = findCached(getCacheId(vshPath, fshPath, defines));
+    if (effect)
+        return effect;
 
     // Read source from file.
     char* vshSource = FileSystem::readAll(vshPath);
@@ -79,11 +74,51 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
         return NULL;
     }
 
-    Effect* effect = createFromSource(vshPath, vshSource, fshPath, fshSource, defines);
+    effect = createCached(vshPath, vshSource, fshPath, fshSource, defines);
     
     SAFE_DELETE_ARRAY(vshSource);
     SAFE_DELETE_ARRAY(fshSource);
 
+    return effect;
+}
+
+std::string Effect::getCacheId(const char* vshPath, const char* fshPath, const char* defines)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    std::string uniqueId = vshPath;
+    uniqueId += ';';
+    uniqueId += fshPath;
+    uniqueId += ';';
+    if (defines)
+    {
+        uniqueId += defines;
+    }
+    return uniqueId;
+}
+
+Effect* Effect::findCached(const std::string& id)
+{
+    std::map<std::string, Effect*>::const_iterator itr = __effectCache.find(id);
+    if (itr != __effectCache.end())
+    {
+        // Found an exiting effect with this id, so increase its ref count and return it.
+        GP_ASSERT(itr->second);
+        itr->second->addRef();
+        return itr->second;
+    }
+    return NULL;
+}
+
+Effect* Effect::createCached(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines)
+{
+    std::string uniqueId = getCacheId(vshPath, fshPath, defines);
+    Effect* effect = findCached(uniqueId);
+    if (effect)
+        return effect;
+
+    effect = createFromSource(vshPath, vshSource, fshPath, fshSource, defines);
     if (effect == NULL)
     {
         GP_ERROR("Failed to create effect from shaders '%s', '%s'.", vshPath, fshPath);
@@ -94,7 +129,6 @@ Effect* Effect::createFromFile(const char* vshPath, const char* fshPath, const c
         effect->_id = uniqueId;
         __effectCache[uniqueId] = effect;
     }
-
     return effect;
 }
 
@@ -215,6 +249,134 @@ static void replaceIncludes(const char* filepath, const char* source, std::strin
     }
 }
 
+static const char* getProgramCachePath()
+{
+    static bool initialized = false;
+    static std::string path;
+    if (!initialized)
+    {
+        initialized = true;
+        Properties* graphicsConfig = Game::getInstance()->getConfig()->getNamespace("graphics", true);
+        const char* cachePath = graphicsConfig ? graphicsConfig->getString("programCache") : NULL;
+        if (cachePath && strlen(cachePath) > 0)
+        {
+            GLint formatCount = 0;
+#ifdef GP_USE_PROGRAM_BINARY
+            if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+                GL_ASSERT( glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount) );
+#endif
+            if (formatCount == 0)
+            {
+                GP_WARN("Program binaries are not supported; the program cache '%s' is disabled.", cachePath);
+            }
+            else if (FileSystem::createDirectory(cachePath))
+            {
+                path = cachePath;
+            }
+        }
+    }
+    return path.length() > 0 ? path.c_str() : NULL;
+}
+
+static std::string getProgramCacheFile(const char* cachePath, const std::string& defines, const std::string& vshSource, const std::string& fshSource)
+{
+    // Binaries are only valid for the driver that created them, so the driver is part of the key.
+    std::string driver;
+    const char* vendor = (const char*)glGetString(GL_VENDOR);
+    const char* renderer = (const char*)glGetString(GL_RENDERER);
+    const char* version = (const char*)glGetString(GL_VERSION);
+    driver += vendor ? vendor : "";
+    driver += '\n';
+    driver += renderer ? renderer : "";
+    driver += '\n';
+    driver += version ? version : "";
+
+    // 64-bit FNV-1a hash of the fully preprocessed program.
+    unsigned long long hash = 14695981039346656037ULL;
+    const std::string* parts[4] = { &driver, &defines, &vshSource, &fshSource };
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        const std::string& part = *parts[i];
+        for (size_t j = 0, length = part.length(); j <= length; ++j)
+        {
+            hash ^= (unsigned char)(j < length ? part[j] : 0);
+            hash *= 1099511628211ULL;
+        }
+    }
+
+    char name[32];
+    sprintf(name, "/%016llx.bin", hash);
+    return std::string(cachePath) + name;
+}
+
+static GLuint loadProgramBinary(const char* filePath)
+{
+#ifdef GP_USE_PROGRAM_BINARY
+    if (!FileSystem::fileExists(filePath))
+        return 0;
+
+    std::unique_ptr<Stream> stream(FileSystem::open(filePath));
+    if (stream.get() == NULL)
+        return 0;
+
+    unsigned int header[4];
+    if (stream->read(header, sizeof(unsigned int), 4) != 4 || header[0] != PROGRAM_CACHE_MAGIC || header[1] != PROGRAM_CACHE_VERSION)
+        return 0;
+    GLenum format = (GLenum)header[2];
+    unsigned int length = header[3];
+
+    std::vector<unsigned char> binary(length);
+    if (length == 0 || stream->read(&binary[0], 1, length) != length)
+        return 0;
+
+    stream.reset();
+
+    // Drivers may reject a binary they no longer support (e.g. after an update), which is reported
+    // as an error or a failed link, so glProgramBinary is not wrapped in GL_ASSERT.
+    GLuint program;
+    GLint success = GL_FALSE;
+    GL_ASSERT( program = glCreateProgram() );
+    glProgramBinary(program, format, &binary[0], length);
+    if (glGetError() == GL_NO_ERROR)
+        GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
+    if (success != GL_TRUE)
+    {
+        // Drop the stale cache entry so the program rebuilt from source replaces it.
+        GP_WARN("Discarding program binary cache file '%s' rejected by the driver.", filePath);
+        GL_ASSERT( glDeleteProgram(program) );
+        FileSystem::deleteFile(filePath);
+        return 0;
+    }
+    return program;
+#else
+    return 0;
+#endif
+}
+
+static void saveProgramBinary(const char* filePath, GLuint program)
+{
+#ifdef GP_USE_PROGRAM_BINARY
+    GLint length = 0;
+    GL_ASSERT( glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length) );
+    if (length <= 0)
+        return;
+
+    std::vector<unsigned char> binary(length);
+    GLenum format = 0;
+    GL_ASSERT( glGetProgramBinary(program, length, &length, &format, &binary[0]) );
+
+    std::unique_ptr<Stream> stream(FileSystem::open(filePath, FileSystem::WRITE));
+    if (stream.get() == NULL || !stream->canWrite())
+    {
+        GP_WARN("Failed to write program binary to cache file '%s'.", filePath);
+        return;
+    }
+    unsigned int header[4] = { PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, (unsigned int)format, (unsigned int)length };
+    stream->write(header, sizeof(unsigned int), 4);
+    stream->write(&binary[0], 1, length);
+#endif
+}
+
 static void writeShaderToErrorFile(const char* filePath, const char* source)
 {
     std::string path = filePath;
@@ -244,8 +406,6 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
     std::string definesStr = "";
     replaceDefines(defines, definesStr);
     
-    shaderSource[0] = definesStr.c_str();
-    shaderSource[1] = "\n";
     std::string vshSourceStr = "";
     if (vshPath)
     {
@@ -254,7 +414,38 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
         if (vshSource && strlen(vshSource) != 0)
             vshSourceStr += "\n";
     }
-    shaderSource[2] = vshPath ? vshSourceStr.c_str() :  vshSource;
+    else if (vshSource)
+    {
+        vshSourceStr = vshSource;
+    }
+
+    std::string fshSourceStr;
+    if (fshPath)
+    {
+        // Replace the #include "xxxxx.xxx" with the sources that come from file paths
+        replaceIncludes(fshPath, fshSource, fshSourceStr);
+        if (fshSource && strlen(fshSource) != 0)
+            fshSourceStr += "\n";
+    }
+    else if (fshSource)
+    {
+        fshSourceStr = fshSource;
+    }
+
+    // Try to reuse the program binary linked by a previous run.
+    std::string cacheFile;
+    const char* cachePath = getProgramCachePath();
+    if (cachePath)
+    {
+        cacheFile = getProgramCacheFile(cachePath, definesStr, vshSourceStr, fshSourceStr);
+        program = loadProgramBinary(cacheFile.c_str());
+        if (program)
+            return createFromProgram(program);
+    }
+
+    shaderSource[0] = definesStr.c_str();
+    shaderSource[1] = "\n";
+    shaderSource[2] = vshSourceStr.c_str();
     GL_ASSERT( vertexShader = glCreateShader(GL_VERTEX_SHADER) );
     GL_ASSERT( glShaderSource(vertexShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
     GL_ASSERT( glCompileShader(vertexShader) );
@@ -287,15 +478,7 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
     }
 
     // Compile the fragment shader.
-    std::string fshSourceStr;
-    if (fshPath)
-    {
-        // Replace the #include "xxxxx.xxx" with the sources that come from file paths
-        replaceIncludes(fshPath, fshSource, fshSourceStr);
-        if (fshSource && strlen(fshSource) != 0)
-            fshSourceStr += "\n";
-    }
-    shaderSource[2] = fshPath ? fshSourceStr.c_str() : fshSource;
+    shaderSource[2] = fshSourceStr.c_str();
     GL_ASSERT( fragmentShader = glCreateShader(GL_FRAGMENT_SHADER) );
     GL_ASSERT( glShaderSource(fragmentShader, SHADER_SOURCE_LENGTH, shaderSource, NULL) );
     GL_ASSERT( glCompileShader(fragmentShader) );
@@ -332,6 +515,10 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
     GL_ASSERT( program = glCreateProgram() );
     GL_ASSERT( glAttachShader(program, vertexShader) );
     GL_ASSERT( glAttachShader(program, fragmentShader) );
+#ifdef GP_USE_PROGRAM_BINARY
+    if (cachePath)
+        GL_ASSERT( glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE) );
+#endif
     GL_ASSERT( glLinkProgram(program) );
     GL_ASSERT( glGetProgramiv(program, GL_LINK_STATUS, &success) );
 
@@ -362,6 +549,16 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
         return NULL;
     }
 
+    if (cachePath)
+        saveProgramBinary(cacheFile.c_str(), program);
+
+    return createFromProgram(program);
+}
+
+Effect* Effect::createFromProgram(GLuint program)
+{
+    GLint length;
+
     // Create and return the new Effect.
     Effect* effect = new Effect();
     effect->_program = program;
@@ -434,6 +631,10 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
                 // Query the pre-assigned uniform location.
                 GL_ASSERT( uniformLocation = glGetUniformLocation(program, uniformName) );
 
+                // Members of uniform blocks have no location; they are set through a UniformBuffer.
+                if (uniformLocation < 0)
+                    continue;
+
                 Uniform* uniform = new Uniform();
                 uniform->_effect = effect;
                 uniform->_name = uniformName;
@@ -450,11 +651,27 @@ Effect* Effect::createFromSource(const char* vshPath, const char* vshSource, con
                 }
 
                 effect->_uniforms[uniformName] = uniform;
+                effect->addUniformSlot(uniform);
             }
             SAFE_DELETE_ARRAY(uniformName);
         }
     }
 
+#ifdef GP_USE_UBO
+    // Bind the program's uniform blocks to the binding points of the uniform buffers with the same names.
+    if (UniformBuffer::isSupported())
+    {
+        GLint activeBlocks = 0;
+        GL_ASSERT( glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &activeBlocks) );
+        for (int i = 0; i < activeBlocks; ++i)
+        {
+            GLchar blockName[128];
+            GL_ASSERT( glGetActiveUniformBlockName(program, i, sizeof(blockName), NULL, blockName) );
+            GL_ASSERT( glUniformBlockBinding(program, i, UniformBuffer::getBindingPoint(blockName)) );
+        }
+    }
+#endif
+
     return effect;
 }
 
@@ -496,7 +713,9 @@ Uniform* Effect::getUniform(const char* name) const
 				uniform->_location = uniformLocation;
 				uniform->_index = 0;
 				uniform->_type = puniform->getType();
+				uniform->_parent = puniform;
 				_uniforms[name] = uniform;
+				addUniformSlot(uniform);
 
 				SAFE_DELETE_ARRAY(parentname);
 				return uniform;
@@ -522,6 +741,51 @@ Uniform* Effect::getUniform(unsigned int index) const
     return NULL;
 }
 
+unsigned int Effect::getUniformSlot(const char* name)
+{
+    GP_ASSERT(name);
+
+    std::unordered_map<std::string, unsigned int>::const_iterator itr = __uniformSlots.find(name);
+    if (itr != __uniformSlots.end())
+        return itr->second;
+
+    unsigned int slot = (unsigned int)__uniformSlots.size();
+    __uniformSlots[name] = slot;
+    return slot;
+}
+
+Uniform* Effect::getUniformBySlot(unsigned int slot) const
+{
+    return slot < _uniformSlots.size() ? _uniformSlots[slot] : NULL;
+}
+
+void Effect::addUniformSlot(Uniform* uniform) const
+{
+    GP_ASSERT(uniform);
+
+    unsigned int slot = getUniformSlot(uniform->_name.c_str());
+    if (slot >= _uniformSlots.size())
+        _uniformSlots.resize(slot + 1, NULL);
+    _uniformSlots[slot] = uniform;
+}
+
+bool Effect::updateShadow(Uniform* uniform, const void* data, size_t size)
+{
+    // Elements of an array uniform share their storage with the array, so they are not
+    // shadowed and setting one makes the array's shadow stale.
+    if (uniform->_parent)
+    {
+        uniform->_parent->_shadow.clear();
+        return true;
+    }
+
+    if (uniform->_shadow.size() == size && (size == 0 || memcmp(&uniform->_shadow[0], data, size) == 0))
+        return false;
+
+    uniform->_shadow.assign((const unsigned char*)data, (const unsigned char*)data + size);
+    return true;
+}
+
 unsigned int Effect::getUniformCount() const
 {
     return (unsigned int)_uniforms.size();
@@ -530,79 +794,94 @@ unsigned int Effect::getUniformCount() const
 void Effect::setValue(Uniform* uniform, float value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform1f(uniform->_location, value) );
+    if (updateShadow(uniform, &value, sizeof(float)))
+        GL_ASSERT( glUniform1f(uniform->_location, value) );
 }
 
 void Effect::setValue(Uniform* uniform, const float* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform1fv(uniform->_location, count, values) );
+    if (updateShadow(uniform, values, sizeof(float) * count))
+        GL_ASSERT( glUniform1fv(uniform->_location, count, values) );
 }
 
 void Effect::setValue(Uniform* uniform, int value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform1i(uniform->_location, value) );
+    if (updateShadow(uniform, &value, sizeof(int)))
+        GL_ASSERT( glUniform1i(uniform->_location, value) );
 }
 
 void Effect::setValue(Uniform* uniform, const int* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform1iv(uniform->_location, count, values) );
+    if (updateShadow(uniform, values, sizeof(int) * count))
+        GL_ASSERT( glUniform1iv(uniform->_location, count, values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Matrix& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniformMatrix4fv(uniform->_location, 1, GL_FALSE, value.m) );
+    if (updateShadow(uniform, value.m, sizeof(float) * 16))
+        GL_ASSERT( glUniformMatrix4fv(uniform->_location, 1, GL_FALSE, value.m) );
 }
 
 void Effect::setValue(Uniform* uniform, const Matrix* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniformMatrix4fv(uniform->_location, count, GL_FALSE, (GLfloat*)values) );
+    if (updateShadow(uniform, values, sizeof(float) * 16 * count))
+        GL_ASSERT( glUniformMatrix4fv(uniform->_location, count, GL_FALSE, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector2& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform2f(uniform->_location, value.x, value.y) );
+    float data[2] = { value.x, value.y };
+    if (updateShadow(uniform, data, sizeof(data)))
+        GL_ASSERT( glUniform2f(uniform->_location, value.x, value.y) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector2* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform2fv(uniform->_location, count, (GLfloat*)values) );
+    if (updateShadow(uniform, values, sizeof(float) * 2 * count))
+        GL_ASSERT( glUniform2fv(uniform->_location, count, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector3& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform3f(uniform->_location, value.x, value.y, value.z) );
+    float data[3] = { value.x, value.y, value.z };
+    if (updateShadow(uniform, data, sizeof(data)))
+        GL_ASSERT( glUniform3f(uniform->_location, value.x, value.y, value.z) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector3* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform3fv(uniform->_location, count, (GLfloat*)values) );
+    if (updateShadow(uniform, values, sizeof(float) * 3 * count))
+        GL_ASSERT( glUniform3fv(uniform->_location, count, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector4& value)
 {
     GP_ASSERT(uniform);
-    GL_ASSERT( glUniform4f(uniform->_location, value.x, value.y, value.z, value.w) );
+    float data[4] = { value.x, value.y, value.z, value.w };
+    if (updateShadow(uniform, data, sizeof(data)))
+        GL_ASSERT( glUniform4f(uniform->_location, value.x, value.y, value.z, value.w) );
 }
 
 void Effect::setValue(Uniform* uniform, const Vector4* values, unsigned int count)
 {
     GP_ASSERT(uniform);
     GP_ASSERT(values);
-    GL_ASSERT( glUniform4fv(uniform->_location, count, (GLfloat*)values) );
+    if (updateShadow(uniform, values, sizeof(float) * 4 * count))
+        GL_ASSERT( glUniform4fv(uniform->_location, count, (GLfloat*)values) );
 }
 
 void Effect::setValue(Uniform* uniform, const Texture::Sampler* sampler)
@@ -618,7 +897,9 @@ void Effect::setValue(Uniform* uniform, const Texture::Sampler* sampler)
     // Bind the sampler - this binds the texture and applies sampler state
     const_cast<Texture::Sampler*>(sampler)->bind();
 
-    GL_ASSERT( glUniform1i(uniform->_location, uniform->_index) );
+    GLint unit = uniform->_index;
+    if (updateShadow(uniform, &unit, sizeof(GLint)))
+        GL_ASSERT( glUniform1i(uniform->_location, unit) );
 }
 
 void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigned int count)
@@ -642,7 +923,8 @@ void Effect::setValue(Uniform* uniform, const Texture::Sampler** values, unsigne
     }
 
     // Pass texture unit array to GL
-    GL_ASSERT( glUniform1iv(uniform->_location, count, units) );
+    if (updateShadow(uniform, units, sizeof(GLint) * count))
+        GL_ASSERT( glUniform1iv(uniform->_location, count, units) );
 }
 
 void Effect::bind()
@@ -658,7 +940,7 @@ Effect* Effect::getCurrentEffect()
 }
 
 Uniform::Uniform() :
-    _location(-1), _type(0), _index(0), _effect(NULL)
+    _location(-1), _type(0), _index(0), _effect(NULL), _parent(NULL)
 {
 }
 
@@ -25,6 +25,9 @@ class Uniform;
  */
 class Effect: public Ref
 {
+    friend class RenderQueue;
+    friend class ResourceLoader;
+
 public:
 
     /**
@@ -82,6 +85,28 @@ public:
      */
     Uniform* getUniform(unsigned int index) const;
 
+    /**
+     * Returns the slot of the given uniform name.
+     *
+     * Slots are small integers shared by all effects, so a uniform name can be
+     * resolved to its slot once and then looked up in any effect without
+     * comparing strings.
+     *
+     * @param name The name of the uniform.
+     *
+     * @return The slot of the uniform name.
+     */
+    static unsigned int getUniformSlot(const char* name);
+
+    /**
+     * Returns the uniform in the given slot.
+     *
+     * @param slot The slot of the uniform (see getUniformSlot).
+     *
+     * @return The uniform, or NULL if this effect has no uniform in the slot.
+     */
+    Uniform* getUniformBySlot(unsigned int slot) const;
+
     /**
      * Returns the number of active uniforms in this effect.
      * 
@@ -241,10 +266,46 @@ private:
 
     static Effect* createFromSource(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines = NULL);
 
+    /**
+     * Gets the id under which an effect created from the given files is cached.
+     */
+    static std::string getCacheId(const char* vshPath, const char* fshPath, const char* defines);
+
+    /**
+     * Finds the effect cached under the given id and adds a reference to it.
+     *
+     * @return The cached effect, or NULL if no effect is cached under the id.
+     */
+    static Effect* findCached(const std::string& id);
+
+    /**
+     * Creates an effect from the source read from the given files and adds it to the cache,
+     * unless an effect has already been created from the files.
+     */
+    static Effect* createCached(const char* vshPath, const char* vshSource, const char* fshPath, const char* fshSource, const char* defines);
+
+    /**
+     * Creates an effect for a linked program, querying its attributes and uniforms.
+     */
+    static Effect* createFromProgram(GLuint program);
+
+    /**
+     * Adds a uniform to the slot of its name.
+     */
+    void addUniformSlot(Uniform* uniform) const;
+
+    /**
+     * Compares a value with the last value set to a uniform, storing it if it differs.
+     *
+     * @return true if the value must be set, false if the uniform already holds it.
+     */
+    static bool updateShadow(Uniform* uniform, const void* data, size_t size);
+
     GLuint _program;
     std::string _id;
     std::map<std::string, VertexAttribute> _vertexAttributes;
     mutable std::map<std::string, Uniform*> _uniforms;
+    mutable std::vector<Uniform*> _uniformSlots;
     static Uniform _emptyUniform;
 };
 
@@ -254,6 +315,7 @@ private:
 class Uniform
 {
     friend class Effect;
+    friend class RenderQueue;
 
 public:
 
@@ -305,6 +367,8 @@ private:
     GLenum _type;
     unsigned int _index;
     Effect* _effect;
+    Uniform* _parent;
+    std::vector<unsigned char> _shadow;
 };
 
 }
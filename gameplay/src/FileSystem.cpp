@@ -18,6 +18,9 @@
     #define __EXT_POSIX2
     #include <libgen.h>
     #include <dirent.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
     #define gp_stat stat
     #define gp_stat_struct struct stat
 #endif
@@ -181,6 +184,42 @@ private:
 
 #endif
 
+/**
+ * A read-only stream over a file that is mapped into memory.
+ *
+ * @script{ignore}
+ */
+class MappedFileStream : public Stream
+{
+public:
+    friend class FileSystem;
+
+    ~MappedFileStream();
+    virtual bool canRead();
+    virtual bool canWrite();
+    virtual bool canSeek();
+    virtual void close();
+    virtual size_t read(void* ptr, size_t size, size_t count);
+    virtual char* readLine(char* str, int num);
+    virtual size_t write(const void* ptr, size_t size, size_t count);
+    virtual bool eof();
+    virtual size_t length();
+    virtual long int position();
+    virtual bool seek(long int offset, int origin);
+    virtual bool rewind();
+    virtual const unsigned char* getData();
+
+    static MappedFileStream* create(const char* filePath);
+
+private:
+    MappedFileStream(const unsigned char* data, size_t length);
+
+private:
+    const unsigned char* _data;
+    size_t _length;
+    size_t _position;
+};
+
 /////////////////////////////
 
 FileSystem::FileSystem()
@@ -363,6 +402,46 @@ bool FileSystem::fileExists(const char* filePath)
 
 }
 
+bool FileSystem::createDirectory(const char* dirPath)
+{
+    GP_ASSERT(dirPath);
+
+    std::string fullPath;
+    getFullPath(dirPath, fullPath);
+
+    // Create each directory along the path (skipping the root and any drive letter).
+    size_t pos = 0;
+    do
+    {
+        pos = fullPath.find('/', pos + 1);
+        std::string path = fullPath.substr(0, pos);
+        gp_stat_struct s;
+        if (path.length() > 0 && path[path.length() - 1] != ':' && stat(path.c_str(), &s) != 0)
+        {
+#ifdef WIN32
+            if (_mkdir(path.c_str()) != 0)
+#else
+            if (mkdir(path.c_str(), 0777) != 0)
+#endif
+            {
+                GP_WARN("Failed to create directory: '%s'", path.c_str());
+                return false;
+            }
+        }
+    } while (pos != std::string::npos);
+
+    return true;
+}
+
+bool FileSystem::deleteFile(const char* filePath)
+{
+    GP_ASSERT(filePath);
+
+    std::string fullPath;
+    getFullPath(filePath, fullPath);
+    return remove(fullPath.c_str()) == 0;
+}
+
 Stream* FileSystem::open(const char* path, size_t streamMode)
 {
     char modeStr[] = "rb";
@@ -388,7 +467,11 @@ Stream* FileSystem::open(const char* path, size_t streamMode)
     else
     {
         // First try the SD card
-        Stream* stream = FileStream::create(fullPath.c_str(), modeStr);
+        Stream* stream = NULL;
+        if ((streamMode & MAPPED) != 0)
+            stream = MappedFileStream::create(fullPath.c_str());
+        if (!stream)
+            stream = FileStream::create(fullPath.c_str(), modeStr);
 
         if (!stream)
         {
@@ -404,6 +487,12 @@ Stream* FileSystem::open(const char* path, size_t streamMode)
 #else
     std::string fullPath;
     getFullPath(path, fullPath);
+    if ((streamMode & MAPPED) != 0 && (streamMode & WRITE) == 0)
+    {
+        Stream* stream = MappedFileStream::create(fullPath.c_str());
+        if (stream)
+            return stream;
+    }
     FileStream* stream = FileStream::create(fullPath.c_str(), modeStr);
     return stream;
 #endif
@@ -717,6 +806,183 @@ bool FileStream::rewind()
 
 ////////////////////////////////
 
+MappedFileStream::MappedFileStream(const unsigned char* data, size_t length)
+    : _data(data), _length(length), _position(0)
+{
+}
+
+MappedFileStream::~MappedFileStream()
+{
+    close();
+}
+
+MappedFileStream* MappedFileStream::create(const char* filePath)
+{
+    const unsigned char* data = NULL;
+    size_t length = 0;
+#ifdef WIN32
+    HANDLE file = CreateFileA(filePath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+        return NULL;
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        // The view keeps the mapping alive, so both handles can be closed immediately.
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping)
+        {
+            data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            length = (size_t)size.QuadPart;
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = ::open(filePath, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat s;
+    if (fstat(fd, &s) == 0 && s.st_size > 0)
+    {
+        // The mapping keeps the file referenced, so the descriptor can be closed immediately.
+        void* ptr = mmap(NULL, (size_t)s.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED)
+        {
+            data = (const unsigned char*)ptr;
+            length = (size_t)s.st_size;
+        }
+    }
+    ::close(fd);
+#endif
+    if (data == NULL)
+        return NULL;
+    return new MappedFileStream(data, length);
+}
+
+bool MappedFileStream::canRead()
+{
+    return _data != NULL;
+}
+
+bool MappedFileStream::canWrite()
+{
+    return false;
+}
+
+bool MappedFileStream::canSeek()
+{
+    return _data != NULL;
+}
+
+void MappedFileStream::close()
+{
+    if (_data)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(_data);
+#else
+        munmap((void*)_data, _length);
+#endif
+    }
+    _data = NULL;
+    _length = 0;
+    _position = 0;
+}
+
+size_t MappedFileStream::read(void* ptr, size_t size, size_t count)
+{
+    if (!_data || size == 0)
+        return 0;
+
+    // Only read whole elements, like fread().
+    size_t available = (_length - _position) / size;
+    if (count > available)
+        count = available;
+    memcpy(ptr, _data + _position, size * count);
+    _position += size * count;
+    return count;
+}
+
+char* MappedFileStream::readLine(char* str, int num)
+{
+    if (!_data || num <= 0 || _position >= _length)
+        return NULL;
+
+    int i = 0;
+    while (i < num - 1 && _position < _length)
+    {
+        char c = (char)_data[_position++];
+        str[i++] = c;
+        if (c == '\n')
+            break;
+    }
+    str[i] = '\0';
+    return str;
+}
+
+size_t MappedFileStream::write(const void* ptr, size_t size, size_t count)
+{
+    return 0;
+}
+
+bool MappedFileStream::eof()
+{
+    return !_data || _position >= _length;
+}
+
+size_t MappedFileStream::length()
+{
+    return _length;
+}
+
+long int MappedFileStream::position()
+{
+    if (!_data)
+        return -1;
+    return (long int)_position;
+}
+
+bool MappedFileStream::seek(long int offset, int origin)
+{
+    if (!_data)
+        return false;
+
+    long int base;
+    switch (origin)
+    {
+    case SEEK_SET:
+        base = 0;
+        break;
+    case SEEK_CUR:
+        base = (long int)_position;
+        break;
+    case SEEK_END:
+        base = (long int)_length;
+        break;
+    default:
+        return false;
+    }
+    if (base + offset < 0 || (size_t)(base + offset) > _length)
+        return false;
+    _position = (size_t)(base + offset);
+    return true;
+}
+
+bool MappedFileStream::rewind()
+{
+    if (!_data)
+        return false;
+    _position = 0;
+    return true;
+}
+
+const unsigned char* MappedFileStream::getData()
+{
+    return _data;
+}
+
+////////////////////////////////
+
 #ifdef __ANDROID__
 
 FileStreamAndroid::FileStreamAndroid(AAsset* asset)
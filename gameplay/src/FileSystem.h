@@ -24,7 +24,8 @@ public:
     enum StreamMode
     {
         READ = 1,
-        WRITE = 2
+        WRITE = 2,
+        MAPPED = 4
     };
 
     /**
@@ -146,12 +147,38 @@ public:
      */
     static bool fileExists(const char* filePath);
 
+    /**
+     * Creates a directory, along with any of its parent directories that do not exist.
+     *
+     * @param dirPath The path to the directory, relative to the path set in <code>setResourcePath(const char*)</code>.
+     *
+     * @return <code>true</code> if the directory exists or was created; <code>false</code> otherwise.
+     *
+     * @script{ignore}
+     */
+    static bool createDirectory(const char* dirPath);
+
+    /**
+     * Deletes a file.
+     *
+     * @param filePath The path to the file, relative to the path set in <code>setResourcePath(const char*)</code>.
+     *
+     * @return <code>true</code> if the file was deleted; <code>false</code> otherwise.
+     *
+     * @script{ignore}
+     */
+    static bool deleteFile(const char* filePath);
+
     /**
      * Opens a byte stream for the given resource path.
      *
      * If <code>path</code> is a file path, the file at the specified location is opened relative to the currently set
      * resource path.
      *
+     * Opening a file with <code>READ | MAPPED</code> maps the whole file into memory, making its
+     * contents available through Stream::getData(). If the file cannot be mapped (for example,
+     * an Android asset), a regular read stream is returned instead.
+     *
      * @param path The path to the resource to be opened, relative to the currently set resource path.
      * @param streamMode The stream mode used to open the file.
      * 
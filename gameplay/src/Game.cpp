@@ -8,6 +8,7 @@
 #include "ControlFactory.h"
 #include "Theme.h"
 #include "Form.h"
+#include "MeshSkin.h"
 
 /** @script{ignore} */
 GLenum __gl_error_code = GL_NO_ERROR;
@@ -61,10 +62,11 @@ public:
 
 Game::Game()
     : _initialized(false), _state(UNINITIALIZED), _pausedCount(0),
-      _frameLastFPS(0), _frameCount(0), _frameRate(0), _width(0), _height(0),
+      _frameLastFPS(0), _frameCount(0), _frameNumber(0), _frameRate(0), _width(0), _height(0),
       _clearDepth(1.0f), _clearStencil(0), _properties(NULL),
       _animationController(NULL), _audioController(NULL),
-      _physicsController(NULL), _aiController(NULL), _audioListener(NULL),
+      _physicsController(NULL), _aiController(NULL), _audioListener(NULL), _workerPool(NULL), _resourceLoader(NULL),
+      _transformChangesBatched(false),
       _timeEvents(NULL), _scriptController(NULL), _scriptTarget(NULL)
 {
     GP_ASSERT(__gameInstance == NULL);
@@ -135,6 +137,16 @@ bool Game::isVsync()
     return Platform::isVsync();
 }
 
+void Game::setTransformChangesBatched(bool batched)
+{
+    _transformChangesBatched = batched;
+}
+
+bool Game::isTransformChangesBatched() const
+{
+    return _transformChangesBatched;
+}
+
 int Game::run()
 {
     if (_state != UNINITIALIZED)
@@ -165,6 +177,20 @@ bool Game::startup()
     RenderState::initialize();
     FrameBuffer::initialize();
 
+    unsigned int workerThreads = std::thread::hardware_concurrency();
+    workerThreads = workerThreads > 1 ? workerThreads - 1 : 0;
+    if (_properties)
+    {
+        Properties* workersConfig = _properties->getNamespace("workers", true);
+        if (workersConfig && workersConfig->exists("threads"))
+            workerThreads = (unsigned int)workersConfig->getInt("threads");
+    }
+    _workerPool = new WorkerPool();
+    _workerPool->initialize(workerThreads);
+
+    _resourceLoader = new ResourceLoader();
+    _resourceLoader->initialize();
+
     _animationController = new AnimationController();
     _animationController->initialize();
 
@@ -260,6 +286,9 @@ void Game::shutdown()
             SAFE_DELETE(gamepad);
         }
 
+        _resourceLoader->finalize();
+        SAFE_DELETE(_resourceLoader);
+
         _animationController->finalize();
         SAFE_DELETE(_animationController);
 
@@ -270,6 +299,9 @@ void Game::shutdown()
         SAFE_DELETE(_physicsController);
         _aiController->finalize();
         SAFE_DELETE(_aiController);
+
+        _workerPool->finalize();
+        SAFE_DELETE(_workerPool);
         
         ControlFactory::finalize();
 
@@ -284,6 +316,7 @@ void Game::shutdown()
         RenderState::finalize();
 
         SAFE_DELETE(_properties);
+        Properties::clearCache();
 
 		_state = UNINITIALIZED;
     }
@@ -369,12 +402,17 @@ void Game::frame()
         Platform::resizeEventInternal(_width, _height);
     }
 
+    ++_frameNumber;
+
 	static double lastFrameTime = Game::getGameTime();
 	double frameTime = getGameTime();
 
     // Fire time events to scheduled TimeListeners
     fireTimeEvents(frameTime);
 
+    // Complete the resources loaded in the background.
+    _resourceLoader->update();
+
     if (_state == Game::RUNNING)
     {
         GP_ASSERT(_animationController);
@@ -386,6 +424,11 @@ void Game::frame()
         float elapsedTime = (frameTime - lastFrameTime);
         lastFrameTime = frameTime;
 
+        // Journal transform changes made while updating.
+        bool batchTransformChanges = _transformChangesBatched;
+        if (batchTransformChanges)
+            Transform::suspendTransformChanged();
+
         // Update the scheduled and running animations.
         _animationController->update(elapsedTime);
 
@@ -408,9 +451,16 @@ void Game::frame()
         if (_scriptTarget)
             _scriptTarget->fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(GameScriptTarget, update), elapsedTime);
 
+        // Notify transform listeners of this frame's changes in a single flush.
+        if (batchTransformChanges)
+            Transform::resumeTransformChanged();
+
         // Audio Rendering.
         _audioController->update(elapsedTime);
 
+        // Build the matrix palettes of the skins animated this frame.
+        MeshSkin::updateMatrixPalettes();
+
         // Graphics Rendering.
         render(elapsedTime);
 
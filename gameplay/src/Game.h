@@ -10,6 +10,8 @@
 #include "AnimationController.h"
 #include "PhysicsController.h"
 #include "AIController.h"
+#include "WorkerPool.h"
+#include "ResourceLoader.h"
 #include "AudioListener.h"
 #include "Rectangle.h"
 #include "Vector4.h"
@@ -91,6 +93,25 @@ public:
      */
     static void setVsync(bool enable);
 
+    /**
+     * Sets whether transform changed events are batched for each frame.
+     *
+     * When enabled, transform changes made while updating the frame (animations, physics,
+     * AI, forms and game/script updates) are recorded once per transform in a journal and
+     * their listeners are notified in a single flush before audio and rendering. World
+     * matrices remain valid when read during the update.
+     *
+     * @param batched true to batch transform changed events, false to dispatch them immediately.
+     */
+    void setTransformChangesBatched(bool batched);
+
+    /**
+     * Gets whether transform changed events are batched for each frame.
+     *
+     * @return true if transform changed events are batched, false otherwise.
+     */
+    bool isTransformChangesBatched() const;
+
     /**
      * Gets the total absolute running time (in milliseconds) since Game::run().
      * 
@@ -169,6 +190,16 @@ public:
      */
     inline unsigned int getFrameRate() const;
 
+    /**
+     * Gets the number of the current frame.
+     *
+     * The frame number is incremented at the start of every frame and can be used
+     * to cache per-frame data.
+     *
+     * @return The current frame number.
+     */
+    inline unsigned int getFrameNumber() const;
+
     /**
      * Gets the game window width.
      * 
@@ -269,6 +300,31 @@ public:
      */
     inline ScriptController* getScriptController() const;
 
+    /**
+     * Gets the worker pool used to run engine work across multiple threads.
+     *
+     * The number of worker threads is read from the "threads" property of the
+     * "workers" section in the game config and defaults to one less than the
+     * number of hardware threads.
+     *
+     * @return The worker pool for this game.
+     * @script{ignore}
+     */
+    inline WorkerPool* getWorkerPool() const;
+
+    /**
+     * Gets the resource loader, which loads textures, effects, properties and scenes
+     * in the background.
+     *
+     * The time spent each frame completing loads is read from the "frameBudget"
+     * property (in milliseconds) of the "loader" section in the game config, and the
+     * number of threads preparing loads from its "threads" property (1 by default).
+     *
+     * @return The resource loader for this game.
+     * @script{ignore}
+     */
+    inline ResourceLoader* getResourceLoader() const;
+
     /**
      * Gets the audio listener for 3D audio.
      * 
@@ -750,6 +806,7 @@ private:
     static double _pausedTimeTotal;             // The total time paused.
     double _frameLastFPS;                       // The last time the frame count was updated.
     unsigned int _frameCount;                   // The current frame count.
+    unsigned int _frameNumber;                  // The number of the current frame (never reset).
     unsigned int _frameRate;                    // The current frame rate.
     unsigned int _width;                        // The game's display width.
     unsigned int _height;                       // The game's display height.
@@ -763,6 +820,9 @@ private:
     PhysicsController* _physicsController;      // Controls the simulation of a physics scene and entities.
     AIController* _aiController;                // Controls AI simulation.
     AudioListener* _audioListener;              // The audio listener in 3D space.
+    WorkerPool* _workerPool;                    // Runs engine work on worker threads.
+    ResourceLoader* _resourceLoader;            // Loads resources in the background.
+    bool _transformChangesBatched;              // If transform changed events are flushed once per frame.
     std::priority_queue<TimeEvent, std::vector<TimeEvent>, std::less<TimeEvent> >* _timeEvents;     // Contains the scheduled time events.
     ScriptController* _scriptController;            // Controls the scripting engine.
     ScriptTarget* _scriptTarget;                // Script target for the game
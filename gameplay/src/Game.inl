@@ -19,6 +19,11 @@ inline unsigned int Game::getFrameRate() const
     return _frameRate;
 }
 
+inline unsigned int Game::getFrameNumber() const
+{
+    return _frameNumber;
+}
+
 inline unsigned int Game::getWidth() const
 {
     return _width;
@@ -58,6 +63,17 @@ inline ScriptController* Game::getScriptController() const
 {
     return _scriptController;
 }
+
+inline WorkerPool* Game::getWorkerPool() const
+{
+    return _workerPool;
+}
+
+inline ResourceLoader* Game::getResourceLoader() const
+{
+    return _resourceLoader;
+}
+
 inline AIController* Game::getAIController() const
 {
     return _aiController;
@@ -7,7 +7,7 @@ namespace gameplay
 {
 
 Joint::Joint(const char* id)
-    : Node(id), _jointMatrixDirty(true)
+    : Node(id)
 {
 }
 
@@ -64,28 +64,7 @@ Scene* Joint::getScene() const
 void Joint::transformChanged()
 {
     Node::transformChanged();
-    _jointMatrixDirty = true;
-}
-
-void Joint::updateJointMatrix(const Matrix& bindShape, Vector4* matrixPalette)
-{
-    // Note: If more than one MeshSkin influences this Joint, we need to skip
-    // the _jointMatrixDirty optimization since updateJointMatrix() may be
-    // called multiple times a frame with different bindShape matrices (and
-    // different matrixPallete pointers).
-    if (_skin.next || _jointMatrixDirty)
-    {
-        _jointMatrixDirty = false;
-
-        static Matrix t;
-        Matrix::multiply(Node::getWorldMatrix(), getInverseBindPose(), &t);
-        Matrix::multiply(t, bindShape, &t);
-
-        GP_ASSERT(matrixPalette);
-        matrixPalette[0].set(t.m[0], t.m[4], t.m[8], t.m[12]);
-        matrixPalette[1].set(t.m[1], t.m[5], t.m[9], t.m[13]);
-        matrixPalette[2].set(t.m[2], t.m[6], t.m[10], t.m[14]);
-    }
+    setSkinsDirty(false);
 }
 
 const Matrix& Joint::getInverseBindPose() const
@@ -96,7 +75,7 @@ const Matrix& Joint::getInverseBindPose() const
 void Joint::setInverseBindPose(const Matrix& m)
 {
     _bindPose = m;
-    _jointMatrixDirty = true;
+    setSkinsDirty(true);
 }
 
 void Joint::addSkin(MeshSkin* skin)
@@ -155,6 +134,14 @@ void Joint::removeSkin(MeshSkin* skin)
     }
 }
 
+void Joint::setSkinsDirty(bool bindPoseChanged)
+{
+    for (SkinReference* itr = &_skin; itr && itr->skin; itr = itr->next)
+    {
+        itr->skin->setMatrixPaletteDirty(bindPoseChanged);
+    }
+}
+
 Joint::SkinReference::SkinReference()
     : skin(NULL), next(NULL)
 {
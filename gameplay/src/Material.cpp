@@ -209,6 +209,82 @@ Material* Material::clone(NodeCloneContext &context) const
     return material;
 }
 
+unsigned int Material::precompile(const char* path, const char* defines)
+{
+    GP_ASSERT(path);
+
+    std::vector<std::string> files;
+    if (FileSystem::getExtension(path) == ".MATERIAL")
+    {
+        files.push_back(path);
+    }
+    else
+    {
+        std::vector<std::string> directoryFiles;
+        if (!FileSystem::listFiles(path, directoryFiles))
+        {
+            GP_WARN("Failed to list material files in directory: %s", path);
+            return 0;
+        }
+        for (size_t i = 0, count = directoryFiles.size(); i < count; ++i)
+        {
+            if (FileSystem::getExtension(directoryFiles[i].c_str()) == ".MATERIAL")
+                files.push_back(std::string(path) + "/" + directoryFiles[i]);
+        }
+    }
+
+    unsigned int effectCount = 0;
+    for (size_t i = 0, count = files.size(); i < count; ++i)
+    {
+        Properties* properties = Properties::create(files[i].c_str());
+        if (properties == NULL)
+        {
+            GP_WARN("Failed to precompile material file: %s", files[i].c_str());
+            continue;
+        }
+        effectCount += precompile(properties, defines);
+        SAFE_DELETE(properties);
+    }
+    return effectCount;
+}
+
+unsigned int Material::precompile(Properties* properties, const char* defines)
+{
+    GP_ASSERT(properties);
+
+    if (strcmp(properties->getNamespace(), "pass") == 0)
+    {
+        const char* vertexShaderPath = properties->getString("vertexShader");
+        const char* fragmentShaderPath = properties->getString("fragmentShader");
+        if (!vertexShaderPath || !fragmentShaderPath)
+            return 0;
+
+        std::string allDefines = properties->getString("defines", "");
+        if (defines && strlen(defines) > 0)
+        {
+            if (allDefines.length() > 0)
+                allDefines += ';';
+            allDefines += defines;
+        }
+
+        // Only the program cache needs to keep the compiled program.
+        Effect* effect = Effect::createFromFile(vertexShaderPath, fragmentShaderPath, allDefines.c_str());
+        if (!effect)
+            return 0;
+        SAFE_RELEASE(effect);
+        return 1;
+    }
+
+    unsigned int effectCount = 0;
+    properties->rewind();
+    Properties* child = NULL;
+    while ((child = properties->getNextNamespace()))
+    {
+        effectCount += precompile(child, defines);
+    }
+    return effectCount;
+}
+
 bool Material::loadTechnique(Material* material, Properties* techniqueProperties, PassCallback callback, void* cookie)
 {
     GP_ASSERT(material);
@@ -27,6 +27,7 @@ class Material : public RenderState
     friend class RenderState;
     friend class Node;
     friend class Model;
+    friend class Scene;
 
 public:
 
@@ -104,6 +105,23 @@ public:
      */
     static Material* create(const char* vshPath, const char* fshPath, const char* defines = NULL);
 
+    /**
+     * Compiles the effect of every pass in a material file, or in every material
+     * file of a directory, without creating the materials.
+     *
+     * When a program cache is set in the game config ("programCache" in the
+     * graphics section), this stores the linked program of every permutation so
+     * that later runs load the programs instead of compiling them.
+     *
+     * @param path Path to a .material file or to a directory of .material files.
+     * @param defines Semicolon delimited defines added to the defines of each pass
+     *      (such as the light defines a scene adds), or NULL.
+     *
+     * @return The number of effects created.
+     * @script{ignore}
+     */
+    static unsigned int precompile(const char* path, const char* defines = NULL);
+
     /**
      * Returns the number of techniques in the material.
      *
@@ -195,6 +213,11 @@ private:
      */
     static void loadRenderState(RenderState* renderState, Properties* properties);
 
+    /**
+     * Compiles the effects of the passes in the given properties and its nested namespaces.
+     */
+    static unsigned int precompile(Properties* properties, const char* defines);
+
     Technique* _currentTechnique;
     std::vector<Technique*> _techniques;
 };
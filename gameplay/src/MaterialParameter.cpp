@@ -6,8 +6,10 @@ namespace gameplay
 {
 
 MaterialParameter::MaterialParameter(const char* name) :
-_type(MaterialParameter::NONE), _count(1), _dynamic(false), _name(name ? name : ""), _uniform(NULL), _loggerDirtyBits(0)
+_type(MaterialParameter::NONE), _count(1), _dynamic(false), _name(name ? name : ""), _uniformSlot(0), _uniform(NULL), _loggerDirtyBits(0)
 {
+    // Resolve the uniform name once, so binding to another effect does not compare strings.
+    _uniformSlot = Effect::getUniformSlot(_name.c_str());
     clearValue();
 }
 
@@ -454,7 +456,11 @@ void MaterialParameter::bind(Effect* effect)
     // we need to update our uniform to point to the new effect's uniform.
     if (!_uniform || _uniform->getEffect() != effect)
     {
-        _uniform = effect->getUniform(_name.c_str());
+        _uniform = effect->getUniformBySlot(_uniformSlot);
+
+        // Uniforms for single array elements ("u_array[1]") are created on their first lookup by name.
+        if (!_uniform && _name.find('[') != std::string::npos)
+            _uniform = effect->getUniform(_name.c_str());
 
         if (!_uniform)
         {
@@ -37,6 +37,7 @@ namespace gameplay
 class MaterialParameter : public AnimationTarget, public Ref
 {
     friend class RenderState;
+    friend class RenderQueue;
 
 public:
 
@@ -479,6 +480,7 @@ private:
     unsigned int _count;
     bool _dynamic;
     std::string _name;
+    unsigned int _uniformSlot;
     Uniform* _uniform;
     char _loggerDirtyBits;
 };
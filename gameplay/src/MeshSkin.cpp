@@ -2,22 +2,44 @@
 #include "MeshSkin.h"
 #include "Joint.h"
 #include "Model.h"
+#include "Game.h"
 
 // The number of rows in each palette matrix.
 #define PALETTE_ROWS 3
 
+// Matrix palette dirty bits
+#define SKIN_DIRTY_PALETTE 1
+#define SKIN_DIRTY_BIND_MATRICES 2
+#define SKIN_DIRTY_ALL (SKIN_DIRTY_PALETTE | SKIN_DIRTY_BIND_MATRICES)
+#define SKIN_QUEUED 4
+
+// The minimum number of skins built by a single worker thread job.
+#define SKIN_PALETTE_GRAIN_SIZE 4
+
 namespace gameplay
 {
 
+// The skins whose matrix palettes must be rebuilt before the next frame is rendered.
+static std::vector<MeshSkin*> __dirtySkins;
+
 MeshSkin::MeshSkin()
-    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL)
+    : _rootJoint(NULL), _rootNode(NULL), _matrixPalette(NULL), _model(NULL),
+      _matrixPaletteBits(0)
 {
+    setMatrixPaletteDirty(true);
 }
 
 MeshSkin::~MeshSkin()
 {
     clearJoints();
 
+    if (_matrixPaletteBits & SKIN_QUEUED)
+    {
+        std::vector<MeshSkin*>::iterator itr = std::find(__dirtySkins.begin(), __dirtySkins.end(), this);
+        GP_ASSERT(itr != __dirtySkins.end());
+        __dirtySkins.erase(itr);
+    }
+
     SAFE_DELETE_ARRAY(_matrixPalette);
 }
 
@@ -29,6 +51,7 @@ const Matrix& MeshSkin::getBindShape() const
 void MeshSkin::setBindShape(const float* matrix)
 {
     _bindShape.set(matrix);
+    setMatrixPaletteDirty(true);
 }
 
 unsigned int MeshSkin::getJointCount() const
@@ -134,6 +157,7 @@ void MeshSkin::setJointCount(unsigned int jointCount)
             _matrixPalette[i+2].set(0.0f, 0.0f, 1.0f, 0.0f);
         }
     }
+    setMatrixPaletteDirty(true);
 }
 
 void MeshSkin::setJoint(Joint* joint, unsigned int index)
@@ -153,20 +177,168 @@ void MeshSkin::setJoint(Joint* joint, unsigned int index)
         joint->addRef();
         joint->addSkin(this);
     }
+    setMatrixPaletteDirty(true);
 }
 
 Vector4* MeshSkin::getMatrixPalette() const
 {
     GP_ASSERT(_matrixPalette);
 
-    for (size_t i = 0, count = _joints.size(); i < count; i++)
+    // Joints in a scene with linear transforms only learn that an ancestor moved when
+    // the scene resolves its transforms, which requesting a world matrix triggers.
+    if (_rootJoint)
+        _rootJoint->getWorldMatrix();
+
+    if (isMatrixPaletteDirty())
     {
-        GP_ASSERT(_joints[i]);
-        _joints[i]->updateJointMatrix(getBindShape(), &_matrixPalette[i * PALETTE_ROWS]);
+        resolveJointMatrices();
+        buildMatrixPalette();
     }
     return _matrixPalette;
 }
 
+void MeshSkin::updateMatrixPalettes()
+{
+    if (__dirtySkins.empty())
+        return;
+
+    // Resolving joint world matrices may update transforms shared between skins,
+    // so gather them serially and only build the palettes in parallel. Skins whose
+    // palettes were already rebuilt on demand since they were queued are skipped.
+    std::vector<MeshSkin*> dirtySkins;
+    dirtySkins.swap(__dirtySkins);
+    size_t buildCount = 0;
+    for (size_t i = 0, count = dirtySkins.size(); i < count; i++)
+    {
+        MeshSkin* skin = dirtySkins[i];
+        GP_ASSERT(skin);
+        skin->_matrixPaletteBits &= ~SKIN_QUEUED;
+        if (skin->_matrixPalette && skin->isMatrixPaletteDirty())
+        {
+            skin->resolveJointMatrices();
+            dirtySkins[buildCount++] = skin;
+        }
+    }
+    dirtySkins.resize(buildCount);
+
+    WorkerPool* workerPool = Game::getInstance()->getWorkerPool();
+    if (workerPool)
+    {
+        workerPool->parallelFor((unsigned int)dirtySkins.size(), SKIN_PALETTE_GRAIN_SIZE, [&dirtySkins](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; i++)
+                dirtySkins[i]->buildMatrixPalette();
+        });
+    }
+    else
+    {
+        for (size_t i = 0; i < buildCount; i++)
+            dirtySkins[i]->buildMatrixPalette();
+    }
+}
+
+void MeshSkin::setMatrixPaletteDirty(bool bindMatricesDirty)
+{
+    _matrixPaletteBits |= bindMatricesDirty ? SKIN_DIRTY_ALL : SKIN_DIRTY_PALETTE;
+    if (!(_matrixPaletteBits & SKIN_QUEUED))
+    {
+        _matrixPaletteBits |= SKIN_QUEUED;
+        __dirtySkins.push_back(this);
+    }
+}
+
+bool MeshSkin::isMatrixPaletteDirty() const
+{
+    return (_matrixPaletteBits & SKIN_DIRTY_PALETTE) != 0;
+}
+
+void MeshSkin::resolveJointMatrices() const
+{
+    size_t jointCount = _joints.size();
+
+    if (_matrixPaletteBits & SKIN_DIRTY_BIND_MATRICES)
+    {
+        // Pre-multiply each inverse bind pose with the bind shape and store the rows
+        // contiguously so that building the palette needs a single 3x4 product per joint.
+        _bindMatrices.resize(jointCount * 16);
+        Matrix bind;
+        for (size_t i = 0; i < jointCount; i++)
+        {
+            GP_ASSERT(_joints[i]);
+            Matrix::multiply(_joints[i]->getInverseBindPose(), _bindShape, &bind);
+            bind.transpose();
+            memcpy(&_bindMatrices[i * 16], bind.m, sizeof(float) * 16);
+        }
+        _matrixPaletteBits &= ~SKIN_DIRTY_BIND_MATRICES;
+    }
+
+    _jointMatrices.resize(jointCount);
+    for (size_t i = 0; i < jointCount; i++)
+    {
+        GP_ASSERT(_joints[i]);
+        _jointMatrices[i] = &_joints[i]->getWorldMatrix();
+    }
+}
+
+void MeshSkin::buildMatrixPalette() const
+{
+    GP_ASSERT(_matrixPalette);
+    GP_ASSERT(_jointMatrices.size() == _joints.size());
+    GP_ASSERT(_bindMatrices.size() == _joints.size() * 16);
+
+    // Each palette entry holds the first three rows of (world * inverseBindPose * bindShape).
+    // Row r of the product is the sum of the bind matrix rows weighted by row r of the world matrix.
+    float rows[PALETTE_ROWS * 4];
+    for (size_t i = 0, count = _joints.size(); i < count; i++)
+    {
+        const float* world = _jointMatrices[i]->m;
+        const float* bind = &_bindMatrices[i * 16];
+
+#if defined(GP_USE_SSE)
+        __m128 bind0 = _mm_loadu_ps(bind);
+        __m128 bind1 = _mm_loadu_ps(bind + 4);
+        __m128 bind2 = _mm_loadu_ps(bind + 8);
+        __m128 bind3 = _mm_loadu_ps(bind + 12);
+        for (unsigned int r = 0; r < PALETTE_ROWS; r++)
+        {
+            __m128 row = _mm_mul_ps(_mm_set1_ps(world[r]), bind0);
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(world[4 + r]), bind1));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(world[8 + r]), bind2));
+            row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(world[12 + r]), bind3));
+            _mm_storeu_ps(rows + r * 4, row);
+        }
+#elif defined(GP_USE_NEON)
+        float32x4_t bind0 = vld1q_f32(bind);
+        float32x4_t bind1 = vld1q_f32(bind + 4);
+        float32x4_t bind2 = vld1q_f32(bind + 8);
+        float32x4_t bind3 = vld1q_f32(bind + 12);
+        for (unsigned int r = 0; r < PALETTE_ROWS; r++)
+        {
+            float32x4_t row = vmulq_n_f32(bind0, world[r]);
+            row = vmlaq_n_f32(row, bind1, world[4 + r]);
+            row = vmlaq_n_f32(row, bind2, world[8 + r]);
+            row = vmlaq_n_f32(row, bind3, world[12 + r]);
+            vst1q_f32(rows + r * 4, row);
+        }
+#else
+        for (unsigned int r = 0; r < PALETTE_ROWS; r++)
+        {
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                rows[r * 4 + c] = world[r] * bind[c] + world[4 + r] * bind[4 + c] + world[8 + r] * bind[8 + c] + world[12 + r] * bind[12 + c];
+            }
+        }
+#endif
+
+        Vector4* palette = &_matrixPalette[i * PALETTE_ROWS];
+        palette[0].set(rows[0], rows[1], rows[2], rows[3]);
+        palette[1].set(rows[4], rows[5], rows[6], rows[7]);
+        palette[2].set(rows[8], rows[9], rows[10], rows[11]);
+    }
+
+    _matrixPaletteBits &= ~SKIN_DIRTY_PALETTE;
+}
+
 unsigned int MeshSkin::getMatrixPaletteSize() const
 {
     return (unsigned int)_joints.size() * PALETTE_ROWS;
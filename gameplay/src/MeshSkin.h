@@ -92,11 +92,25 @@ public:
 
     /**
      * Returns the pointer to the Vector4 array for the purpose of binding to a shader.
+     *
+     * The palette is only rebuilt when a joint or the bind shape changed since it was
+     * last built, so drawing the same skin in several passes is cheap.
      * 
      * @return The pointer to the matrix palette.
      */
     Vector4* getMatrixPalette() const;
 
+    /**
+     * Rebuilds the matrix palettes of all skins whose joints changed since their
+     * palettes were last built, spreading the work across the game's worker threads.
+     *
+     * The game calls this once per frame after updating and before rendering, so that
+     * getMatrixPalette() returns the cached palettes while drawing.
+     *
+     * @script{ignore}
+     */
+    static void updateMatrixPalettes();
+
     /**
      * Returns the number of elements in the matrix palette array.
      * Each element is a Vector4* that represents a row.
@@ -175,6 +189,32 @@ private:
      */
     void clearJoints();
 
+    /**
+     * Marks the matrix palette dirty so that it is rebuilt before it is used next.
+     *
+     * @param bindMatricesDirty true if the bind shape or a joint's inverse bind pose changed.
+     */
+    void setMatrixPaletteDirty(bool bindMatricesDirty);
+
+    /**
+     * Determines whether the matrix palette must be rebuilt before it is used.
+     */
+    bool isMatrixPaletteDirty() const;
+
+    /**
+     * Resolves the world matrices of the joints and the bind matrices if they are dirty.
+     *
+     * This may update joint transforms, so it must not run concurrently with other skins.
+     */
+    void resolveJointMatrices() const;
+
+    /**
+     * Builds the matrix palette from the matrices gathered by resolveJointMatrices().
+     *
+     * This only writes data owned by this skin and is safe to run on a worker thread.
+     */
+    void buildMatrixPalette() const;
+
     Matrix _bindShape;
     std::vector<Joint*> _joints;
     Joint* _rootJoint;
@@ -190,6 +230,13 @@ private:
     // The number of Vector4's is (_joints.size() * 3).
     Vector4* _matrixPalette;
     Model* _model;
+
+    // Row-major product of each joint's inverse bind pose and the bind shape (16 floats per joint).
+    mutable std::vector<float> _bindMatrices;
+    // The world matrices of the joints, gathered by resolveJointMatrices().
+    mutable std::vector<const Matrix*> _jointMatrices;
+    // Dirty bits for the matrix palette and bind matrices, and whether the skin is queued for updateMatrixPalettes().
+    mutable int _matrixPaletteBits;
 };
 
 }
@@ -5,17 +5,18 @@
 #include "Technique.h"
 #include "Pass.h"
 #include "Node.h"
+#include "RenderQueue.h"
 
 namespace gameplay
 {
 
 Model::Model() : Drawable(),
-    _mesh(NULL), _material(NULL), _partCount(0), _partMaterials(NULL), _skin(NULL)
+    _mesh(NULL), _material(NULL), _partCount(0), _partMaterials(NULL), _skin(NULL), _staticBatched(false)
 {
 }
 
 Model::Model(Mesh* mesh) : Drawable(),
-    _mesh(mesh), _material(NULL), _partCount(0), _partMaterials(NULL), _skin(NULL)
+    _mesh(mesh), _material(NULL), _partCount(0), _partMaterials(NULL), _skin(NULL), _staticBatched(false)
 {
     GP_ASSERT(mesh);
     _partCount = mesh->getPartCount();
@@ -85,6 +86,10 @@ void Model::setMaterial(Material* material, int partIndex)
 
     Material* oldMaterial = NULL;
 
+    // Batches are grouped by material, so the batches holding our parts must be rebuilt.
+    if (_staticBatched && _node && _node->getScene())
+        _node->getScene()->setStaticBatchDirty(_node);
+
     if (partIndex == -1)
     {
         oldMaterial = _material;
@@ -330,6 +335,10 @@ unsigned int Model::draw(bool wireframe)
 {
     GP_ASSERT(_mesh);
 
+    // Our geometry is drawn by the static batches of our node's scene.
+    if (_staticBatched)
+        return 0;
+
     unsigned int partCount = _mesh->getPartCount();
     if (partCount == 0)
     {
@@ -385,6 +394,56 @@ unsigned int Model::draw(bool wireframe)
     return partCount;
 }
 
+void Model::enqueue(RenderQueue* queue)
+{
+    GP_ASSERT(queue);
+    GP_ASSERT(_mesh);
+
+    // Our geometry is drawn by the static batches of our node's scene.
+    if (_staticBatched)
+        return;
+
+    // A mesh without parts is drawn as a single part with the shared material.
+    unsigned int partCount = _mesh->getPartCount();
+    for (unsigned int i = 0, count = std::max(partCount, 1u); i < count; ++i)
+    {
+        Material* material = partCount == 0 ? _material : getMaterial(i);
+        if (!material)
+            continue;
+
+        Technique* technique = material->getTechnique();
+        GP_ASSERT(technique);
+        for (unsigned int j = 0, passCount = technique->getPassCount(); j < passCount; ++j)
+        {
+            queue->add(this, technique->getPassByIndex(j), i, j);
+        }
+    }
+}
+
+unsigned int Model::drawPart(unsigned int part, bool wireframe)
+{
+    GP_ASSERT(_mesh);
+
+    if (_mesh->getPartCount() == 0)
+    {
+        GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0) );
+        if (!wireframe || !drawWireframe(_mesh))
+        {
+            GL_ASSERT( glDrawArrays(_mesh->getPrimitiveType(), 0, _mesh->getVertexCount()) );
+        }
+        return 1;
+    }
+
+    MeshPart* meshPart = _mesh->getPart(part);
+    GP_ASSERT(meshPart);
+    GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, meshPart->_indexBuffer) );
+    if (!wireframe || !drawWireframe(meshPart))
+    {
+        GL_ASSERT( glDrawElements(meshPart->getPrimitiveType(), meshPart->getIndexCount(), meshPart->getIndexFormat(), 0) );
+    }
+    return 1;
+}
+
 void Model::setMaterialNodeBinding(Material *material)
 {
     GP_ASSERT(material);
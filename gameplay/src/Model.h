@@ -141,6 +141,14 @@ public:
      */
     unsigned int draw(bool wireframe = false);
 
+    /**
+     * @see Drawable::enqueue
+     *
+     * Adds a packet for each pass of each mesh part's material, so that the
+     * parts are sorted by effect, texture and depth with all other packets.
+     */
+    void enqueue(RenderQueue* queue);
+
 private:
 
     /**
@@ -168,6 +176,11 @@ private:
      */
     void setNode(Node* node);
 
+    /**
+     * @see Drawable::drawPart
+     */
+    unsigned int drawPart(unsigned int part, bool wireframe);
+
     /**
      * @see Drawable::clone
      */
@@ -192,6 +205,7 @@ private:
     unsigned int _partCount;
     Material** _partMaterials;
     MeshSkin* _skin;
+    bool _staticBatched;
 };
 
 }
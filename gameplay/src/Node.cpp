@@ -26,7 +26,8 @@ namespace gameplay
 Node::Node(const char* id)
     : _scene(NULL), _firstChild(NULL), _nextSibling(NULL), _prevSibling(NULL), _parent(NULL), _childCount(0), _enabled(true), _tags(NULL),
     _drawable(NULL), _camera(NULL), _light(NULL), _audioSource(NULL), _collisionObject(NULL), _agent(NULL), _userObject(NULL),
-      _dirtyBits(NODE_DIRTY_ALL)
+      _dirtyBits(NODE_DIRTY_ALL), _linearScene(NULL), _linearIndex(0),
+      _staticBatchScene(NULL), _spatialIndexScene(NULL), _spatialIndexProxy(-1), _spatialIndexDirty(false)
 {
     GP_REGISTER_SCRIPT_EVENTS();
     if (id)
@@ -72,7 +73,12 @@ void Node::setId(const char* id)
 {
     if (id)
     {
+        std::string oldId = _id;
         _id = id;
+
+        // Our agent is found through our ID, so it must be re-indexed.
+        if (_agent)
+            Game::getInstance()->getAIController()->updateAgentId(_agent, oldId.c_str());
     }
 }
 
@@ -122,6 +128,16 @@ void Node::addChild(Node* child)
     ++_childCount;
     setBoundsDirty();
 
+    if (_spatialIndexScene)
+    {
+        _spatialIndexScene->addSpatialIndexNodes(child);
+    }
+
+    if (_linearScene)
+    {
+        _linearScene->setTransformHierarchyDirty();
+    }
+
     if (_dirtyBits & NODE_DIRTY_HIERARCHY)
     {
         hierarchyChanged();
@@ -153,6 +169,19 @@ void Node::removeAllChildren()
 
 void Node::remove()
 {
+    // Batches built from this subtree must drop the nodes that leave the scene.
+    Scene* scene = getScene();
+    if (scene && !scene->_staticBatches.empty())
+    {
+        scene->_staticBatchesChanged = true;
+    }
+
+    // The spatial index stores node pointers, so our subtree leaves it immediately.
+    if (_spatialIndexScene)
+    {
+        _spatialIndexScene->removeSpatialIndexNodes(this);
+    }
+
     // Re-link our neighbours.
     if (_prevSibling)
     {
@@ -176,6 +205,13 @@ void Node::remove()
     _prevSibling = NULL;
     _parent = NULL;
 
+    // We are leaving our scene, so stop resolving our subtree through its linear transform arrays.
+    if (_linearScene)
+    {
+        _linearScene->setTransformHierarchyDirty();
+        detachLinearTransforms();
+    }
+
     if (parent && parent->_dirtyBits & NODE_DIRTY_HIERARCHY)
     {
         parent->hierarchyChanged();
@@ -390,6 +426,10 @@ void Node::setEnabled(bool enabled)
         {
             _collisionObject->setEnabled(enabled);
         }
+        if (_staticBatchScene)
+        {
+            _staticBatchScene->setStaticBatchDirty(this);
+        }
         _enabled = enabled;
     }
 }
@@ -435,6 +475,14 @@ bool Node::isStatic() const
 
 const Matrix& Node::getWorldMatrix() const
 {
+    if (_linearScene)
+    {
+        // Our scene resolves all world matrices in a single pass, which it only runs here
+        // when something changed and the pass is safe to run from the calling thread.
+        _linearScene->updateTransformsOnDemand();
+        return _world;
+    }
+
     if (_dirtyBits & NODE_DIRTY_WORLD)
     {
         // Clear our dirty flag immediately to prevent this block from being entered if our
@@ -656,6 +704,21 @@ void Node::hierarchyChanged()
 
 void Node::transformChanged()
 {
+    setSpatialIndexDirty();
+    if (_staticBatchScene)
+    {
+        _staticBatchScene->setStaticBatchDirty(this);
+    }
+
+    if (_linearScene)
+    {
+        // Our scene resolves our world matrix (and notifies our children) in its next linear pass.
+        _dirtyBits |= NODE_DIRTY_BOUNDS;
+        _linearScene->setTransformDirty(_linearIndex);
+        Transform::transformChanged();
+        return;
+    }
+
     // Our local transform was changed, so mark our world matrices dirty.
     _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS;
 
@@ -679,6 +742,64 @@ void Node::transformChanged()
     Transform::transformChanged();
 }
 
+void Node::resolveWorldMatrix(const Matrix* parentWorld, Matrix* local, Matrix* world)
+{
+    GP_ASSERT(local);
+    GP_ASSERT(world);
+
+    // Mirrors the rules of getWorldMatrix(): static nodes keep their world matrix and
+    // non-kinematic collision objects are simulated in world space.
+    if (!isStatic())
+    {
+        *local = getMatrix();
+        if (parentWorld && (!_collisionObject || _collisionObject->isKinematic()))
+        {
+            Matrix::multiply(*parentWorld, *local, &_world);
+        }
+        else
+        {
+            _world = *local;
+        }
+    }
+    *world = _world;
+    _dirtyBits &= ~NODE_DIRTY_WORLD;
+    _dirtyBits |= NODE_DIRTY_BOUNDS;
+}
+
+void Node::detachLinearTransforms()
+{
+    _linearScene = NULL;
+    _linearIndex = 0;
+    _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS;
+    for (Node* child = _firstChild; child != NULL; child = child->_nextSibling)
+    {
+        child->detachLinearTransforms();
+    }
+}
+
+void Node::transformInvalidated()
+{
+    setSpatialIndexDirty();
+
+    if (_linearScene)
+    {
+        _dirtyBits |= NODE_DIRTY_BOUNDS;
+        _linearScene->setTransformDirty(_linearIndex);
+        return;
+    }
+
+    // A dirty world matrix implies our whole subtree is already dirty, since resolving
+    // a node's world matrix also resolves those of all of its children.
+    if (_dirtyBits & NODE_DIRTY_WORLD)
+        return;
+
+    _dirtyBits |= NODE_DIRTY_WORLD | NODE_DIRTY_BOUNDS;
+    for (Node* child = _firstChild; child != NULL; child = child->_nextSibling)
+    {
+        child->transformInvalidated();
+    }
+}
+
 void Node::setBoundsDirty()
 {
     // Mark ourself and our parent nodes as dirty
@@ -799,6 +920,7 @@ void Node::setLight(Light* light)
     }
 
     setBoundsDirty();
+    setSpatialIndexDirty();
 }
 
 Drawable* Node::getDrawable() const
@@ -810,6 +932,14 @@ void Node::setDrawable(Drawable* drawable)
 {
     if (_drawable != drawable)
     {
+        if (_staticBatchScene)
+        {
+            // Our model is about to be replaced, so it can no longer be drawn from the batches.
+            Model* model = dynamic_cast<Model*>(_drawable);
+            if (model)
+                model->_staticBatched = false;
+            _staticBatchScene->setStaticBatchDirty(this);
+        }
         if (_drawable)
         {
             _drawable->setNode(NULL);
@@ -829,6 +959,7 @@ void Node::setDrawable(Drawable* drawable)
         }
     }
     setBoundsDirty();
+    setSpatialIndexDirty();
 }
 
 const BoundingSphere& Node::getBoundingSphere() const
@@ -837,109 +968,125 @@ const BoundingSphere& Node::getBoundingSphere() const
     {
         _dirtyBits &= ~NODE_DIRTY_BOUNDS;
 
-        const Matrix& worldMatrix = getWorldMatrix();
+        // Start with our own world-space bounding sphere
+        bool empty = !computeBounds(&_bounds);
 
-        // Start with our local bounding sphere
-        // TODO: Incorporate bounds from entities other than mesh (i.e. particleemitters, audiosource, etc)
-        bool empty = true;
-        Terrain* terrain = dynamic_cast<Terrain*>(_drawable);
-        if (terrain)
-        {
-            _bounds.set(terrain->getBoundingBox());
-            empty = false;
-        }
-        Model* model = dynamic_cast<Model*>(_drawable);
-        if (model && model->getMesh())
-        {
-            if (empty)
-            {
-                _bounds.set(model->getMesh()->getBoundingSphere());
-                empty = false;
-            }
-            else
-            {
-                _bounds.merge(model->getMesh()->getBoundingSphere());
-            }
-        }
-        if (_light)
+        // Merge this world-space bounding sphere with our childrens' bounding volumes.
+        for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
         {
-            switch (_light->getLightType())
+            const BoundingSphere& childSphere = n->getBoundingSphere();
+            if (!childSphere.isEmpty())
             {
-            case Light::POINT:
                 if (empty)
                 {
-                    _bounds.set(Vector3::zero(), _light->getRange());
+                    _bounds.set(childSphere);
                     empty = false;
                 }
                 else
                 {
-                    _bounds.merge(BoundingSphere(Vector3::zero(), _light->getRange()));
+                    _bounds.merge(childSphere);
                 }
-                break;
-            case Light::SPOT:
-                // TODO: Implement spot light bounds
-                break;
             }
         }
+    }
+
+    return _bounds;
+}
+
+bool Node::computeBounds(BoundingSphere* bounds) const
+{
+    GP_ASSERT(bounds);
+
+    const Matrix& worldMatrix = getWorldMatrix();
+
+    // Start with our local bounding sphere
+    // TODO: Incorporate bounds from entities other than mesh (i.e. particleemitters, audiosource, etc)
+    bool empty = true;
+    Terrain* terrain = dynamic_cast<Terrain*>(_drawable);
+    if (terrain)
+    {
+        bounds->set(terrain->getBoundingBox());
+        empty = false;
+    }
+    Model* model = dynamic_cast<Model*>(_drawable);
+    if (model && model->getMesh())
+    {
         if (empty)
         {
-            // Empty bounding sphere, set the world translation with zero radius
-            worldMatrix.getTranslation(&_bounds.center);
-            _bounds.radius = 0;
+            bounds->set(model->getMesh()->getBoundingSphere());
+            empty = false;
         }
-
-        // Transform the sphere (if not empty) into world space.
-        if (!empty)
+        else
+        {
+            bounds->merge(model->getMesh()->getBoundingSphere());
+        }
+    }
+    if (_light)
+    {
+        switch (_light->getLightType())
         {
-            bool applyWorldTransform = true;
-            if (model && model->getSkin())
+        case Light::POINT:
+            if (empty)
             {
-                // Special case: If the root joint of our mesh skin is parented by any nodes, 
-                // multiply the world matrix of the root joint's parent by this node's
-                // world matrix. This computes a final world matrix used for transforming this
-                // node's bounding volume. This allows us to store a much smaller bounding
-                // volume approximation than would otherwise be possible for skinned meshes,
-                // since joint parent nodes that are not in the matrix palette do not need to
-                // be considered as directly transforming vertices on the GPU (they can instead
-                // be applied directly to the bounding volume transformation below).
-                GP_ASSERT(model->getSkin()->getRootJoint());
-                Node* jointParent = model->getSkin()->getRootJoint()->getParent();
-                if (jointParent)
-                {
-                    // TODO: Should we protect against the case where joints are nested directly
-                    // in the node hierachy of the model (this is normally not the case)?
-                    Matrix boundsMatrix;
-                    Matrix::multiply(getWorldMatrix(), jointParent->getWorldMatrix(), &boundsMatrix);
-                    _bounds.transform(boundsMatrix);
-                    applyWorldTransform = false;
-                }
+                bounds->set(Vector3::zero(), _light->getRange());
+                empty = false;
             }
-            if (applyWorldTransform)
+            else
             {
-                _bounds.transform(getWorldMatrix());
+                bounds->merge(BoundingSphere(Vector3::zero(), _light->getRange()));
             }
+            break;
+        case Light::SPOT:
+            // TODO: Implement spot light bounds
+            break;
         }
-
-        // Merge this world-space bounding sphere with our childrens' bounding volumes.
-        for (Node* n = getFirstChild(); n != NULL; n = n->getNextSibling())
+    }
+    if (empty)
+    {
+        // Empty bounding sphere, set the world translation with zero radius
+        worldMatrix.getTranslation(&bounds->center);
+        bounds->radius = 0;
+        return false;
+    }
+
+    // Transform the sphere into world space.
+    bool applyWorldTransform = true;
+    if (model && model->getSkin())
+    {
+        // Special case: If the root joint of our mesh skin is parented by any nodes, 
+        // multiply the world matrix of the root joint's parent by this node's
+        // world matrix. This computes a final world matrix used for transforming this
+        // node's bounding volume. This allows us to store a much smaller bounding
+        // volume approximation than would otherwise be possible for skinned meshes,
+        // since joint parent nodes that are not in the matrix palette do not need to
+        // be considered as directly transforming vertices on the GPU (they can instead
+        // be applied directly to the bounding volume transformation below).
+        GP_ASSERT(model->getSkin()->getRootJoint());
+        Node* jointParent = model->getSkin()->getRootJoint()->getParent();
+        if (jointParent)
         {
-            const BoundingSphere& childSphere = n->getBoundingSphere();
-            if (!childSphere.isEmpty())
-            {
-                if (empty)
-                {
-                    _bounds.set(childSphere);
-                    empty = false;
-                }
-                else
-                {
-                    _bounds.merge(childSphere);
-                }
-            }
+            // TODO: Should we protect against the case where joints are nested directly
+            // in the node hierachy of the model (this is normally not the case)?
+            Matrix boundsMatrix;
+            Matrix::multiply(getWorldMatrix(), jointParent->getWorldMatrix(), &boundsMatrix);
+            bounds->transform(boundsMatrix);
+            applyWorldTransform = false;
         }
     }
+    if (applyWorldTransform)
+    {
+        bounds->transform(getWorldMatrix());
+    }
+    return true;
+}
 
-    return _bounds;
+void Node::setSpatialIndexDirty()
+{
+    if (_spatialIndexScene && !_spatialIndexDirty)
+    {
+        _spatialIndexDirty = true;
+        _spatialIndexScene->_spatialIndexDirtyNodes.push_back(this);
+    }
 }
 
 Node* Node::clone() const
@@ -1054,6 +1201,11 @@ PhysicsCollisionObject* Node::getCollisionObject() const
 
 PhysicsCollisionObject* Node::setCollisionObject(PhysicsCollisionObject::Type type, const PhysicsCollisionShape::Definition& shape, PhysicsRigidBody::Parameters* rigidBodyParameters, int group, int mask)
 {
+    if (_staticBatchScene)
+    {
+        // Only nodes with static collision objects can be batched.
+        _staticBatchScene->setStaticBatchDirty(this);
+    }
     SAFE_DELETE(_collisionObject);
 
     switch (type)
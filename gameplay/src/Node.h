@@ -655,6 +655,12 @@ protected:
      */
     void transformChanged();
 
+    /**
+     * Marks the world matrix of this node and its children dirty without notifying
+     * listeners, while transform changed events are suspended.
+     */
+    void transformInvalidated();
+
     /**
      * Called when this Node's hierarchy changes.
      */
@@ -665,6 +671,34 @@ protected:
      */
     void setBoundsDirty();
 
+    /**
+     * Computes the world-space bounding sphere of this node's own content, excluding its children.
+     *
+     * @param bounds Populated with the bounding sphere (or the node translation with a zero radius).
+     *
+     * @return true if the node has content with bounds, false otherwise.
+     */
+    bool computeBounds(BoundingSphere* bounds) const;
+
+    /**
+     * Queues this node's leaf in the spatial index of its scene for an update.
+     */
+    void setSpatialIndexDirty();
+
+    /**
+     * Resolves the world matrix of this node during a linear transform pass of its scene.
+     *
+     * @param parentWorld The resolved world matrix of the parent node, or NULL for a root node.
+     * @param local Populated with the local matrix of the node.
+     * @param world Populated with the resolved world matrix of the node.
+     */
+    void resolveWorldMatrix(const Matrix* parentWorld, Matrix* local, Matrix* world);
+
+    /**
+     * Detaches this node and all of its children from the linear transform arrays of their scene.
+     */
+    void detachLinearTransforms();
+
     /**
      * Returns the first child node that matches the given ID.
      *
@@ -752,6 +786,18 @@ protected:
     mutable BoundingSphere _bounds;
     /** The dirty bits used for optimization. */
     mutable int _dirtyBits;
+    /** The scene resolving this node's world matrix in its linear transform arrays (or NULL). */
+    Scene* _linearScene;
+    /** The index of this node within the linear transform arrays of _linearScene. */
+    unsigned int _linearIndex;
+    /** The scene drawing this node's model from its static batches (or NULL). */
+    Scene* _staticBatchScene;
+    /** The scene tracking this node in its spatial index (or NULL). */
+    Scene* _spatialIndexScene;
+    /** The leaf of this node in the spatial index of _spatialIndexScene (or -1). */
+    int _spatialIndexProxy;
+    /** Whether this node is queued for a spatial index update. */
+    bool _spatialIndexDirty;
 };
 
 /**
@@ -10,12 +10,44 @@
 #define PARTICLE_EMISSION_RATE                   10
 #define PARTICLE_EMISSION_RATE_TIME_INTERVAL     1000.0f / (float)PARTICLE_EMISSION_RATE
 #define PARTICLE_UPDATE_RATE_MAX                 8
+#define PARTICLE_FIXED_STEPS_MAX                 4
+#define PARTICLE_PARALLEL_GRAIN_SIZE             2048
 
 namespace gameplay
 {
 
+#if defined(GP_USE_SSE)
+#define PARTICLE_SIMD
+typedef __m128 ParticleVector;
+static inline ParticleVector simdLoad(const float* src) { return _mm_loadu_ps(src); }
+static inline void simdStore(float* dst, ParticleVector v) { _mm_storeu_ps(dst, v); }
+static inline ParticleVector simdSet(float s) { return _mm_set1_ps(s); }
+static inline ParticleVector simdAdd(ParticleVector a, ParticleVector b) { return _mm_add_ps(a, b); }
+static inline ParticleVector simdSub(ParticleVector a, ParticleVector b) { return _mm_sub_ps(a, b); }
+static inline ParticleVector simdMul(ParticleVector a, ParticleVector b) { return _mm_mul_ps(a, b); }
+static inline ParticleVector simdDiv(ParticleVector a, ParticleVector b) { return _mm_div_ps(a, b); }
+#elif defined(GP_USE_NEON)
+#define PARTICLE_SIMD
+typedef float32x4_t ParticleVector;
+static inline ParticleVector simdLoad(const float* src) { return vld1q_f32(src); }
+static inline void simdStore(float* dst, ParticleVector v) { vst1q_f32(dst, v); }
+static inline ParticleVector simdSet(float s) { return vdupq_n_f32(s); }
+static inline ParticleVector simdAdd(ParticleVector a, ParticleVector b) { return vaddq_f32(a, b); }
+static inline ParticleVector simdSub(ParticleVector a, ParticleVector b) { return vsubq_f32(a, b); }
+static inline ParticleVector simdMul(ParticleVector a, ParticleVector b) { return vmulq_f32(a, b); }
+static inline ParticleVector simdDiv(ParticleVector a, ParticleVector b)
+{
+    // NEON has no divide; refine the reciprocal estimate with two Newton-Raphson steps.
+    float32x4_t r = vrecpeq_f32(b);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    r = vmulq_f32(vrecpsq_f32(b, r), r);
+    return vmulq_f32(a, r);
+}
+#endif
+
 ParticleEmitter::ParticleEmitter(unsigned int particleCountMax) : Drawable(),
-    _particleCountMax(particleCountMax), _particleCount(0), _particles(NULL),
+    _particleCountMax(particleCountMax), _particleCount(0), _particles(NULL), _storageMode(STORAGE_INTERLEAVED),
+    _particleStreams(NULL), _particleStreamStride(0), _particleFrames(NULL), _particleLiveIndices(NULL),
     _emissionRate(PARTICLE_EMISSION_RATE), _started(false), _ellipsoid(false),
     _sizeStartMin(1.0f), _sizeStartMax(1.0f), _sizeEndMin(1.0f), _sizeEndMax(1.0f),
     _energyMin(1000L), _energyMax(1000L),
@@ -29,16 +61,24 @@ ParticleEmitter::ParticleEmitter(unsigned int particleCountMax) : Drawable(),
     _spriteBatch(NULL), _spriteBlendMode(BLEND_ALPHA),  _spriteTextureWidth(0), _spriteTextureHeight(0), _spriteTextureWidthRatio(0), _spriteTextureHeightRatio(0), _spriteTextureCoords(NULL),
     _spriteAnimated(false),  _spriteLooped(false), _spriteFrameCount(1), _spriteFrameRandomOffset(0),_spriteFrameDuration(0L), _spriteFrameDurationSecs(0.0f), _spritePercentPerFrame(0.0f),
     _orbitPosition(false), _orbitVelocity(false), _orbitAcceleration(false),
-    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _emitTime(0), _lastUpdated(0)
+    _timePerEmission(PARTICLE_EMISSION_RATE_TIME_INTERVAL), _emitTime(0), _updateTime(0), _fixedTimeStep(0.0f),
+    _randomState(0)
 {
     GP_ASSERT(particleCountMax);
     _particles = new Particle[particleCountMax];
+
+    // Seed this emitter's random sequence from the global one (never with zero), so
+    // emitters still differ from each other and follow srand().
+    _randomState = (unsigned int)rand() + 1;
 }
 
 ParticleEmitter::~ParticleEmitter()
 {
     SAFE_DELETE(_spriteBatch);
     SAFE_DELETE_ARRAY(_particles);
+    SAFE_DELETE_ARRAY(_particleStreams);
+    SAFE_DELETE_ARRAY(_particleFrames);
+    SAFE_DELETE_ARRAY(_particleLiveIndices);
     SAFE_DELETE_ARRAY(_spriteTextureCoords);
 }
 
@@ -175,6 +215,8 @@ ParticleEmitter* ParticleEmitter::create(Properties* properties)
     bool orbitPosition = properties->getBool("orbitPosition");
     bool orbitVelocity = properties->getBool("orbitVelocity");
     bool orbitAcceleration = properties->getBool("orbitAcceleration");
+    const char* storage = properties->getString("storage");
+    float fixedTimeStep = properties->getFloat("fixedTimeStep");
 
     // Apply all properties to a newly created ParticleEmitter.
     ParticleEmitter* emitter = ParticleEmitter::create(texturePath.c_str(), blendMode, particleCountMax);
@@ -199,6 +241,9 @@ ParticleEmitter* ParticleEmitter::create(Properties* properties)
     emitter->setSpriteFrameDuration(spriteFrameDuration);
     emitter->setSpriteFrameCoords(spriteFrameCount, spriteWidth, spriteHeight);
     emitter->setOrbit(orbitPosition, orbitVelocity, orbitAcceleration);
+    if (storage && strcmp(storage, "SOA") == 0)
+        emitter->setStorageMode(STORAGE_SOA);
+    emitter->setFixedTimeStep(fixedTimeStep);
 
     return emitter;
 }
@@ -273,7 +318,7 @@ void ParticleEmitter::setEmissionRate(unsigned int rate)
 void ParticleEmitter::start()
 {
     _started = true;
-    _lastUpdated = 0;
+    _updateTime = 0;
 }
 
 void ParticleEmitter::stop()
@@ -300,7 +345,7 @@ bool ParticleEmitter::isActive() const
 void ParticleEmitter::emitOnce(unsigned int particleCount)
 {
     GP_ASSERT(_node);
-    GP_ASSERT(_particles);
+    GP_ASSERT(_particles || _particleStreams);
 
     // Limit particleCount so as not to go over _particleCountMax.
     if (particleCount + _particleCount > _particleCountMax)
@@ -318,9 +363,11 @@ void ParticleEmitter::emitOnce(unsigned int particleCount)
     world.m[14] = 0.0f;
 
     // Emit the new particles.
+    Particle particle;
     for (unsigned int i = 0; i < particleCount; i++)
     {
-        Particle* p = &_particles[_particleCount];
+        // Particles stored as attribute arrays are generated into a temporary first.
+        Particle* p = (_storageMode == STORAGE_SOA) ? &particle : &_particles[_particleCount];
 
         generateColor(_colorStart, _colorStartVar, &p->_colorStart);
         generateColor(_colorEnd, _colorEndVar, &p->_colorEnd);
@@ -368,7 +415,7 @@ void ParticleEmitter::emitOnce(unsigned int particleCount)
         // Initial sprite frame.
         if (_spriteFrameRandomOffset > 0)
         {
-            p->_frame = rand() % _spriteFrameRandomOffset;
+            p->_frame = generateRandom() % _spriteFrameRandomOffset;
         }
         else
         {
@@ -376,6 +423,9 @@ void ParticleEmitter::emitOnce(unsigned int particleCount)
         }
         p->_timeOnCurrentFrame = 0.0f;
 
+        if (_storageMode == STORAGE_SOA)
+            storeParticle(_particleCount, *p);
+
         ++_particleCount;
     }
 }
@@ -597,6 +647,45 @@ ParticleEmitter::BlendMode ParticleEmitter::getBlendMode() const
     return _spriteBlendMode;
 }
 
+void ParticleEmitter::setStorageMode(StorageMode mode)
+{
+    if (_storageMode == mode)
+        return;
+
+    if (mode == STORAGE_SOA)
+    {
+        // Round the arrays up to a multiple of four particles for the SIMD kernel.
+        _particleStreamStride = (_particleCountMax + 3) & ~3u;
+        _particleStreams = new float[STREAM_COUNT * _particleStreamStride];
+        _particleFrames = new unsigned int[_particleStreamStride];
+        _particleLiveIndices = new unsigned int[_particleStreamStride];
+        _storageMode = mode;
+        for (unsigned int i = 0; i < _particleCount; ++i)
+        {
+            storeParticle(i, _particles[i]);
+        }
+        SAFE_DELETE_ARRAY(_particles);
+    }
+    else
+    {
+        _particles = new Particle[_particleCountMax];
+        for (unsigned int i = 0; i < _particleCount; ++i)
+        {
+            loadParticle(i, &_particles[i]);
+        }
+        SAFE_DELETE_ARRAY(_particleStreams);
+        SAFE_DELETE_ARRAY(_particleFrames);
+        SAFE_DELETE_ARRAY(_particleLiveIndices);
+        _particleStreamStride = 0;
+        _storageMode = mode;
+    }
+}
+
+ParticleEmitter::StorageMode ParticleEmitter::getStorageMode() const
+{
+    return _storageMode;
+}
+
 void ParticleEmitter::setSpriteAnimated(bool animated)
 {
     _spriteAnimated = animated;
@@ -744,6 +833,28 @@ bool ParticleEmitter::getOrbitAcceleration() const
     return _orbitAcceleration;
 }
 
+unsigned int ParticleEmitter::generateRandom()
+{
+    // Xorshift: not a very good RNG, but it should be suitable for our purposes.
+    unsigned int x = _randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _randomState = x;
+    return x;
+}
+
+float ParticleEmitter::generateRandom0To1()
+{
+    // Use the upper 24 bits, which are exactly representable as a float.
+    return (float)(generateRandom() >> 8) / 16777215.0f;
+}
+
+float ParticleEmitter::generateRandomMinus1To1()
+{
+    return 2.0f * generateRandom0To1() - 1.0f;
+}
+
 long ParticleEmitter::generateScalar(long min, long max)
 {
     // Note: this is not a very good RNG, but it should be suitable for our purposes.
@@ -751,7 +862,7 @@ long ParticleEmitter::generateScalar(long min, long max)
     for (unsigned int i = 0; i < sizeof(long)/sizeof(int); i++)
     {
         r = r << 8; // sizeof(int) * CHAR_BITS
-        r |= rand();
+        r |= (long)(generateRandom() & 0x7fffffff);
     }
 
     // Now we have a random long between 0 and MAX_LONG.  We need to clamp it between min and max.
@@ -763,7 +874,7 @@ long ParticleEmitter::generateScalar(long min, long max)
 
 float ParticleEmitter::generateScalar(float min, float max)
 {
-    return min + (max - min) * MATH_RANDOM_0_1();
+    return min + (max - min) * generateRandom0To1();
 }
 
 void ParticleEmitter::generateVectorInRect(const Vector3& base, const Vector3& variance, Vector3* dst)
@@ -772,9 +883,9 @@ void ParticleEmitter::generateVectorInRect(const Vector3& base, const Vector3& v
 
     // Scale each component of the variance vector by a random float
     // between -1 and 1, then add this to the corresponding base component.
-    dst->x = base.x + variance.x * MATH_RANDOM_MINUS1_1();
-    dst->y = base.y + variance.y * MATH_RANDOM_MINUS1_1();
-    dst->z = base.z + variance.z * MATH_RANDOM_MINUS1_1();
+    dst->x = base.x + variance.x * generateRandomMinus1To1();
+    dst->y = base.y + variance.y * generateRandomMinus1To1();
+    dst->z = base.z + variance.z * generateRandomMinus1To1();
 }
 
 void ParticleEmitter::generateVectorInEllipsoid(const Vector3& center, const Vector3& scale, Vector3* dst)
@@ -784,9 +895,9 @@ void ParticleEmitter::generateVectorInEllipsoid(const Vector3& center, const Vec
     // Generate a point within a unit cube, then reject if the point is not in a unit sphere.
     do
     {
-        dst->x = MATH_RANDOM_MINUS1_1();
-        dst->y = MATH_RANDOM_MINUS1_1();
-        dst->z = MATH_RANDOM_MINUS1_1();
+        dst->x = generateRandomMinus1To1();
+        dst->y = generateRandomMinus1To1();
+        dst->z = generateRandomMinus1To1();
     } while (dst->length() > 1.0f);
     
     // Scale this point by the scaling vector.
@@ -816,10 +927,10 @@ void ParticleEmitter::generateColor(const Vector4& base, const Vector4& variance
 
     // Scale each component of the variance color by a random float
     // between -1 and 1, then add this to the corresponding base component.
-    dst->x = base.x + variance.x * MATH_RANDOM_MINUS1_1();
-    dst->y = base.y + variance.y * MATH_RANDOM_MINUS1_1();
-    dst->z = base.z + variance.z * MATH_RANDOM_MINUS1_1();
-    dst->w = base.w + variance.w * MATH_RANDOM_MINUS1_1();
+    dst->x = base.x + variance.x * generateRandomMinus1To1();
+    dst->y = base.y + variance.y * generateRandomMinus1To1();
+    dst->z = base.z + variance.z * generateRandomMinus1To1();
+    dst->w = base.w + variance.w * generateRandomMinus1To1();
 }
 
 ParticleEmitter::BlendMode ParticleEmitter::getBlendModeFromString(const char* str)
@@ -856,22 +967,53 @@ ParticleEmitter::BlendMode ParticleEmitter::getBlendModeFromString(const char* s
     }
 }
 
+void ParticleEmitter::setFixedTimeStep(float step)
+{
+    GP_ASSERT(step >= 0.0f);
+    _fixedTimeStep = step;
+}
+
+float ParticleEmitter::getFixedTimeStep() const
+{
+    return _fixedTimeStep;
+}
+
 void ParticleEmitter::update(float elapsedTime)
 {
     if (!isActive())
         return;
 
+    _updateTime += elapsedTime;
+
+    if (_fixedTimeStep > 0.0f)
+    {
+        // Consume the accumulated time in fixed steps, dropping whatever exceeds
+        // the step budget for this update.
+        unsigned int steps = 0;
+        while (_updateTime >= _fixedTimeStep && steps < PARTICLE_FIXED_STEPS_MAX)
+        {
+            simulate(_fixedTimeStep);
+            _updateTime -= _fixedTimeStep;
+            ++steps;
+        }
+        if (_updateTime >= _fixedTimeStep)
+            _updateTime = fmod(_updateTime, (double)_fixedTimeStep);
+        return;
+    }
+
     // Cap particle updates at a maximum rate. This saves processing
     // and also improves precision since updating with very small
     // time increments is more lossy.
-    static double runningTime = 0;
-    runningTime += elapsedTime;
-    if (runningTime < PARTICLE_UPDATE_RATE_MAX)
-        return;    
+    if (_updateTime < PARTICLE_UPDATE_RATE_MAX)
+        return;
 
-    float elapsedMs = runningTime;
-    runningTime = 0;
+    float elapsedMs = (float)_updateTime;
+    _updateTime = 0;
+    simulate(elapsedMs);
+}
 
+void ParticleEmitter::simulate(float elapsedMs)
+{
     float elapsedSecs = elapsedMs * 0.001f;
 
     if (_started && _emissionRate)
@@ -893,6 +1035,12 @@ void ParticleEmitter::update(float elapsedTime)
         }
     }
 
+    if (_storageMode == STORAGE_SOA)
+    {
+        updateParticleStreams(elapsedMs, elapsedSecs);
+        return;
+    }
+
     // Now update all currently living particles.
     GP_ASSERT(_particles);
     for (unsigned int particlesIndex = 0; particlesIndex < _particleCount; ++particlesIndex)
@@ -987,7 +1135,7 @@ unsigned int ParticleEmitter::draw(bool wireframe)
     if (_particleCount > 0)
     {
         GP_ASSERT(_spriteBatch);
-        GP_ASSERT(_particles);
+        GP_ASSERT(_particles || _particleStreams);
         GP_ASSERT(_spriteTextureCoords);
 
         // Set our node's view projection matrix to this emitter's effect.
@@ -1011,13 +1159,41 @@ unsigned int ParticleEmitter::draw(bool wireframe)
         Vector3 up;
         cameraWorldMatrix.getUpVector(&up);
 
-        for (unsigned int i = 0; i < _particleCount; i++)
+        if (_storageMode == STORAGE_SOA)
+        {
+            const float* positionX = getParticleStream(STREAM_POSITION_X);
+            const float* positionY = getParticleStream(STREAM_POSITION_Y);
+            const float* positionZ = getParticleStream(STREAM_POSITION_Z);
+            const float* colorR = getParticleStream(STREAM_COLOR_R);
+            const float* colorG = getParticleStream(STREAM_COLOR_G);
+            const float* colorB = getParticleStream(STREAM_COLOR_B);
+            const float* colorA = getParticleStream(STREAM_COLOR_A);
+            const float* size = getParticleStream(STREAM_SIZE);
+            const float* angle = getParticleStream(STREAM_ANGLE);
+
+            Vector3 position;
+            Vector4 color;
+            for (unsigned int i = 0; i < _particleCount; i++)
+            {
+                position.set(positionX[i], positionY[i], positionZ[i]);
+                color.set(colorR[i], colorG[i], colorB[i], colorA[i]);
+                const float* texCoords = &_spriteTextureCoords[_particleFrames[i] * 4];
+
+                _spriteBatch->draw(position, right, up, size[i], size[i],
+                                    texCoords[0], texCoords[1], texCoords[2], texCoords[3],
+                                    color, pivot, angle[i]);
+            }
+        }
+        else
         {
-            Particle* p = &_particles[i];
+            for (unsigned int i = 0; i < _particleCount; i++)
+            {
+                Particle* p = &_particles[i];
 
-            _spriteBatch->draw(p->_position, right, up, p->_size, p->_size,
-                                _spriteTextureCoords[p->_frame * 4], _spriteTextureCoords[p->_frame * 4 + 1], _spriteTextureCoords[p->_frame * 4 + 2], _spriteTextureCoords[p->_frame * 4 + 3],
-                                p->_color, pivot, p->_angle);
+                _spriteBatch->draw(p->_position, right, up, p->_size, p->_size,
+                                    _spriteTextureCoords[p->_frame * 4], _spriteTextureCoords[p->_frame * 4 + 1], _spriteTextureCoords[p->_frame * 4 + 2], _spriteTextureCoords[p->_frame * 4 + 3],
+                                    p->_color, pivot, p->_angle);
+            }
         }
 
         // Render.
@@ -1064,8 +1240,270 @@ Drawable* ParticleEmitter::clone(NodeCloneContext& context)
     clone->_orbitPosition = _orbitPosition;
     clone->_orbitVelocity = _orbitVelocity;
     clone->_orbitAcceleration = _orbitAcceleration;
+    clone->setStorageMode(_storageMode);
+    clone->_fixedTimeStep = _fixedTimeStep;
 
     return clone;
 }
 
+float* ParticleEmitter::getParticleStream(unsigned int stream) const
+{
+    GP_ASSERT(_particleStreams && stream < STREAM_COUNT);
+    return _particleStreams + stream * _particleStreamStride;
+}
+
+void ParticleEmitter::storeParticle(unsigned int index, const Particle& particle)
+{
+    GP_ASSERT(index < _particleStreamStride);
+
+    float* streams = _particleStreams + index;
+    const unsigned int stride = _particleStreamStride;
+    streams[STREAM_POSITION_X * stride] = particle._position.x;
+    streams[STREAM_POSITION_Y * stride] = particle._position.y;
+    streams[STREAM_POSITION_Z * stride] = particle._position.z;
+    streams[STREAM_VELOCITY_X * stride] = particle._velocity.x;
+    streams[STREAM_VELOCITY_Y * stride] = particle._velocity.y;
+    streams[STREAM_VELOCITY_Z * stride] = particle._velocity.z;
+    streams[STREAM_ACCELERATION_X * stride] = particle._acceleration.x;
+    streams[STREAM_ACCELERATION_Y * stride] = particle._acceleration.y;
+    streams[STREAM_ACCELERATION_Z * stride] = particle._acceleration.z;
+    streams[STREAM_COLOR_START_R * stride] = particle._colorStart.x;
+    streams[STREAM_COLOR_START_G * stride] = particle._colorStart.y;
+    streams[STREAM_COLOR_START_B * stride] = particle._colorStart.z;
+    streams[STREAM_COLOR_START_A * stride] = particle._colorStart.w;
+    streams[STREAM_COLOR_END_R * stride] = particle._colorEnd.x;
+    streams[STREAM_COLOR_END_G * stride] = particle._colorEnd.y;
+    streams[STREAM_COLOR_END_B * stride] = particle._colorEnd.z;
+    streams[STREAM_COLOR_END_A * stride] = particle._colorEnd.w;
+    streams[STREAM_COLOR_R * stride] = particle._color.x;
+    streams[STREAM_COLOR_G * stride] = particle._color.y;
+    streams[STREAM_COLOR_B * stride] = particle._color.z;
+    streams[STREAM_COLOR_A * stride] = particle._color.w;
+    streams[STREAM_ROTATION_PER_PARTICLE_SPEED * stride] = particle._rotationPerParticleSpeed;
+    streams[STREAM_ROTATION_AXIS_X * stride] = particle._rotationAxis.x;
+    streams[STREAM_ROTATION_AXIS_Y * stride] = particle._rotationAxis.y;
+    streams[STREAM_ROTATION_AXIS_Z * stride] = particle._rotationAxis.z;
+    streams[STREAM_ROTATION_SPEED * stride] = particle._rotationSpeed;
+    streams[STREAM_ANGLE * stride] = particle._angle;
+    streams[STREAM_ENERGY_START * stride] = (float)particle._energyStart;
+    streams[STREAM_ENERGY * stride] = (float)particle._energy;
+    streams[STREAM_SIZE_START * stride] = particle._sizeStart;
+    streams[STREAM_SIZE_END * stride] = particle._sizeEnd;
+    streams[STREAM_SIZE * stride] = particle._size;
+    streams[STREAM_TIME_ON_CURRENT_FRAME * stride] = particle._timeOnCurrentFrame;
+    _particleFrames[index] = particle._frame;
+}
+
+void ParticleEmitter::loadParticle(unsigned int index, Particle* particle) const
+{
+    GP_ASSERT(particle);
+    GP_ASSERT(index < _particleStreamStride);
+
+    const float* streams = _particleStreams + index;
+    const unsigned int stride = _particleStreamStride;
+    particle->_position.set(streams[STREAM_POSITION_X * stride], streams[STREAM_POSITION_Y * stride], streams[STREAM_POSITION_Z * stride]);
+    particle->_velocity.set(streams[STREAM_VELOCITY_X * stride], streams[STREAM_VELOCITY_Y * stride], streams[STREAM_VELOCITY_Z * stride]);
+    particle->_acceleration.set(streams[STREAM_ACCELERATION_X * stride], streams[STREAM_ACCELERATION_Y * stride], streams[STREAM_ACCELERATION_Z * stride]);
+    particle->_colorStart.set(streams[STREAM_COLOR_START_R * stride], streams[STREAM_COLOR_START_G * stride], streams[STREAM_COLOR_START_B * stride], streams[STREAM_COLOR_START_A * stride]);
+    particle->_colorEnd.set(streams[STREAM_COLOR_END_R * stride], streams[STREAM_COLOR_END_G * stride], streams[STREAM_COLOR_END_B * stride], streams[STREAM_COLOR_END_A * stride]);
+    particle->_color.set(streams[STREAM_COLOR_R * stride], streams[STREAM_COLOR_G * stride], streams[STREAM_COLOR_B * stride], streams[STREAM_COLOR_A * stride]);
+    particle->_rotationPerParticleSpeed = streams[STREAM_ROTATION_PER_PARTICLE_SPEED * stride];
+    particle->_rotationAxis.set(streams[STREAM_ROTATION_AXIS_X * stride], streams[STREAM_ROTATION_AXIS_Y * stride], streams[STREAM_ROTATION_AXIS_Z * stride]);
+    particle->_rotationSpeed = streams[STREAM_ROTATION_SPEED * stride];
+    particle->_angle = streams[STREAM_ANGLE * stride];
+    particle->_energyStart = (long)streams[STREAM_ENERGY_START * stride];
+    particle->_energy = (long)streams[STREAM_ENERGY * stride];
+    particle->_sizeStart = streams[STREAM_SIZE_START * stride];
+    particle->_sizeEnd = streams[STREAM_SIZE_END * stride];
+    particle->_size = streams[STREAM_SIZE * stride];
+    particle->_timeOnCurrentFrame = streams[STREAM_TIME_ON_CURRENT_FRAME * stride];
+    particle->_frame = _particleFrames[index];
+}
+
+void ParticleEmitter::updateParticleStreams(float elapsedMs, float elapsedSecs)
+{
+    // Each particle is simulated independently, so large emitters are split into
+    // chunks that run across the worker threads.
+    WorkerPool* workerPool = Game::getInstance()->getWorkerPool();
+    if (workerPool && _particleCount >= PARTICLE_PARALLEL_GRAIN_SIZE * 2)
+    {
+        workerPool->parallelFor(_particleCount, PARTICLE_PARALLEL_GRAIN_SIZE, [this, elapsedMs, elapsedSecs](unsigned int begin, unsigned int end)
+        {
+            simulateParticleStreams(begin, end, elapsedMs, elapsedSecs);
+        });
+    }
+    else
+    {
+        simulateParticleStreams(0, _particleCount, elapsedMs, elapsedSecs);
+    }
+
+    compactParticleStreams();
+}
+
+void ParticleEmitter::simulateParticleStreams(unsigned int begin, unsigned int end, float elapsedMs, float elapsedSecs)
+{
+    float* position[3] = { getParticleStream(STREAM_POSITION_X), getParticleStream(STREAM_POSITION_Y), getParticleStream(STREAM_POSITION_Z) };
+    float* velocity[3] = { getParticleStream(STREAM_VELOCITY_X), getParticleStream(STREAM_VELOCITY_Y), getParticleStream(STREAM_VELOCITY_Z) };
+    float* acceleration[3] = { getParticleStream(STREAM_ACCELERATION_X), getParticleStream(STREAM_ACCELERATION_Y), getParticleStream(STREAM_ACCELERATION_Z) };
+    float* colorStart[4] = { getParticleStream(STREAM_COLOR_START_R), getParticleStream(STREAM_COLOR_START_G), getParticleStream(STREAM_COLOR_START_B), getParticleStream(STREAM_COLOR_START_A) };
+    float* colorEnd[4] = { getParticleStream(STREAM_COLOR_END_R), getParticleStream(STREAM_COLOR_END_G), getParticleStream(STREAM_COLOR_END_B), getParticleStream(STREAM_COLOR_END_A) };
+    float* color[4] = { getParticleStream(STREAM_COLOR_R), getParticleStream(STREAM_COLOR_G), getParticleStream(STREAM_COLOR_B), getParticleStream(STREAM_COLOR_A) };
+    float* rotationPerParticleSpeed = getParticleStream(STREAM_ROTATION_PER_PARTICLE_SPEED);
+    float* angle = getParticleStream(STREAM_ANGLE);
+    float* energyStart = getParticleStream(STREAM_ENERGY_START);
+    float* energy = getParticleStream(STREAM_ENERGY);
+    float* sizeStart = getParticleStream(STREAM_SIZE_START);
+    float* sizeEnd = getParticleStream(STREAM_SIZE_END);
+    float* size = getParticleStream(STREAM_SIZE);
+
+    // Rotate velocity and acceleration around each particle's rotation axis (Rodrigues' formula).
+    if (_rotationSpeedMin != 0.0f || _rotationSpeedMax != 0.0f)
+    {
+        const float* rotationSpeed = getParticleStream(STREAM_ROTATION_SPEED);
+        const float* axis[3] = { getParticleStream(STREAM_ROTATION_AXIS_X), getParticleStream(STREAM_ROTATION_AXIS_Y), getParticleStream(STREAM_ROTATION_AXIS_Z) };
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            float x = axis[0][i];
+            float y = axis[1][i];
+            float z = axis[2][i];
+            float length = sqrt(x * x + y * y + z * z);
+            if (rotationSpeed[i] == 0.0f || length == 0.0f)
+                continue;
+
+            x /= length;
+            y /= length;
+            z /= length;
+            float c = cos(rotationSpeed[i] * elapsedSecs);
+            float s = sin(rotationSpeed[i] * elapsedSecs);
+            float t = 1.0f - c;
+
+            float** vectors[2] = { velocity, acceleration };
+            for (unsigned int v = 0; v < 2; ++v)
+            {
+                float vx = vectors[v][0][i];
+                float vy = vectors[v][1][i];
+                float vz = vectors[v][2][i];
+                float d = (x * vx + y * vy + z * vz) * t;
+                vectors[v][0][i] = vx * c + (y * vz - z * vy) * s + x * d;
+                vectors[v][1][i] = vy * c + (z * vx - x * vz) * s + y * d;
+                vectors[v][2][i] = vz * c + (x * vy - y * vx) * s + z * d;
+            }
+        }
+    }
+
+    // Integrate and interpolate color and size over the particles' lifetime.
+    unsigned int i = begin;
+#ifdef PARTICLE_SIMD
+    ParticleVector elapsedMsVector = simdSet(elapsedMs);
+    ParticleVector elapsedSecsVector = simdSet(elapsedSecs);
+    ParticleVector oneVector = simdSet(1.0f);
+    for (; i + 4 <= end; i += 4)
+    {
+        ParticleVector e = simdSub(simdLoad(energy + i), elapsedMsVector);
+        simdStore(energy + i, e);
+        ParticleVector percent = simdSub(oneVector, simdDiv(e, simdLoad(energyStart + i)));
+
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            ParticleVector v = simdAdd(simdLoad(velocity[c] + i), simdMul(simdLoad(acceleration[c] + i), elapsedSecsVector));
+            simdStore(velocity[c] + i, v);
+            simdStore(position[c] + i, simdAdd(simdLoad(position[c] + i), simdMul(v, elapsedSecsVector)));
+        }
+
+        simdStore(angle + i, simdAdd(simdLoad(angle + i), simdMul(simdLoad(rotationPerParticleSpeed + i), elapsedSecsVector)));
+
+        for (unsigned int c = 0; c < 4; ++c)
+        {
+            ParticleVector from = simdLoad(colorStart[c] + i);
+            simdStore(color[c] + i, simdAdd(from, simdMul(simdSub(simdLoad(colorEnd[c] + i), from), percent)));
+        }
+
+        ParticleVector from = simdLoad(sizeStart + i);
+        simdStore(size + i, simdAdd(from, simdMul(simdSub(simdLoad(sizeEnd + i), from), percent)));
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        energy[i] -= elapsedMs;
+        float percent = 1.0f - (energy[i] / energyStart[i]);
+
+        for (unsigned int c = 0; c < 3; ++c)
+        {
+            velocity[c][i] += acceleration[c][i] * elapsedSecs;
+            position[c][i] += velocity[c][i] * elapsedSecs;
+        }
+
+        angle[i] += rotationPerParticleSpeed[i] * elapsedSecs;
+
+        for (unsigned int c = 0; c < 4; ++c)
+        {
+            color[c][i] = colorStart[c][i] + (colorEnd[c][i] - colorStart[c][i]) * percent;
+        }
+
+        size[i] = sizeStart[i] + (sizeEnd[i] - sizeStart[i]) * percent;
+    }
+
+    // Handle sprite animations.
+    if (_spriteAnimated)
+    {
+        float* timeOnCurrentFrame = getParticleStream(STREAM_TIME_ON_CURRENT_FRAME);
+        for (i = begin; i < end; ++i)
+        {
+            unsigned int& frame = _particleFrames[i];
+            if (!_spriteLooped)
+            {
+                // The last frame should finish exactly when the particle dies.
+                float percent = 1.0f - (energy[i] / energyStart[i]);
+                timeOnCurrentFrame[i] = percent - frame * _spritePercentPerFrame;
+                if (frame < _spriteFrameCount - 1 && timeOnCurrentFrame[i] >= _spritePercentPerFrame)
+                {
+                    ++frame;
+                }
+            }
+            else
+            {
+                timeOnCurrentFrame[i] += elapsedSecs;
+                if (timeOnCurrentFrame[i] >= _spriteFrameDurationSecs)
+                {
+                    timeOnCurrentFrame[i] -= _spriteFrameDurationSecs;
+                    if (++frame == _spriteFrameCount)
+                    {
+                        frame = 0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void ParticleEmitter::compactParticleStreams()
+{
+    // Gather the indices of the living particles without branching, then move each
+    // attribute array down over the dead particles (keeping the particles in order).
+    const float* energy = getParticleStream(STREAM_ENERGY);
+    unsigned int liveCount = 0;
+    for (unsigned int i = 0; i < _particleCount; ++i)
+    {
+        _particleLiveIndices[liveCount] = i;
+        liveCount += (energy[i] > 0.0f) ? 1 : 0;
+    }
+
+    if (liveCount == _particleCount)
+        return;
+
+    for (unsigned int s = 0; s < STREAM_COUNT; ++s)
+    {
+        float* stream = getParticleStream(s);
+        for (unsigned int i = 0; i < liveCount; ++i)
+        {
+            stream[i] = stream[_particleLiveIndices[i]];
+        }
+    }
+    for (unsigned int i = 0; i < liveCount; ++i)
+    {
+        _particleFrames[i] = _particleFrames[_particleLiveIndices[i]];
+    }
+    _particleCount = liveCount;
+}
+
 }
@@ -156,6 +156,24 @@ public:
         BLEND_MULTIPLIED
     };
 
+    /**
+     * Defines the layouts used to store the particles of an emitter.
+     */
+    enum StorageMode
+    {
+        /**
+         * Each particle is stored as a single structure (the default).
+         */
+        STORAGE_INTERLEAVED,
+
+        /**
+         * Each particle attribute is stored in its own contiguous array, allowing
+         * the particles to be simulated with SIMD instructions and, for large
+         * emitters, across the game's worker threads.
+         */
+        STORAGE_SOA
+    };
+
     /**
      * Creates a particle emitter using the data from the Properties object defined at the specified URL, 
      * where the URL is of the format "<file-path>.<extension>#<namespace-id>/<namespace-id>/.../<namespace-id>"
@@ -700,9 +718,50 @@ public:
      */
     BlendMode getBlendMode() const;
 
+    /**
+     * Sets the layout used to store the particles of this emitter.
+     *
+     * Particles that are currently alive are preserved when the layout is changed.
+     * The STORAGE_SOA layout is recommended for emitters with many particles.
+     *
+     * @param mode The new storage mode.
+     */
+    void setStorageMode(StorageMode mode);
+
+    /**
+     * Gets the layout used to store the particles of this emitter.
+     *
+     * @return The current storage mode.
+     */
+    StorageMode getStorageMode() const;
+
+    /**
+     * Sets the fixed time step used to simulate this emitter's particles.
+     *
+     * By default (a step of zero) the elapsed time is accumulated until at least
+     * a few milliseconds have passed and the particles are then simulated in a
+     * single step. With a fixed time step the accumulated time is consumed in
+     * steps of exactly the given length, which makes the simulation independent
+     * of the frame rate. Each update runs a bounded number of steps; time beyond
+     * that is dropped so a slow frame cannot stall later ones.
+     *
+     * @param step The length of a simulation step in milliseconds, or zero to disable fixed stepping.
+     */
+    void setFixedTimeStep(float step);
+
+    /**
+     * Gets the fixed time step used to simulate this emitter's particles.
+     *
+     * @return The length of a simulation step in milliseconds, or zero if fixed stepping is disabled.
+     */
+    float getFixedTimeStep() const;
+
     /**
      * Updates the particles currently being emitted.
      *
+     * Each emitter keeps its own accumulated time, so emitters can be updated
+     * independently of one another (see ParticleEmitterPool).
+     *
      * @param elapsedTime The amount of time that has passed since the last call to update(), in milliseconds.
      */
     void update(float elapsedTime);
@@ -746,6 +805,17 @@ private:
      */
     ParticleEmitter& operator=(const ParticleEmitter&);
 
+    // Generates the next value of this emitter's random sequence. Each emitter owns its
+    // sequence so that emitters updated concurrently neither race on nor reorder the
+    // shared state of rand().
+    unsigned int generateRandom();
+
+    // Generates a random float between 0 and 1 from this emitter's random sequence.
+    float generateRandom0To1();
+
+    // Generates a random float between -1 and 1 from this emitter's random sequence.
+    float generateRandomMinus1To1();
+
     // Generates a scalar within the range defined by min and max.
     float generateScalar(float min, float max);
 
@@ -765,6 +835,70 @@ private:
     // Gets the blend mode from string.
     static ParticleEmitter::BlendMode getBlendModeFromString(const char* src);
 
+    /**
+     * Defines the particle attribute arrays used by the STORAGE_SOA layout.
+     */
+    enum ParticleStream
+    {
+        STREAM_POSITION_X,
+        STREAM_POSITION_Y,
+        STREAM_POSITION_Z,
+        STREAM_VELOCITY_X,
+        STREAM_VELOCITY_Y,
+        STREAM_VELOCITY_Z,
+        STREAM_ACCELERATION_X,
+        STREAM_ACCELERATION_Y,
+        STREAM_ACCELERATION_Z,
+        STREAM_COLOR_START_R,
+        STREAM_COLOR_START_G,
+        STREAM_COLOR_START_B,
+        STREAM_COLOR_START_A,
+        STREAM_COLOR_END_R,
+        STREAM_COLOR_END_G,
+        STREAM_COLOR_END_B,
+        STREAM_COLOR_END_A,
+        STREAM_COLOR_R,
+        STREAM_COLOR_G,
+        STREAM_COLOR_B,
+        STREAM_COLOR_A,
+        STREAM_ROTATION_PER_PARTICLE_SPEED,
+        STREAM_ROTATION_AXIS_X,
+        STREAM_ROTATION_AXIS_Y,
+        STREAM_ROTATION_AXIS_Z,
+        STREAM_ROTATION_SPEED,
+        STREAM_ANGLE,
+        STREAM_ENERGY_START,
+        STREAM_ENERGY,
+        STREAM_SIZE_START,
+        STREAM_SIZE_END,
+        STREAM_SIZE,
+        STREAM_TIME_ON_CURRENT_FRAME,
+        STREAM_COUNT
+    };
+
+    // Gets the array holding the given attribute of all particles (STORAGE_SOA only).
+    float* getParticleStream(unsigned int stream) const;
+
+    class Particle;
+
+    // Copies a particle into the attribute arrays at the given index.
+    void storeParticle(unsigned int index, const Particle& particle);
+
+    // Copies the particle at the given index out of the attribute arrays.
+    void loadParticle(unsigned int index, Particle* particle) const;
+
+    // Updates the particles stored in the attribute arrays.
+    void updateParticleStreams(float elapsedMs, float elapsedSecs);
+
+    // Simulates the particles in the range [begin, end) of the attribute arrays.
+    void simulateParticleStreams(unsigned int begin, unsigned int end, float elapsedMs, float elapsedSecs);
+
+    // Removes the dead particles from the attribute arrays.
+    void compactParticleStreams();
+
+    // Emits new particles and simulates the living particles over the given time.
+    void simulate(float elapsedMs);
+
     /**
      * Defines the data for a single particle in the system.
      */
@@ -794,6 +928,11 @@ private:
     unsigned int _particleCountMax;
     unsigned int _particleCount;
     Particle* _particles;
+    StorageMode _storageMode;
+    float* _particleStreams;
+    unsigned int _particleStreamStride;
+    unsigned int* _particleFrames;
+    unsigned int* _particleLiveIndices;
     unsigned int _emissionRate;
     bool _started;
     bool _ellipsoid;
@@ -839,7 +978,9 @@ private:
     bool _orbitAcceleration;
     float _timePerEmission;
     float _emitTime;
-    double _lastUpdated;
+    double _updateTime;
+    float _fixedTimeStep;
+    unsigned int _randomState;
 };
 
 }
@@ -0,0 +1,110 @@
+#include "Base.h"
+#include "ParticleEmitterPool.h"
+#include "Game.h"
+#include "Node.h"
+
+namespace gameplay
+{
+
+ParticleEmitterPool::ParticleEmitterPool(bool parallel)
+    : _parallel(parallel)
+{
+}
+
+ParticleEmitterPool::~ParticleEmitterPool()
+{
+    removeAllEmitters();
+}
+
+ParticleEmitterPool* ParticleEmitterPool::create(bool parallel)
+{
+    return new ParticleEmitterPool(parallel);
+}
+
+void ParticleEmitterPool::addEmitter(ParticleEmitter* emitter)
+{
+    GP_ASSERT(emitter);
+
+    if (std::find(_emitters.begin(), _emitters.end(), emitter) != _emitters.end())
+        return;
+
+    emitter->addRef();
+    _emitters.push_back(emitter);
+}
+
+void ParticleEmitterPool::removeEmitter(ParticleEmitter* emitter)
+{
+    std::vector<ParticleEmitter*>::iterator itr = std::find(_emitters.begin(), _emitters.end(), emitter);
+    if (itr != _emitters.end())
+    {
+        _emitters.erase(itr);
+        SAFE_RELEASE(emitter);
+    }
+}
+
+void ParticleEmitterPool::removeAllEmitters()
+{
+    for (size_t i = 0, count = _emitters.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_emitters[i]);
+    }
+    _emitters.clear();
+}
+
+unsigned int ParticleEmitterPool::getEmitterCount() const
+{
+    return (unsigned int)_emitters.size();
+}
+
+ParticleEmitter* ParticleEmitterPool::getEmitter(unsigned int index) const
+{
+    GP_ASSERT(index < _emitters.size());
+    return _emitters[index];
+}
+
+void ParticleEmitterPool::setParallel(bool parallel)
+{
+    _parallel = parallel;
+}
+
+bool ParticleEmitterPool::isParallel() const
+{
+    return _parallel;
+}
+
+void ParticleEmitterPool::update(float elapsedTime)
+{
+    // Gather the active emitters. Emitting reads the world matrix of the emitter's
+    // node, so resolve those here since nodes may share dirty ancestors.
+    _activeEmitters.clear();
+    for (size_t i = 0, count = _emitters.size(); i < count; ++i)
+    {
+        ParticleEmitter* emitter = _emitters[i];
+        GP_ASSERT(emitter);
+        if (!emitter->isActive())
+            continue;
+
+        if (emitter->getNode())
+            emitter->getNode()->getWorldMatrix();
+        _activeEmitters.push_back(emitter);
+    }
+
+    WorkerPool* workerPool = Game::getInstance()->getWorkerPool();
+    if (_parallel && workerPool && _activeEmitters.size() > 1)
+    {
+        workerPool->parallelFor((unsigned int)_activeEmitters.size(), 1, [this, elapsedTime](unsigned int begin, unsigned int end)
+        {
+            for (unsigned int i = begin; i < end; ++i)
+                _activeEmitters[i]->update(elapsedTime);
+        });
+    }
+    else
+    {
+        for (size_t i = 0, count = _activeEmitters.size(); i < count; ++i)
+        {
+            _activeEmitters[i]->update(elapsedTime);
+        }
+    }
+}
+
+}
@@ -0,0 +1,119 @@
+#ifndef PARTICLEEMITTERPOOL_H_
+#define PARTICLEEMITTERPOOL_H_
+
+#include "ParticleEmitter.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a collection of particle emitters that are updated together.
+ *
+ * Instead of calling ParticleEmitter::update() on every emitter, add the emitters
+ * to a pool and update the pool once per frame. Since each emitter keeps its own
+ * timing state, the emitters of a pool can be updated concurrently on the game's
+ * worker threads.
+ *
+ * @script{ignore}
+ */
+class ParticleEmitterPool
+{
+public:
+
+    /**
+     * Creates a new, empty emitter pool.
+     *
+     * @param parallel true to update the emitters across the game's worker threads.
+     *
+     * @return A new emitter pool.
+     */
+    static ParticleEmitterPool* create(bool parallel = true);
+
+    /**
+     * Destructor.
+     */
+    ~ParticleEmitterPool();
+
+    /**
+     * Adds an emitter to the pool.
+     *
+     * The reference count of the emitter is increased while it is in the pool.
+     *
+     * @param emitter The emitter to add.
+     */
+    void addEmitter(ParticleEmitter* emitter);
+
+    /**
+     * Removes an emitter from the pool.
+     *
+     * @param emitter The emitter to remove.
+     */
+    void removeEmitter(ParticleEmitter* emitter);
+
+    /**
+     * Removes all emitters from the pool.
+     */
+    void removeAllEmitters();
+
+    /**
+     * Gets the number of emitters in the pool.
+     *
+     * @return The number of emitters.
+     */
+    unsigned int getEmitterCount() const;
+
+    /**
+     * Gets the emitter at the specified index.
+     *
+     * @param index The index of the emitter.
+     *
+     * @return The emitter at the specified index.
+     */
+    ParticleEmitter* getEmitter(unsigned int index) const;
+
+    /**
+     * Sets whether the emitters are updated across the game's worker threads.
+     *
+     * @param parallel true to update the emitters in parallel.
+     */
+    void setParallel(bool parallel);
+
+    /**
+     * Determines whether the emitters are updated across the game's worker threads.
+     *
+     * @return true if the emitters are updated in parallel.
+     */
+    bool isParallel() const;
+
+    /**
+     * Updates all active emitters in the pool.
+     *
+     * @param elapsedTime The amount of time that has passed since the last call to update(), in milliseconds.
+     */
+    void update(float elapsedTime);
+
+private:
+
+    /**
+     * Constructor.
+     */
+    ParticleEmitterPool(bool parallel);
+
+    /**
+     * Hidden copy constructor.
+     */
+    ParticleEmitterPool(const ParticleEmitterPool& copy);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ParticleEmitterPool& operator=(const ParticleEmitterPool&);
+
+    std::vector<ParticleEmitter*> _emitters;
+    std::vector<ParticleEmitter*> _activeEmitters;
+    bool _parallel;
+};
+
+}
+
+#endif
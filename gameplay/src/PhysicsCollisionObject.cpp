@@ -210,6 +210,11 @@ bool PhysicsCollisionObject::CollisionPair::operator < (const CollisionPair& col
     return false;
 }
 
+bool PhysicsCollisionObject::CollisionPair::operator == (const CollisionPair& collisionPair) const
+{
+    return (objectA == collisionPair.objectA && objectB == collisionPair.objectB) || (objectA == collisionPair.objectB && objectB == collisionPair.objectA);
+}
+
 PhysicsCollisionObject::PhysicsMotionState::PhysicsMotionState(Node* node, PhysicsCollisionObject* collisionObject, const Vector3* centerOfMassOffset) :
     _node(node), _collisionObject(collisionObject), _centerOfMassOffset(btTransform::getIdentity())
 {
@@ -242,9 +247,31 @@ void PhysicsCollisionObject::PhysicsMotionState::setWorldTransform(const btTrans
     GP_ASSERT(_node);
 
     _worldTransform = transform * _centerOfMassOffset;
-        
-    const btQuaternion& rot = _worldTransform.getRotation();
-    const btVector3& pos = _worldTransform.getOrigin();
+    setNodeTransform(_worldTransform);
+}
+
+void PhysicsCollisionObject::PhysicsMotionState::storePreviousTransform()
+{
+    _previousTransform = _worldTransform;
+}
+
+void PhysicsCollisionObject::PhysicsMotionState::interpolateTransform(float alpha)
+{
+    // The node already holds the transform when the object has not moved.
+    if (_previousTransform == _worldTransform)
+        return;
+
+    btTransform transform(_previousTransform.getRotation().slerp(_worldTransform.getRotation(), alpha),
+                          _previousTransform.getOrigin().lerp(_worldTransform.getOrigin(), alpha));
+    setNodeTransform(transform);
+}
+
+void PhysicsCollisionObject::PhysicsMotionState::setNodeTransform(const btTransform& transform)
+{
+    GP_ASSERT(_node);
+
+    const btQuaternion& rot = transform.getRotation();
+    const btVector3& pos = transform.getOrigin();
 
     _node->setRotation(rot.x(), rot.y(), rot.z(), rot.w());
     _node->setTranslation(pos.x(), pos.y(), pos.z());
@@ -274,6 +301,9 @@ void PhysicsCollisionObject::PhysicsMotionState::updateTransformFromNode() const
     {
         _worldTransform = btTransform(BQ(rotation), btVector3(m.m[12], m.m[13], m.m[14]));
     }
+
+    // Objects placed from their node are not interpolated from where they were.
+    _previousTransform = _worldTransform;
 }
 
 void PhysicsCollisionObject::PhysicsMotionState::setCenterOfMassOffset(const Vector3& centerOfMassOffset)
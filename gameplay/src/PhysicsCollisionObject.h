@@ -88,6 +88,14 @@ public:
          */
         bool operator < (const CollisionPair& collisionPair) const;
 
+        /**
+         * Equality operator (the order of the objects is ignored).
+         *
+         * @param collisionPair The collision pair to compare.
+         * @return True if both pairs hold the same objects; false otherwise.
+         */
+        bool operator == (const CollisionPair& collisionPair) const;
+
         /**
          * The first object in the collision.
          */
@@ -385,13 +393,32 @@ private:
          * Sets the center of mass offset for the associated collision shape.
          */
         void setCenterOfMassOffset(const Vector3& centerOfMassOffset);
+
+        /**
+         * Stores the current world transform as the state that following interpolations start from.
+         */
+        void storePreviousTransform();
+
+        /**
+         * Sets the node's transform to the interpolation of the previous and current world transforms
+         * (the node is left untouched if both are the same).
+         *
+         * @param alpha The interpolation factor (0 is the previous transform and 1 the current one).
+         */
+        void interpolateTransform(float alpha);
         
     private:
+
+        /**
+         * Sets the node's rotation and translation from the given world transform.
+         */
+        void setNodeTransform(const btTransform& transform);
         
         Node* _node;
         PhysicsCollisionObject* _collisionObject;
         btTransform _centerOfMassOffset;
         mutable btTransform _worldTransform;
+        mutable btTransform _previousTransform;
     };
 
     /** 
@@ -12,6 +12,9 @@
 #endif
 #include "BulletCollision/CollisionShapes/btHeightfieldTerrainShape.h"
 #include "BulletCollision/CollisionShapes/btShapeHull.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
 #ifdef GP_USE_MEM_LEAK_DETECTION
 #define new DEBUG_NEW
 #endif
@@ -19,9 +22,77 @@
 // The initial capacity of the Bullet debug drawer's vertex batch.
 #define INITIAL_CAPACITY 280
 
+// The size of the manifold and collision algorithm pools of a multithreaded world
+// (allocations that overflow the pools take a lock).
+#define PHYSICS_MT_POOL_SIZE 80000
+
+// The minimum number of batched ray or sweep tests run by a single worker task.
+#define PHYSICS_QUERY_GRAIN_SIZE 64
+
 namespace gameplay
 {
 
+#if BT_THREADSAFE
+/**
+ * Runs Bullet's parallel loops on a worker pool.
+ *
+ * Bullet indexes its per-thread data by thread, so the pool is owned by the physics
+ * controller and only ever used (along with the main thread) to step the world.
+ */
+class WorkerPoolTaskScheduler : public btITaskScheduler
+{
+public:
+
+    WorkerPoolTaskScheduler(WorkerPool* pool) : btITaskScheduler("WorkerPool"), _pool(pool)
+    {
+    }
+
+    int getMaxNumThreads() const
+    {
+        return (int)_pool->getThreadCount() + 1;
+    }
+
+    int getNumThreads() const
+    {
+        return (int)_pool->getThreadCount() + 1;
+    }
+
+    void setNumThreads(int numThreads)
+    {
+        // The pool is sized when the controller is initialized.
+    }
+
+    void parallelFor(int iBegin, int iEnd, int grainSize, const btIParallelForBody& body)
+    {
+        if (iEnd <= iBegin)
+            return;
+        _pool->parallelFor((unsigned int)(iEnd - iBegin), (unsigned int)grainSize, [iBegin, &body](unsigned int begin, unsigned int end)
+        {
+            body.forLoop(iBegin + (int)begin, iBegin + (int)end);
+        });
+    }
+
+    btScalar parallelSum(int iBegin, int iEnd, int grainSize, const btIParallelSumBody& body)
+    {
+        if (iEnd <= iBegin)
+            return btScalar(0);
+        std::mutex mutex;
+        btScalar sum = btScalar(0);
+        _pool->parallelFor((unsigned int)(iEnd - iBegin), (unsigned int)grainSize, [iBegin, &body, &mutex, &sum](unsigned int begin, unsigned int end)
+        {
+            btScalar chunkSum = body.sumLoop(iBegin + (int)begin, iBegin + (int)end);
+            std::lock_guard<std::mutex> lock(mutex);
+            sum += chunkSum;
+        });
+        return sum;
+    }
+
+private:
+
+    WorkerPool* _pool;
+};
+#endif
+
 const int PhysicsController::DIRTY         = 0x01;
 const int PhysicsController::COLLISION     = 0x02;
 const int PhysicsController::REGISTERED    = 0x04;
@@ -29,19 +100,15 @@ const int PhysicsController::REMOVE        = 0x08;
 
 PhysicsController::PhysicsController()
   : _isUpdating(false), _collisionConfiguration(NULL), _dispatcher(NULL),
-    _overlappingPairCache(NULL), _solver(NULL), _world(NULL), _ghostPairCallback(NULL),
+    _overlappingPairCache(NULL), _solver(NULL), _world(NULL), _stepPool(NULL), _taskScheduler(NULL), _ghostPairCallback(NULL), _queryPool(NULL),
     _debugDrawer(NULL), _status(PhysicsController::Listener::DEACTIVATED), _listeners(NULL),
-    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _collisionCallback(NULL)
+    _gravity(btScalar(0.0), btScalar(-9.8), btScalar(0.0)), _fixedTimeStep(0.0f), _maxSubSteps(10), _accumulator(0.0f)
 {
     GP_REGISTER_SCRIPT_EVENTS();
-
-    // Default gravity is 9.8 along the negative Y axis.
-    _collisionCallback = new CollisionCallback(this);
 }
 
 PhysicsController::~PhysicsController()
 {
-    SAFE_DELETE(_collisionCallback);
     SAFE_DELETE(_ghostPairCallback);
     SAFE_DELETE(_debugDrawer);
     SAFE_DELETE(_listeners);
@@ -160,6 +227,29 @@ void PhysicsController::setGravity(const Vector3& gravity)
         _world->setGravity(BV(_gravity));
 }
 
+void PhysicsController::setFixedTimeStep(float timeStep, unsigned int maxSubSteps)
+{
+    GP_ASSERT(!_isUpdating);
+
+    _fixedTimeStep = std::max(timeStep, 0.0f);
+    _maxSubSteps = std::max(maxSubSteps, 1u);
+    _accumulator = 0.0f;
+
+    // Start interpolating from the current state.
+    if (_world && _fixedTimeStep > 0.0f)
+        storePreviousTransforms();
+}
+
+float PhysicsController::getFixedTimeStep() const
+{
+    return _fixedTimeStep;
+}
+
+unsigned int PhysicsController::getMaxSubSteps() const
+{
+    return _maxSubSteps;
+}
+
 void PhysicsController::drawDebug(const Matrix& viewProjection)
 {
     GP_ASSERT(_debugDrawer);
@@ -170,6 +260,31 @@ void PhysicsController::drawDebug(const Matrix& viewProjection)
     _debugDrawer->end();
 }
 
+// Gets the transform a sweep test of the given object starts from (returns false if its shape cannot be swept).
+static bool getSweepStart(PhysicsCollisionObject* object, btTransform* start)
+{
+    GP_ASSERT(object && object->getCollisionShape());
+    GP_ASSERT(start);
+
+    PhysicsCollisionShape::Type type = object->getCollisionShape()->getType();
+    if (type != PhysicsCollisionShape::SHAPE_BOX && type != PhysicsCollisionShape::SHAPE_SPHERE && type != PhysicsCollisionShape::SHAPE_CAPSULE)
+        return false;
+
+    start->setIdentity();
+    if (object->getNode())
+    {
+        Vector3 translation;
+        Quaternion rotation;
+        const Matrix& m = object->getNode()->getWorldMatrix();
+        m.getTranslation(&translation);
+        m.getRotation(&rotation);
+
+        start->setOrigin(BV(translation));
+        start->setRotation(BQ(rotation));
+    }
+    return true;
+}
+
 bool PhysicsController::rayTest(const Ray& ray, float distance, PhysicsController::HitResult* result, PhysicsController::HitFilter* filter)
 {
     class RayTestCallback : public btCollisionWorld::ClosestRayResultCallback
@@ -296,27 +411,11 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
         }
     };
 
-    GP_ASSERT(object && object->getCollisionShape());
-    PhysicsCollisionShape* shape = object->getCollisionShape();
-    PhysicsCollisionShape::Type type = shape->getType();
-    if (type != PhysicsCollisionShape::SHAPE_BOX && type != PhysicsCollisionShape::SHAPE_SPHERE && type != PhysicsCollisionShape::SHAPE_CAPSULE)
-        return false; // unsupported type
-
     // Define the start transform.
     btTransform start;
-    start.setIdentity();
-    if (object->getNode())
-    {
-        Vector3 translation;
-        Quaternion rotation;
-        const Matrix& m = object->getNode()->getWorldMatrix();
-        m.getTranslation(&translation);
-        m.getRotation(&rotation);
-
-        start.setIdentity();
-        start.setOrigin(BV(translation));
-        start.setRotation(BQ(rotation));
-    }
+    if (!getSweepStart(object, &start))
+        return false; // unsupported type
+    PhysicsCollisionShape* shape = object->getCollisionShape();
 
     // Define the end transform.
     btTransform end(start);
@@ -360,88 +459,589 @@ bool PhysicsController::sweepTest(PhysicsCollisionObject* object, const Vector3&
     return false;
 }
 
-btScalar PhysicsController::CollisionCallback::addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, 
-    const btCollisionObjectWrapper* b, int partIdB, int indexB)
+// Orders hit results from nearest to furthest.
+static bool compareHitFraction(const PhysicsController::HitResult& a, const PhysicsController::HitResult& b)
 {
-    GP_ASSERT(_pc);
+    return a.fraction < b.fraction;
+}
 
-    // Get pointers to the PhysicsCollisionObject objects.
-    PhysicsCollisionObject* objectA = _pc->getCollisionObject(a->m_collisionObject);
-    PhysicsCollisionObject* objectB = _pc->getCollisionObject(b->m_collisionObject);
+/**
+ * Ray test callback of batched queries, collecting either the closest hit or all of them.
+ */
+class BatchRayCallback : public btCollisionWorld::RayResultCallback
+{
+public:
 
-    // If the given collision object pair has collided in the past, then
-    // we notify the listeners only if the pair was not colliding
-    // during the previous frame. Otherwise, it's a new pair, so add a
-    // new entry to the cache with the appropriate listeners and notify them.
-    PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
+    BatchRayCallback(const btVector3& rayFromWorld, const btVector3& rayToWorld, int mask, bool allHits)
+        : _rayFromWorld(rayFromWorld), _rayToWorld(rayToWorld), _allHits(allHits)
+    {
+        m_collisionFilterGroup = btBroadphaseProxy::AllFilter;
+        m_collisionFilterMask = mask;
+    }
 
-    CollisionInfo* collisionInfo;
-    if (_pc->_collisionStatus.count(pair) > 0)
+    bool needsCollision(btBroadphaseProxy* proxy0) const
     {
-        collisionInfo = &_pc->_collisionStatus[pair];
+        if (!btCollisionWorld::RayResultCallback::needsCollision(proxy0))
+            return false;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+        return co->getUserPointer() != NULL;
     }
-    else
+
+    btScalar addSingleResult(btCollisionWorld::LocalRayResult& rayResult, bool normalInWorldSpace)
     {
-        // Add a new collision pair for these objects.
-        collisionInfo = &_pc->_collisionStatus[pair];
+        GP_ASSERT(rayResult.m_collisionObject);
+
+        btVector3 normal = normalInWorldSpace ? rayResult.m_hitNormalLocal : rayResult.m_collisionObject->getWorldTransform().getBasis() * rayResult.m_hitNormalLocal;
+        btVector3 point;
+        point.setInterpolate3(_rayFromWorld, _rayToWorld, rayResult.m_hitFraction);
+
+        PhysicsController::HitResult hit;
+        hit.object = reinterpret_cast<PhysicsCollisionObject*>(rayResult.m_collisionObject->getUserPointer());
+        hit.point.set(point.x(), point.y(), point.z());
+        hit.fraction = rayResult.m_hitFraction;
+        hit.normal.set(normal.x(), normal.y(), normal.z());
 
-        // Add the appropriate listeners.
-        PhysicsCollisionObject::CollisionPair p1(pair.objectA, NULL);
-        if (_pc->_collisionStatus.count(p1) > 0)
+        if (_allHits)
         {
-            const CollisionInfo& ci = _pc->_collisionStatus[p1];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
+            // Keep the closest fraction at 1 so every object along the ray is reported.
+            hits.push_back(hit);
+            return m_closestHitFraction;
         }
-        PhysicsCollisionObject::CollisionPair p2(pair.objectB, NULL);
-        if (_pc->_collisionStatus.count(p2) > 0)
+
+        hits.clear();
+        hits.push_back(hit);
+        m_collisionObject = rayResult.m_collisionObject;
+        m_closestHitFraction = rayResult.m_hitFraction;
+        return m_closestHitFraction;
+    }
+
+    std::vector<PhysicsController::HitResult> hits;
+
+private:
+
+    btVector3 _rayFromWorld;
+    btVector3 _rayToWorld;
+    bool _allHits;
+};
+
+/**
+ * Sweep test callback of batched queries, collecting either the closest hit or all of them.
+ */
+class BatchSweepCallback : public btCollisionWorld::ConvexResultCallback
+{
+public:
+
+    BatchSweepCallback(const btCollisionObject* me, int mask, bool allHits)
+        : _me(me), _allHits(allHits)
+    {
+        m_collisionFilterGroup = btBroadphaseProxy::AllFilter;
+        m_collisionFilterMask = mask;
+    }
+
+    bool needsCollision(btBroadphaseProxy* proxy0) const
+    {
+        if (!btCollisionWorld::ConvexResultCallback::needsCollision(proxy0))
+            return false;
+
+        btCollisionObject* co = reinterpret_cast<btCollisionObject*>(proxy0->m_clientObject);
+        return co != _me && co->getUserPointer() != NULL;
+    }
+
+    btScalar addSingleResult(btCollisionWorld::LocalConvexResult& convexResult, bool normalInWorldSpace)
+    {
+        GP_ASSERT(convexResult.m_hitCollisionObject);
+
+        btVector3 normal = normalInWorldSpace ? convexResult.m_hitNormalLocal : convexResult.m_hitCollisionObject->getWorldTransform().getBasis() * convexResult.m_hitNormalLocal;
+
+        PhysicsController::HitResult hit;
+        hit.object = reinterpret_cast<PhysicsCollisionObject*>(convexResult.m_hitCollisionObject->getUserPointer());
+        hit.point.set(convexResult.m_hitPointLocal.x(), convexResult.m_hitPointLocal.y(), convexResult.m_hitPointLocal.z());
+        hit.fraction = convexResult.m_hitFraction;
+        hit.normal.set(normal.x(), normal.y(), normal.z());
+
+        if (_allHits)
         {
-            const CollisionInfo& ci = _pc->_collisionStatus[p2];
-            std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = ci._listeners.begin();
-            for (; iter != ci._listeners.end(); iter++)
-            {
-                GP_ASSERT(*iter);
-                collisionInfo->_listeners.push_back(*iter);
-            }
+            hits.push_back(hit);
+            return m_closestHitFraction;
+        }
+
+        hits.clear();
+        hits.push_back(hit);
+        m_closestHitFraction = convexResult.m_hitFraction;
+        return m_closestHitFraction;
+    }
+
+    std::vector<PhysicsController::HitResult> hits;
+
+private:
+
+    const btCollisionObject* _me;
+    bool _allHits;
+};
+
+/**
+ * Passes the broadphase proxies of the leaves hit by a batched ray or sweep to its callback.
+ */
+struct BatchBroadphaseTester : public btDbvt::ICollide
+{
+    BatchBroadphaseTester(btBroadphaseRayCallback& callback) : callback(callback)
+    {
+    }
+
+    void Process(const btDbvtNode* leaf)
+    {
+        callback.process((const btBroadphaseProxy*)leaf->data);
+    }
+
+    btBroadphaseRayCallback& callback;
+};
+
+/**
+ * Broadphase callback of batched ray tests, testing the ray against each object it reaches.
+ */
+struct BatchRayBroadphaseCallback : public btBroadphaseRayCallback
+{
+    BatchRayBroadphaseCallback(const btVector3& rayFromWorld, const btVector3& rayToWorld, btCollisionWorld::RayResultCallback& resultCallback)
+        : resultCallback(resultCallback)
+    {
+        rayFromTrans.setIdentity();
+        rayFromTrans.setOrigin(rayFromWorld);
+        rayToTrans.setIdentity();
+        rayToTrans.setOrigin(rayToWorld);
+
+        btVector3 rayDir = (rayToWorld - rayFromWorld).normalized();
+        m_rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+        m_rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+        m_rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+        m_signs[0] = m_rayDirectionInverse[0] < 0.0;
+        m_signs[1] = m_rayDirectionInverse[1] < 0.0;
+        m_signs[2] = m_rayDirectionInverse[2] < 0.0;
+        m_lambda_max = rayDir.dot(rayToWorld - rayFromWorld);
+    }
+
+    bool process(const btBroadphaseProxy* proxy)
+    {
+        if (resultCallback.m_closestHitFraction == btScalar(0.0))
+            return false;
+
+        btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
+        if (resultCallback.needsCollision(collisionObject->getBroadphaseHandle()))
+        {
+            btCollisionWorld::rayTestSingle(rayFromTrans, rayToTrans, collisionObject, collisionObject->getCollisionShape(),
+                                            collisionObject->getWorldTransform(), resultCallback);
         }
+        return true;
     }
 
-    // Fire collision event.
-    if ((collisionInfo->_status & COLLISION) == 0)
+    btTransform rayFromTrans;
+    btTransform rayToTrans;
+    btCollisionWorld::RayResultCallback& resultCallback;
+};
+
+/**
+ * Broadphase callback of batched sweep tests, sweeping the shape against each object it reaches.
+ */
+struct BatchSweepBroadphaseCallback : public btBroadphaseRayCallback
+{
+    BatchSweepBroadphaseCallback(const btConvexShape* castShape, const btTransform& convexFromTrans, const btTransform& convexToTrans,
+                                 btCollisionWorld::ConvexResultCallback& resultCallback, btScalar allowedPenetration)
+        : castShape(castShape), convexFromTrans(convexFromTrans), convexToTrans(convexToTrans), resultCallback(resultCallback), allowedPenetration(allowedPenetration)
+    {
+        btVector3 unnormalizedRayDir = convexToTrans.getOrigin() - convexFromTrans.getOrigin();
+        btVector3 rayDir = unnormalizedRayDir.fuzzyZero() ? btVector3(btScalar(0.0), btScalar(0.0), btScalar(0.0)) : unnormalizedRayDir.normalized();
+        m_rayDirectionInverse[0] = rayDir[0] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[0];
+        m_rayDirectionInverse[1] = rayDir[1] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[1];
+        m_rayDirectionInverse[2] = rayDir[2] == btScalar(0.0) ? btScalar(BT_LARGE_FLOAT) : btScalar(1.0) / rayDir[2];
+        m_signs[0] = m_rayDirectionInverse[0] < 0.0;
+        m_signs[1] = m_rayDirectionInverse[1] < 0.0;
+        m_signs[2] = m_rayDirectionInverse[2] < 0.0;
+        m_lambda_max = rayDir.dot(unnormalizedRayDir);
+    }
+
+    bool process(const btBroadphaseProxy* proxy)
     {
-        std::vector<PhysicsCollisionObject::CollisionListener*>::const_iterator iter = collisionInfo->_listeners.begin();
-        for (; iter != collisionInfo->_listeners.end(); iter++)
+        if (resultCallback.m_closestHitFraction == btScalar(0.0))
+            return false;
+
+        btCollisionObject* collisionObject = (btCollisionObject*)proxy->m_clientObject;
+        if (resultCallback.needsCollision(collisionObject->getBroadphaseHandle()))
         {
-            GP_ASSERT(*iter);
-            if ((collisionInfo->_status & REMOVE) == 0)
+            btCollisionWorld::objectQuerySingle(castShape, convexFromTrans, convexToTrans, collisionObject, collisionObject->getCollisionShape(),
+                                                collisionObject->getWorldTransform(), resultCallback, allowedPenetration);
+        }
+        return true;
+    }
+
+    const btConvexShape* castShape;
+    btTransform convexFromTrans;
+    btTransform convexToTrans;
+    btCollisionWorld::ConvexResultCallback& resultCallback;
+    btScalar allowedPenetration;
+};
+
+/**
+ * Walks the broadphase trees along a ray (or the sweep of an AABB), passing the leaves hit to the callback.
+ *
+ * btDbvtBroadphase::rayTest shares a single traversal stack between all callers unless Bullet
+ * is built with BT_THREADSAFE, so batched queries walk the trees themselves with their own stack.
+ * Walking the trees is read only, so any number of threads can do it while the world is not updating.
+ */
+static void batchBroadphaseTest(const btDbvtBroadphase* broadphase, const btVector3& from, const btVector3& to, btBroadphaseRayCallback& callback,
+                                const btVector3& aabbMin, const btVector3& aabbMax, btAlignedObjectArray<const btDbvtNode*>& stack)
+{
+    BatchBroadphaseTester tester(callback);
+    for (int i = 0; i < 2; i++)
+    {
+        const btDbvt& set = broadphase->m_sets[i];
+        set.rayTestInternal(set.m_root, from, to, callback.m_rayDirectionInverse, callback.m_signs, callback.m_lambda_max,
+                            aabbMin, aabbMax, stack, tester);
+    }
+}
+
+/**
+ * Runs a batch of queries, gathering the hits that the test appends for each query into the results.
+ *
+ * The queries are split into chunks that run on the given pool (or on the calling thread only
+ * when the pool has no threads). Each chunk has its own broadphase traversal stack.
+ */
+template <class Query, class Test>
+static unsigned int runQueryBatch(WorkerPool* pool, std::vector<Query>& queries, std::vector<PhysicsController::HitResult>& results, const Test& test)
+{
+    // The hits of a contiguous range of queries.
+    struct Chunk
+    {
+        unsigned int begin;
+        unsigned int end;
+        std::vector<PhysicsController::HitResult> hits;
+    };
+
+    GP_ASSERT(pool);
+
+    results.clear();
+    unsigned int count = (unsigned int)queries.size();
+    if (count == 0)
+        return 0;
+
+    std::vector<Chunk> chunks;
+    std::mutex mutex;
+    pool->parallelFor(count, PHYSICS_QUERY_GRAIN_SIZE, [&queries, &test, &chunks, &mutex](unsigned int begin, unsigned int end)
+    {
+        Chunk chunk;
+        chunk.begin = begin;
+        chunk.end = end;
+        btAlignedObjectArray<const btDbvtNode*> stack;
+        for (unsigned int i = begin; i < end; i++)
+        {
+            Query& query = queries[i];
+            query.firstHit = (unsigned int)chunk.hits.size();
+            test(query, chunk.hits, stack);
+            query.hitCount = (unsigned int)chunk.hits.size() - query.firstHit;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.push_back(Chunk());
+        chunks.back().begin = chunk.begin;
+        chunks.back().end = chunk.end;
+        chunks.back().hits.swap(chunk.hits);
+    });
+
+    if (chunks.size() == 1)
+    {
+        results.swap(chunks[0].hits);
+        return (unsigned int)results.size();
+    }
+
+    // Concatenate the chunks in query order, offsetting the first hit of their queries.
+    std::sort(chunks.begin(), chunks.end(), [](const Chunk& a, const Chunk& b) { return a.begin < b.begin; });
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        unsigned int offset = (unsigned int)results.size();
+        for (unsigned int j = chunks[i].begin; j < chunks[i].end; j++)
+            queries[j].firstHit += offset;
+        results.insert(results.end(), chunks[i].hits.begin(), chunks[i].hits.end());
+    }
+    return (unsigned int)results.size();
+}
+
+unsigned int PhysicsController::rayTestBatch(std::vector<RayQuery>& queries, std::vector<HitResult>& results, bool allHits)
+{
+    GP_ASSERT(_world);
+    GP_ASSERT(!_isUpdating);
+
+    // The world always uses a btDbvtBroadphase (see initialize).
+    const btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+    return runQueryBatch(_queryPool, queries, results, [broadphase, allHits](const RayQuery& query, std::vector<HitResult>& hits, btAlignedObjectArray<const btDbvtNode*>& stack)
+    {
+        btVector3 rayFromWorld(BV(query.ray.getOrigin()));
+        btVector3 rayToWorld(rayFromWorld + BV(query.ray.getDirection() * query.distance));
+
+        BatchRayCallback callback(rayFromWorld, rayToWorld, query.mask, allHits);
+        BatchRayBroadphaseCallback broadphaseCallback(rayFromWorld, rayToWorld, callback);
+        btVector3 zero(btScalar(0.0), btScalar(0.0), btScalar(0.0));
+        batchBroadphaseTest(broadphase, rayFromWorld, rayToWorld, broadphaseCallback, zero, zero, stack);
+        if (callback.hits.empty())
+            return;
+
+        if (allHits)
+            std::sort(callback.hits.begin(), callback.hits.end(), compareHitFraction);
+        hits.insert(hits.end(), callback.hits.begin(), callback.hits.end());
+    });
+}
+
+unsigned int PhysicsController::sweepTestBatch(std::vector<SweepQuery>& queries, std::vector<HitResult>& results, bool allHits)
+{
+    GP_ASSERT(_world);
+    GP_ASSERT(!_isUpdating);
+
+    // Compute the start transforms up front since node world matrices are updated lazily (which is not thread safe).
+    btAlignedObjectArray<btTransform> starts;
+    starts.resize((int)queries.size());
+    std::vector<bool> supported(queries.size());
+    for (size_t i = 0; i < queries.size(); i++)
+        supported[i] = getSweepStart(queries[i].object, &starts[(int)i]);
+
+    const btDbvtBroadphase* broadphase = static_cast<btDbvtBroadphase*>(_overlappingPairCache);
+    btScalar allowedPenetration = _world->getDispatchInfo().m_allowedCcdPenetration;
+    const SweepQuery* first = queries.empty() ? NULL : &queries[0];
+    return runQueryBatch(_queryPool, queries, results, [broadphase, allowedPenetration, allHits, first, &starts, &supported](const SweepQuery& query,
+        std::vector<HitResult>& hits, btAlignedObjectArray<const btDbvtNode*>& stack)
+    {
+        int index = (int)(&query - first);
+        if (!supported[index])
+            return;
+
+        const btTransform& start = starts[index];
+        btTransform end(start);
+        end.setOrigin(BV(query.endPosition));
+
+        // Compute the AABB of the shape that encompasses its angular motion (as btCollisionWorld::convexSweepTest does).
+        const btConvexShape* shape = static_cast<btConvexShape*>(query.object->getCollisionShape()->getShape());
+        btVector3 linearVelocity, angularVelocity;
+        btTransformUtil::calculateVelocity(start, end, btScalar(1.0), linearVelocity, angularVelocity);
+        btTransform rotation;
+        rotation.setIdentity();
+        rotation.setRotation(start.getRotation());
+        btVector3 aabbMin, aabbMax;
+        shape->calculateTemporalAabb(rotation, btVector3(btScalar(0.0), btScalar(0.0), btScalar(0.0)), angularVelocity, btScalar(1.0), aabbMin, aabbMax);
+
+        BatchSweepCallback callback(query.object->getCollisionObject(), query.mask, allHits);
+        BatchSweepBroadphaseCallback broadphaseCallback(shape, start, end, callback, allowedPenetration);
+        batchBroadphaseTest(broadphase, start.getOrigin(), end.getOrigin(), broadphaseCallback, aabbMin, aabbMax, stack);
+        if (callback.hits.empty())
+            return;
+
+        if (allHits)
+            std::sort(callback.hits.begin(), callback.hits.end(), compareHitFraction);
+        hits.insert(hits.end(), callback.hits.begin(), callback.hits.end());
+    });
+}
+
+size_t PhysicsController::CollisionPairHash::operator()(const PhysicsCollisionObject::CollisionPair& pair) const
+{
+    // Combine the objects in address order so (A, B) and (B, A) hash the same.
+    size_t a = (size_t)pair.objectA / sizeof(void*);
+    size_t b = (size_t)pair.objectB / sizeof(void*);
+    if (a > b)
+        std::swap(a, b);
+    return a ^ (b + 0x9e3779b9 + (a << 6) + (a >> 2));
+}
+
+PhysicsController::CollisionInfo* PhysicsController::getCollisionInfo(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
+{
+    // Listeners registered for a specific pair.
+    PhysicsCollisionObject::CollisionPair pair(objectA, objectB);
+    CollisionStatusMap::iterator iter = _collisionStatus.find(pair);
+    if (iter != _collisionStatus.end())
+    {
+        // Pairs derived from an object's listeners are only tracked while one of those is still active.
+        if ((iter->second._status & REMOVE) != 0)
+            return NULL;
+        if ((iter->second._status & REGISTERED) != 0)
+            return &iter->second;
+    }
+
+    // Listeners registered for all collisions of either object.
+    CollisionStatusMap::iterator iterA = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(objectA, NULL));
+    CollisionStatusMap::iterator iterB = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(objectB, NULL));
+    bool activeA = iterA != _collisionStatus.end() && (iterA->second._status & REMOVE) == 0;
+    bool activeB = iterB != _collisionStatus.end() && (iterB->second._status & REMOVE) == 0;
+    if (!activeA && !activeB)
+        return NULL;
+    if (iter != _collisionStatus.end())
+        return &iter->second;
+
+    // Add a new collision pair for these objects (with the object that has listeners first) and gather the appropriate listeners.
+    if (!activeA)
+        std::swap(objectA, objectB);
+    CollisionInfo& collisionInfo = _collisionStatus[PhysicsCollisionObject::CollisionPair(objectA, objectB)];
+    iterA = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(objectA, NULL));
+    iterB = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(objectB, NULL));
+    if (iterA != _collisionStatus.end())
+        collisionInfo._listeners.insert(collisionInfo._listeners.end(), iterA->second._listeners.begin(), iterA->second._listeners.end());
+    if (iterB != _collisionStatus.end())
+        collisionInfo._listeners.insert(collisionInfo._listeners.end(), iterB->second._listeners.begin(), iterB->second._listeners.end());
+    return &collisionInfo;
+}
+
+void PhysicsController::updateCollisionStatus()
+{
+    // Entries that collided in the last update have the DIRTY bit set. The contact
+    // manifolds that Bullet's dispatcher computed during the step are walked and
+    // every touching pair with listeners clears its DIRTY bit (firing COLLIDING if it
+    // was not colliding yet). Entries that are still dirty afterwards stopped
+    // colliding. Events are queued and fired once the cache is up to date.
+    _collisionEvents.clear();
+    _removedCollisionPairs.clear();
+
+    if (!_collisionStatus.empty())
+    {
+        GP_ASSERT(_dispatcher);
+        int manifoldCount = _dispatcher->getNumManifolds();
+        for (int i = 0; i < manifoldCount; i++)
+        {
+            btPersistentManifold* manifold = _dispatcher->getManifoldByIndexInternal(i);
+            GP_ASSERT(manifold);
+
+            // The manifold keeps points until they separate past the breaking threshold, so only penetrating points count as contact.
+            int contact = -1;
+            for (int j = 0; j < manifold->getNumContacts(); j++)
             {
-                (*iter)->collisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, pair, Vector3(cp.getPositionWorldOnA().x(), cp.getPositionWorldOnA().y(), cp.getPositionWorldOnA().z()),
-                    Vector3(cp.getPositionWorldOnB().x(), cp.getPositionWorldOnB().y(), cp.getPositionWorldOnB().z()));
+                if (manifold->getContactPoint(j).getDistance() <= 0.0f)
+                {
+                    contact = j;
+                    break;
+                }
             }
+            if (contact < 0)
+                continue;
+
+            PhysicsCollisionObject* objectA = getCollisionObject(manifold->getBody0());
+            PhysicsCollisionObject* objectB = getCollisionObject(manifold->getBody1());
+            if (!objectA || !objectB)
+                continue;
+
+            CollisionInfo* collisionInfo = getCollisionInfo(objectA, objectB);
+            if (!collisionInfo)
+                continue;
+
+            // Update the collision status cache (clearing the dirty bit so that the pair's
+            // status is not reset to 'no collision' below).
+            if ((collisionInfo->_status & COLLISION) == 0)
+            {
+                CollisionStatusMap::iterator iter = _collisionStatus.find(PhysicsCollisionObject::CollisionPair(objectA, objectB));
+                GP_ASSERT(iter != _collisionStatus.end());
+                const btManifoldPoint& point = manifold->getContactPoint(contact);
+                Vector3 pointA(point.getPositionWorldOnA().x(), point.getPositionWorldOnA().y(), point.getPositionWorldOnA().z());
+                Vector3 pointB(point.getPositionWorldOnB().x(), point.getPositionWorldOnB().y(), point.getPositionWorldOnB().z());
+                if (iter->first.objectA == objectA)
+                    _collisionEvents.push_back(CollisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, iter->first, collisionInfo, pointA, pointB));
+                else
+                    _collisionEvents.push_back(CollisionEvent(PhysicsCollisionObject::CollisionListener::COLLIDING, iter->first, collisionInfo, pointB, pointA));
+            }
+            collisionInfo->_status &= ~DIRTY;
+            collisionInfo->_status |= COLLISION;
+        }
+    }
+
+    // Queue NOT_COLLIDING for the pairs that stopped colliding (or are being removed) and dirty the rest for the next update.
+    CollisionStatusMap::iterator iter = _collisionStatus.begin();
+    for (; iter != _collisionStatus.end(); iter++)
+    {
+        CollisionInfo& collisionInfo = iter->second;
+        if ((collisionInfo._status & REMOVE) != 0)
+        {
+            if ((collisionInfo._status & COLLISION) != 0 && iter->first.objectB)
+                _collisionEvents.push_back(CollisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, PhysicsCollisionObject::CollisionPair(iter->first.objectA, NULL), &collisionInfo));
+            _removedCollisionPairs.push_back(iter->first);
+        }
+        else if ((collisionInfo._status & DIRTY) != 0)
+        {
+            if ((collisionInfo._status & COLLISION) != 0 && iter->first.objectB)
+                _collisionEvents.push_back(CollisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, iter->first, &collisionInfo));
+            collisionInfo._status &= ~COLLISION;
+        }
+        else if ((collisionInfo._status & COLLISION) != 0)
+        {
+            collisionInfo._status |= DIRTY;
+        }
+    }
+
+    // Fire the queued events. Listeners may add listeners (entries of the cache are never
+    // moved) or remove them (which only marks them for removal), so the events stay valid.
+    for (size_t i = 0, count = _collisionEvents.size(); i < count; i++)
+    {
+        const CollisionEvent& event = _collisionEvents[i];
+        GP_ASSERT(event._info);
+        for (size_t j = 0; j < event._info->_listeners.size(); j++)
+        {
+            GP_ASSERT(event._info->_listeners[j]);
+            if (event._type == PhysicsCollisionObject::CollisionListener::COLLIDING && (event._info->_status & REMOVE) != 0)
+                break;
+            event._info->_listeners[j]->collisionEvent(event._type, event._pair, event._contactPointA, event._contactPointB);
         }
     }
 
-    // Update the collision status cache (we remove the dirty bit
-    // set in the controller's update so that this particular collision pair's
-    // status is not reset to 'no collision' when the controller's update completes).
-    collisionInfo->_status &= ~DIRTY;
-    collisionInfo->_status |= COLLISION;
-    return 0.0f;
+    for (size_t i = 0, count = _removedCollisionPairs.size(); i < count; i++)
+        _collisionStatus.erase(_removedCollisionPairs[i]);
 }
 
 void PhysicsController::initialize()
 {
-    _collisionConfiguration = bullet_new<btDefaultCollisionConfiguration>();
-    _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
-    _overlappingPairCache = bullet_new<btDbvtBroadphase>();
-    _solver = bullet_new<btSequentialImpulseConstraintSolver>();
+    int threadCount = 1;
+    unsigned int queryThreads = Game::getInstance()->getWorkerPool()->getThreadCount();
+    Properties* config = Game::getInstance()->getConfig()->getNamespace("physics", true);
+    if (config && config->exists("threads"))
+        threadCount = std::max(config->getInt("threads"), 1);
+    if (config && config->exists("fixedTimeStep"))
+    {
+        _fixedTimeStep = std::max(config->getFloat("fixedTimeStep"), 0.0f);
+        if (config->exists("maxSubSteps"))
+            _maxSubSteps = (unsigned int)std::max(config->getInt("maxSubSteps"), 1);
+    }
+    if (config && config->exists("queryThreads"))
+        queryThreads = (unsigned int)std::max(config->getInt("queryThreads"), 0);
+
+    // Batched queries get their own pool so they never wait behind (or hold up) the game's jobs.
+    _queryPool = new WorkerPool();
+    _queryPool->initialize(queryThreads);
 
-    // Create the world.
-    _world = bullet_new<btDiscreteDynamicsWorld>(_dispatcher, _overlappingPairCache, _solver, _collisionConfiguration);
+#if BT_THREADSAFE
+    if (threadCount > 1)
+    {
+        // Bullet's task scheduler must be set before any of the multithreaded classes are created.
+        threadCount = std::min(threadCount, (int)BT_MAX_THREAD_COUNT);
+        _stepPool = new WorkerPool();
+        _stepPool->initialize((unsigned int)threadCount - 1);
+        _taskScheduler = new WorkerPoolTaskScheduler(_stepPool);
+        btSetTaskScheduler(_taskScheduler);
+
+        btDefaultCollisionConstructionInfo constructionInfo;
+        constructionInfo.m_defaultMaxPersistentManifoldPoolSize = PHYSICS_MT_POOL_SIZE;
+        constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = PHYSICS_MT_POOL_SIZE;
+        _collisionConfiguration = bullet_new<btDefaultCollisionConfiguration>(constructionInfo);
+        _dispatcher = bullet_new<btCollisionDispatcherMt>(_collisionConfiguration);
+        _overlappingPairCache = bullet_new<btDbvtBroadphase>();
+        btConstraintSolverPoolMt* solverPool = bullet_new<btConstraintSolverPoolMt>(threadCount);
+        _solver = solverPool;
+
+        // Create the world (islands are solved in parallel by the solver pool).
+        _world = bullet_new<btDiscreteDynamicsWorldMt>(_dispatcher, _overlappingPairCache, solverPool, (btConstraintSolver*)NULL, _collisionConfiguration);
+    }
+    else
+#else
+    if (threadCount > 1)
+        GP_WARN("Multithreaded physics requires gameplay and Bullet to be built with BT_THREADSAFE; using a single thread.");
+#endif
+    {
+        _collisionConfiguration = bullet_new<btDefaultCollisionConfiguration>();
+        _dispatcher = bullet_new<btCollisionDispatcher>(_collisionConfiguration);
+        _overlappingPairCache = bullet_new<btDbvtBroadphase>();
+        _solver = bullet_new<btSequentialImpulseConstraintSolver>();
+
+        // Create the world.
+        _world = bullet_new<btDiscreteDynamicsWorld>(_dispatcher, _overlappingPairCache, _solver, _collisionConfiguration);
+    }
     _world->setGravity(BV(_gravity));
 
     // Register ghost pair callback so bullet detects collisions with ghost objects (used for character collisions).
@@ -464,6 +1064,24 @@ void PhysicsController::finalize()
     SAFE_DELETE(_overlappingPairCache);
     SAFE_DELETE(_dispatcher);
     SAFE_DELETE(_collisionConfiguration);
+
+#if BT_THREADSAFE
+    if (_taskScheduler)
+    {
+        btSetTaskScheduler(btGetSequentialTaskScheduler());
+        SAFE_DELETE(_taskScheduler);
+    }
+#endif
+    if (_stepPool)
+    {
+        _stepPool->finalize();
+        SAFE_DELETE(_stepPool);
+    }
+    if (_queryPool)
+    {
+        _queryPool->finalize();
+        SAFE_DELETE(_queryPool);
+    }
 }
 
 void PhysicsController::pause()
@@ -486,7 +1104,10 @@ void PhysicsController::update(float elapsedTime)
     //
     // Note that stepSimulation takes elapsed time in seconds
     // so we divide by 1000 to convert from milliseconds.
-    _world->stepSimulation(elapsedTime * 0.001f, 10);
+    if (_fixedTimeStep > 0.0f)
+        stepFixed(elapsedTime * 0.001f);
+    else
+        _world->stepSimulation(elapsedTime * 0.001f, 10);
 
     // If we have status listeners, then check if our status has changed.
     if (_listeners || hasScriptListener(GP_GET_SCRIPT_EVENT(PhysicsController, statusEvent)))
@@ -538,76 +1159,71 @@ void PhysicsController::update(float elapsedTime)
         }
     }
 
-    // All statuses are set with the DIRTY bit before collision processing occurs.
-    // During collision processing, if a collision occurs, the status is 
-    // set to COLLISION and the DIRTY bit is cleared. Then, after collision processing 
-    // is finished, if a given status is still dirty, the COLLISION bit is cleared.
-    //
-    // If an entry was marked for removal in the last frame, fire NOT_COLLIDING if appropriate and remove it now.
+    updateCollisionStatus();
 
-    // Dirty the collision status cache entries.
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end();)
-    {
-        if ((iter->second._status & REMOVE) != 0)
-        {
-            if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
-            {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
-                {
-                    PhysicsCollisionObject::CollisionPair cp(iter->first.objectA, NULL);
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, cp);
-                }
-            }
+    _isUpdating = false;
+}
 
-            std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator eraseIter = iter;
-            iter++;
-            _collisionStatus.erase(eraseIter);
-        }
-        else
-        {
-            iter->second._status |= DIRTY;
-            iter++;
-        }
+void PhysicsController::stepFixed(float elapsedTime)
+{
+    GP_ASSERT(_world);
+    GP_ASSERT(_fixedTimeStep > 0.0f);
+
+    _accumulator += elapsedTime;
+    unsigned int steps = (unsigned int)(_accumulator / _fixedTimeStep);
+    if (steps > _maxSubSteps)
+    {
+        // Drop the time that does not fit in the step budget rather than catching up later.
+        steps = _maxSubSteps;
+        _accumulator = _fixedTimeStep * steps;
     }
 
-    // Go through the collision status cache and perform all registered collision tests.
-    iter = _collisionStatus.begin();
-    for (; iter != _collisionStatus.end(); iter++)
+    for (unsigned int i = 0; i < steps; i++)
     {
-        // If this collision pair was one that was registered for listening, then perform the collision test.
-        // (In the case where we register for all collisions with a rigid body, there will be a lot
-        // of collision pairs in the status cache that we did not explicitly register for.)
-        if ((iter->second._status & REGISTERED) != 0 && (iter->second._status & REMOVE) == 0)
-        {
-            if (iter->first.objectB)
-                _world->contactPairTest(iter->first.objectA->getCollisionObject(), iter->first.objectB->getCollisionObject(), *_collisionCallback);
-            else
-                _world->contactTest(iter->first.objectA->getCollisionObject(), *_collisionCallback);
-        }
+        // The transforms before the last step are the start of the interpolation.
+        if (i == steps - 1)
+            storePreviousTransforms();
+
+        // A single step of exactly the fixed time step (Bullet sets the motion states to the new state).
+        _world->stepSimulation(_fixedTimeStep, 0);
+        _accumulator -= _fixedTimeStep;
     }
+    _accumulator = std::max(_accumulator, 0.0f);
 
-    // Update all the collision status cache entries.
-    iter = _collisionStatus.begin();
-    for ( ; iter != _collisionStatus.end(); iter++)
+    // Show the dynamic rigid bodies between the last two states, as far along as the time left over.
+    float alpha = std::min(_accumulator / _fixedTimeStep, 1.0f);
+    btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+    for (int i = 0; i < objects.size(); i++)
     {
-        if ((iter->second._status & DIRTY) != 0)
+        btRigidBody* body = btRigidBody::upcast(objects[i]);
+        if (body && body->getMotionState() && !body->isStaticOrKinematicObject() && body->getUserPointer())
         {
-            if ((iter->second._status & COLLISION) != 0 && iter->first.objectB)
+            PhysicsCollisionObject::PhysicsMotionState* motionState = static_cast<PhysicsCollisionObject::PhysicsMotionState*>(body->getMotionState());
+            if (body->isActive())
             {
-                size_t size = iter->second._listeners.size();
-                for (size_t i = 0; i < size; i++)
-                {
-                    iter->second._listeners[i]->collisionEvent(PhysicsCollisionObject::CollisionListener::NOT_COLLIDING, iter->first);
-                }
+                motionState->interpolateTransform(alpha);
+            }
+            else
+            {
+                // Settle bodies that fell asleep on their final state.
+                motionState->interpolateTransform(1.0f);
+                motionState->storePreviousTransform();
             }
-
-            iter->second._status &= ~COLLISION;
         }
     }
+}
 
-    _isUpdating = false;
+void PhysicsController::storePreviousTransforms()
+{
+    GP_ASSERT(_world);
+
+    btCollisionObjectArray& objects = _world->getCollisionObjectArray();
+    for (int i = 0; i < objects.size(); i++)
+    {
+        btRigidBody* body = btRigidBody::upcast(objects[i]);
+        if (body && body->getMotionState() && !body->isStaticOrKinematicObject() && body->getUserPointer())
+            static_cast<PhysicsCollisionObject::PhysicsMotionState*>(body->getMotionState())->storePreviousTransform();
+    }
 }
 
 void PhysicsController::addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB)
@@ -698,7 +1314,7 @@ void PhysicsController::removeCollisionObject(PhysicsCollisionObject* object, bo
     // Find all references to the object in the collision status cache and mark them for removal.
     if (removeListeners)
     {
-        std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo>::iterator iter = _collisionStatus.begin();
+        CollisionStatusMap::iterator iter = _collisionStatus.begin();
         for (; iter != _collisionStatus.end(); iter++)
         {
             if (iter->first.objectA == object || iter->first.objectB == object)
@@ -1042,7 +1658,7 @@ PhysicsCollisionShape* PhysicsController::createHeightfield(Node* node, HeightFi
     Terrain* terrain = dynamic_cast<Terrain*>(node->getDrawable());
     if (terrain != NULL)
     {
-        const Vector3& tScale = terrain->_localScale;
+        Vector3 tScale = terrain->getHeightfieldScale();
         scale.set(scale.x * tScale.x, scale.y * tScale.y, scale.z * tScale.z);
     }
 
@@ -1133,12 +1749,13 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
     unsigned int vertexCount = data->vertexCount;
     shapeMeshData->vertexData = new float[vertexCount * 3];
     Vector3 v;
+    float position[3];
     int vertexStride = data->vertexFormat.getVertexSize();
     for (unsigned int i = 0; i < data->vertexCount; i++)
     {
-        v.set(*((float*)&data->vertexData[i * vertexStride + 0 * sizeof(float)]),
-                *((float*)&data->vertexData[i * vertexStride + 1 * sizeof(float)]),
-                *((float*)&data->vertexData[i * vertexStride + 2 * sizeof(float)]));
+        // The vertex data may point (unaligned) into a memory mapped bundle, so copy it out.
+        memcpy(position, &data->vertexData[i * vertexStride], sizeof(float) * 3);
+        v.set(position[0], position[1], position[2]);
         v *= m;
         memcpy(&(shapeMeshData->vertexData[i * 3]), &v, sizeof(float) * 3);
     }
@@ -1200,8 +1817,18 @@ PhysicsCollisionShape* PhysicsController::createMesh(Mesh* mesh, const Vector3&
 
                 // Move the index data into the rigid body's local buffer.
                 // Set it to NULL in the MeshPartData so it is not released when the data is freed.
-                shapeMeshData->indexData.push_back(meshPart->indexData);
-                meshPart->indexData = NULL;
+                // Data that points into a memory mapped bundle is not owned, so it is copied instead.
+                if (meshPart->indexDataMapped)
+                {
+                    unsigned char* indexData = new unsigned char[meshPart->indexCount * indexStride];
+                    memcpy(indexData, meshPart->indexData, meshPart->indexCount * indexStride);
+                    shapeMeshData->indexData.push_back(indexData);
+                }
+                else
+                {
+                    shapeMeshData->indexData.push_back(meshPart->indexData);
+                    meshPart->indexData = NULL;
+                }
 
                 // Create a btIndexedMesh object for the current mesh part.
                 btIndexedMesh indexedMesh;
@@ -1481,4 +2108,24 @@ bool PhysicsController::HitFilter::hit(const PhysicsController::HitResult& resul
     return true;
 }
 
+PhysicsController::RayQuery::RayQuery()
+    : distance(0.0f), mask(PHYSICS_COLLISION_MASK_DEFAULT), firstHit(0), hitCount(0)
+{
+}
+
+PhysicsController::RayQuery::RayQuery(const Ray& ray, float distance, int mask)
+    : ray(ray), distance(distance), mask(mask), firstHit(0), hitCount(0)
+{
+}
+
+PhysicsController::SweepQuery::SweepQuery()
+    : object(NULL), mask(PHYSICS_COLLISION_MASK_DEFAULT), firstHit(0), hitCount(0)
+{
+}
+
+PhysicsController::SweepQuery::SweepQuery(PhysicsCollisionObject* object, const Vector3& endPosition, int mask)
+    : object(object), endPosition(endPosition), mask(mask), firstHit(0), hitCount(0)
+{
+}
+
 }
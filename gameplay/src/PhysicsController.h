@@ -12,10 +12,13 @@
 #include "HeightField.h"
 #include "ScriptTarget.h"
 
+class btITaskScheduler;
+
 namespace gameplay
 {
 
 class ScriptListener;
+class WorkerPool;
 
 /**
  * Defines a class for controlling game physics.
@@ -148,6 +151,100 @@ public:
         virtual bool hit(const HitResult& result);
     };
 
+    /**
+     * Defines a ray test performed by rayTestBatch.
+     *
+     * @script{ignore}
+     */
+    struct RayQuery
+    {
+        /**
+         * Constructor.
+         */
+        RayQuery();
+
+        /**
+         * Constructor.
+         *
+         * @param ray The ray to test intersection with.
+         * @param distance How far along the ray to test for intersections.
+         * @param mask The collision groups that the ray can hit.
+         */
+        RayQuery(const Ray& ray, float distance, int mask = PHYSICS_COLLISION_MASK_DEFAULT);
+
+        /**
+         * The ray to test intersection with.
+         */
+        Ray ray;
+
+        /**
+         * How far along the ray to test for intersections.
+         */
+        float distance;
+
+        /**
+         * The collision groups that the ray can hit.
+         */
+        int mask;
+
+        /**
+         * The index of the first hit of this test in the results (set by the test).
+         */
+        unsigned int firstHit;
+
+        /**
+         * The number of hits of this test (set by the test).
+         */
+        unsigned int hitCount;
+    };
+
+    /**
+     * Defines a sweep test performed by sweepTestBatch.
+     *
+     * @script{ignore}
+     */
+    struct SweepQuery
+    {
+        /**
+         * Constructor.
+         */
+        SweepQuery();
+
+        /**
+         * Constructor.
+         *
+         * @param object The collision object to sweep (from the world position of its node).
+         * @param endPosition The end position of the sweep, in world space.
+         * @param mask The collision groups that the object can hit.
+         */
+        SweepQuery(PhysicsCollisionObject* object, const Vector3& endPosition, int mask = PHYSICS_COLLISION_MASK_DEFAULT);
+
+        /**
+         * The collision object to sweep (with a box, sphere or capsule shape).
+         */
+        PhysicsCollisionObject* object;
+
+        /**
+         * The end position of the sweep, in world space.
+         */
+        Vector3 endPosition;
+
+        /**
+         * The collision groups that the object can hit.
+         */
+        int mask;
+
+        /**
+         * The index of the first hit of this test in the results (set by the test).
+         */
+        unsigned int firstHit;
+
+        /**
+         * The number of hits of this test (set by the test).
+         */
+        unsigned int hitCount;
+    };
+
     /**
      * Extends ScriptTarget::getTypeName() to return the type name of this class.
      *
@@ -301,6 +398,40 @@ public:
      */
     void setGravity(const Vector3& gravity);
 
+    /**
+     * Sets the fixed time step of the simulated physics world.
+     *
+     * With a fixed time step, each update advances the simulation by whole steps of the
+     * given length, and the time left over is carried to the next update. Once all the
+     * steps are taken, the nodes of dynamic rigid bodies are interpolated between the
+     * last two simulated states. Motion is therefore smooth at any frame rate, but it is
+     * shown up to one step behind the simulation. An update never takes more than
+     * maxSubSteps steps. After a long frame, the time beyond that budget is dropped
+     * instead of being caught up over the next frames.
+     *
+     * A time step of zero (the default) steps the simulation by the elapsed time of
+     * each update instead. The step can also be set from the "fixedTimeStep" and
+     * "maxSubSteps" properties of the "physics" section of the game config.
+     *
+     * @param timeStep The fixed time step, in seconds (or zero for a variable time step).
+     * @param maxSubSteps The maximum number of steps taken by a single update.
+     */
+    void setFixedTimeStep(float timeStep, unsigned int maxSubSteps = 10);
+
+    /**
+     * Gets the fixed time step of the simulated physics world.
+     *
+     * @return The fixed time step, in seconds, or zero if the time step is variable.
+     */
+    float getFixedTimeStep() const;
+
+    /**
+     * Gets the maximum number of steps taken by a single update.
+     *
+     * @return The maximum number of steps.
+     */
+    unsigned int getMaxSubSteps() const;
+
     /**
      * Draws debugging information (rigid body outlines, etc.) using the given view projection matrix.
      * 
@@ -341,29 +472,49 @@ public:
      */
     bool sweepTest(PhysicsCollisionObject* object, const Vector3& endPosition, PhysicsController::HitResult* result = NULL, PhysicsController::HitFilter* filter = NULL);
 
-private:
+    /**
+     * Performs a batch of ray tests on the physics world.
+     *
+     * The tests are spread across a worker pool owned by the physics controller, sized
+     * from the "queryThreads" property of the "physics" section of the game config (the
+     * size of the game's worker pool by default). Objects are selected by collision group
+     * only (there is no HitFilter), so no user code runs on the worker threads. Batches
+     * must not be issued while the physics controller is updating.
+     *
+     * @param queries The ray tests. The firstHit and hitCount members of each are set.
+     * @param results Populated with the hits of all the tests, those of each test being
+     *      sorted from nearest to furthest.
+     * @param allHits true to report every object hit by each ray, false to report the closest one only.
+     *
+     * @return The total number of hits.
+     * @script{ignore}
+     */
+    unsigned int rayTestBatch(std::vector<RayQuery>& queries, std::vector<HitResult>& results, bool allHits = false);
 
     /**
-     * Internal class used to integrate with Bullet collision callbacks.
+     * Performs a batch of sweep tests on the physics world.
+     *
+     * The tests are run like those of rayTestBatch. The start position of each sweep is
+     * the current world position of its object, which is never reported as a hit.
+     *
+     * @param queries The sweep tests. The firstHit and hitCount members of each are set.
+     * @param results Populated with the hits of all the tests, those of each test being
+     *      sorted from nearest to furthest.
+     * @param allHits true to report every object hit by each sweep, false to report the closest one only.
+     *
+     * @return The total number of hits.
+     * @script{ignore}
      */
-    class CollisionCallback : public btCollisionWorld::ContactResultCallback
-    {
-    public:
-        /**
-         * Constructor.
-         * 
-         * @param pc The physics controller that owns the callback.
-         */
-        CollisionCallback(PhysicsController* pc) : _pc(pc) {}
+    unsigned int sweepTestBatch(std::vector<SweepQuery>& queries, std::vector<HitResult>& results, bool allHits = false);
 
-    protected:
-        /**
-            * Internal function used for Bullet integration (do not use or override).
-            */
-        btScalar addSingleResult(btManifoldPoint& cp, const btCollisionObjectWrapper* a, int partIdA, int indexA, const btCollisionObjectWrapper* b, int partIdB, int indexB);    
+private:
 
-    private:
-        PhysicsController* _pc;
+    /**
+     * Hashes a collision pair independently of the order of its objects.
+     */
+    struct CollisionPairHash
+    {
+        size_t operator()(const PhysicsCollisionObject::CollisionPair& pair) const;
     };
 
     // Internal constants for the collision status cache.
@@ -381,6 +532,23 @@ private:
         int _status;
     };
 
+    // A collision event queued while the contact manifolds are processed.
+    struct CollisionEvent
+    {
+        CollisionEvent(PhysicsCollisionObject::CollisionListener::EventType type, const PhysicsCollisionObject::CollisionPair& pair,
+                       CollisionInfo* info, const Vector3& contactPointA = Vector3::zero(), const Vector3& contactPointB = Vector3::zero())
+            : _type(type), _pair(pair), _info(info), _contactPointA(contactPointA), _contactPointB(contactPointB) { }
+
+        PhysicsCollisionObject::CollisionListener::EventType _type;
+        PhysicsCollisionObject::CollisionPair _pair;
+        CollisionInfo* _info;
+        Vector3 _contactPointA;
+        Vector3 _contactPointB;
+    };
+
+    // The collision status cache, keyed by collision pair.
+    typedef std::unordered_map<PhysicsCollisionObject::CollisionPair, CollisionInfo, CollisionPairHash> CollisionStatusMap;
+
     /**
      * Constructor.
      */
@@ -393,6 +561,14 @@ private:
 
     /**
      * Controller initialize.
+     *
+     * The number of threads used to step the simulation is read from the "threads"
+     * property of the "physics" section of the game config (1 by default). With more
+     * than one thread the world, the narrowphase and the island solvers run in parallel.
+     *
+     * Stepping on more than one thread requires gameplay and the Bullet libraries to be
+     * built with BT_THREADSAFE=1 (the GP_BULLET_THREADSAFE CMake option); otherwise a
+     * warning is logged and the world is stepped on the calling thread.
      */
     void initialize();
 
@@ -416,6 +592,18 @@ private:
      */
     void update(float elapsedTime);
 
+    // Steps the simulation by whole fixed time steps and interpolates the transforms of dynamic rigid bodies.
+    void stepFixed(float elapsedTime);
+
+    // Stores the current transforms of the dynamic rigid bodies as the start of the interpolation.
+    void storePreviousTransforms();
+
+    // Updates the collision status cache from the dispatcher's contact manifolds and fires the collision events.
+    void updateCollisionStatus();
+
+    // Gets the collision status cache entry of the given pair if it is registered (or derived from a registered object) and not being removed.
+    CollisionInfo* getCollisionInfo(PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
+
     // Adds the given collision listener for the two given collision objects.
     void addCollisionListener(PhysicsCollisionObject::CollisionListener* listener, PhysicsCollisionObject* objectA, PhysicsCollisionObject* objectB);
 
@@ -547,16 +735,23 @@ private:
     btDefaultCollisionConfiguration* _collisionConfiguration;
     btCollisionDispatcher* _dispatcher;
     btBroadphaseInterface* _overlappingPairCache;
-    btSequentialImpulseConstraintSolver* _solver;
+    btConstraintSolver* _solver;
     btDynamicsWorld* _world;
+    WorkerPool* _stepPool;
+    btITaskScheduler* _taskScheduler;
     btGhostPairCallback* _ghostPairCallback;
+    WorkerPool* _queryPool;
     std::vector<PhysicsCollisionShape*> _shapes;
     DebugDrawer* _debugDrawer;
     Listener::EventType _status;
     std::vector<Listener*>* _listeners;
     Vector3 _gravity;
-    std::map<PhysicsCollisionObject::CollisionPair, CollisionInfo> _collisionStatus;
-    CollisionCallback* _collisionCallback;
+    float _fixedTimeStep;
+    unsigned int _maxSubSteps;
+    float _accumulator;
+    CollisionStatusMap _collisionStatus;
+    std::vector<CollisionEvent> _collisionEvents;
+    std::vector<PhysicsCollisionObject::CollisionPair> _removedCollisionPairs;
 };
 
 }
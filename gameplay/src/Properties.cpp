@@ -6,6 +6,18 @@
 namespace gameplay
 {
 
+// Identifier at the start of the compiled binary form of a properties file (followed by the major and minor version).
+static const unsigned char __binaryIdentifier[9] = { 0xAB, 'G', 'P', 'P', 0xBB, '\r', '\n', 0x1A, '\n' };
+#define PROPERTIES_BINARY_VERSION_MAJOR 1
+#define PROPERTIES_BINARY_VERSION_MINOR 0
+
+// The extension appended to the path of a properties file to find its compiled binary form.
+#define PROPERTIES_BINARY_EXTENSION ".gpp"
+
+// Parsed files by resolved path; create() returns copies of them.
+static std::unordered_map<std::string, Properties*> __cache;
+static std::mutex __cacheMutex;
+
 /**
  * Reads the next character from the stream. Returns EOF if the end of the stream is reached.
  */
@@ -33,6 +45,7 @@ Properties::Properties()
 Properties::Properties(const Properties& copy)
     : _namespace(copy._namespace), _id(copy._id), _parentID(copy._parentID), _properties(copy._properties), _variables(NULL), _dirPath(NULL), _visited(false), _parent(copy._parent)
 {
+    indexProperties();
     setDirectoryPath(copy._dirPath);
     _namespaces = std::vector<Properties*>();
     std::vector<Properties*>::const_iterator it;
@@ -80,38 +93,250 @@ Properties* Properties::create(const char* url)
     std::vector<std::string> namespacePath;
     calculateNamespacePath(urlString, fileString, namespacePath);
 
-    std::unique_ptr<Stream> stream(FileSystem::open(fileString.c_str()));
-    if (stream.get() == NULL)
+    // Load the file, unless it has already been parsed. Files are loaded and parsed without
+    // holding the cache lock, so that threads creating properties from other files do not wait.
+    std::string path = FileSystem::resolvePath(fileString.c_str());
+    std::unique_lock<std::mutex> lock(__cacheMutex);
+    std::unordered_map<std::string, Properties*>::const_iterator itr = __cache.find(path);
+    Properties* properties;
+    if (itr != __cache.end())
     {
-        GP_WARN("Failed to open file '%s'.", fileString.c_str());
-        return NULL;
+        properties = itr->second;
+    }
+    else
+    {
+        lock.unlock();
+        properties = loadFile(path.c_str());
+        if (!properties)
+            return NULL;
+        lock.lock();
+
+        // Another thread may have loaded the same file in the meantime.
+        std::pair<std::unordered_map<std::string, Properties*>::iterator, bool> inserted = __cache.insert(std::make_pair(path, properties));
+        if (!inserted.second)
+        {
+            SAFE_DELETE(properties);
+            properties = inserted.first->second;
+        }
     }
 
-    Properties* properties = new Properties(stream.get());
-    properties->resolveInheritance();
-    stream->close();
-
-    // Get the specified properties object.
+    // Get the specified properties object (still under the lock, since finding it moves the namespace iterators).
     Properties* p = getPropertiesFromNamespacePath(properties, namespacePath);
     if (!p)
     {
         GP_WARN("Failed to load properties from url '%s'.", url);
-        SAFE_DELETE(properties);
         return NULL;
     }
 
-    // If the loaded properties object is not the root namespace,
-    // then we have to clone it and delete the root namespace
-    // so that we don't leak memory.
-    if (p != properties)
-    {
-        p = p->clone();
-        SAFE_DELETE(properties);
-    }
+    // Return a copy, since the caller owns it and may modify it.
+    p = p->clone();
+    lock.unlock();
     p->setDirectoryPath(FileSystem::getDirectoryName(fileString.c_str()));
     return p;
 }
 
+void Properties::clearCache()
+{
+    std::lock_guard<std::mutex> lock(__cacheMutex);
+    for (std::unordered_map<std::string, Properties*>::iterator itr = __cache.begin(); itr != __cache.end(); ++itr)
+    {
+        SAFE_DELETE(itr->second);
+    }
+    __cache.clear();
+}
+
+Properties* Properties::loadFile(const char* path)
+{
+    GP_ASSERT(path);
+
+    // Prefer the compiled binary form of the file.
+    std::string binaryPath = std::string(path) + PROPERTIES_BINARY_EXTENSION;
+    std::unique_ptr<Stream> stream;
+    if (FileSystem::fileExists(binaryPath.c_str()))
+        stream.reset(FileSystem::open(binaryPath.c_str()));
+    if (stream.get() == NULL)
+        stream.reset(FileSystem::open(path));
+    if (stream.get() == NULL)
+    {
+        GP_WARN("Failed to open file '%s'.", path);
+        return NULL;
+    }
+
+    Properties* properties = NULL;
+    unsigned char identifier[sizeof(__binaryIdentifier) + 2];
+    if (stream->read(identifier, 1, sizeof(identifier)) == sizeof(identifier) &&
+        memcmp(identifier, __binaryIdentifier, sizeof(__binaryIdentifier)) == 0)
+    {
+        if (identifier[sizeof(__binaryIdentifier)] != PROPERTIES_BINARY_VERSION_MAJOR)
+        {
+            GP_WARN("Unsupported version (%d.%d) of compiled properties file '%s'.",
+                identifier[sizeof(__binaryIdentifier)], identifier[sizeof(__binaryIdentifier) + 1], path);
+            return NULL;
+        }
+
+        // Read the whole file at once (or use it in place if the stream is mapped).
+        std::vector<unsigned char> buffer;
+        const unsigned char* data = stream->getData();
+        size_t length = stream->length();
+        if (!data)
+        {
+            buffer.resize(length);
+            if (!stream->rewind() || length == 0 || stream->read(&buffer[0], 1, length) != length)
+            {
+                GP_WARN("Failed to read compiled properties file '%s'.", path);
+                return NULL;
+            }
+            data = &buffer[0];
+        }
+
+        const unsigned char* ptr = data + sizeof(identifier);
+        properties = new Properties();
+        if (!properties->readBinary(ptr, data + length))
+        {
+            GP_WARN("Compiled properties file '%s' is truncated.", path);
+            SAFE_DELETE(properties);
+            return NULL;
+        }
+    }
+    else
+    {
+        stream->rewind();
+        properties = new Properties(stream.get());
+    }
+    stream->close();
+
+    properties->resolveInheritance();
+    return properties;
+}
+
+// Reads a length-prefixed string from the compiled binary form of a properties file.
+static bool readBinaryString(const unsigned char*& ptr, const unsigned char* end, std::string& str)
+{
+    unsigned int length;
+    if (end - ptr < (ptrdiff_t)sizeof(length))
+        return false;
+    memcpy(&length, ptr, sizeof(length));
+    ptr += sizeof(length);
+    if ((size_t)(end - ptr) < length)
+        return false;
+    str.assign((const char*)ptr, length);
+    ptr += length;
+    return true;
+}
+
+// Reads a count from the compiled binary form of a properties file.
+static bool readBinaryCount(const unsigned char*& ptr, const unsigned char* end, unsigned int& count)
+{
+    if (end - ptr < (ptrdiff_t)sizeof(count))
+        return false;
+    memcpy(&count, ptr, sizeof(count));
+    ptr += sizeof(count);
+    return true;
+}
+
+bool Properties::readBinary(const unsigned char*& ptr, const unsigned char* end)
+{
+    // Each namespace is written as its name, ID and parent ID, followed by
+    // its properties, its variables and its nested namespaces.
+    if (!readBinaryString(ptr, end, _namespace) || !readBinaryString(ptr, end, _id) || !readBinaryString(ptr, end, _parentID))
+        return false;
+
+    unsigned int count;
+    std::string name;
+    std::string value;
+    if (!readBinaryCount(ptr, end, count))
+        return false;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (!readBinaryString(ptr, end, name) || !readBinaryString(ptr, end, value))
+            return false;
+        addProperty(name.c_str(), value.c_str());
+    }
+
+    if (!readBinaryCount(ptr, end, count))
+        return false;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        if (!readBinaryString(ptr, end, name) || !readBinaryString(ptr, end, value))
+            return false;
+        setVariable(name.c_str(), value.c_str());
+    }
+
+    if (!readBinaryCount(ptr, end, count))
+        return false;
+    _namespaces.reserve(count);
+    for (unsigned int i = 0; i < count; i++)
+    {
+        Properties* space = new Properties();
+        space->_parent = this;
+        _namespaces.push_back(space);
+        if (!space->readBinary(ptr, end))
+            return false;
+    }
+
+    rewind();
+    return true;
+}
+
+unsigned int Properties::hashName(const char* name)
+{
+    GP_ASSERT(name);
+
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (; *name; name++)
+    {
+        hash ^= (unsigned char)*name;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+std::list<Properties::Property>::const_iterator Properties::findProperty(const char* name) const
+{
+    return const_cast<Properties*>(this)->findProperty(name);
+}
+
+std::list<Properties::Property>::iterator Properties::findProperty(const char* name)
+{
+    GP_ASSERT(name);
+
+    typedef std::unordered_multimap<unsigned int, std::list<Property>::iterator>::const_iterator IndexIterator;
+    std::pair<IndexIterator, IndexIterator> range = _propertyIndex.equal_range(hashName(name));
+    for (IndexIterator itr = range.first; itr != range.second; ++itr)
+    {
+        if (itr->second->name == name)
+            return itr->second;
+    }
+    return _properties.end();
+}
+
+void Properties::addProperty(const char* name, const char* value)
+{
+    GP_ASSERT(name);
+    GP_ASSERT(value);
+
+    // Only the first property with a name is indexed, since that is the one found by name.
+    bool indexed = findProperty(name) != _properties.end();
+    _properties.push_back(Property(name, value));
+    if (!indexed)
+    {
+        std::list<Property>::iterator itr = _properties.end();
+        --itr;
+        _propertyIndex.insert(std::make_pair(itr->hash, itr));
+    }
+}
+
+void Properties::indexProperties()
+{
+    _propertyIndex.clear();
+    for (std::list<Property>::iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+    {
+        if (findProperty(itr->name.c_str()) == _properties.end())
+            _propertyIndex.insert(std::make_pair(itr->hash, itr));
+    }
+}
+
 static bool isVariable(const char* str, char* outName, size_t outSize)
 {
     size_t len = strlen(str);
@@ -216,7 +441,7 @@ void Properties::readProperties(Stream* stream)
                 else
                 {
                     // Normal name/value pair
-                    _properties.push_back(Property(name, value));
+                    addProperty(name, value);
                 }
             }
             else
@@ -364,11 +589,11 @@ void Properties::readProperties(Stream* stream)
                             // Store "name value" as a name/value pair, or even just "name".
                             if (value != NULL)
                             {
-                                _properties.push_back(Property(name, value));
+                                addProperty(name, value);
                             }
                             else
                             {
-                                _properties.push_back(Property(name, ""));
+                                addProperty(name, "");
                             }
                         }
                     }
@@ -477,6 +702,7 @@ void Properties::resolveInheritance(const char* id)
 
                 // Copy data from the parent into the child.
                 derived->_properties = parent->_properties;
+                derived->indexProperties();
                 derived->_namespaces = std::vector<Properties*>();
                 std::vector<Properties*>::const_iterator itt;
                 for (itt = parent->_namespaces.begin(); itt < parent->_namespaces.end(); ++itt)
@@ -637,13 +863,7 @@ bool Properties::exists(const char* name) const
     if (name == NULL)
         return false;
 
-    for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
-    {
-        if (itr->name == name)
-            return true;
-    }
-
-    return false;
+    return findProperty(name) != _properties.end();
 }
 
 static const bool isStringNumeric(const char* str)
@@ -727,14 +947,9 @@ const char* Properties::getString(const char* name, const char* defaultValue) co
             return getVariable(variable, defaultValue);
         }
 
-        for (std::list<Property>::const_iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
-        {
-            if (itr->name == name)
-            {
-                value = itr->value.c_str();
-                break;
-            }
-        }
+        std::list<Property>::const_iterator itr = findProperty(name);
+        if (itr != _properties.end())
+            value = itr->value.c_str();
     }
     else
     {
@@ -761,18 +976,16 @@ bool Properties::setString(const char* name, const char* value)
 {
     if (name)
     {
-        for (std::list<Property>::iterator itr = _properties.begin(); itr != _properties.end(); ++itr)
+        std::list<Property>::iterator itr = findProperty(name);
+        if (itr != _properties.end())
         {
-            if (itr->name == name)
-            {
-                // Update the first property that matches this name
-                itr->value = value ? value : "";
-                return true;
-            }
+            // Update the first property that matches this name
+            itr->value = value ? value : "";
+            return true;
         }
 
         // There is no property with this name, so add one
-        _properties.push_back(Property(name, value ? value : ""));
+        addProperty(name, value ? value : "");
     }
     else
     {
@@ -1014,8 +1227,11 @@ Properties* Properties::clone()
     p->_id = _id;
     p->_parentID = _parentID;
     p->_properties = _properties;
+    p->indexProperties();
     p->_propertiesItr = p->_properties.end();
     p->setDirectoryPath(_dirPath);
+    if (_variables)
+        p->_variables = new std::vector<Property>(*_variables);
 
     for (size_t i = 0, count = _namespaces.size(); i < count; i++)
     {
@@ -122,6 +122,11 @@ class Properties;
  * modified to do so.  Also note that nothing in a properties file indicates the type
  * of a property. If the type is unknown, its string can be retrieved and interpreted
  * as necessary.
+ *
+ * Files are parsed once and kept in a cache keyed by their resolved path; each call to
+ * create() returns a copy of the cached namespace that the caller owns and may modify.
+ * The encoder can compile a properties file into a binary form (written next to it with
+ * a ".gpp" extension appended), which create() loads in preference to the text file.
  */
 class Properties
 {
@@ -155,6 +160,14 @@ public:
      */
     static Properties* create(const char* url);
 
+    /**
+     * Releases the parsed files kept by the cache, so that later calls to create()
+     * read the files again.
+     *
+     * This can be called between levels to reclaim memory, or after files are modified.
+     */
+    static void clearCache();
+
     /**
      * Destructor.
      */
@@ -515,7 +528,8 @@ private:
     {
         std::string name;
         std::string value;
-        Property(const char* name, const char* value) : name(name), value(value) { }
+        unsigned int hash;
+        Property(const char* name, const char* value) : name(name), value(value), hash(hashName(name)) { }
     };
 
     /**
@@ -540,6 +554,43 @@ private:
 
     void readProperties(Stream* stream);
 
+    /**
+     * Reads a namespace (and those it contains) from the compiled binary form of a file.
+     *
+     * @param ptr The data to read, advanced past the namespace.
+     * @param end The end of the data.
+     *
+     * @return true if the namespace was read, false if the data is truncated.
+     */
+    bool readBinary(const unsigned char*& ptr, const unsigned char* end);
+
+    /**
+     * Loads and parses a file, either compiled or text, and resolves its inheritance.
+     */
+    static Properties* loadFile(const char* path);
+
+    /**
+     * Computes the hash used to find properties by name.
+     */
+    static unsigned int hashName(const char* name);
+
+    /**
+     * Finds the first property with the given name.
+     */
+    std::list<Property>::const_iterator findProperty(const char* name) const;
+
+    std::list<Property>::iterator findProperty(const char* name);
+
+    /**
+     * Appends a property, indexing it if it is the first with its name.
+     */
+    void addProperty(const char* name, const char* value);
+
+    /**
+     * Rebuilds the index of the properties (after the list is copied).
+     */
+    void indexProperties();
+
     void setDirectoryPath(const std::string* path);
 
     void setDirectoryPath(const std::string& path);
@@ -560,6 +611,7 @@ private:
     std::string _parentID;
     std::list<Property> _properties;
     std::list<Property>::iterator _propertiesItr;
+    std::unordered_multimap<unsigned int, std::list<Property>::iterator> _propertyIndex;
     std::vector<Properties*> _namespaces;
     std::vector<Properties*>::const_iterator _namespacesItr;
     std::vector<Property>* _variables;
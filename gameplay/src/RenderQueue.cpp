@@ -0,0 +1,392 @@
+#include "Base.h"
+#include "RenderQueue.h"
+#include "Camera.h"
+#include "Drawable.h"
+#include "MaterialParameter.h"
+#include "Node.h"
+#include "Pass.h"
+#include "Scene.h"
+#include "Technique.h"
+
+// The number of texture units whose bound sampler is tracked.
+#define RENDER_QUEUE_TEXTURE_UNITS 32
+
+// The maximum depth of a render state hierarchy (pass, technique, material).
+#define RENDER_QUEUE_STATE_DEPTH 4
+
+// The largest quantized depth (24 bits).
+#define RENDER_QUEUE_DEPTH_MAX 0xFFFFFF
+
+// Sort key layout (from the most significant bit):
+//   opaque:      layer(2) | order(4) | program(16) | texture(16) | depth(24) | unused(2)
+//   transparent: layer(2) | inverted depth(24) | order(4) | program(16) | texture(16) | unused(2)
+#define RENDER_QUEUE_LAYER_OPAQUE 0ULL
+#define RENDER_QUEUE_LAYER_TRANSPARENT 1ULL
+
+namespace gameplay
+{
+
+RenderQueue::Statistics::Statistics()
+    : packetCount(0), drawCallCount(0), programBinds(0), programBindsAvoided(0), stateBinds(0), stateBindsAvoided(0),
+      textureBinds(0), textureBindsAvoided(0), uniformBinds(0), uniformBindsAvoided(0)
+{
+}
+
+RenderQueue::RenderQueue()
+    : _nearPlane(0.0f), _depthScale(0.0f), _camera(NULL), _currentEffect(NULL), _currentPass(NULL),
+      _textureUnits(RENDER_QUEUE_TEXTURE_UNITS, (const Texture::Sampler*)NULL)
+{
+}
+
+RenderQueue::~RenderQueue()
+{
+}
+
+RenderQueue* RenderQueue::create()
+{
+    return new RenderQueue();
+}
+
+void RenderQueue::start(Camera* camera)
+{
+    _packets.clear();
+    _entries.clear();
+    _statistics = Statistics();
+
+    _camera = camera;
+    if (_camera)
+    {
+        _viewMatrix = _camera->getViewMatrix();
+        _nearPlane = _camera->getNearPlane();
+        float range = _camera->getFarPlane() - _nearPlane;
+        _depthScale = range > 0.0f ? 1.0f / range : 0.0f;
+    }
+}
+
+void RenderQueue::add(Drawable* drawable, Pass* pass, unsigned int part, unsigned int order)
+{
+    GP_ASSERT(drawable);
+    GP_ASSERT(pass);
+    GP_ASSERT(pass->getEffect());
+
+    unsigned long long depth = getDepth(drawable);
+    unsigned long long program = pass->getEffect()->_program & 0xFFFF;
+    Texture* texture = getTexture(pass);
+    unsigned long long textureId = texture ? (texture->getHandle() & 0xFFFF) : 0;
+    unsigned long long passOrder = std::min(order, 15u);
+
+    SortEntry entry;
+    if (isTransparent(pass))
+    {
+        entry.key = (RENDER_QUEUE_LAYER_TRANSPARENT << 62) | ((RENDER_QUEUE_DEPTH_MAX - depth) << 38) |
+                    (passOrder << 34) | (program << 18) | (textureId << 2);
+    }
+    else
+    {
+        entry.key = (RENDER_QUEUE_LAYER_OPAQUE << 62) | (passOrder << 58) | (program << 42) | (textureId << 26) | (depth << 2);
+    }
+    entry.index = (unsigned int)_packets.size();
+    _entries.push_back(entry);
+
+    Packet packet;
+    packet.drawable = drawable;
+    packet.pass = pass;
+    packet.part = part;
+    _packets.push_back(packet);
+}
+
+void RenderQueue::add(Drawable* drawable, bool transparent)
+{
+    GP_ASSERT(drawable);
+
+    unsigned long long depth = getDepth(drawable);
+
+    SortEntry entry;
+    if (transparent)
+        entry.key = (RENDER_QUEUE_LAYER_TRANSPARENT << 62) | ((RENDER_QUEUE_DEPTH_MAX - depth) << 38);
+    else
+        entry.key = (RENDER_QUEUE_LAYER_OPAQUE << 62) | (depth << 2);
+    entry.index = (unsigned int)_packets.size();
+    _entries.push_back(entry);
+
+    Packet packet;
+    packet.drawable = drawable;
+    packet.pass = NULL;
+    packet.part = 0;
+    _packets.push_back(packet);
+}
+
+unsigned int RenderQueue::add(Scene* scene)
+{
+    GP_ASSERT(scene);
+
+    Camera* camera = _camera ? _camera : scene->getActiveCamera();
+    if (!camera)
+    {
+        GP_WARN("Failed to add scene '%s' to render queue; the scene has no active camera.", scene->getId());
+        return 0;
+    }
+
+    _nodes.clear();
+    scene->queryNodes(camera->getFrustum(), _nodes);
+
+    unsigned int count = 0;
+    for (size_t i = 0, nodeCount = _nodes.size(); i < nodeCount; ++i)
+    {
+        Drawable* drawable = _nodes[i]->getDrawable();
+        if (drawable)
+        {
+            drawable->enqueue(this);
+            ++count;
+        }
+    }
+    return count;
+}
+
+unsigned int RenderQueue::getPacketCount() const
+{
+    return (unsigned int)_packets.size();
+}
+
+unsigned int RenderQueue::draw(bool wireframe)
+{
+    sort(_entries, _scratch);
+
+    // Other code may have bound anything since the last frame.
+    resetState();
+
+    for (size_t i = 0, count = _entries.size(); i < count; ++i)
+    {
+        const Packet& packet = _packets[_entries[i].index];
+        GP_ASSERT(packet.drawable);
+
+        if (packet.pass)
+        {
+            bindPass(packet.pass);
+            _statistics.drawCallCount += packet.drawable->drawPart(packet.part, wireframe);
+        }
+        else
+        {
+            // Self drawing packets bind their own state, so forget ours around them.
+            resetState();
+            _statistics.drawCallCount += packet.drawable->draw(wireframe);
+            resetState();
+        }
+        ++_statistics.packetCount;
+    }
+    resetState();
+
+    return _statistics.drawCallCount;
+}
+
+const RenderQueue::Statistics& RenderQueue::getStatistics() const
+{
+    return _statistics;
+}
+
+unsigned int RenderQueue::getDepth(Drawable* drawable) const
+{
+    Node* node = drawable->getNode();
+    if (!_camera || !node)
+        return 0;
+
+    Vector3 center;
+    _viewMatrix.transformPoint(node->getBoundingSphere().center, &center);
+
+    // The camera looks down -z in view space.
+    float depth = (-center.z - _nearPlane) * _depthScale;
+    if (depth <= 0.0f)
+        return 0;
+    if (depth >= 1.0f)
+        return RENDER_QUEUE_DEPTH_MAX;
+    return (unsigned int)(depth * RENDER_QUEUE_DEPTH_MAX);
+}
+
+void RenderQueue::bindPass(Pass* pass)
+{
+    GP_ASSERT(pass);
+
+    Effect* effect = pass->getEffect();
+    GP_ASSERT(effect);
+    if (effect != _currentEffect)
+    {
+        effect->bind();
+        _currentEffect = effect;
+        ++_statistics.programBinds;
+    }
+    else
+    {
+        ++_statistics.programBindsAvoided;
+    }
+
+    // Collect the render state hierarchy (pass, technique, material).
+    RenderState* states[RENDER_QUEUE_STATE_DEPTH];
+    unsigned int stateCount = 0;
+    for (RenderState* rs = pass; rs != NULL; rs = rs->_parent)
+    {
+        GP_ASSERT(stateCount < RENDER_QUEUE_STATE_DEPTH);
+        states[stateCount++] = rs;
+    }
+
+    // The same pass was bound by the previous packet, so its program still holds the values
+    // of all parameters except those computed by methods (node transforms, lights, etc.) and
+    // its render state and vertex attribute binding are still in place.
+    if (pass == _currentPass)
+    {
+        ++_statistics.stateBindsAvoided;
+        for (unsigned int i = stateCount; i-- > 0;)
+        {
+            const std::vector<MaterialParameter*>& parameters = states[i]->_parameters;
+            for (size_t j = 0, count = parameters.size(); j < count; ++j)
+            {
+                GP_ASSERT(parameters[j]);
+                if (parameters[j]->_type == MaterialParameter::METHOD)
+                {
+                    parameters[j]->bind(effect);
+                    ++_statistics.uniformBinds;
+                }
+                else
+                {
+                    ++_statistics.uniformBindsAvoided;
+                }
+            }
+        }
+        return;
+    }
+
+    if (_currentPass)
+        _currentPass->unbind();
+    _currentPass = pass;
+
+    pass->bindStateBlocks();
+    ++_statistics.stateBinds;
+
+    // Apply parameter bindings for the entire hierarchy, top-down.
+    for (unsigned int i = stateCount; i-- > 0;)
+    {
+        const std::vector<MaterialParameter*>& parameters = states[i]->_parameters;
+        for (size_t j = 0, count = parameters.size(); j < count; ++j)
+        {
+            MaterialParameter* parameter = parameters[j];
+            GP_ASSERT(parameter);
+
+            // Skip re-binding a sampler that is already bound to the texture unit of its uniform.
+            Uniform* uniform = parameter->_uniform;
+            if (parameter->_type == MaterialParameter::SAMPLER && uniform && uniform->getEffect() == effect &&
+                uniform->_index < RENDER_QUEUE_TEXTURE_UNITS && _textureUnits[uniform->_index] == parameter->_value.samplerValue)
+            {
+                effect->setValue(uniform, (int)uniform->_index);
+                ++_statistics.textureBindsAvoided;
+                ++_statistics.uniformBinds;
+                continue;
+            }
+
+            parameter->bind(effect);
+            ++_statistics.uniformBinds;
+
+            uniform = parameter->_uniform;
+            if (!uniform || uniform->getEffect() != effect)
+                continue;
+            if (parameter->_type == MaterialParameter::SAMPLER)
+            {
+                const Texture::Sampler* sampler = parameter->_value.samplerValue;
+                ++_statistics.textureBinds;
+                if (uniform->_index >= RENDER_QUEUE_TEXTURE_UNITS)
+                    continue;
+
+                // Binding the sampler applied its filter and wrap modes to the texture, so other units
+                // holding the same texture through another sampler no longer match their sampler.
+                for (unsigned int unit = 0; unit < RENDER_QUEUE_TEXTURE_UNITS; ++unit)
+                {
+                    const Texture::Sampler* bound = _textureUnits[unit];
+                    if (bound && bound != sampler && bound->getTexture() == sampler->getTexture())
+                        _textureUnits[unit] = NULL;
+                }
+                _textureUnits[uniform->_index] = sampler;
+            }
+            else if (parameter->_type == MaterialParameter::SAMPLER_ARRAY)
+            {
+                _statistics.textureBinds += parameter->_count;
+                for (unsigned int unit = 0; unit < RENDER_QUEUE_TEXTURE_UNITS; ++unit)
+                    _textureUnits[unit] = NULL;
+            }
+        }
+    }
+
+    if (pass->_vaBinding)
+        pass->_vaBinding->bind();
+}
+
+void RenderQueue::resetState()
+{
+    if (_currentPass)
+    {
+        _currentPass->unbind();
+        _currentPass = NULL;
+    }
+    _currentEffect = NULL;
+    for (unsigned int unit = 0; unit < RENDER_QUEUE_TEXTURE_UNITS; ++unit)
+        _textureUnits[unit] = NULL;
+}
+
+void RenderQueue::sort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    size_t count = entries.size();
+    if (count < 2)
+        return;
+    scratch.resize(count);
+
+    SortEntry* source = &entries[0];
+    SortEntry* destination = &scratch[0];
+    unsigned int histogram[256];
+    for (unsigned int shift = 0; shift < 64; shift += 8)
+    {
+        memset(histogram, 0, sizeof(histogram));
+        for (size_t i = 0; i < count; ++i)
+            ++histogram[(source[i].key >> shift) & 0xFF];
+
+        // Every key has the same byte here, so this pass would not move anything.
+        if (histogram[(source[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        unsigned int offset = 0;
+        for (unsigned int i = 0; i < 256; ++i)
+        {
+            unsigned int bucketCount = histogram[i];
+            histogram[i] = offset;
+            offset += bucketCount;
+        }
+        for (size_t i = 0; i < count; ++i)
+            destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+
+        std::swap(source, destination);
+    }
+
+    if (source != &entries[0])
+        memcpy(&entries[0], source, count * sizeof(SortEntry));
+}
+
+bool RenderQueue::isTransparent(Pass* pass)
+{
+    GP_ASSERT(pass);
+    return pass->isBlendEnabled();
+}
+
+Texture* RenderQueue::getTexture(Pass* pass)
+{
+    GP_ASSERT(pass);
+
+    // Parameters lower in the hierarchy override those above, so search from the pass up.
+    for (RenderState* rs = pass; rs != NULL; rs = rs->_parent)
+    {
+        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
+        {
+            MaterialParameter* parameter = rs->_parameters[i];
+            if (parameter->_type == MaterialParameter::SAMPLER && parameter->_value.samplerValue)
+                return parameter->_value.samplerValue->getTexture();
+        }
+    }
+    return NULL;
+}
+
+}
@@ -0,0 +1,238 @@
+#ifndef RENDERQUEUE_H_
+#define RENDERQUEUE_H_
+
+#include "Matrix.h"
+#include "Texture.h"
+
+namespace gameplay
+{
+
+class Camera;
+class Drawable;
+class Effect;
+class Node;
+class Pass;
+class Scene;
+
+/**
+ * Defines a queue of draw packets that are sorted before they are drawn.
+ *
+ * Drawables add packets to the queue (see Drawable::enqueue) instead of drawing
+ * themselves immediately. Each packet is given a 64-bit sort key that orders
+ * opaque geometry by pass, effect and texture (and then front-to-back), followed
+ * by transparent geometry back-to-front. When the queue is drawn, the keys are
+ * radix sorted and consecutive packets skip program, texture, render state and
+ * uniform binds that would not change anything.
+ *
+ * A queue is typically filled and drawn once per frame:
+ *
+ * @code
+ * _queue->start(scene->getActiveCamera());
+ * _queue->add(scene);
+ * _queue->draw();
+ * @endcode
+ *
+ * @script{ignore}
+ */
+class RenderQueue
+{
+public:
+
+    /**
+     * Defines the counters gathered while the queue is drawn.
+     */
+    struct Statistics
+    {
+        /**
+         * Constructor.
+         */
+        Statistics();
+
+        /** The number of packets drawn. */
+        unsigned int packetCount;
+        /** The number of draw calls issued. */
+        unsigned int drawCallCount;
+        /** The number of shader programs bound. */
+        unsigned int programBinds;
+        /** The number of shader program binds skipped. */
+        unsigned int programBindsAvoided;
+        /** The number of render state hierarchies applied. */
+        unsigned int stateBinds;
+        /** The number of render state hierarchy binds skipped. */
+        unsigned int stateBindsAvoided;
+        /** The number of textures bound. */
+        unsigned int textureBinds;
+        /** The number of texture binds skipped. */
+        unsigned int textureBindsAvoided;
+        /** The number of uniforms set. */
+        unsigned int uniformBinds;
+        /** The number of uniform sets skipped. */
+        unsigned int uniformBindsAvoided;
+    };
+
+    /**
+     * Creates a new render queue.
+     *
+     * @return The new render queue.
+     */
+    static RenderQueue* create();
+
+    /**
+     * Destructor.
+     */
+    ~RenderQueue();
+
+    /**
+     * Starts a new frame, removing all packets and resetting the statistics.
+     *
+     * @param camera The camera used to compute the depth of packets (may be NULL).
+     */
+    void start(Camera* camera);
+
+    /**
+     * Adds a packet that draws a part of a drawable with the given pass.
+     *
+     * The drawable's drawPart method is called to issue the draw call once the
+     * pass has been bound.
+     *
+     * @param drawable The drawable.
+     * @param pass The pass used to draw the part.
+     * @param part The index of the part to draw.
+     * @param order The order of the pass within its technique (passes of a lower order are drawn first).
+     */
+    void add(Drawable* drawable, Pass* pass, unsigned int part, unsigned int order = 0);
+
+    /**
+     * Adds a packet that draws a drawable with its own draw method.
+     *
+     * Such drawables bind their own state, so the queue's cached state is reset around them.
+     *
+     * @param drawable The drawable.
+     * @param transparent true to draw the drawable with the transparent (back-to-front) geometry.
+     */
+    void add(Drawable* drawable, bool transparent);
+
+    /**
+     * Adds the drawables of all the enabled nodes in the scene that intersect the
+     * frustum of the queue's camera (or of all enabled nodes if there is no camera).
+     *
+     * Nodes are found through Scene::queryNodes, so the scene's spatial index is
+     * used when it is enabled.
+     *
+     * @param scene The scene.
+     *
+     * @return The number of drawables added.
+     */
+    unsigned int add(Scene* scene);
+
+    /**
+     * Gets the number of packets in the queue.
+     *
+     * @return The number of packets.
+     */
+    unsigned int getPacketCount() const;
+
+    /**
+     * Sorts and draws the packets in the queue.
+     *
+     * @param wireframe true to request to draw the wireframe only.
+     *
+     * @return The number of draw calls issued.
+     */
+    unsigned int draw(bool wireframe = false);
+
+    /**
+     * Gets the statistics gathered by the last call to draw.
+     *
+     * @return The statistics.
+     */
+    const Statistics& getStatistics() const;
+
+private:
+
+    /**
+     * Defines a draw packet.
+     */
+    struct Packet
+    {
+        /** The drawable. */
+        Drawable* drawable;
+        /** The pass (NULL when the drawable draws itself). */
+        Pass* pass;
+        /** The part of the drawable. */
+        unsigned int part;
+    };
+
+    /**
+     * Defines a sort key and the index of its packet.
+     */
+    struct SortEntry
+    {
+        /** The sort key. */
+        unsigned long long key;
+        /** The index of the packet. */
+        unsigned int index;
+    };
+
+    /**
+     * Constructor.
+     */
+    RenderQueue();
+
+    /**
+     * Hidden copy constructor.
+     */
+    RenderQueue(const RenderQueue&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    RenderQueue& operator=(const RenderQueue&);
+
+    /**
+     * Gets the quantized depth of a drawable from the queue's camera.
+     */
+    unsigned int getDepth(Drawable* drawable) const;
+
+    /**
+     * Binds a pass, skipping whatever is already bound.
+     */
+    void bindPass(Pass* pass);
+
+    /**
+     * Forgets all cached state, unbinding the current pass.
+     */
+    void resetState();
+
+    /**
+     * Sorts the entries by key using a least significant byte first radix sort.
+     */
+    static void sort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+    /**
+     * Gets whether the render state hierarchy of a pass enables blending.
+     */
+    static bool isTransparent(Pass* pass);
+
+    /**
+     * Gets the first texture sampled by the render state hierarchy of a pass.
+     */
+    static Texture* getTexture(Pass* pass);
+
+    std::vector<Packet> _packets;
+    std::vector<SortEntry> _entries;
+    std::vector<SortEntry> _scratch;
+    std::vector<Node*> _nodes;
+    Matrix _viewMatrix;
+    float _nearPlane;
+    float _depthScale;
+    Camera* _camera;
+    Effect* _currentEffect;
+    Pass* _currentPass;
+    std::vector<const Texture::Sampler*> _textureUnits;
+    Statistics _statistics;
+};
+
+}
+
+#endif
@@ -405,6 +405,23 @@ void RenderState::bind(Pass* pass)
 {
     GP_ASSERT(pass);
 
+    bindStateBlocks();
+
+    // Apply parameter bindings for the entire hierarchy, top-down.
+    RenderState* rs = NULL;
+    Effect* effect = pass->getEffect();
+    while ((rs = getTopmost(rs)))
+    {
+        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
+        {
+            GP_ASSERT(rs->_parameters[i]);
+            rs->_parameters[i]->bind(effect);
+        }
+    }
+}
+
+void RenderState::bindStateBlocks()
+{
     // Get the combined modified state bits for our RenderState hierarchy.
     long stateOverrideBits = _state ? _state->_bits : 0;
     RenderState* rs = _parent;
@@ -420,17 +437,10 @@ void RenderState::bind(Pass* pass)
     // Restore renderer state to its default, except for explicitly specified states
     StateBlock::restore(stateOverrideBits);
 
-    // Apply parameter bindings and renderer state for the entire hierarchy, top-down.
+    // Apply renderer state for the entire hierarchy, top-down.
     rs = NULL;
-    Effect* effect = pass->getEffect();
     while ((rs = getTopmost(rs)))
     {
-        for (size_t i = 0, count = rs->_parameters.size(); i < count; ++i)
-        {
-            GP_ASSERT(rs->_parameters[i]);
-            rs->_parameters[i]->bind(effect);
-        }
-
         if (rs->_state)
         {
             rs->_state->bindNoRestore();
@@ -438,6 +448,16 @@ void RenderState::bind(Pass* pass)
     }
 }
 
+bool RenderState::isBlendEnabled() const
+{
+    for (const RenderState* rs = this; rs != NULL; rs = rs->_parent)
+    {
+        if (rs->_state && (rs->_state->_bits & RS_BLEND))
+            return rs->_state->_blendEnabled;
+    }
+    return false;
+}
+
 RenderState* RenderState::getTopmost(RenderState* below)
 {
     RenderState* rs = this;
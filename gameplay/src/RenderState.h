@@ -23,6 +23,7 @@ class RenderState : public Ref
     friend class Technique;
     friend class Pass;
     friend class Model;
+    friend class RenderQueue;
 
 public:
 
@@ -612,6 +613,17 @@ protected:
      */
     RenderState* getTopmost(RenderState* below);
 
+    /**
+     * Restores the renderer state to its default and applies the state blocks of
+     * this RenderState and any of its parents, top-down.
+     */
+    void bindStateBlocks();
+
+    /**
+     * Returns whether blending is enabled by this RenderState or its nearest parent that sets it.
+     */
+    bool isBlendEnabled() const;
+
     /**
      * Copies the data from this RenderState into the given RenderState.
      * 
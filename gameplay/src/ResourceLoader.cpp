@@ -0,0 +1,442 @@
+#include "Base.h"
+#include "ResourceLoader.h"
+#include "Game.h"
+#include "FileSystem.h"
+#include "Image.h"
+#include "Texture.h"
+#include "Effect.h"
+#include "Material.h"
+#include "Properties.h"
+#include "Scene.h"
+
+// The default time spent each frame completing loads on the game thread, in milliseconds.
+#define RESOURCE_LOADER_FRAME_BUDGET 4.0f
+
+// The default number of threads preparing loads (file I/O and decoding).
+#define RESOURCE_LOADER_THREADS 1
+
+// The size of the blocks read when reading bundles ahead of their use.
+#define RESOURCE_LOADER_READ_AHEAD_SIZE 65536
+
+namespace gameplay
+{
+
+// Reads a file through to warm the file system cache for the game thread, which reads it later.
+static void readAhead(const char* path)
+{
+    std::unique_ptr<Stream> stream(FileSystem::open(path));
+    if (stream.get() == NULL || stream->getData())
+        return;
+    std::vector<char> buffer(RESOURCE_LOADER_READ_AHEAD_SIZE);
+    while (stream->read(&buffer[0], 1, buffer.size()) == buffer.size())
+    {
+    }
+}
+
+// Gets the file part of a url referencing a namespace within the file.
+static std::string getFilePath(const char* url)
+{
+    const char* hash = strchr(url, '#');
+    return hash ? std::string(url, hash - url) : std::string(url);
+}
+
+ResourceLoader::ResourceLoader()
+    : _frameBudget(RESOURCE_LOADER_FRAME_BUDGET), _workerPool(NULL)
+{
+}
+
+ResourceLoader::~ResourceLoader()
+{
+}
+
+void ResourceLoader::initialize()
+{
+    unsigned int threadCount = RESOURCE_LOADER_THREADS;
+    Properties* config = Game::getInstance()->getConfig()->getNamespace("loader", true);
+    if (config && config->exists("frameBudget"))
+        _frameBudget = std::max(config->getFloat("frameBudget"), 0.0f);
+    if (config && config->exists("threads"))
+        threadCount = (unsigned int)std::max(config->getInt("threads"), 0);
+
+    _workerPool = new WorkerPool();
+    _workerPool->initialize(threadCount);
+}
+
+void ResourceLoader::finalize()
+{
+    // Wait for the loads being prepared, then drop every pending load.
+    if (_workerPool)
+    {
+        _workerPool->finalize();
+        SAFE_DELETE(_workerPool);
+    }
+    _prepared.clear();
+    _finalizing.clear();
+    for (std::list<Request*>::iterator itr = _requests.begin(); itr != _requests.end(); ++itr)
+    {
+        Request* request = *itr;
+        request->_state = Request::CANCELLED;
+        SAFE_RELEASE(request);
+    }
+    _requests.clear();
+}
+
+ResourceLoader::Request* ResourceLoader::loadTexture(const char* path, bool generateMipmaps, Listener* listener)
+{
+    GP_ASSERT(path);
+
+    Request* request = new Request(Request::TEXTURE, path);
+    request->_generateMipmaps = generateMipmaps;
+    return start(request, listener);
+}
+
+ResourceLoader::Request* ResourceLoader::loadEffect(const char* vshPath, const char* fshPath, const char* defines, Listener* listener)
+{
+    GP_ASSERT(vshPath);
+    GP_ASSERT(fshPath);
+
+    Request* request = new Request(Request::EFFECT, vshPath);
+    request->_fshPath = fshPath;
+    request->_defines = defines ? defines : "";
+    return start(request, listener);
+}
+
+ResourceLoader::Request* ResourceLoader::loadProperties(const char* url, Listener* listener)
+{
+    GP_ASSERT(url);
+
+    return start(new Request(Request::PROPERTIES, url), listener);
+}
+
+ResourceLoader::Request* ResourceLoader::loadScene(const char* url, Listener* listener)
+{
+    GP_ASSERT(url);
+
+    return start(new Request(Request::SCENE, url), listener);
+}
+
+void ResourceLoader::setFrameBudget(float milliseconds)
+{
+    _frameBudget = std::max(milliseconds, 0.0f);
+}
+
+float ResourceLoader::getFrameBudget() const
+{
+    return _frameBudget;
+}
+
+unsigned int ResourceLoader::getPendingCount() const
+{
+    return (unsigned int)_requests.size();
+}
+
+ResourceLoader::Request* ResourceLoader::start(Request* request, Listener* listener)
+{
+    GP_ASSERT(request);
+    GP_ASSERT(_workerPool);
+
+    request->_listener = listener;
+
+    // The loader holds a reference until the load completes; the other belongs to the caller.
+    request->addRef();
+    _requests.push_back(request);
+
+    _workerPool->submit(std::bind(&ResourceLoader::prepare, this, request));
+    return request;
+}
+
+void ResourceLoader::prepare(Request* request)
+{
+    GP_ASSERT(request);
+
+    if (!request->_cancelled.load())
+    {
+        switch (request->_type)
+        {
+        case Request::TEXTURE:
+            if (FileSystem::getExtension(request->_path.c_str()) == ".PNG")
+            {
+                Request::PendingTexture texture;
+                texture.path = request->_path;
+                texture.image = Image::create(request->_path.c_str());
+                texture.generateMipmaps = request->_generateMipmaps;
+                if (texture.image)
+                    request->_pendingTextures.push_back(texture);
+            }
+            break;
+
+        case Request::EFFECT:
+            {
+                char* vshSource = FileSystem::readAll(request->_path.c_str());
+                char* fshSource = FileSystem::readAll(request->_fshPath.c_str());
+                if (vshSource && fshSource)
+                {
+                    request->_vshSource = vshSource;
+                    request->_fshSource = fshSource;
+                }
+                SAFE_DELETE_ARRAY(vshSource);
+                SAFE_DELETE_ARRAY(fshSource);
+            }
+            break;
+
+        case Request::PROPERTIES:
+            request->_properties = Properties::create(request->_path.c_str());
+            break;
+
+        case Request::SCENE:
+            if (FileSystem::getExtension(request->_path.c_str()) == ".GPB")
+            {
+                readAhead(request->_path.c_str());
+            }
+            else
+            {
+                std::set<std::string> visited;
+                visited.insert(getFilePath(request->_path.c_str()));
+                Properties* properties = Properties::create(request->_path.c_str());
+                if (properties)
+                    prepareReferences(request, properties, visited);
+                SAFE_DELETE(properties);
+            }
+            break;
+        }
+    }
+    request->_prepared = true;
+
+    _preparedMutex.lock();
+    _prepared.push_back(request);
+    _preparedMutex.unlock();
+}
+
+void ResourceLoader::prepareReferences(Request* request, Properties* properties, std::set<std::string>& visited)
+{
+    GP_ASSERT(request);
+    GP_ASSERT(properties);
+
+    // Look for the files referenced by the property values.
+    properties->rewind();
+    while (properties->getNextProperty())
+    {
+        const char* value = properties->getString();
+        if (!value || !strchr(value, '.'))
+            continue;
+
+        std::string path = getFilePath(value);
+        std::string extension = FileSystem::getExtension(path.c_str());
+        if (extension.empty() || !visited.insert(path).second || !FileSystem::fileExists(path.c_str()))
+            continue;
+
+        if (extension == ".PNG")
+        {
+            Request::PendingTexture texture;
+            texture.path = path;
+            texture.image = Image::create(path.c_str());
+            texture.generateMipmaps = properties->getBool("mipmap");
+            if (texture.image)
+                request->_pendingTextures.push_back(texture);
+        }
+        else if (extension == ".GPB")
+        {
+            readAhead(path.c_str());
+        }
+        else if (extension == ".MATERIAL" || extension == ".PHYSICS" || extension == ".PARTICLE" ||
+                 extension == ".ANIMATION" || extension == ".AUDIO" || extension == ".TERRAIN")
+        {
+            // Parsing the file leaves it in the properties cache for the game thread.
+            Properties* referenced = Properties::create(path.c_str());
+            if (referenced)
+            {
+                prepareReferences(request, referenced, visited);
+                SAFE_DELETE(referenced);
+            }
+            if (extension == ".MATERIAL")
+                request->_pendingMaterials.push_back(path);
+        }
+    }
+
+    for (Properties* space = properties->getNextNamespace(); space; space = properties->getNextNamespace())
+    {
+        prepareReferences(request, space, visited);
+    }
+}
+
+void ResourceLoader::update()
+{
+    if (_requests.empty())
+        return;
+
+    _preparedMutex.lock();
+    _finalizing.insert(_finalizing.end(), _prepared.begin(), _prepared.end());
+    _prepared.clear();
+    _preparedMutex.unlock();
+
+    // Complete loads one step at a time until the budget is spent.
+    double start = Game::getAbsoluteTime();
+    while (!_finalizing.empty())
+    {
+        Request* request = _finalizing.front();
+        if (request->_cancelled.load() || finalizeStep(request))
+        {
+            _finalizing.pop_front();
+            complete(request);
+        }
+        if (Game::getAbsoluteTime() - start >= _frameBudget)
+            break;
+    }
+}
+
+bool ResourceLoader::finalizeStep(Request* request)
+{
+    GP_ASSERT(request);
+
+    // Create the textures of the images decoded by the loader threads first.
+    if (!request->_pendingTextures.empty())
+    {
+        Request::PendingTexture& pending = request->_pendingTextures.back();
+        Texture* texture = Texture::createCached(pending.path.c_str(), pending.image, pending.generateMipmaps);
+        SAFE_RELEASE(pending.image);
+        request->_pendingTextures.pop_back();
+        if (texture)
+            request->_textures.push_back(texture);
+        return false;
+    }
+
+    // Then compile the effects of the materials, one material at a time.
+    if (!request->_pendingMaterials.empty())
+    {
+        Material::precompile(request->_pendingMaterials.back().c_str());
+        request->_pendingMaterials.pop_back();
+        return false;
+    }
+
+    switch (request->_type)
+    {
+    case Request::TEXTURE:
+        if (!request->_textures.empty())
+        {
+            request->_texture = request->_textures.back();
+            request->_textures.pop_back();
+        }
+        else
+        {
+            // Files that are not decoded in the background are loaded here.
+            request->_texture = Texture::create(request->_path.c_str(), request->_generateMipmaps);
+        }
+        request->_state = request->_texture ? Request::LOADED : Request::FAILED;
+        break;
+
+    case Request::EFFECT:
+        if (!request->_vshSource.empty())
+        {
+            request->_effect = Effect::createCached(request->_path.c_str(), request->_vshSource.c_str(), request->_fshPath.c_str(), request->_fshSource.c_str(),
+                                                    request->_defines.empty() ? NULL : request->_defines.c_str());
+        }
+        request->_state = request->_effect ? Request::LOADED : Request::FAILED;
+        break;
+
+    case Request::PROPERTIES:
+        request->_state = request->_properties ? Request::LOADED : Request::FAILED;
+        break;
+
+    case Request::SCENE:
+        // The scene finds its textures, effects and properties files in the caches.
+        request->_scene = Scene::load(request->_path.c_str());
+        request->_state = request->_scene ? Request::LOADED : Request::FAILED;
+        break;
+    }
+    return true;
+}
+
+void ResourceLoader::complete(Request* request)
+{
+    GP_ASSERT(request);
+
+    // The textures held while the load completes stay cached only if the loaded resource uses them.
+    for (size_t i = 0, count = request->_textures.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(request->_textures[i]);
+    }
+    request->_textures.clear();
+    request->_vshSource.clear();
+    request->_fshSource.clear();
+
+    _requests.remove(request);
+    if (request->_cancelled.load())
+    {
+        request->_state = Request::CANCELLED;
+    }
+    else if (request->_listener)
+    {
+        request->_listener->resourceLoaded(request);
+    }
+    SAFE_RELEASE(request);
+}
+
+ResourceLoader::Request::Request(Type type, const char* path)
+    : _type(type), _path(path), _state(PENDING), _cancelled(false), _listener(NULL),
+      _generateMipmaps(false), _prepared(false), _texture(NULL), _effect(NULL), _properties(NULL), _scene(NULL)
+{
+}
+
+ResourceLoader::Request::~Request()
+{
+    for (size_t i = 0, count = _pendingTextures.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_pendingTextures[i].image);
+    }
+    for (size_t i = 0, count = _textures.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_textures[i]);
+    }
+    SAFE_RELEASE(_texture);
+    SAFE_RELEASE(_effect);
+    SAFE_DELETE(_properties);
+    SAFE_RELEASE(_scene);
+}
+
+ResourceLoader::Request::Type ResourceLoader::Request::getType() const
+{
+    return _type;
+}
+
+const char* ResourceLoader::Request::getPath() const
+{
+    return _path.c_str();
+}
+
+ResourceLoader::Request::State ResourceLoader::Request::getState() const
+{
+    return _state;
+}
+
+bool ResourceLoader::Request::isDone() const
+{
+    return _state != PENDING;
+}
+
+Texture* ResourceLoader::Request::getTexture() const
+{
+    return _texture;
+}
+
+Effect* ResourceLoader::Request::getEffect() const
+{
+    return _effect;
+}
+
+Properties* ResourceLoader::Request::getProperties() const
+{
+    return _state == LOADED ? _properties : NULL;
+}
+
+Scene* ResourceLoader::Request::getScene() const
+{
+    return _scene;
+}
+
+void ResourceLoader::Request::cancel()
+{
+    if (_state == PENDING)
+        _cancelled = true;
+}
+
+}
@@ -0,0 +1,359 @@
+#ifndef RESOURCELOADER_H_
+#define RESOURCELOADER_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+class Texture;
+class Effect;
+class Image;
+class Properties;
+class Scene;
+class WorkerPool;
+
+/**
+ * Defines a class for loading resources in the background.
+ *
+ * Loading is split in two stages. The file I/O and decoding (reading and parsing
+ * properties files, decoding PNG images, reading shader sources) runs on the loader's
+ * own worker threads, so long reads never hold up the game's worker pool. The steps
+ * that need the graphics context (creating textures, compiling effects, creating the
+ * scene) then run on the game thread at the start of each frame, for no more than the
+ * frame budget, so loading a level does not stall the game.
+ *
+ * Each load returns a request through which the state and result of the load are
+ * retrieved, and which notifies a listener when the load is done. Loaded textures and
+ * effects are added to the same caches used by Texture::create and
+ * Effect::createFromFile, so resources loaded ahead of their use are shared by
+ * everything that loads them later.
+ *
+ * Loading a scene loads (ahead of the scene itself) the properties files it references,
+ * the textures and effects of its materials and the bundles it references.
+ *
+ * The loader is not exposed to Lua scripts yet.
+ *
+ * @script{ignore}
+ */
+class ResourceLoader
+{
+    friend class Game;
+
+public:
+
+    class Listener;
+
+    /**
+     * Defines a request to load a resource, through which the loaded resource is retrieved.
+     */
+    class Request : public Ref
+    {
+        friend class ResourceLoader;
+
+    public:
+
+        /**
+         * Defines the types of resources that are loaded.
+         */
+        enum Type
+        {
+            TEXTURE,
+            EFFECT,
+            PROPERTIES,
+            SCENE
+        };
+
+        /**
+         * Defines the states of a request.
+         */
+        enum State
+        {
+            PENDING,
+            LOADED,
+            FAILED,
+            CANCELLED
+        };
+
+        /**
+         * Gets the type of resource loaded by this request.
+         *
+         * @return The type of resource.
+         */
+        Type getType() const;
+
+        /**
+         * Gets the path or url of the resource loaded by this request.
+         *
+         * @return The path of the resource.
+         */
+        const char* getPath() const;
+
+        /**
+         * Gets the state of this request.
+         *
+         * @return The state of the request.
+         */
+        State getState() const;
+
+        /**
+         * Gets whether the load has completed (or failed or been cancelled).
+         *
+         * @return true if the load is done, false if it is pending.
+         */
+        bool isDone() const;
+
+        /**
+         * Gets the loaded texture.
+         *
+         * The texture is owned by the request; add a reference to keep it after the request is released.
+         *
+         * @return The texture, or NULL if the request did not load a texture or has not completed.
+         */
+        Texture* getTexture() const;
+
+        /**
+         * Gets the loaded effect.
+         *
+         * The effect is owned by the request; add a reference to keep it after the request is released.
+         *
+         * @return The effect, or NULL if the request did not load an effect or has not completed.
+         */
+        Effect* getEffect() const;
+
+        /**
+         * Gets the loaded properties.
+         *
+         * The properties are owned by the request and deleted with it.
+         *
+         * @return The properties, or NULL if the request did not load properties or has not completed.
+         */
+        Properties* getProperties() const;
+
+        /**
+         * Gets the loaded scene.
+         *
+         * The scene is owned by the request; add a reference to keep it after the request is released.
+         *
+         * @return The scene, or NULL if the request did not load a scene or has not completed.
+         */
+        Scene* getScene() const;
+
+        /**
+         * Cancels the load. The listener of a cancelled request is not notified.
+         */
+        void cancel();
+
+    private:
+
+        /**
+         * Constructor.
+         */
+        Request(Type type, const char* path);
+
+        /**
+         * Destructor.
+         */
+        ~Request();
+
+        /**
+         * Hidden copy constructor.
+         */
+        Request(const Request&);
+
+        /**
+         * Hidden copy assignment operator.
+         */
+        Request& operator=(const Request&);
+
+        /**
+         * An image decoded ahead of the texture created from it.
+         */
+        struct PendingTexture
+        {
+            std::string path;
+            Image* image;
+            bool generateMipmaps;
+        };
+
+        Type _type;
+        std::string _path;
+        State _state;
+        std::atomic<bool> _cancelled;
+        Listener* _listener;
+        std::string _fshPath;
+        std::string _defines;
+        std::string _vshSource;
+        std::string _fshSource;
+        std::vector<PendingTexture> _pendingTextures;
+        std::vector<std::string> _pendingMaterials;
+        std::vector<Texture*> _textures;
+        bool _generateMipmaps;
+        bool _prepared;
+        Texture* _texture;
+        Effect* _effect;
+        Properties* _properties;
+        Scene* _scene;
+    };
+
+    /**
+     * Defines an interface for being notified when a load completes.
+     */
+    class Listener
+    {
+    public:
+
+        /**
+         * Destructor.
+         */
+        virtual ~Listener() { }
+
+        /**
+         * Called on the game thread when a load completes or fails.
+         *
+         * @param request The request of the load.
+         */
+        virtual void resourceLoaded(Request* request) = 0;
+    };
+
+    /**
+     * Loads a texture from a file in the background.
+     *
+     * @param path The path of the texture file (only PNG files are decoded in the background).
+     * @param generateMipmaps Whether to generate a full mipmap chain for the texture.
+     * @param listener The listener to notify when the texture is loaded (may be NULL).
+     *
+     * @return The request of the load, which the caller must release.
+     */
+    Request* loadTexture(const char* path, bool generateMipmaps = false, Listener* listener = NULL);
+
+    /**
+     * Loads an effect from shader files in the background.
+     *
+     * @param vshPath The path to the vertex shader file.
+     * @param fshPath The path to the fragment shader file.
+     * @param defines A new-line delimited list of preprocessor defines. May be NULL.
+     * @param listener The listener to notify when the effect is loaded (may be NULL).
+     *
+     * @return The request of the load, which the caller must release.
+     */
+    Request* loadEffect(const char* vshPath, const char* fshPath, const char* defines = NULL, Listener* listener = NULL);
+
+    /**
+     * Loads properties from a url in the background.
+     *
+     * @param url The url of the properties (see Properties::create).
+     * @param listener The listener to notify when the properties are loaded (may be NULL).
+     *
+     * @return The request of the load, which the caller must release.
+     */
+    Request* loadProperties(const char* url, Listener* listener = NULL);
+
+    /**
+     * Loads a scene from a .scene or .gpb file in the background.
+     *
+     * @param url The url of the scene (see Scene::load).
+     * @param listener The listener to notify when the scene is loaded (may be NULL).
+     *
+     * @return The request of the load, which the caller must release.
+     */
+    Request* loadScene(const char* url, Listener* listener = NULL);
+
+    /**
+     * Sets the time spent each frame completing loads on the game thread.
+     *
+     * At least one step of a pending load is completed each frame, however small the budget.
+     *
+     * @param milliseconds The frame budget, in milliseconds.
+     */
+    void setFrameBudget(float milliseconds);
+
+    /**
+     * Gets the time spent each frame completing loads on the game thread.
+     *
+     * @return The frame budget, in milliseconds.
+     */
+    float getFrameBudget() const;
+
+    /**
+     * Gets the number of loads that have not completed.
+     *
+     * @return The number of pending loads.
+     */
+    unsigned int getPendingCount() const;
+
+private:
+
+    /**
+     * Constructor.
+     */
+    ResourceLoader();
+
+    /**
+     * Destructor.
+     */
+    ~ResourceLoader();
+
+    /**
+     * Hidden copy constructor.
+     */
+    ResourceLoader(const ResourceLoader&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    ResourceLoader& operator=(const ResourceLoader&);
+
+    /**
+     * Called during startup to read the frame budget and thread count from the game config.
+     */
+    void initialize();
+
+    /**
+     * Called during shutdown to cancel the pending loads and join the loader threads.
+     */
+    void finalize();
+
+    /**
+     * Completes the loads prepared on the loader threads, within the frame budget (called each frame).
+     */
+    void update();
+
+    /**
+     * Starts a load, submitting its preparation to the loader threads.
+     */
+    Request* start(Request* request, Listener* listener);
+
+    /**
+     * Prepares a load on a loader thread (file I/O and decoding).
+     */
+    void prepare(Request* request);
+
+    /**
+     * Prepares the resources referenced by a properties file, recursing into the properties files it references.
+     */
+    static void prepareReferences(Request* request, Properties* properties, std::set<std::string>& visited);
+
+    /**
+     * Runs the next step of a load on the game thread.
+     *
+     * @return true if the load is complete, false if it has steps left.
+     */
+    bool finalizeStep(Request* request);
+
+    /**
+     * Notifies the listener of a completed load and releases it.
+     */
+    void complete(Request* request);
+
+    float _frameBudget;
+    std::list<Request*> _requests;
+    std::deque<Request*> _prepared;
+    std::mutex _preparedMutex;
+    std::deque<Request*> _finalizing;
+    WorkerPool* _workerPool;
+};
+
+}
+
+#endif
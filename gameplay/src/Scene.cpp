@@ -6,6 +6,16 @@
 #include "Joint.h"
 #include "Terrain.h"
 #include "Bundle.h"
+#include "MeshPart.h"
+#include "BoundingVolumeTree.h"
+
+// Linear transform array flags
+#define TRANSFORM_DIRTY 1
+#define TRANSFORM_CHANGED 2
+#define TRANSFORM_NOTIFY 4
+
+// Maximum number of indices in a static batch (so that its vertices can be addressed with 16 bit indices)
+#define STATIC_BATCH_INDEX_MAX 65535
 
 namespace gameplay
 {
@@ -61,7 +71,9 @@ static bool endsWith(const char* str, const char* suffix, bool ignoreCase)
 
 Scene::Scene()
     : _id(""), _activeCamera(NULL), _firstNode(NULL), _lastNode(NULL), _nodeCount(0), _bindAudioListenerToCamera(true), 
-      _nextItr(NULL), _nextReset(true)
+      _nextItr(NULL), _nextReset(true), _linearTransforms(false), _linearTransformsParallel(false),
+      _transformsDirty(false), _transformHierarchyDirty(false), _transformsResolving(false), _transformNotifyIndex(-1),
+      _staticBatchesChanged(false), _spatialIndex(NULL)
 {
     __sceneList.push_back(this);
 }
@@ -80,6 +92,10 @@ Scene::~Scene()
         SAFE_RELEASE(_activeCamera);
     }
 
+    // Release the static batches (and the nodes they reference) before the nodes are removed
+    clearStaticBatches();
+    setSpatialIndexEnabled(false);
+
     // Remove all nodes from the scene
     removeAllNodes();
 
@@ -273,6 +289,16 @@ void Scene::addNode(Node* node)
 
     ++_nodeCount;
 
+    if (_spatialIndex)
+    {
+        addSpatialIndexNodes(node);
+    }
+
+    if (_linearTransforms)
+    {
+        setTransformHierarchyDirty();
+    }
+
     // If we don't have an active camera set, then check for one and set it.
     if (_activeCamera == NULL)
     {
@@ -291,6 +317,10 @@ void Scene::removeNode(Node* node)
     if (node->_scene != this)
         return;
 
+    // The nodes drawing the static batches are owned by the batches, not the node list.
+    if (isStaticBatchDrawNode(node))
+        return;
+
     if (node == _firstNode)
     {
         _firstNode = node->_nextSibling;
@@ -393,6 +423,881 @@ void Scene::update(float elapsedTime)
         if (node->isEnabled())
             node->update(elapsedTime);
     }
+    updateTransforms();
+}
+
+void Scene::setLinearTransformsEnabled(bool enabled, bool parallel)
+{
+    _linearTransformsParallel = parallel;
+    if (_linearTransforms == enabled)
+        return;
+
+    if (enabled)
+    {
+        _linearTransforms = true;
+        _transformThread = std::this_thread::get_id();
+        setTransformHierarchyDirty();
+    }
+    else
+    {
+        // Resolve any pending changes so nodes start from valid world matrices.
+        updateTransforms();
+        clearTransforms();
+        _linearTransforms = false;
+    }
+}
+
+bool Scene::isLinearTransformsEnabled() const
+{
+    return _linearTransforms;
+}
+
+void Scene::updateTransforms()
+{
+    if (!_linearTransforms)
+        return;
+
+    if (_transformHierarchyDirty)
+        buildTransforms();
+
+    if (!_transformsDirty)
+        return;
+    _transformsDirty = false;
+
+    // Node::getWorldMatrix() may be called while the world matrices are being resolved,
+    // in which case it must not start a nested pass over the same arrays.
+    _transformsResolving = true;
+
+    // Each root subtree occupies a contiguous, depth sorted range of the arrays, so
+    // parents are always resolved before their children and ranges are independent.
+    unsigned int rangeCount = (unsigned int)_transformRanges.size() - 1;
+    WorkerPool* workerPool = Game::getInstance()->getWorkerPool();
+    if (_linearTransformsParallel && workerPool && rangeCount > 1)
+    {
+        workerPool->parallelFor(rangeCount, 1, [this](unsigned int begin, unsigned int end)
+        {
+            resolveTransforms(_transformRanges[begin], _transformRanges[end]);
+        });
+    }
+    else
+    {
+        resolveTransforms(0, (unsigned int)_transformNodes.size());
+    }
+    _transformsResolving = false;
+
+    // Notify the listeners of nodes whose world matrix changed through their parent.
+    // This happens serially since listeners may modify other transforms. A listener
+    // that triggers a nested pass dispatches the pending notifications itself, so the
+    // index of the notification in progress here is restored once it returns.
+    int notifyIndex = _transformNotifyIndex;
+    for (size_t i = 0; i < _transformNodes.size(); ++i)
+    {
+        unsigned char flags = _transformFlags[i];
+        _transformFlags[i] &= ~(TRANSFORM_CHANGED | TRANSFORM_NOTIFY);
+        if (flags & TRANSFORM_NOTIFY)
+        {
+            _transformNotifyIndex = (int)i;
+            _transformNodes[i]->transformChanged();
+        }
+    }
+    _transformNotifyIndex = notifyIndex;
+}
+
+void Scene::updateTransformsOnDemand()
+{
+    if (!_transformsDirty && !_transformHierarchyDirty)
+        return;
+
+    // Only the thread that owns the scene resolves transforms on demand, and never while
+    // a pass is resolving. Other threads (such as WorkerPool jobs) see the world matrices
+    // of the last pass, so updateTransforms() must be called before handing work to them.
+    if (_transformsResolving || std::this_thread::get_id() != _transformThread)
+        return;
+
+    updateTransforms();
+}
+
+void Scene::buildTransforms()
+{
+    _transformNodes.clear();
+    _transformParents.clear();
+    _transformRanges.clear();
+
+    // Gather each root subtree in breadth first order so it is sorted by depth.
+    for (Node* root = _firstNode; root != NULL; root = root->_nextSibling)
+    {
+        unsigned int begin = (unsigned int)_transformNodes.size();
+        _transformRanges.push_back(begin);
+        _transformNodes.push_back(root);
+        _transformParents.push_back(-1);
+        for (unsigned int i = begin; i < _transformNodes.size(); ++i)
+        {
+            for (Node* child = _transformNodes[i]->_firstChild; child != NULL; child = child->_nextSibling)
+            {
+                _transformNodes.push_back(child);
+                _transformParents.push_back((int)i);
+            }
+        }
+    }
+    _transformRanges.push_back((unsigned int)_transformNodes.size());
+
+    size_t count = _transformNodes.size();
+    _localMatrices.resize(count);
+    _worldMatrices.resize(count);
+    _transformFlags.assign(count, TRANSFORM_DIRTY);
+    for (size_t i = 0; i < count; ++i)
+    {
+        _transformNodes[i]->_linearScene = this;
+        _transformNodes[i]->_linearIndex = (unsigned int)i;
+    }
+
+    _transformHierarchyDirty = false;
+    _transformsDirty = true;
+}
+
+void Scene::clearTransforms()
+{
+    // Walk the live hierarchy rather than the arrays since they may reference removed nodes.
+    for (Node* root = _firstNode; root != NULL; root = root->_nextSibling)
+    {
+        root->detachLinearTransforms();
+    }
+    _transformNodes.clear();
+    _transformParents.clear();
+    _localMatrices.clear();
+    _worldMatrices.clear();
+    _transformFlags.clear();
+    _transformRanges.clear();
+    _transformsDirty = false;
+    _transformHierarchyDirty = false;
+}
+
+void Scene::resolveTransforms(unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; ++i)
+    {
+        int parent = _transformParents[i];
+        bool parentChanged = parent >= 0 && (_transformFlags[parent] & TRANSFORM_CHANGED);
+        unsigned char flags = _transformFlags[i];
+        if (!(flags & TRANSFORM_DIRTY) && !parentChanged)
+            continue;
+
+        _transformNodes[i]->resolveWorldMatrix(parent >= 0 ? &_worldMatrices[parent] : NULL, &_localMatrices[i], &_worldMatrices[i]);
+
+        // Nodes that were not changed directly only learn about the change from this pass.
+        _transformFlags[i] = TRANSFORM_CHANGED | ((flags & TRANSFORM_DIRTY) ? 0 : TRANSFORM_NOTIFY);
+    }
+}
+
+void Scene::setTransformDirty(unsigned int index)
+{
+    // Ignore the notification we are currently dispatching from updateTransforms().
+    if ((int)index == _transformNotifyIndex)
+        return;
+
+    if (!_transformHierarchyDirty)
+    {
+        GP_ASSERT(index < _transformFlags.size());
+        _transformFlags[index] |= TRANSFORM_DIRTY;
+    }
+    _transformsDirty = true;
+}
+
+void Scene::setTransformHierarchyDirty()
+{
+    _transformHierarchyDirty = true;
+    _transformsDirty = true;
+}
+
+struct Scene::StaticBatchSource
+{
+    StaticBatchSource(const Bundle::MeshData* data, unsigned int vertexSize);
+
+    struct Part
+    {
+        /** The vertices referenced by the part, in the order they are first indexed. */
+        std::vector<unsigned char> vertices;
+        /** The indices of the part into its own vertices. */
+        std::vector<unsigned short> indices;
+    };
+
+    std::vector<Part> parts;
+    BoundingSphere boundingSphere;
+    BoundingBox boundingBox;
+};
+
+Scene::StaticBatchSource::StaticBatchSource(const Bundle::MeshData* data, unsigned int vertexSize)
+    : parts(data->parts.size()), boundingSphere(data->boundingSphere), boundingBox(data->boundingBox)
+{
+    // Gather the vertices referenced by each part, compacting and converting the indices, so
+    // only the batched geometry is kept and not the whole mesh (or its mapped bundle).
+    std::vector<int> remap;
+    for (size_t i = 0, partCount = parts.size(); i < partCount; ++i)
+    {
+        const Bundle::MeshPartData* partData = data->parts[i];
+        Part& part = parts[i];
+        if (partData->primitiveType != Mesh::TRIANGLES || partData->indexCount > STATIC_BATCH_INDEX_MAX)
+            continue;
+
+        remap.assign(data->vertexCount, -1);
+        part.indices.resize(partData->indexCount);
+        unsigned int vertexCount = 0;
+        for (unsigned int k = 0; k < partData->indexCount; ++k)
+        {
+            // The index data may point (unaligned) into a memory mapped bundle, so copy each index out.
+            unsigned int index;
+            switch (partData->indexFormat)
+            {
+            case Mesh::INDEX8:
+                index = partData->indexData[k];
+                break;
+            case Mesh::INDEX16:
+            {
+                unsigned short index16;
+                memcpy(&index16, partData->indexData + k * sizeof(unsigned short), sizeof(unsigned short));
+                index = index16;
+                break;
+            }
+            default:
+                memcpy(&index, partData->indexData + k * sizeof(unsigned int), sizeof(unsigned int));
+                break;
+            }
+            GP_ASSERT(index < data->vertexCount);
+            if (remap[index] < 0)
+                remap[index] = (int)vertexCount++;
+            part.indices[k] = (unsigned short)remap[index];
+        }
+
+        part.vertices.resize(vertexCount * vertexSize);
+        for (unsigned int k = 0; k < data->vertexCount; ++k)
+        {
+            if (remap[k] >= 0)
+                memcpy(&part.vertices[remap[k] * vertexSize], data->vertexData + k * vertexSize, vertexSize);
+        }
+    }
+}
+
+Scene::StaticBatch::StaticBatch(Material* material, const VertexFormat& vertexFormat)
+    : node(NULL), material(material), vertexFormat(vertexFormat), indexCount(0), dirty(false)
+{
+    GP_ASSERT(material);
+    material->addRef();
+}
+
+Scene::StaticBatch::~StaticBatch()
+{
+    if (node)
+        node->_scene = NULL;
+    SAFE_RELEASE(node);
+    SAFE_RELEASE(material);
+}
+
+void Scene::buildStaticBatches()
+{
+    clearStaticBatches();
+
+    std::vector<Node*> nodes;
+    for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+    {
+        collectStaticBatchNodes(node, nodes);
+    }
+
+    // Group the mesh parts by material and vertex format, splitting each group into
+    // batches that can be addressed with 16 bit indices.
+    for (size_t i = 0, count = nodes.size(); i < count; ++i)
+    {
+        Node* node = nodes[i];
+        Model* model = static_cast<Model*>(node->getDrawable());
+        Mesh* mesh = model->getMesh();
+
+        // Meshes keep no client side copy of their geometry, so read it from the bundle
+        // once and keep the batched parts for rebuilding the batches when their nodes change.
+        StaticBatchSource*& source = _staticBatchSources[mesh->getUrl()];
+        if (source == NULL)
+        {
+            Bundle::MeshData* data = Bundle::readMeshData(mesh->getUrl());
+            if (data == NULL || data->parts.size() < mesh->getPartCount() ||
+                data->vertexFormat.getVertexSize() != mesh->getVertexFormat().getVertexSize())
+            {
+                GP_WARN("Failed to read mesh data '%s' for static batching.", mesh->getUrl());
+                SAFE_DELETE(data);
+                _staticBatchSources.erase(mesh->getUrl());
+                continue;
+            }
+            source = new StaticBatchSource(data, mesh->getVertexFormat().getVertexSize());
+            SAFE_DELETE(data);
+        }
+
+        std::vector<StaticBatch*>& nodeBatches = _staticBatchIndex[node];
+        for (unsigned int j = 0, partCount = mesh->getPartCount(); j < partCount; ++j)
+        {
+            Material* material = model->getMaterial(j);
+            unsigned int indexCount = mesh->getPart(j)->getIndexCount();
+
+            StaticBatch* batch = NULL;
+            for (size_t k = 0, batchCount = _staticBatches.size(); k < batchCount; ++k)
+            {
+                StaticBatch* b = _staticBatches[k];
+                if (b->material == material && b->vertexFormat == mesh->getVertexFormat() &&
+                    b->indexCount + indexCount <= STATIC_BATCH_INDEX_MAX)
+                {
+                    batch = b;
+                    break;
+                }
+            }
+            if (batch == NULL)
+            {
+                batch = new StaticBatch(material, mesh->getVertexFormat());
+                _staticBatches.push_back(batch);
+            }
+            batch->nodes.push_back(node);
+            batch->parts.push_back(j);
+            batch->indexCount += indexCount;
+            if (std::find(nodeBatches.begin(), nodeBatches.end(), batch) == nodeBatches.end())
+                nodeBatches.push_back(batch);
+            node->addRef();
+        }
+        model->_staticBatched = true;
+        node->_staticBatchScene = this;
+    }
+
+    if (_staticBatches.empty())
+        return;
+
+    // The batches are drawn by models attached to identity nodes that report this scene
+    // (for the material bindings of its camera and lights) but are not in its node list.
+    for (size_t i = 0, count = _staticBatches.size(); i < count; ++i)
+    {
+        StaticBatch* batch = _staticBatches[i];
+        batch->node = Node::create("_staticBatch");
+        batch->node->_scene = this;
+        setStaticBatchDirty(batch);
+    }
+
+    _staticBatchesChanged = false;
+    updateStaticBatches();
+}
+
+void Scene::clearStaticBatches()
+{
+    for (size_t i = 0, count = _staticBatches.size(); i < count; ++i)
+    {
+        StaticBatch* batch = _staticBatches[i];
+        for (size_t j = 0, nodeCount = batch->nodes.size(); j < nodeCount; ++j)
+        {
+            Node* node = batch->nodes[j];
+            if (node->_staticBatchScene == this)
+            {
+                Model* model = dynamic_cast<Model*>(node->getDrawable());
+                if (model)
+                    model->_staticBatched = false;
+                node->_staticBatchScene = NULL;
+            }
+            SAFE_RELEASE(node);
+        }
+        SAFE_DELETE(batch);
+    }
+    _staticBatches.clear();
+    _staticBatchIndex.clear();
+    _dirtyStaticBatches.clear();
+    _staticBatchesChanged = false;
+
+    for (std::map<std::string, StaticBatchSource*>::iterator itr = _staticBatchSources.begin(); itr != _staticBatchSources.end(); ++itr)
+    {
+        SAFE_DELETE(itr->second);
+    }
+    _staticBatchSources.clear();
+}
+
+unsigned int Scene::getStaticBatchCount() const
+{
+    return (unsigned int)_staticBatches.size();
+}
+
+void Scene::setSpatialIndexEnabled(bool enabled)
+{
+    if (enabled == (_spatialIndex != NULL))
+        return;
+
+    if (enabled)
+    {
+        _spatialIndex = new BoundingVolumeTree();
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            addSpatialIndexNodes(node);
+        }
+    }
+    else
+    {
+        // Drop the queue first so that untracking does not search it for every node.
+        for (size_t i = 0, count = _spatialIndexDirtyNodes.size(); i < count; ++i)
+        {
+            _spatialIndexDirtyNodes[i]->_spatialIndexDirty = false;
+        }
+        _spatialIndexDirtyNodes.clear();
+        for (Node* node = _firstNode; node != NULL; node = node->_nextSibling)
+        {
+            removeSpatialIndexNodes(node);
+        }
+        SAFE_DELETE(_spatialIndex);
+    }
+}
+
+bool Scene::isSpatialIndexEnabled() const
+{
+    return _spatialIndex != NULL;
+}
+
+template <class V>
+unsigned int Scene::queryBoundsNodes(const V& volume, std::vector<Node*>& nodes)
+{
+    size_t first = nodes.size();
+    if (_spatialIndex)
+    {
+        updateSpatialIndex();
+        _spatialIndex->query(volume, nodes);
+    }
+    else
+    {
+        collectSpatialIndexNodes(NULL, nodes);
+        BoundingSphere bounds;
+        nodes.erase(std::remove_if(nodes.begin() + first, nodes.end(), [&](Node* node)
+        {
+            node->computeBounds(&bounds);
+            return !bounds.intersects(volume);
+        }), nodes.end());
+    }
+
+    // Disabled nodes stay indexed (so enabling them is free), so they are filtered here.
+    nodes.erase(std::remove_if(nodes.begin() + first, nodes.end(), [](Node* node) { return !node->isEnabledInHierarchy(); }), nodes.end());
+    return (unsigned int)(nodes.size() - first);
+}
+
+unsigned int Scene::queryNodes(const Frustum& frustum, std::vector<Node*>& nodes)
+{
+    // Frustum queries gather what is drawn, so rebuild the batches of changed static nodes first.
+    updateStaticBatches();
+
+    unsigned int count = queryBoundsNodes(frustum, nodes);
+
+    // The static batch nodes are neither in the node list nor indexed, so they are culled here.
+    BoundingSphere bounds;
+    for (size_t i = 0, batchCount = _staticBatches.size(); i < batchCount; ++i)
+    {
+        Node* node = _staticBatches[i]->node;
+        if (node && node->getDrawable())
+        {
+            node->computeBounds(&bounds);
+            if (bounds.intersects(frustum))
+            {
+                nodes.push_back(node);
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+unsigned int Scene::queryNodes(const BoundingSphere& sphere, std::vector<Node*>& nodes)
+{
+    return queryBoundsNodes(sphere, nodes);
+}
+
+unsigned int Scene::queryNodes(const BoundingBox& box, std::vector<Node*>& nodes)
+{
+    return queryBoundsNodes(box, nodes);
+}
+
+unsigned int Scene::queryNodes(const Ray& ray, std::vector<Node*>& nodes, float maxDistance)
+{
+    std::vector<std::pair<float, Node*> > hits;
+    if (_spatialIndex)
+    {
+        updateSpatialIndex();
+        _spatialIndex->query(ray, maxDistance, hits);
+    }
+    else
+    {
+        std::vector<Node*> candidates;
+        collectSpatialIndexNodes(NULL, candidates);
+        BoundingSphere bounds;
+        for (size_t i = 0, count = candidates.size(); i < count; ++i)
+        {
+            candidates[i]->computeBounds(&bounds);
+            float distance = bounds.intersects(ray);
+            if (distance != Ray::INTERSECTS_NONE && distance <= maxDistance)
+                hits.push_back(std::make_pair(distance, candidates[i]));
+        }
+    }
+
+    // Sort by distance only; ties keep no particular order.
+    std::sort(hits.begin(), hits.end(), [](const std::pair<float, Node*>& a, const std::pair<float, Node*>& b) { return a.first < b.first; });
+    unsigned int count = 0;
+    for (size_t i = 0, hitCount = hits.size(); i < hitCount; ++i)
+    {
+        if (hits[i].second->isEnabledInHierarchy())
+        {
+            nodes.push_back(hits[i].second);
+            ++count;
+        }
+    }
+    return count;
+}
+
+void Scene::addSpatialIndexNodes(Node* node)
+{
+    GP_ASSERT(node);
+    GP_ASSERT(_spatialIndex);
+
+    node->_spatialIndexScene = this;
+    node->setSpatialIndexDirty();
+    for (Node* child = node->_firstChild; child != NULL; child = child->_nextSibling)
+    {
+        addSpatialIndexNodes(child);
+    }
+}
+
+void Scene::removeSpatialIndexNodes(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (node->_spatialIndexProxy >= 0)
+    {
+        _spatialIndex->remove(node->_spatialIndexProxy);
+        node->_spatialIndexProxy = -1;
+    }
+    if (node->_spatialIndexDirty)
+    {
+        std::vector<Node*>::iterator itr = std::find(_spatialIndexDirtyNodes.begin(), _spatialIndexDirtyNodes.end(), node);
+        if (itr != _spatialIndexDirtyNodes.end())
+        {
+            *itr = _spatialIndexDirtyNodes.back();
+            _spatialIndexDirtyNodes.pop_back();
+        }
+        node->_spatialIndexDirty = false;
+    }
+    node->_spatialIndexScene = NULL;
+
+    for (Node* child = node->_firstChild; child != NULL; child = child->_nextSibling)
+    {
+        removeSpatialIndexNodes(child);
+    }
+}
+
+void Scene::updateSpatialIndex()
+{
+    GP_ASSERT(_spatialIndex);
+
+    // Resolve pending linear transforms so that world matrices are current.
+    updateTransforms();
+
+    // Resolving a world matrix may queue more nodes, so the size is re-read each iteration.
+    for (size_t i = 0; i < _spatialIndexDirtyNodes.size(); ++i)
+    {
+        Node* node = _spatialIndexDirtyNodes[i];
+        node->_spatialIndexDirty = false;
+
+        if (node->_drawable == NULL && node->_light == NULL)
+        {
+            if (node->_spatialIndexProxy >= 0)
+            {
+                _spatialIndex->remove(node->_spatialIndexProxy);
+                node->_spatialIndexProxy = -1;
+            }
+            continue;
+        }
+
+        BoundingSphere bounds;
+        node->computeBounds(&bounds);
+        if (node->_spatialIndexProxy < 0)
+            node->_spatialIndexProxy = _spatialIndex->insert(node, bounds);
+        else
+            _spatialIndex->update(node->_spatialIndexProxy, bounds);
+    }
+    _spatialIndexDirtyNodes.clear();
+}
+
+void Scene::collectSpatialIndexNodes(Node* node, std::vector<Node*>& nodes)
+{
+    for (Node* n = node ? node->_firstChild : _firstNode; n != NULL; n = n->_nextSibling)
+    {
+        if (n->_drawable || n->_light)
+            nodes.push_back(n);
+        collectSpatialIndexNodes(n, nodes);
+    }
+}
+
+void Scene::collectStaticBatchNodes(Node* node, std::vector<Node*>& nodes)
+{
+    GP_ASSERT(node);
+
+    Model* model = dynamic_cast<Model*>(node->getDrawable());
+    if (model && node->isStatic() && node->isEnabled() && model->getSkin() == NULL)
+    {
+        // Batches are built from the geometry in the mesh's bundle, so only bundled, indexed triangle lists qualify.
+        Mesh* mesh = model->getMesh();
+        bool batchable = mesh && mesh->getUrl() && strlen(mesh->getUrl()) > 0 && mesh->getPartCount() > 0;
+        for (unsigned int i = 0, partCount = batchable ? mesh->getPartCount() : 0; i < partCount; ++i)
+        {
+            MeshPart* part = mesh->getPart(i);
+            if (part->getPrimitiveType() != Mesh::TRIANGLES || part->getIndexCount() > STATIC_BATCH_INDEX_MAX || model->getMaterial(i) == NULL)
+            {
+                batchable = false;
+            }
+        }
+        if (batchable)
+            nodes.push_back(node);
+    }
+
+    for (Node* child = node->_firstChild; child != NULL; child = child->_nextSibling)
+    {
+        collectStaticBatchNodes(child, nodes);
+    }
+}
+
+bool Scene::isStaticBatchDrawNode(Node* node) const
+{
+    GP_ASSERT(node);
+
+    // Batch nodes report this scene without being linked into its node list or hierarchy.
+    return node->_scene == this && node->_parent == NULL && node->_prevSibling == NULL && node != _firstNode;
+}
+
+bool Scene::isStaticBatchNodeValid(Node* node) const
+{
+    GP_ASSERT(node);
+
+    if (node->_staticBatchScene != this || node->getScene() != this || !node->isStatic() || !node->isEnabled())
+        return false;
+    Model* model = dynamic_cast<Model*>(node->getDrawable());
+    return model && model->_staticBatched;
+}
+
+void Scene::removeStaticBatchNode(Node* node)
+{
+    GP_ASSERT(node);
+
+    if (node->_staticBatchScene == this)
+    {
+        Model* model = dynamic_cast<Model*>(node->getDrawable());
+        if (model)
+            model->_staticBatched = false;
+        node->_staticBatchScene = NULL;
+    }
+
+    std::map<Node*, std::vector<StaticBatch*> >::iterator itr = _staticBatchIndex.find(node);
+    if (itr == _staticBatchIndex.end())
+        return;
+
+    std::vector<StaticBatch*>& nodeBatches = itr->second;
+    for (size_t i = 0, count = nodeBatches.size(); i < count; ++i)
+    {
+        StaticBatch* batch = nodeBatches[i];
+        for (size_t j = 0; j < batch->nodes.size();)
+        {
+            if (batch->nodes[j] == node)
+            {
+                batch->nodes.erase(batch->nodes.begin() + j);
+                batch->parts.erase(batch->parts.begin() + j);
+                node->release();
+            }
+            else
+            {
+                ++j;
+            }
+        }
+        setStaticBatchDirty(batch);
+    }
+    _staticBatchIndex.erase(itr);
+}
+
+void Scene::setStaticBatchDirty(Node* node)
+{
+    std::map<Node*, std::vector<StaticBatch*> >::iterator itr = _staticBatchIndex.find(node);
+    if (itr == _staticBatchIndex.end())
+        return;
+
+    std::vector<StaticBatch*>& nodeBatches = itr->second;
+    for (size_t i = 0, count = nodeBatches.size(); i < count; ++i)
+    {
+        setStaticBatchDirty(nodeBatches[i]);
+    }
+}
+
+void Scene::setStaticBatchDirty(StaticBatch* batch)
+{
+    GP_ASSERT(batch);
+
+    if (!batch->dirty)
+    {
+        batch->dirty = true;
+        _dirtyStaticBatches.push_back(batch);
+    }
+}
+
+void Scene::updateStaticBatches()
+{
+    // Nodes left the scene, so find the batches that still reference them.
+    if (_staticBatchesChanged)
+    {
+        for (std::map<Node*, std::vector<StaticBatch*> >::iterator itr = _staticBatchIndex.begin(); itr != _staticBatchIndex.end(); ++itr)
+        {
+            if (itr->first->getScene() != this)
+                setStaticBatchDirty(itr->first);
+        }
+        _staticBatchesChanged = false;
+    }
+
+    if (_dirtyStaticBatches.empty())
+        return;
+
+    // Drop the members of dirty batches that can no longer be batched (their models draw themselves again).
+    std::vector<Node*> invalidNodes;
+    for (size_t i = 0, count = _dirtyStaticBatches.size(); i < count; ++i)
+    {
+        StaticBatch* batch = _dirtyStaticBatches[i];
+        for (size_t j = 0, nodeCount = batch->nodes.size(); j < nodeCount; ++j)
+        {
+            Node* node = batch->nodes[j];
+            Model* model = dynamic_cast<Model*>(node->getDrawable());
+            if ((!isStaticBatchNodeValid(node) || model->getMaterial(batch->parts[j]) != batch->material) &&
+                std::find(invalidNodes.begin(), invalidNodes.end(), node) == invalidNodes.end())
+            {
+                invalidNodes.push_back(node);
+            }
+        }
+    }
+    for (size_t i = 0, count = invalidNodes.size(); i < count; ++i)
+    {
+        removeStaticBatchNode(invalidNodes[i]);
+    }
+
+    std::vector<StaticBatch*> dirtyBatches;
+    dirtyBatches.swap(_dirtyStaticBatches);
+    for (size_t i = 0, count = dirtyBatches.size(); i < count; ++i)
+    {
+        StaticBatch* batch = dirtyBatches[i];
+        batch->dirty = false;
+        if (batch->nodes.empty())
+        {
+            std::vector<StaticBatch*>::iterator itr = std::find(_staticBatches.begin(), _staticBatches.end(), batch);
+            GP_ASSERT(itr != _staticBatches.end());
+            _staticBatches.erase(itr);
+            SAFE_DELETE(batch);
+        }
+        else
+        {
+            buildStaticBatch(batch);
+        }
+    }
+}
+
+void Scene::buildStaticBatch(StaticBatch* batch)
+{
+    GP_ASSERT(batch);
+    GP_ASSERT(batch->node);
+
+    const unsigned int vertexSize = batch->vertexFormat.getVertexSize();
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned short> indices;
+    BoundingSphere bounds(BoundingSphere::empty());
+    BoundingBox box(BoundingBox::empty());
+    for (size_t i = 0, nodeCount = batch->nodes.size(); i < nodeCount; ++i)
+    {
+        Node* node = batch->nodes[i];
+        Mesh* mesh = static_cast<Model*>(node->getDrawable())->getMesh();
+        std::map<std::string, StaticBatchSource*>::const_iterator source = _staticBatchSources.find(mesh->getUrl());
+        GP_ASSERT(source != _staticBatchSources.end());
+        GP_ASSERT(batch->parts[i] < source->second->parts.size());
+        const StaticBatchSource::Part& part = source->second->parts[batch->parts[i]];
+
+        unsigned int vertexStart = (unsigned int)(vertices.size() / vertexSize);
+        unsigned int vertexCount = (unsigned int)(part.vertices.size() / vertexSize);
+        unsigned int indexStart = (unsigned int)indices.size();
+        vertices.insert(vertices.end(), part.vertices.begin(), part.vertices.end());
+        indices.resize(indexStart + part.indices.size());
+        for (size_t k = 0, indexCount = part.indices.size(); k < indexCount; ++k)
+        {
+            indices[indexStart + k] = (unsigned short)(vertexStart + part.indices[k]);
+        }
+        unsigned char* partVertices = vertexCount > 0 ? &vertices[vertexStart * vertexSize] : NULL;
+
+        transformStaticBatchVertices(batch->vertexFormat, node->getWorldMatrix(), node->getInverseTransposeWorldMatrix(), partVertices, vertexCount);
+
+        BoundingSphere partBounds(source->second->boundingSphere);
+        partBounds.transform(node->getWorldMatrix());
+        bounds.merge(partBounds);
+        BoundingBox partBox(source->second->boundingBox);
+        partBox.transform(node->getWorldMatrix());
+        box.merge(partBox);
+    }
+
+    unsigned int vertexCount = (unsigned int)(vertices.size() / vertexSize);
+    if (vertexCount == 0)
+    {
+        batch->node->setDrawable(NULL);
+        return;
+    }
+
+    // The merged geometry only changes when batched nodes do, so it lives in static buffers.
+    Mesh* mesh = Mesh::createMesh(batch->vertexFormat, vertexCount, false);
+    if (mesh == NULL)
+    {
+        GP_ERROR("Failed to create mesh for static batch.");
+        return;
+    }
+    mesh->setVertexData(&vertices[0], 0, vertexCount);
+    mesh->setBoundingSphere(bounds);
+    mesh->setBoundingBox(box);
+    MeshPart* part = mesh->addPart(Mesh::TRIANGLES, Mesh::INDEX16, (unsigned int)indices.size(), false);
+    GP_ASSERT(part);
+    part->setIndexData(&indices[0], 0, (unsigned int)indices.size());
+
+    Model* model = Model::create(mesh);
+    SAFE_RELEASE(mesh);
+    NodeCloneContext context;
+    Material* material = batch->material->clone(context);
+    model->setMaterial(material);
+    SAFE_RELEASE(material);
+    batch->node->setDrawable(model);
+    SAFE_RELEASE(model);
+}
+
+void Scene::transformStaticBatchVertices(const VertexFormat& vertexFormat, const Matrix& world, const Matrix& inverseTransposeWorld, unsigned char* vertices, unsigned int vertexCount)
+{
+    const unsigned int vertexSize = vertexFormat.getVertexSize();
+    for (unsigned int i = 0, offset = 0, elementCount = vertexFormat.getElementCount(); i < elementCount; ++i)
+    {
+        const VertexFormat::Element& element = vertexFormat.getElement(i);
+        unsigned int elementOffset = offset;
+        offset += element.size * sizeof(float);
+
+        bool point = element.usage == VertexFormat::POSITION;
+        if (!point && element.usage != VertexFormat::NORMAL && element.usage != VertexFormat::TANGENT && element.usage != VertexFormat::BINORMAL)
+            continue;
+
+        // Positions are transformed as points, directions by the inverse transpose and renormalized.
+        unsigned int size = std::min(element.size, 3u);
+        for (unsigned int j = 0; j < vertexCount; ++j)
+        {
+            float* v = (float*)(vertices + j * vertexSize + elementOffset);
+            Vector3 value(v[0], size > 1 ? v[1] : 0.0f, size > 2 ? v[2] : 0.0f);
+            if (point)
+            {
+                world.transformPoint(&value);
+            }
+            else
+            {
+                inverseTransposeWorld.transformVector(&value);
+                value.normalize();
+            }
+            v[0] = value.x;
+            if (size > 1)
+                v[1] = value.y;
+            if (size > 2)
+                v[2] = value.z;
+        }
+    }
 }
 
 void Scene::reset()
@@ -10,6 +10,8 @@
 namespace gameplay
 {
 
+class BoundingVolumeTree;
+
 /**
  * Defines the root container for a hierarchy of Node objects.
  *
@@ -17,6 +19,9 @@ namespace gameplay
  */
 class Scene : public Ref
 {
+    friend class Node;
+    friend class Model;
+
 public:
 
     /**
@@ -188,6 +193,148 @@ public:
      */
     void update(float elapsedTime);
 
+    /**
+     * Enables or disables linear world transform propagation for this scene.
+     *
+     * By default, each Node resolves its world matrix lazily by walking its parents
+     * and dirties its entire subtree whenever its local transform changes. When linear
+     * transforms are enabled, the scene instead keeps the local and world matrices and
+     * dirty flags of every node in its hierarchy in contiguous arrays sorted by depth,
+     * and resolves all dirty world matrices in a single pass (see updateTransforms()).
+     *
+     * The Node and Transform APIs keep working in this mode: Node::getWorldMatrix()
+     * triggers a pass when any transform in the scene is dirty, but only when called from
+     * the thread that enabled linear transforms and outside of a running pass. Other
+     * threads see the world matrices of the last pass, so call updateTransforms() before
+     * reading world matrices from parallel work. Transform listeners of child nodes are
+     * notified when the pass runs rather than when the parent changes.
+     *
+     * @param enabled true to enable linear transform propagation, false to disable it.
+     * @param parallel true to resolve independent root subtrees on the game's WorkerPool.
+     */
+    void setLinearTransformsEnabled(bool enabled, bool parallel = false);
+
+    /**
+     * Determines if linear world transform propagation is enabled for this scene.
+     *
+     * @return true if linear transforms are enabled, false otherwise.
+     */
+    bool isLinearTransformsEnabled() const;
+
+    /**
+     * Resolves the world matrices of all nodes whose transforms have changed.
+     *
+     * This method is called automatically from update() and whenever a world matrix is
+     * requested from a dirty scene on the thread that owns it, but may be called explicitly
+     * at a well defined point in the frame (such as right before rendering or dispatching
+     * parallel work). It must only be called from the thread that enabled linear transforms
+     * and does nothing unless linear transforms are enabled.
+     */
+    void updateTransforms();
+
+    /**
+     * Merges the geometry of the static nodes in this scene into batches.
+     *
+     * Every node for which Node::isStatic() returns true and whose drawable is an
+     * unskinned Model loaded from a bundle is considered. The geometry of these models
+     * is read once, transformed into world space and merged, per material and vertex
+     * format, into static vertex and index buffers. Each batch is drawn by a Model
+     * attached to a node owned by the scene. These nodes are not part of the scene's
+     * node list (so they are not found, counted, saved or cloned), but they are passed
+     * to visit() after the scene's nodes and are returned by frustum queries, so the
+     * batches are drawn and culled by RenderQueue like any other model, while the
+     * batched models no longer draw themselves.
+     *
+     * When a batched node is moved, removed from the scene or given a different
+     * drawable, only the batches containing it are rebuilt (from the geometry read
+     * when the batches were built) the next time the scene is visited or queried
+     * with a frustum.
+     *
+     * This may be enabled from a scene file with "staticBatching = true", in which
+     * case the batches are built while the scene is loaded.
+     */
+    void buildStaticBatches();
+
+    /**
+     * Destroys all static batches, restoring the batched models to draw themselves.
+     */
+    void clearStaticBatches();
+
+    /**
+     * Gets the number of static batches built by buildStaticBatches().
+     *
+     * @return The number of static batches.
+     */
+    unsigned int getStaticBatchCount() const;
+
+    /**
+     * Enables or disables the spatial index of this scene.
+     *
+     * The spatial index is a dynamic bounding volume hierarchy over the nodes that have a
+     * drawable or a light. It is updated incrementally as those nodes move or are added to
+     * or removed from the scene, making the query methods run in sub-linear time. When it is
+     * disabled, the queries test every node in the scene.
+     *
+     * This may be enabled from a scene file with "spatialIndex = true".
+     *
+     * @param enabled true to enable the spatial index, false to disable it.
+     */
+    void setSpatialIndexEnabled(bool enabled);
+
+    /**
+     * Determines whether the spatial index of this scene is enabled.
+     *
+     * @return true if the spatial index is enabled, false otherwise.
+     */
+    bool isSpatialIndexEnabled() const;
+
+    /**
+     * Finds the enabled nodes with a drawable or light whose own bounds intersect the given frustum.
+     *
+     * Unlike Node::getBoundingSphere(), the bounds of a node do not include its children.
+     *
+     * @param frustum The frustum to test against (such as Camera::getFrustum()).
+     * @param nodes Vector that the matching nodes are appended to.
+     *
+     * @return The number of matching nodes.
+     * @script{ignore}
+     */
+    unsigned int queryNodes(const Frustum& frustum, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the enabled nodes with a drawable or light whose own bounds intersect the given sphere.
+     *
+     * @param sphere The sphere to test against.
+     * @param nodes Vector that the matching nodes are appended to.
+     *
+     * @return The number of matching nodes.
+     * @script{ignore}
+     */
+    unsigned int queryNodes(const BoundingSphere& sphere, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the enabled nodes with a drawable or light whose own bounds intersect the given box.
+     *
+     * @param box The box to test against.
+     * @param nodes Vector that the matching nodes are appended to.
+     *
+     * @return The number of matching nodes.
+     * @script{ignore}
+     */
+    unsigned int queryNodes(const BoundingBox& box, std::vector<Node*>& nodes);
+
+    /**
+     * Finds the enabled nodes with a drawable or light whose own bounds are hit by the given ray.
+     *
+     * @param ray The ray to test against.
+     * @param nodes Vector that the matching nodes are appended to, nearest first.
+     * @param maxDistance The maximum distance along the ray at which a node may be hit.
+     *
+     * @return The number of matching nodes.
+     * @script{ignore}
+     */
+    unsigned int queryNodes(const Ray& ray, std::vector<Node*>& nodes, float maxDistance = FLT_MAX);
+
     /**
      * Visits each node in the scene and calls the specified method pointer.
      *
@@ -299,6 +446,145 @@ private:
 
     bool isNodeVisible(Node* node);
 
+    /**
+     * Defines a batch of pre-transformed static geometry sharing a material.
+     */
+    struct StaticBatch
+    {
+        /**
+         * Constructor.
+         */
+        StaticBatch(Material* material, const VertexFormat& vertexFormat);
+
+        /**
+         * Destructor.
+         */
+        ~StaticBatch();
+
+        /** The node whose model draws the merged geometry (owned by the scene, outside its node list). */
+        Node* node;
+        /** The material shared by the batched mesh parts (referenced). */
+        Material* material;
+        /** The vertex format shared by the batched mesh parts. */
+        VertexFormat vertexFormat;
+        /** The batched nodes (referenced once per entry). */
+        std::vector<Node*> nodes;
+        /** The mesh part index of each entry in nodes. */
+        std::vector<unsigned int> parts;
+        /** The total number of indices of the batched mesh parts. */
+        unsigned int indexCount;
+        /** Whether the merged geometry must be rebuilt (and the batch is queued for it). */
+        bool dirty;
+    };
+
+    /**
+     * Defines the geometry of the parts of a batched mesh, kept to rebuild the batches it is part of.
+     */
+    struct StaticBatchSource;
+
+    /**
+     * Determines whether the given node draws a static batch.
+     */
+    bool isStaticBatchDrawNode(Node* node) const;
+
+    /**
+     * Collects the static batching candidates in the subtree of the given node.
+     */
+    void collectStaticBatchNodes(Node* node, std::vector<Node*>& nodes);
+
+    /**
+     * Determines whether the given node can still be drawn from the static batches.
+     */
+    bool isStaticBatchNodeValid(Node* node) const;
+
+    /**
+     * Removes a node from the static batches so that its model draws itself again.
+     */
+    void removeStaticBatchNode(Node* node);
+
+    /**
+     * Marks the static batches containing the specified node dirty.
+     */
+    void setStaticBatchDirty(Node* node);
+
+    /**
+     * Marks the specified static batch dirty, queuing it to be rebuilt.
+     */
+    void setStaticBatchDirty(StaticBatch* batch);
+
+    /**
+     * Drops invalid nodes from the dirty static batches and rebuilds their merged geometry.
+     */
+    void updateStaticBatches();
+
+    /**
+     * Builds the merged geometry of a static batch into a new model for its node.
+     */
+    void buildStaticBatch(StaticBatch* batch);
+
+    /**
+     * Transforms the positions, normals, tangents and binormals of the given vertices into world space.
+     */
+    static void transformStaticBatchVertices(const VertexFormat& vertexFormat, const Matrix& world, const Matrix& inverseTransposeWorld,
+                                             unsigned char* vertices, unsigned int vertexCount);
+
+    /**
+     * Starts tracking the nodes in the given subtree in the spatial index.
+     */
+    void addSpatialIndexNodes(Node* node);
+
+    /**
+     * Stops tracking the nodes in the given subtree in the spatial index.
+     */
+    void removeSpatialIndexNodes(Node* node);
+
+    /**
+     * Applies the queued node changes to the spatial index.
+     */
+    void updateSpatialIndex();
+
+    /**
+     * Collects the nodes the spatial index would contain, for queries without an index.
+     */
+    void collectSpatialIndexNodes(Node* node, std::vector<Node*>& nodes);
+
+    /**
+     * Appends the enabled nodes whose bounds intersect the given volume (a frustum,
+     * sphere or box), using the spatial index when it is enabled.
+     */
+    template <class V>
+    unsigned int queryBoundsNodes(const V& volume, std::vector<Node*>& nodes);
+
+    /**
+     * Rebuilds the depth sorted transform arrays from the current node hierarchy.
+     */
+    void buildTransforms();
+
+    /**
+     * Detaches all nodes from the transform arrays and clears them.
+     */
+    void clearTransforms();
+
+    /**
+     * Resolves the world matrices for the transform array entries in the range [begin, end).
+     */
+    void resolveTransforms(unsigned int begin, unsigned int end);
+
+    /**
+     * Runs updateTransforms() for Node::getWorldMatrix() if it is safe to do so.
+     */
+    void updateTransformsOnDemand();
+
+    /**
+     * Marks the transform array entry for the specified node as dirty.
+     */
+    void setTransformDirty(unsigned int index);
+
+    /**
+     * Marks the transform arrays for rebuild after the node hierarchy changed.
+     */
+    void setTransformHierarchyDirty();
+
     std::string _id;
     Camera* _activeCamera;
     Node* _firstNode;
@@ -308,32 +594,67 @@ private:
     bool _bindAudioListenerToCamera;
     Node* _nextItr;
     bool _nextReset;
+    bool _linearTransforms;
+    bool _linearTransformsParallel;
+    bool _transformsDirty;
+    bool _transformHierarchyDirty;
+    bool _transformsResolving;
+    std::thread::id _transformThread;
+    int _transformNotifyIndex;
+    std::vector<Node*> _transformNodes;
+    std::vector<int> _transformParents;
+    std::vector<Matrix> _localMatrices;
+    std::vector<Matrix> _worldMatrices;
+    std::vector<unsigned char> _transformFlags;
+    std::vector<unsigned int> _transformRanges;
+    std::vector<StaticBatch*> _staticBatches;
+    std::map<Node*, std::vector<StaticBatch*> > _staticBatchIndex;
+    std::vector<StaticBatch*> _dirtyStaticBatches;
+    std::map<std::string, StaticBatchSource*> _staticBatchSources;
+    bool _staticBatchesChanged;
+    BoundingVolumeTree* _spatialIndex;
+    std::vector<Node*> _spatialIndexDirtyNodes;
 };
 
 template <class T>
 void Scene::visit(T* instance, bool (T::*visitMethod)(Node*))
 {
+    updateStaticBatches();
     for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
     {
         visitNode(node, instance, visitMethod);
     }
+    for (size_t i = 0; i < _staticBatches.size(); ++i)
+    {
+        visitNode(_staticBatches[i]->node, instance, visitMethod);
+    }
 }
 
 template <class T, class C>
 void Scene::visit(T* instance, bool (T::*visitMethod)(Node*,C), C cookie)
 {
+    updateStaticBatches();
     for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
     {
         visitNode(node, instance, visitMethod, cookie);
     }
+    for (size_t i = 0; i < _staticBatches.size(); ++i)
+    {
+        visitNode(_staticBatches[i]->node, instance, visitMethod, cookie);
+    }
 }
 
 inline void Scene::visit(const char* visitMethod)
 {
+    updateStaticBatches();
     for (Node* node = getFirstNode(); node != NULL; node = node->getNextSibling())
     {
         visitNode(node, visitMethod);
     }
+    for (size_t i = 0; i < _staticBatches.size(); ++i)
+    {
+        visitNode(_staticBatches[i]->node, visitMethod);
+    }
 }
 
 template <class T>
@@ -143,6 +143,13 @@ Scene* SceneLoader::loadInternal(const char* url)
     if (physics)
         loadPhysics(physics);
 
+    if (sceneProperties->getBool("spatialIndex"))
+        _scene->setSpatialIndexEnabled(true);
+
+    // Merge static geometry once all collision objects (which mark nodes static) exist.
+    if (sceneProperties->getBool("staticBatching"))
+        _scene->buildStaticBatches();
+
     // Clean up all loaded properties objects.
     std::map<std::string, Properties*>::iterator iter = _propertiesFromFile.begin();
     for (; iter != _propertiesFromFile.end(); ++iter)
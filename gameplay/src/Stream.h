@@ -155,6 +155,17 @@ public:
      */
     virtual bool rewind() = 0;
 
+    /**
+     * Returns a pointer to the entire contents of this stream, if the stream is
+     * memory mapped (see FileSystem::MAPPED).
+     *
+     * The returned memory is read-only and remains valid until the stream is closed.
+     * Reading through the pointer does not move the stream position.
+     *
+     * @return The contents of the stream, or NULL if the stream is not memory mapped.
+     */
+    virtual const unsigned char* getData() { return NULL; }
+
 protected:
     Stream() {};
 private:
@@ -1,8 +1,12 @@
 #include "Base.h"
 #include "Terrain.h"
 #include "TerrainPatch.h"
+#include "MeshPart.h"
 #include "Node.h"
+#include "RenderQueue.h"
 #include "FileSystem.h"
+#include "Scene.h"
+#include "Game.h"
 
 namespace gameplay
 {
@@ -25,22 +29,49 @@ static const float DEFAULT_TERRAIN_HEIGHT_RATIO = 0.3f;
 // Terrain dirty flags
 static const unsigned int DIRTY_FLAG_INVERSE_WORLD = 1;
 
+// The default memory budget of the resident tiles of a streaming terrain, in kilobytes.
+#define TERRAIN_STREAMING_BUDGET 65536
+
+// The maximum number of tiles of a streaming terrain loaded at once.
+#define TERRAIN_STREAMING_MAX_LOADS 4
+
+// The maximum number of loaded tiles whose meshes are created each frame.
+#define TERRAIN_STREAMING_MAX_FINISHES 2
+
+// The default screen-space error allowed when selecting the level of detail of patches, in pixels.
+#define TERRAIN_PIXEL_ERROR 4.0f
+
+// The largest ratio of the steps of neighboring patches that their edges are stitched for.
+#define TERRAIN_MAX_STITCH_RATIO 31u
+
 static float getDefaultHeight(unsigned int width, unsigned int height);
+static size_t getTileSize(unsigned int tileSize, unsigned int maxStep, float skirtScale, bool normals);
+static unsigned int getStitchedVertex(unsigned int x, unsigned int z, unsigned int width, unsigned int height,
+                                      bool skirt, const unsigned int* ratios);
 
 Terrain::Terrain() : Drawable(),
     _heightfield(NULL), _normalMap(NULL), _flags(FRUSTUM_CULLING | LEVEL_OF_DETAIL),
-    _dirtyFlags(DIRTY_FLAG_INVERSE_WORLD)
+    _dirtyFlags(DIRTY_FLAG_INVERSE_WORLD), _streaming(NULL), _pixelError(TERRAIN_PIXEL_ERROR),
+    _patchRows(0), _patchColumns(0), _patchLayers(false), _drawStamp(0)
 {
 }
 
 Terrain::~Terrain()
 {
+    // Wait for the tiles being loaded by the worker pool.
+    if (_streaming)
+    {
+        std::unique_lock<std::mutex> lock(_streaming->readyMutex);
+        _streaming->loaded.wait(lock, [this] { return _streaming->loading == 0; });
+    }
+
     for (size_t i = 0, count = _patches.size(); i < count; ++i)
     {
         SAFE_DELETE(_patches[i]);
     }
     SAFE_RELEASE(_normalMap);
     SAFE_RELEASE(_heightfield);
+    SAFE_DELETE(_streaming);
 }
 
 Terrain* Terrain::create(const char* path)
@@ -206,12 +237,41 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         return NULL;
     }
 
+    // Read 'streaming'
+    Streaming* streaming = NULL;
+    Properties* pStreaming = pTerrain->getNamespace("streaming", true);
+    if (pStreaming)
+    {
+        streaming = createStreaming(pStreaming, heightfield);
+        if (streaming == NULL)
+        {
+            GP_WARN("Invalid streaming section in terrain definition: %s", path);
+            SAFE_RELEASE(heightfield);
+            if (!externalProperties)
+                SAFE_DELETE(p);
+            return NULL;
+        }
+
+        // The normal map of a streaming terrain is given per tile.
+        if (normalMap)
+            streaming->normalMapPath = normalMap;
+        normalMap = NULL;
+    }
+
+    // The heights of a streaming terrain are those of its tiles, of which the heightfield is a coarse version.
+    unsigned int columnCount = streaming ? streaming->columns * streaming->tileSize + 1 : heightfield->getColumnCount();
+    unsigned int rowCount = streaming ? streaming->rows * streaming->tileSize + 1 : heightfield->getRowCount();
+
     if (terrainSize.isZero())
     {
-        terrainSize.set(heightfield->getColumnCount(), getDefaultHeight(heightfield->getColumnCount(), heightfield->getRowCount()), heightfield->getRowCount());
+        terrainSize.set(columnCount, getDefaultHeight(columnCount, rowCount), rowCount);
     }
 
-    if (patchSize <= 0 || patchSize > (int)heightfield->getColumnCount() || patchSize > (int)heightfield->getRowCount())
+    if (streaming)
+    {
+        patchSize = streaming->tileSize;
+    }
+    else if (patchSize <= 0 || patchSize > (int)heightfield->getColumnCount() || patchSize > (int)heightfield->getRowCount())
     {
         patchSize = std::min(heightfield->getRowCount(), std::min(heightfield->getColumnCount(), DEFAULT_TERRAIN_PATCH_SIZE));
     }
@@ -223,10 +283,10 @@ Terrain* Terrain::create(const char* path, Properties* properties)
         skirtScale = 0;
 
     // Compute terrain scale
-    Vector3 scale(terrainSize.x / (heightfield->getColumnCount()-1), terrainSize.y, terrainSize.z / (heightfield->getRowCount()-1));
+    Vector3 scale(terrainSize.x / (columnCount-1), terrainSize.y, terrainSize.z / (rowCount-1));
 
     // Create terrain
-    Terrain* terrain = create(heightfield, scale, (unsigned int)patchSize, (unsigned int)detailLevels, skirtScale, normalMap, materialPath.c_str(), pTerrain);
+    Terrain* terrain = create(heightfield, scale, (unsigned int)patchSize, (unsigned int)detailLevels, skirtScale, normalMap, materialPath.c_str(), pTerrain, streaming);
 
     if (!externalProperties)
         SAFE_DELETE(p);
@@ -236,12 +296,12 @@ Terrain* Terrain::create(const char* path, Properties* properties)
 
 Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale, unsigned int patchSize, unsigned int detailLevels, float skirtScale, const char* normalMapPath, const char* materialPath)
 {
-    return create(heightfield, scale, patchSize, detailLevels, skirtScale, normalMapPath, materialPath, NULL);
+    return create(heightfield, scale, patchSize, detailLevels, skirtScale, normalMapPath, materialPath, NULL, NULL);
 }
 
 Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
     unsigned int patchSize, unsigned int detailLevels, float skirtScale,
-    const char* normalMapPath, const char* materialPath, Properties* properties)
+    const char* normalMapPath, const char* materialPath, Properties* properties, Streaming* streaming)
 {
     GP_ASSERT(heightfield);
 
@@ -251,6 +311,7 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
     // Create the terrain object
     Terrain* terrain = new Terrain();
     terrain->_heightfield = heightfield;
+    terrain->_streaming = streaming;
     terrain->_materialPath = (materialPath == NULL || strlen(materialPath) == 0) ? TERRAIN_MATERIAL : materialPath;
 
     // Store terrain local scaling so it can be applied to the heightfield
@@ -274,31 +335,67 @@ Terrain* Terrain::create(HeightField* heightfield, const Vector3& scale,
     // level detail terrain patch.
     unsigned int maxStep = (unsigned int)std::pow(2.0, (double)(detailLevels-1));
 
-    // Create terrain patches
-    unsigned int x1, x2, z1, z2;
-    unsigned int row = 0, column = 0;
-    for (unsigned int z = 0; z < height-1; z = z2, ++row)
+    if (streaming)
     {
-        z1 = z;
-        z2 = std::min(z1 + patchSize, height-1);
-
-        for (unsigned int x = 0; x < width-1; x = x2, ++column)
+        // Create a patch for each tile, drawn from the coarse heightfield until its tile is loaded
+        streaming->maxStep = maxStep;
+        streaming->skirtScale = skirtScale;
+        size_t tileSize = getTileSize(streaming->tileSize, maxStep, skirtScale, streaming->normalMapPath.empty());
+        streaming->maxResident = (unsigned int)std::max(streaming->budget / tileSize, (size_t)1);
+
+        halfWidth = streaming->columns * streaming->tileSize * 0.5f;
+        halfHeight = streaming->rows * streaming->tileSize * 0.5f;
+        for (unsigned int row = 0; row < streaming->rows; ++row)
         {
-            x1 = x;
-            x2 = std::min(x1 + patchSize, width-1);
+            for (unsigned int column = 0; column < streaming->columns; ++column)
+            {
+                TerrainPatch* patch = TerrainPatch::create(terrain, terrain->_patches.size(), row, column,
+                    column * streaming->tileSize - halfWidth, row * streaming->tileSize - halfHeight, skirtScale);
+                terrain->_patches.push_back(patch);
+                bounds.merge(patch->getBoundingBox(false));
+            }
+        }
+        streaming->order = terrain->_patches;
+        terrain->_patchRows = streaming->rows;
+        terrain->_patchColumns = streaming->columns;
+    }
+    else
+    {
+        // Create terrain patches
+        unsigned int x1, x2, z1, z2;
+        unsigned int row = 0, column = 0;
+        for (unsigned int z = 0; z < height-1; z = z2, ++row)
+        {
+            z1 = z;
+            z2 = std::min(z1 + patchSize, height-1);
 
-            // Create this patch
-            TerrainPatch* patch = TerrainPatch::create(terrain, terrain->_patches.size(), row, column, heightfield->getArray(), width, height, x1, z1, x2, z2, -halfWidth, -halfHeight, maxStep, skirtScale);
-            terrain->_patches.push_back(patch);
+            column = 0;
+            for (unsigned int x = 0; x < width-1; x = x2, ++column)
+            {
+                x1 = x;
+                x2 = std::min(x1 + patchSize, width-1);
+
+                // Create this patch
+                TerrainPatch* patch = TerrainPatch::create(terrain, terrain->_patches.size(), row, column, heightfield->getArray(), width, height, x1, z1, x2, z2, -halfWidth, -halfHeight, maxStep, skirtScale);
+                terrain->_patches.push_back(patch);
 
-            // Append the new patch's local bounds to the terrain local bounds
-            bounds.merge(patch->getBoundingBox(false));
+                // Append the new patch's local bounds to the terrain local bounds
+                bounds.merge(patch->getBoundingBox(false));
+            }
         }
+        terrain->_patchRows = row;
+        terrain->_patchColumns = column;
+
+        // Create the meshes of the patch lods
+        terrain->createBatches();
     }
 
     // Read additional layer information from properties (if specified)
     if (properties)
     {
+        if (properties->exists("pixelError"))
+            terrain->_pixelError = std::max(properties->getFloat("pixelError"), 0.0f);
+
         // Parse terrain layers
         Properties* lp;
         int index = -1;
@@ -401,6 +498,11 @@ void Terrain::setNode(Node* node)
 void Terrain::transformChanged(Transform* transform, long cookie)
 {
     _dirtyFlags |= DIRTY_FLAG_INVERSE_WORLD;
+
+    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    {
+        _patches[i]->setBoundsDirty();
+    }
 }
 
 const Matrix& Terrain::getInverseWorldMatrix() const
@@ -430,6 +532,33 @@ bool Terrain::setLayer(int index, const char* texturePath, const Vector2& textur
     if (!texturePath)
         return false;
 
+    // Layers with a blend map per tile are set on the patches of the tiles as they are loaded
+    bool tileLayer = _streaming && blendPath && strchr(blendPath, '{');
+    if (tileLayer)
+    {
+        for (std::vector<TileLayer>::iterator itr = _streaming->layers.begin(); itr != _streaming->layers.end(); ++itr)
+        {
+            if (itr->index == index)
+            {
+                _streaming->layers.erase(itr);
+                break;
+            }
+        }
+        TileLayer layer;
+        layer.index = index;
+        layer.texturePath = texturePath;
+        layer.textureRepeat = textureRepeat;
+        layer.blendPath = blendPath;
+        layer.blendChannel = blendChannel;
+        layer.row = row;
+        layer.column = column;
+        _streaming->layers.push_back(layer);
+    }
+
+    // Patches with different layers are drawn with their own materials
+    if (row != -1 || column != -1)
+        _patchLayers = true;
+
     // Set layer on applicable patches
     bool result = true;
     for (size_t i = 0, count = _patches.size(); i < count; ++i)
@@ -438,8 +567,18 @@ bool Terrain::setLayer(int index, const char* texturePath, const Vector2& textur
 
         if ((row == -1 || (int)patch->_row == row) && (column == -1 || (int)patch->_column == column))
         {
-            if (!patch->setLayer(index, texturePath, textureRepeat, blendPath, blendChannel))
+            if (tileLayer)
+            {
+                if (patch->_tileState != TerrainPatch::TILE_RESIDENT)
+                    continue;
+                std::string tileBlendPath = getTilePath(blendPath, patch->_row, patch->_column);
+                if (!patch->setLayer(index, texturePath, textureRepeat, tileBlendPath.c_str(), blendChannel))
+                    result = false;
+            }
+            else if (!patch->setLayer(index, texturePath, textureRepeat, blendPath, blendChannel))
+            {
                 result = false;
+            }
         }
     }
     return result;
@@ -486,6 +625,35 @@ unsigned int Terrain::getPatchCount() const
     return _patches.size();
 }
 
+bool Terrain::isStreaming() const
+{
+    return _streaming != NULL;
+}
+
+unsigned int Terrain::getResidentPatchCount() const
+{
+    if (!_streaming)
+        return _patches.size();
+
+    unsigned int count = 0;
+    for (size_t i = 0, patchCount = _patches.size(); i < patchCount; ++i)
+    {
+        if (_patches[i]->_tileState == TerrainPatch::TILE_RESIDENT)
+            ++count;
+    }
+    return count;
+}
+
+void Terrain::setPixelError(float pixelError)
+{
+    _pixelError = std::max(pixelError, 0.0f);
+}
+
+float Terrain::getPixelError() const
+{
+    return _pixelError;
+}
+
 TerrainPatch* Terrain::getPatch(unsigned int index) const
 {
     return _patches[index];
@@ -499,8 +667,8 @@ const BoundingBox& Terrain::getBoundingBox() const
 float Terrain::getHeight(float x, float z) const
 {
     // Calculate the correct x, z position relative to the heightfield data.
-    float cols = _heightfield->getColumnCount();
-    float rows = _heightfield->getRowCount();
+    float cols = _streaming ? _streaming->columns * _streaming->tileSize + 1 : _heightfield->getColumnCount();
+    float rows = _streaming ? _streaming->rows * _streaming->tileSize + 1 : _heightfield->getRowCount();
 
     GP_ASSERT(cols > 0);
     GP_ASSERT(rows > 0);
@@ -513,7 +681,22 @@ float Terrain::getHeight(float x, float z) const
     z = v.z + (rows - 1) * 0.5f;
 
     // Get the unscaled height value from the HeightField
-    float height = _heightfield->getHeight(x, z);
+    float height;
+    if (_streaming)
+    {
+        // Use the heights of the tile if it is resident, otherwise the coarse heightfield
+        unsigned int column = std::min((unsigned int)std::max(x, 0.0f) / _streaming->tileSize, _streaming->columns - 1);
+        unsigned int row = std::min((unsigned int)std::max(z, 0.0f) / _streaming->tileSize, _streaming->rows - 1);
+        const TerrainPatch* patch = _patches[row * _streaming->columns + column];
+        if (patch->_heights)
+            height = patch->_heights->getHeight(x - column * _streaming->tileSize, z - row * _streaming->tileSize);
+        else
+            height = _heightfield->getHeight(x / _streaming->spacingX, z / _streaming->spacingZ);
+    }
+    else
+    {
+        height = _heightfield->getHeight(x, z);
+    }
 
     // Apply world scale to the height value
     if (_node)
@@ -529,14 +712,101 @@ float Terrain::getHeight(float x, float z) const
     return height;
 }
 
+Vector3 Terrain::getHeightfieldScale() const
+{
+    if (!_streaming)
+        return _localScale;
+    return Vector3(_localScale.x * _streaming->spacingX, _localScale.y, _localScale.z * _streaming->spacingZ);
+}
+
 unsigned int Terrain::draw(bool wireframe)
 {
-    size_t visibleCount = 0;
+    Scene* scene = _node ? _node->getScene() : NULL;
+    Camera* camera = scene ? scene->getActiveCamera() : NULL;
+    if (!camera)
+        return 0;
+
+    if (_streaming && camera->getNode())
+        updateStreaming(camera);
+
+    computeLevels(camera);
+
+    // Build the indices of the visible patches into the index buffers of the batches of their levels
+    ++_drawStamp;
+    _batches.clear();
+    unsigned int ratios[4];
     for (size_t i = 0, count = _patches.size(); i < count; ++i)
     {
-        visibleCount += _patches[i]->draw(wireframe);
+        TerrainPatch* patch = _patches[i];
+        patch->_indexCount = 0;
+        if (!_patchVisible[i] || !patch->updateMaterial())
+            continue;
+
+        TerrainPatch::Level* level = patch->_levels[patch->_level];
+        TerrainPatch::Batch* batch = level->batch;
+        GP_ASSERT(batch);
+        if (batch->stamp != _drawStamp)
+        {
+            batch->stamp = _drawStamp;
+            batch->first = patch;
+            batch->next.clear();
+            _batches.push_back(batch);
+        }
+
+        getEdgeRatios(patch, ratios);
+        const std::vector<unsigned short>& indices = getIndices(level, ratios);
+        std::vector<unsigned short>& next = batch->next;
+        if (!next.empty())
+        {
+            // Add degenerate indices to connect the strips of the patches
+            next.push_back(next.back());
+            next.push_back((unsigned short)(indices[0] + level->baseVertex));
+        }
+        patch->_indexStart = next.size();
+        patch->_indexCount = indices.size();
+        for (size_t j = 0, indexCount = indices.size(); j < indexCount; ++j)
+        {
+            next.push_back((unsigned short)(indices[j] + level->baseVertex));
+        }
     }
-    return visibleCount;
+
+    // Upload the indices of the batches that changed since they were last drawn
+    for (size_t i = 0, count = _batches.size(); i < count; ++i)
+    {
+        TerrainPatch::Batch* batch = _batches[i];
+        if (batch->next != batch->indices)
+        {
+            batch->indices.swap(batch->next);
+            batch->part->setIndexData(&batch->indices[0], 0, (unsigned int)batch->indices.size());
+        }
+    }
+
+    // Draw each batch at once when its patches share the same layers, otherwise each patch with its own material
+    unsigned int drawCount = 0;
+    if (!_patchLayers && !isFlagSet(DEBUG_PATCHES))
+    {
+        for (size_t i = 0, count = _batches.size(); i < count; ++i)
+        {
+            TerrainPatch::Batch* batch = _batches[i];
+            drawCount += batch->first->draw(0, (unsigned int)batch->indices.size(), wireframe);
+        }
+    }
+    else
+    {
+        for (size_t i = 0, count = _patches.size(); i < count; ++i)
+        {
+            TerrainPatch* patch = _patches[i];
+            if (patch->_indexCount > 0)
+                drawCount += patch->draw(patch->_indexStart, patch->_indexCount, wireframe);
+        }
+    }
+    return drawCount;
+}
+
+void Terrain::enqueue(RenderQueue* queue)
+{
+    GP_ASSERT(queue);
+    queue->add(this, false);
 }
 
 Drawable* Terrain::clone(NodeCloneContext& context)
@@ -545,6 +815,431 @@ Drawable* Terrain::clone(NodeCloneContext& context)
     return NULL;
 }
 
+Terrain::Streaming* Terrain::createStreaming(Properties* properties, HeightField* heightfield)
+{
+    GP_ASSERT(properties);
+    GP_ASSERT(heightfield);
+
+    const char* tilePath = properties->getString("tiles");
+    int tileSize = properties->getInt("tileSize");
+    int rows = properties->getInt("rows");
+    int columns = properties->getInt("columns");
+    if (!tilePath || tileSize <= 0 || rows <= 0 || columns <= 0)
+    {
+        GP_WARN("Streaming terrains require 'tiles', 'tileSize', 'rows' and 'columns' properties.");
+        return NULL;
+    }
+
+    Streaming* streaming = new Streaming();
+    streaming->tilePath = tilePath;
+    streaming->tileSize = (unsigned int)tileSize;
+    streaming->rows = (unsigned int)rows;
+    streaming->columns = (unsigned int)columns;
+    streaming->spacingX = (float)(columns * tileSize) / (heightfield->getColumnCount() - 1);
+    streaming->spacingZ = (float)(rows * tileSize) / (heightfield->getRowCount() - 1);
+    if (properties->exists("memoryBudget"))
+        streaming->budget = (size_t)std::max(properties->getInt("memoryBudget"), 0) * 1024;
+    return streaming;
+}
+
+std::string Terrain::getTilePath(const std::string& path, unsigned int row, unsigned int column)
+{
+    std::string result = path;
+    char value[16];
+    size_t pos;
+    sprintf(value, "%u", row);
+    while ((pos = result.find("{row}")) != std::string::npos)
+        result.replace(pos, 5, value);
+    sprintf(value, "%u", column);
+    while ((pos = result.find("{column}")) != std::string::npos)
+        result.replace(pos, 8, value);
+    return result;
+}
+
+void Terrain::updateStreaming(Camera* camera)
+{
+    GP_ASSERT(_streaming);
+    GP_ASSERT(camera);
+
+    // The terrain may be drawn more than once each frame.
+    unsigned int frame = Game::getInstance()->getFrameNumber();
+    if (_streaming->frame == frame)
+        return;
+    _streaming->frame = frame;
+
+    // Take the tiles built on the worker pool
+    _streaming->readyMutex.lock();
+    _streaming->finishing.insert(_streaming->finishing.end(), _streaming->ready.begin(), _streaming->ready.end());
+    _streaming->ready.clear();
+    _streaming->readyMutex.unlock();
+
+    // Create the meshes of the tiles whose textures have loaded, a few each frame
+    unsigned int finished = 0;
+    for (size_t i = 0; i < _streaming->finishing.size() && finished < TERRAIN_STREAMING_MAX_FINISHES; )
+    {
+        TerrainPatch* patch = _streaming->finishing[i];
+        if (patch->isTileLoaded())
+        {
+            patch->finishTile();
+            _boundingBox.merge(patch->getBoundingBox(false));
+            _streaming->finishing.erase(_streaming->finishing.begin() + i);
+            ++finished;
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    // Order the patches by their distance to the camera
+    std::vector<TerrainPatch*>& order = _streaming->order;
+    Vector3 eye = camera->getNode()->getTranslationWorld();
+    unsigned int used = 0, loading = 0;
+    for (size_t i = 0, count = order.size(); i < count; ++i)
+    {
+        TerrainPatch* patch = order[i];
+        patch->_distance = patch->getBoundingBox(true).getCenter().distanceSquared(eye);
+        if (patch->_tileState == TerrainPatch::TILE_LOADING)
+            ++loading;
+        if (patch->_tileState == TerrainPatch::TILE_LOADING || patch->_tileState == TerrainPatch::TILE_RESIDENT)
+            ++used;
+    }
+    std::sort(order.begin(), order.end(), compareDistance);
+
+    // Load the nearest tiles that fit in the budget, evicting the farthest resident tiles to make room
+    size_t wanted = std::min((size_t)_streaming->maxResident, order.size());
+    for (size_t i = 0; i < wanted && loading < TERRAIN_STREAMING_MAX_LOADS; ++i)
+    {
+        TerrainPatch* patch = order[i];
+        if (patch->_tileState != TerrainPatch::TILE_COARSE)
+            continue;
+
+        for (size_t j = order.size(); used >= _streaming->maxResident && j-- > wanted; )
+        {
+            if (order[j]->_tileState == TerrainPatch::TILE_RESIDENT)
+            {
+                order[j]->evictTile();
+                --used;
+            }
+        }
+        if (used >= _streaming->maxResident)
+            break;
+
+        patch->requestTile();
+        ++used;
+        ++loading;
+    }
+}
+
+bool Terrain::compareDistance(const TerrainPatch* lhs, const TerrainPatch* rhs)
+{
+    return lhs->_distance < rhs->_distance;
+}
+
+void Terrain::createBatches()
+{
+    // Pack the levels of neighboring patches into shared meshes, of no more vertices than
+    // 16-bit indices address, so that the patches at the same level are drawn together
+    std::vector<TerrainPatch::LevelData*> data;
+    std::vector<TerrainPatch*> patches;
+    for (unsigned int level = 0; ; ++level)
+    {
+        bool found = false;
+        for (size_t i = 0, count = _patches.size(); i < count; )
+        {
+            data.clear();
+            patches.clear();
+            unsigned int vertexCount = 0;
+            for (; i < count; ++i)
+            {
+                TerrainPatch* patch = _patches[i];
+                if (level >= patch->_levelData.size())
+                    continue;
+
+                TerrainPatch::LevelData* levelData = patch->_levelData[level];
+                if (!data.empty() && vertexCount + levelData->vertexCount > USHRT_MAX + 1)
+                    break;
+
+                vertexCount += levelData->vertexCount;
+                data.push_back(levelData);
+                patches.push_back(patch);
+            }
+            if (data.empty())
+                break;
+
+            found = true;
+            TerrainPatch::Batch* batch = TerrainPatch::createBatch(&data[0], (unsigned int)data.size());
+            unsigned int baseVertex = 0;
+            for (size_t j = 0, patchCount = patches.size(); j < patchCount; ++j)
+            {
+                patches[j]->_levels.push_back(TerrainPatch::createLOD(data[j], batch, baseVertex));
+                baseVertex += data[j]->vertexCount;
+            }
+            batch->release();
+        }
+        if (!found)
+            break;
+    }
+
+    // The vertex data is now in the meshes
+    for (size_t i = 0, count = _patches.size(); i < count; ++i)
+    {
+        TerrainPatch* patch = _patches[i];
+        for (size_t j = 0, levelCount = patch->_levelData.size(); j < levelCount; ++j)
+        {
+            SAFE_DELETE(patch->_levelData[j]);
+        }
+        patch->_levelData.clear();
+    }
+}
+
+void Terrain::computeLevels(Camera* camera)
+{
+    GP_ASSERT(camera);
+
+    // Gather the world-space bounds of the patches, as arrays of centers and extents
+    size_t count = _patches.size();
+    if (count == 0)
+        return;
+    _patchBounds.resize(count * 6);
+    _patchErrors.resize(count);
+    _patchVisible.resize(count);
+    float* cx = &_patchBounds[0];
+    float* cy = cx + count;
+    float* cz = cy + count;
+    float* ex = cz + count;
+    float* ey = ex + count;
+    float* ez = ey + count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const BoundingBox& bounds = _patches[i]->getBoundingBox(true);
+        cx[i] = (bounds.min.x + bounds.max.x) * 0.5f;
+        cy[i] = (bounds.min.y + bounds.max.y) * 0.5f;
+        cz[i] = (bounds.min.z + bounds.max.z) * 0.5f;
+        ex[i] = (bounds.max.x - bounds.min.x) * 0.5f;
+        ey[i] = (bounds.max.y - bounds.min.y) * 0.5f;
+        ez[i] = (bounds.max.z - bounds.min.z) * 0.5f;
+    }
+
+    // Cull the patches that are behind any plane of the view frustum
+    unsigned char* visible = &_patchVisible[0];
+    for (size_t i = 0; i < count; ++i)
+    {
+        visible[i] = 1;
+    }
+    if (isFlagSet(FRUSTUM_CULLING))
+    {
+        const Frustum& frustum = camera->getFrustum();
+        const Plane* planes[6] = { &frustum.getNear(), &frustum.getFar(), &frustum.getLeft(),
+                                   &frustum.getRight(), &frustum.getBottom(), &frustum.getTop() };
+        for (unsigned int p = 0; p < 6; ++p)
+        {
+            const Vector3& n = planes[p]->getNormal();
+            float d = planes[p]->getDistance();
+            float ax = fabsf(n.x);
+            float ay = fabsf(n.y);
+            float az = fabsf(n.z);
+            for (size_t i = 0; i < count; ++i)
+            {
+                float distance = n.x * cx[i] + n.y * cy[i] + n.z * cz[i] + d;
+                float radius = ax * ex[i] + ay * ey[i] + az * ez[i];
+                visible[i] &= (distance + radius >= 0.0f) ? 1 : 0;
+            }
+        }
+    }
+
+    if (!isFlagSet(LEVEL_OF_DETAIL))
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            _patches[i]->_level = 0;
+        }
+        return;
+    }
+
+    // The largest geometric error allowed for each patch, in the local units of the terrain:
+    // the error that projects to the pixel error at the distance of the patch from the camera
+    float viewportHeight = Game::getInstance()->getViewport().height;
+    Vector3 worldScale(Vector3::one());
+    if (_node)
+        _node->getWorldMatrix().getScale(&worldScale);
+    float scale = _pixelError / (std::max(viewportHeight, 1.0f) * std::max(fabsf(worldScale.y), MATH_EPSILON));
+    float* errors = &_patchErrors[0];
+    if (camera->getCameraType() == Camera::PERSPECTIVE)
+    {
+        scale *= 2.0f * tanf(MATH_DEG_TO_RAD(camera->getFieldOfView()) * 0.5f);
+        Vector3 eye = camera->getNode() ? camera->getNode()->getTranslationWorld() : Vector3::zero();
+        for (size_t i = 0; i < count; ++i)
+        {
+            float dx = std::max(fabsf(cx[i] - eye.x) - ex[i], 0.0f);
+            float dy = std::max(fabsf(cy[i] - eye.y) - ey[i], 0.0f);
+            float dz = std::max(fabsf(cz[i] - eye.z) - ez[i], 0.0f);
+            errors[i] = sqrtf(dx * dx + dy * dy + dz * dz) * scale;
+        }
+    }
+    else
+    {
+        scale *= camera->getZoomY();
+        for (size_t i = 0; i < count; ++i)
+        {
+            errors[i] = scale;
+        }
+    }
+
+    // Select the coarsest level of each patch whose error is within the error allowed for it
+    for (size_t i = 0; i < count; ++i)
+    {
+        TerrainPatch* patch = _patches[i];
+        unsigned int level = (unsigned int)patch->_levels.size() - 1;
+        while (level > 0 && patch->_levels[level]->error > errors[i])
+            --level;
+        patch->_level = level;
+    }
+}
+
+void Terrain::getEdgeRatios(const TerrainPatch* patch, unsigned int* ratios) const
+{
+    GP_ASSERT(patch);
+    GP_ASSERT(ratios);
+
+    static const int offsets[4][2] = { { -1, 0 }, { 0, 1 }, { 1, 0 }, { 0, -1 } };
+    float step = patch->_levels[patch->_level]->step;
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        ratios[i] = 1;
+        int row = (int)patch->_row + offsets[i][0];
+        int column = (int)patch->_column + offsets[i][1];
+        if (row < 0 || column < 0 || row >= (int)_patchRows || column >= (int)_patchColumns)
+            continue;
+
+        // Edges are stitched to the neighbors whose vertices are on those of the patch
+        const TerrainPatch* neighbor = _patches[row * _patchColumns + column];
+        float ratio = neighbor->_levels[neighbor->_level]->step / step;
+        unsigned int r = (unsigned int)(ratio + 0.5f);
+        if (r > 1 && fabsf(ratio - r) < 0.001f)
+            ratios[i] = std::min(r, TERRAIN_MAX_STITCH_RATIO);
+    }
+}
+
+const std::vector<unsigned short>& Terrain::getIndices(const TerrainPatch::Level* level, const unsigned int* ratios)
+{
+    GP_ASSERT(level);
+    GP_ASSERT(ratios);
+
+    // Levels of the same size share their indices
+    unsigned long long key = (unsigned long long)level->width | ((unsigned long long)level->height << 20) |
+                             ((unsigned long long)(level->skirt ? 1 : 0) << 40);
+    for (unsigned int i = 0; i < 4; ++i)
+    {
+        key |= (unsigned long long)ratios[i] << (41 + i * 5);
+    }
+
+    std::map<unsigned long long, std::vector<unsigned short> >::iterator itr = _indices.find(key);
+    if (itr != _indices.end())
+        return itr->second;
+
+    std::vector<unsigned short>& indices = _indices[key];
+    buildIndices(level->width, level->height, level->skirt, ratios, indices);
+    return indices;
+}
+
+void Terrain::buildIndices(unsigned int width, unsigned int height, bool skirt, const unsigned int* ratios,
+                           std::vector<unsigned short>& indices)
+{
+    unsigned int patchWidth = skirt ? width + 2 : width;
+    unsigned int patchHeight = skirt ? height + 2 : height;
+    unsigned int indexCount = TerrainPatch::getIndexCount(width, height, skirt);
+    indices.resize(indexCount);
+
+    unsigned int index = 0;
+    for (unsigned int z = 0; z < patchHeight-1; ++z)
+    {
+        // Move left to right for even rows and right to left for odd rows.
+        // Note that this results in two degenerate triangles between rows
+        // for stitching purposes, but actually does not require any extra
+        // indices to achieve this.
+        if (z % 2 == 0)
+        {
+            if (z > 0)
+            {
+                // Add degenerate indices to connect strips
+                indices[index] = indices[index-1];
+                ++index;
+                indices[index++] = getStitchedVertex(0, z, width, height, skirt, ratios);
+            }
+
+            // Add row strip
+            for (unsigned int x = 0; x < patchWidth; ++x)
+            {
+                indices[index++] = getStitchedVertex(x, z, width, height, skirt, ratios);
+                indices[index++] = getStitchedVertex(x, z+1, width, height, skirt, ratios);
+            }
+        }
+        else
+        {
+            // Add degenerate indices to connect strips
+            if (z > 0)
+            {
+                indices[index] = indices[index-1];
+                ++index;
+                indices[index++] = getStitchedVertex(patchWidth-1, z+1, width, height, skirt, ratios);
+            }
+
+            // Add row strip
+            for (int x = (int)patchWidth-1; x >= 0; --x)
+            {
+                indices[index++] = getStitchedVertex(x, z+1, width, height, skirt, ratios);
+                indices[index++] = getStitchedVertex(x, z, width, height, skirt, ratios);
+            }
+        }
+    }
+    GP_ASSERT(index == indexCount);
+}
+
+Terrain::Streaming::Streaming()
+    : tileSize(0), rows(0), columns(0), maxStep(1), skirtScale(0.0f), spacingX(1.0f), spacingZ(1.0f),
+      budget(TERRAIN_STREAMING_BUDGET * 1024), maxResident(1), frame(0), loading(0)
+{
+}
+
+static size_t getTileSize(unsigned int tileSize, unsigned int maxStep, float skirtScale, bool normals)
+{
+    // The heights of the tile, and the vertices and indices of each of its levels
+    size_t size = (tileSize + 1) * (tileSize + 1) * sizeof(float);
+    for (unsigned int step = 1; step <= maxStep; step *= 2)
+    {
+        size_t width = tileSize / step + (tileSize % step == 0 ? 0 : 1) + 1 + (skirtScale > 0.0f ? 2 : 0);
+        size += width * width * (normals ? 8 : 5) * sizeof(float);
+        size += ((width * 2) * (width - 1) + (width - 2) * 2) * sizeof(unsigned short);
+    }
+    return size;
+}
+
+static unsigned int getStitchedVertex(unsigned int x, unsigned int z, unsigned int width, unsigned int height,
+                                      bool skirt, const unsigned int* ratios)
+{
+    // The position of the vertex in the grid of the level, without its skirt
+    unsigned int offset = skirt ? 1 : 0;
+    unsigned int gx = std::min(std::max(x, offset) - offset, width - 1);
+    unsigned int gz = std::min(std::max(z, offset) - offset, height - 1);
+
+    // Snap the vertices of the edges bordering coarser neighbors (and of their skirts) onto the vertices
+    // of the neighbors, the nearest multiples of the ratio of their steps (the last vertex of an edge is
+    // shared with the neighbor)
+    unsigned int sx = gx;
+    unsigned int sz = gz;
+    if (gz == 0 && ratios[0] > 1)
+        sx = std::min((gx + ratios[0] / 2) / ratios[0] * ratios[0], width - 1);
+    else if (gz == height - 1 && ratios[2] > 1)
+        sx = std::min((gx + ratios[2] / 2) / ratios[2] * ratios[2], width - 1);
+    if (gx == width - 1 && ratios[1] > 1)
+        sz = std::min((gz + ratios[1] / 2) / ratios[1] * ratios[1], height - 1);
+    else if (gx == 0 && ratios[3] > 1)
+        sz = std::min((gz + ratios[3] / 2) / ratios[3] * ratios[3], height - 1);
+
+    return (z + sz - gz) * (width + offset * 2) + (x + sx - gx);
+}
+
 static float getDefaultHeight(unsigned int width, unsigned int height)
 {
     // When terrain height is not specified, we'll use a default height of ~ 0.3 of the image dimensions
@@ -61,23 +61,39 @@ class TerrainAutoBindingResolver;
  * flags.
  *
  * Level of detail (LOD) is supported using a technique that is similar to texture mipmapping.
- * A distance-to-camera based test, using a simple screen-space error metric is used to decide
- * the appropriate LOD for a terrain patch. The number of LOD levels is 1 by default (which
- * means only the base level is used), but can be specified via the detailLevels property.
- * Using too large a number for detailLevels can result in excessive popping in the distance
- * for very hilly terrains, so a smaller number (2-3) often works best in these cases.
+ * Each LOD of a patch records its geometric error (the largest vertical distance between the
+ * heights of the patch and the surface of the LOD) and each patch is drawn at the coarsest LOD
+ * whose error, projected to the screen at the distance of the patch from the camera, is no larger
+ * than the pixel error of the terrain (see setPixelError). The number of LOD levels is 1 by default
+ * (which means only the base level is used), but can be specified via the detailLevels property.
  *
- * Finally, when LOD is enabled, cracks can begin to appear between terrain patches of
- * different LOD levels. If the cracks are only minor (depends on your terrain topology
- * and textures used), an acceptable approach might be to simply use a background clear
- * color that closely matches your terrain to make the cracks much less visible. However,
- * often that is not acceptable, so the Terrain class also supports a simple solution called
- * "vertical skirts". When enabled (via the skirtScale parameter in the terrain file), a vertical
- * edge will extend down along the sides of all terrain patches, which fills in the crack.
- * This is a very fast approach as it adds only a small number of triangles per patch and requires
- * zero extra CPU time or draw calls, which are often needed for more complex stitching
- * approaches. In practice, the skirts are often not noticeable at all unless the LOD variation
- * is very large and the terrain is excessively hilly on the edge of a LOD transition.
+ * When LOD is enabled, cracks would appear between terrain patches of different LOD levels. The
+ * edges of a patch that border a coarser patch are stitched to it, by snapping the vertices of the
+ * edge onto those of the coarser patch. Stitching needs no extra vertices or draw calls, but it can
+ * only close the cracks between patches built from the same heights, so "vertical skirts" are also
+ * supported. When enabled (via the skirtScale parameter in the terrain file), a vertical edge will
+ * extend down along the sides of all terrain patches, which fills in any remaining crack (such as
+ * those between the resident and the coarse patches of a streaming terrain).
+ *
+ * The LODs of neighboring patches share vertex buffers and the visible patches at the same LOD are
+ * drawn with a single draw call, unless their materials differ (for layers that apply to specific
+ * patches, or when the DEBUG_PATCHES flag is set).
+ *
+ * Terrains too large to keep in memory can be streamed, by adding a streaming section to the
+ * terrain file. The heightfield of a streaming terrain is split into square tiles of RAW
+ * heights on disk (as exported by many terrain tools), each of which holds the heights of
+ * one terrain patch, including the edge it shares with its neighbors. Only the tiles nearest
+ * to the scene's active camera that fit in the memory budget are resident; their heights are
+ * read and their geometry built on the game's worker pool and the tiles farthest from the
+ * camera are evicted to make room for new ones. The heightmap of a streaming terrain is a
+ * coarse heightmap of the entire terrain, from which the patches that are not resident are
+ * drawn and which answers getHeight queries (and defines the physics heightfield) for them.
+ *
+ * The texture coordinates of a streaming terrain span each tile rather than the entire
+ * terrain, so its normal map and layer blend maps are given per tile, as paths containing
+ * {row} and {column} placeholders, and are loaded in the background with their tile. The
+ * repeat counts of layer textures are relative to a tile. Patches that are not resident are
+ * drawn with vertex normals and with the layers that have no per tile blend map.
  *
  * @see http://gameplay3d.github.io/GamePlay/docs/file-formats.html#wiki-Terrain
  */
@@ -201,6 +217,37 @@ public:
      */
     TerrainPatch* getPatch(unsigned int index) const;
 
+    /**
+     * Determines if this terrain streams its tiles from disk.
+     *
+     * @return true if the terrain is streaming, false if all of its patches are resident.
+     */
+    bool isStreaming() const;
+
+    /**
+     * Gets the number of patches whose tiles are resident.
+     *
+     * @return The number of resident patches (all patches for a terrain that is not streaming).
+     */
+    unsigned int getResidentPatchCount() const;
+
+    /**
+     * Sets the largest screen-space error allowed when selecting the level of detail of patches.
+     *
+     * Larger values draw patches at coarser levels of detail, closer to the camera. The default
+     * is 4 pixels, or the pixelError property of the terrain file.
+     *
+     * @param pixelError The screen-space error, in pixels.
+     */
+    void setPixelError(float pixelError);
+
+    /**
+     * Gets the largest screen-space error allowed when selecting the level of detail of patches.
+     *
+     * @return The screen-space error, in pixels.
+     */
+    float getPixelError() const;
+
     /**
      * Gets the local bounding box for this terrain.
      *
@@ -267,6 +314,13 @@ public:
      */
     unsigned int draw(bool wireframe = false);
 
+    /**
+     * @see Drawable::enqueue
+     *
+     * Terrain is opaque, so it is added with the opaque geometry.
+     */
+    void enqueue(RenderQueue* queue);
+
 protected:
 
     /**
@@ -281,6 +335,48 @@ protected:
 
 private:
 
+    /**
+     * A layer whose blend map is given per tile of a streaming terrain.
+     */
+    struct TileLayer
+    {
+        int index;
+        std::string texturePath;
+        Vector2 textureRepeat;
+        std::string blendPath;
+        int blendChannel;
+        int row;
+        int column;
+    };
+
+    /**
+     * The tiles of a streaming terrain and their loading state.
+     */
+    struct Streaming
+    {
+        Streaming();
+
+        std::string tilePath;
+        std::string normalMapPath;
+        unsigned int tileSize;
+        unsigned int rows;
+        unsigned int columns;
+        unsigned int maxStep;
+        float skirtScale;
+        float spacingX;
+        float spacingZ;
+        size_t budget;
+        unsigned int maxResident;
+        unsigned int frame;
+        std::vector<TileLayer> layers;
+        std::vector<TerrainPatch*> order;
+        std::vector<TerrainPatch*> finishing;
+        std::vector<TerrainPatch*> ready;
+        std::mutex readyMutex;
+        std::condition_variable loaded;
+        unsigned int loading;
+    };
+
     /**
      * Constructor.
      */
@@ -306,7 +402,53 @@ private:
      */
     static Terrain* create(HeightField* heightfield, const Vector3& scale, 
         unsigned int patchSize, unsigned int detailLevels, float skirtScale, 
-        const char* normalMapPath, const char* materialPath, Properties* properties);
+        const char* normalMapPath, const char* materialPath, Properties* properties, Streaming* streaming);
+
+    /**
+     * Reads the streaming section of a terrain definition.
+     */
+    static Streaming* createStreaming(Properties* properties, HeightField* heightfield);
+
+    /**
+     * Gets the path of the file of a tile, replacing the {row} and {column} placeholders of a path.
+     */
+    static std::string getTilePath(const std::string& path, unsigned int row, unsigned int column);
+
+    /**
+     * Loads the tiles nearest to the camera and evicts the farthest ones (called once per frame).
+     */
+    void updateStreaming(Camera* camera);
+
+    /**
+     * Orders patches by their distance to the camera.
+     */
+    static bool compareDistance(const TerrainPatch* lhs, const TerrainPatch* rhs);
+
+    /**
+     * Creates the meshes of the levels of the patches, shared by neighboring patches.
+     */
+    void createBatches();
+
+    /**
+     * Culls the patches outside of the view frustum and selects the level of each patch.
+     */
+    void computeLevels(Camera* camera);
+
+    /**
+     * Gets the ratio of the step of each coarser neighbor of a patch to its own, by edge (north, east, south, west).
+     */
+    void getEdgeRatios(const TerrainPatch* patch, unsigned int* ratios) const;
+
+    /**
+     * Gets the strip indices of a level, with its edges stitched to its neighbors.
+     */
+    const std::vector<unsigned short>& getIndices(const TerrainPatch::Level* level, const unsigned int* ratios);
+
+    /**
+     * Builds the strip indices of a level, with its edges stitched to its neighbors.
+     */
+    static void buildIndices(unsigned int width, unsigned int height, bool skirt, const unsigned int* ratios,
+                             std::vector<unsigned short>& indices);
 
     /**
      * Internal method for creating terrain.
@@ -329,6 +471,11 @@ private:
      */
     BoundingBox getBoundingBox(bool worldSpace) const;
 
+    /**
+     * Returns the scale of the heightfield samples, used for the physics heightfield.
+     */
+    Vector3 getHeightfieldScale() const;
+
     std::string _materialPath;
     HeightField* _heightfield;
     Vector3 _localScale;
@@ -338,6 +485,17 @@ private:
     mutable Matrix _inverseWorldMatrix;
     mutable unsigned int _dirtyFlags;
     BoundingBox _boundingBox;
+    Streaming* _streaming;
+    float _pixelError;
+    unsigned int _patchRows;
+    unsigned int _patchColumns;
+    bool _patchLayers;
+    unsigned int _drawStamp;
+    std::vector<float> _patchBounds;
+    std::vector<float> _patchErrors;
+    std::vector<unsigned char> _patchVisible;
+    std::vector<TerrainPatch::Batch*> _batches;
+    std::map<unsigned long long, std::vector<unsigned short> > _indices;
 };
 
 }
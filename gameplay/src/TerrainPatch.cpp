@@ -15,8 +15,7 @@ template <class T> T clamp(T value, T min, T max) { return value < min ? min : (
 
 #define TERRAINPATCH_DIRTY_MATERIAL 1
 #define TERRAINPATCH_DIRTY_BOUNDS 2
-#define TERRAINPATCH_DIRTY_LEVEL 4
-#define TERRAINPATCH_DIRTY_ALL (TERRAINPATCH_DIRTY_MATERIAL | TERRAINPATCH_DIRTY_BOUNDS | TERRAINPATCH_DIRTY_LEVEL)
+#define TERRAINPATCH_DIRTY_ALL (TERRAINPATCH_DIRTY_MATERIAL | TERRAINPATCH_DIRTY_BOUNDS)
 
 /**
  * Custom material auto-binding resolver for terrain.
@@ -30,7 +29,8 @@ static TerrainAutoBindingResolver __autoBindingResolver;
 static int __currentPatchIndex = -1;
 
 TerrainPatch::TerrainPatch() :
-    _terrain(NULL), _row(0), _column(0), _camera(NULL), _level(0), _bits(TERRAINPATCH_DIRTY_ALL)
+    _terrain(NULL), _row(0), _column(0), _level(0), _bits(TERRAINPATCH_DIRTY_ALL), _indexStart(0), _indexCount(0),
+    _coarseLevel(NULL), _tileState(TILE_COARSE), _heights(NULL), _normalMap(NULL), _loadedHeights(NULL), _distance(0.0f)
 {
 }
 
@@ -39,20 +39,28 @@ TerrainPatch::~TerrainPatch()
     for (size_t i = 0, count = _levels.size(); i < count; ++i)
     {
         Level* level = _levels[i];
+        if (level == _coarseLevel)
+            continue;
 
-        SAFE_RELEASE(level->model);
         SAFE_DELETE(level);
     }
+    SAFE_DELETE(_coarseLevel);
 
-    while (_layers.size() > 0)
+    for (size_t i = 0, count = _levelData.size(); i < count; ++i)
     {
-        deleteLayer(*_layers.begin());
+        SAFE_DELETE(_levelData[i]);
+    }
+    for (size_t i = 0, count = _requests.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_requests[i]);
     }
-    
-    if (_camera != NULL)
+    SAFE_RELEASE(_loadedHeights);
+    SAFE_RELEASE(_heights);
+    SAFE_RELEASE(_normalMap);
+
+    while (_layers.size() > 0)
     {
-    	_camera->removeListener(this);
-    	SAFE_RELEASE(_camera);
+        deleteLayer(*_layers.begin());
     }
 }
 
@@ -70,15 +78,60 @@ TerrainPatch* TerrainPatch::create(Terrain* terrain, unsigned int index,
     patch->_row = row;
     patch->_column = column;
 
-    // Add patch lods
+    // Build the patch lods. Their meshes are created when the terrain batches the lods of its patches.
     for (unsigned int step = 1; step <= maxStep; step *= 2)
     {
-        patch->addLOD(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, step, verticalSkirtSize);
+        LevelData* data = patch->buildLOD(heights, width, height, x1, z1, x2, z2, xOffset, zOffset, 1.0f, step,
+                                          verticalSkirtSize, terrain->_normalMap == NULL);
+        if (data)
+            patch->_levelData.push_back(data);
+        // else ignore this level, not enough geometry
     }
+    GP_ASSERT(!patch->_levelData.empty());
 
-    // Set our bounding box using the base LOD mesh
+    // Set our bounding box using the base LOD
     BoundingBox& bounds = patch->_boundingBox;
-    bounds.set(patch->_levels[0]->model->getMesh()->getBoundingBox());
+    bounds.set(patch->_levelData[0]->bounds);
+
+    return patch;
+}
+
+TerrainPatch* TerrainPatch::create(Terrain* terrain, unsigned int index, unsigned int row, unsigned int column,
+                                   float xOffset, float zOffset, float verticalSkirtSize)
+{
+    GP_ASSERT(terrain && terrain->_streaming);
+
+    // Create patch
+    TerrainPatch* patch = new TerrainPatch();
+    patch->_terrain = terrain;
+    patch->_index = index;
+    patch->_row = row;
+    patch->_column = column;
+
+    // Sample the coarse heightfield over the tile, at the resolution of the coarse heightfield
+    const Terrain::Streaming* streaming = terrain->_streaming;
+    unsigned int tileSize = streaming->tileSize;
+    unsigned int resolution = clamp((unsigned int)(tileSize / std::max(streaming->spacingX, streaming->spacingZ)), 1u, tileSize);
+    float spacing = (float)tileSize / resolution;
+    unsigned int size = resolution + 1;
+    std::vector<float> heights(size * size);
+    for (unsigned int z = 0; z < size; ++z)
+    {
+        for (unsigned int x = 0; x < size; ++x)
+        {
+            heights[z * size + x] = terrain->_heightfield->getHeight((column * tileSize + x * spacing) / streaming->spacingX,
+                                                                     (row * tileSize + z * spacing) / streaming->spacingZ);
+        }
+    }
+
+    // The coarse level is drawn with vertex normals until the tile is loaded
+    LevelData* data = patch->buildLOD(&heights[0], size, size, 0, 0, resolution, resolution, xOffset, zOffset, spacing, 1, verticalSkirtSize, true);
+    GP_ASSERT(data);
+    patch->_coarseLevel = patch->createLOD(data);
+    patch->_levels.push_back(patch->_coarseLevel);
+    SAFE_DELETE(data);
+
+    patch->_boundingBox.set(patch->_coarseLevel->bounds);
 
     return patch;
 }
@@ -91,26 +144,14 @@ unsigned int TerrainPatch::getMaterialCount() const
 Material* TerrainPatch::getMaterial(int index) const
 {
     if (index == -1)
-    {
-        Scene* scene = _terrain->_node ? _terrain->_node->getScene() : NULL;
-        Camera* camera = scene ? scene->getActiveCamera() : NULL;
-        if (!camera)
-        {
-            _level = const_cast<TerrainPatch*>(this)->computeLOD(camera, getBoundingBox(true));
-        }
-        else
-        {
-            _level = 0;
-        }
         return _levels[_level]->model->getMaterial();
-    }
     return _levels[index]->model->getMaterial();
 }
 
-void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int height,
-                          unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
-                          float xOffset, float zOffset,
-                          unsigned int step, float verticalSkirtSize)
+TerrainPatch::LevelData* TerrainPatch::buildLOD(const float* heights, unsigned int width, unsigned int height,
+                                                unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
+                                                float xOffset, float zOffset, float spacing,
+                                                unsigned int step, float verticalSkirtSize, bool hasNormals) const
 {
     // Allocate vertex data for this patch
     unsigned int patchWidth;
@@ -127,7 +168,36 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
     }
 
     if (patchWidth < 2 || patchHeight < 2)
-        return; // ignore this level, not enough geometry
+        return NULL; // not enough geometry for this level
+
+    // The level's geometric error: the largest vertical distance between the heights and the surface of the level.
+    float error = 0.0f;
+    if (step > 1)
+    {
+        for (unsigned int z = z1; z <= z2; ++z)
+        {
+            unsigned int za = z1 + (z - z1) / step * step;
+            unsigned int zb = std::min(za + step, z2);
+            float tz = zb > za ? (float)(z - za) / (zb - za) : 0.0f;
+            for (unsigned int x = x1; x <= x2; ++x)
+            {
+                unsigned int xa = x1 + (x - x1) / step * step;
+                unsigned int xb = std::min(xa + step, x2);
+                float tx = xb > xa ? (float)(x - xa) / (xb - xa) : 0.0f;
+                float h = (computeHeight(heights, width, xa, za) * (1.0f - tx) + computeHeight(heights, width, xb, za) * tx) * (1.0f - tz) +
+                          (computeHeight(heights, width, xa, zb) * (1.0f - tx) + computeHeight(heights, width, xb, zb) * tx) * tz;
+                error = std::max(error, fabsf(computeHeight(heights, width, x, z) - h));
+            }
+        }
+    }
+
+    LevelData* data = new LevelData();
+    data->width = patchWidth;
+    data->height = patchHeight;
+    data->skirt = verticalSkirtSize > 0.0f;
+    data->normals = hasNormals;
+    data->step = step * spacing;
+    data->error = error;
 
     if (verticalSkirtSize > 0.0f)
     {
@@ -135,14 +205,22 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
         patchHeight += 2;
     }
 
+    // Support a maximum number of vertices of USHRT_MAX + 1, since patches are drawn with 16-bit indices.
+    // Any more vertices will require breaking up the terrain into smaller patches.
     unsigned int vertexCount = patchHeight * patchWidth;
-    unsigned int vertexElements = _terrain->_normalMap ? 5 : 8; //<x,y,z>[i,j,k]<u,v>
+    if (vertexCount > USHRT_MAX + 1)
+    {
+        GP_WARN("Vertex count of %d for terrain patch exceeds the limit of 65536. Please specifiy a smaller patch size.", vertexCount);
+        GP_ASSERT(vertexCount <= USHRT_MAX + 1);
+    }
+
+    unsigned int vertexElements = hasNormals ? 8 : 5; //<x,y,z>[i,j,k]<u,v>
     float* vertices = new float[vertexCount * vertexElements];
     unsigned int index = 0;
     Vector3 min(FLT_MAX, FLT_MAX, FLT_MAX);
     Vector3 max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-    float stepXScaled = step * _terrain->_localScale.x;
-    float stepZScaled = step * _terrain->_localScale.z;
+    float stepXScaled = step * spacing * _terrain->_localScale.x;
+    float stepZScaled = step * spacing * _terrain->_localScale.z;
     bool zskirt = verticalSkirtSize > 0 ? true : false;
     for (unsigned int z = z1; ; )
     {
@@ -155,11 +233,11 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
             index++;
 
             // Compute position - apply the local scale of the terrain into the vertex data
-            v[0] = (x + xOffset) * _terrain->_localScale.x;
+            v[0] = (x * spacing + xOffset) * _terrain->_localScale.x;
             v[1] = computeHeight(heights, width, x, z);
             if (xskirt || zskirt)
                 v[1] -= verticalSkirtSize * _terrain->_localScale.y;
-            v[2] = (z + zOffset) * _terrain->_localScale.z;
+            v[2] = (z * spacing + zOffset) * _terrain->_localScale.z;
 
             // Update bounding box min/max (don't include vertical skirt vertices in bounding box)
             if (!(xskirt || zskirt))
@@ -179,7 +257,7 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
             }
 
             // Compute normal
-            if (!_terrain->_normalMap)
+            if (hasNormals)
             {
                 Vector3 p(v[0], computeHeight(heights, width, x, z), v[2]);
                 Vector3 w(Vector3(x>=step ? v[0]-stepXScaled : v[0], computeHeight(heights, width, x>=step ? x-step : x, z), v[2]), p);
@@ -250,12 +328,51 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
     }
     GP_ASSERT(index == vertexCount);
 
-    Vector3 center(min + ((max - min) * 0.5f));
+    data->vertices = vertices;
+    data->vertexCount = vertexCount;
+    data->bounds.set(min, max);
+    return data;
+}
+
+TerrainPatch::Level* TerrainPatch::createLOD(LevelData* data)
+{
+    GP_ASSERT(data);
+
+    // The level is drawn from a batch of its own
+    Batch* batch = createBatch(&data, 1);
+    Level* level = createLOD(data, batch, 0);
+    batch->release();
+    return level;
+}
+
+TerrainPatch::Level* TerrainPatch::createLOD(LevelData* data, Batch* batch, unsigned int baseVertex)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(batch);
+
+    // Create model
+    Level* level = new Level();
+    level->model = Model::create(batch->mesh);
+    level->batch = batch;
+    batch->addRef();
+    level->baseVertex = baseVertex;
+    level->width = data->width;
+    level->height = data->height;
+    level->skirt = data->skirt;
+    level->step = data->step;
+    level->error = data->error;
+    level->bounds.set(data->bounds);
+    return level;
+}
+
+TerrainPatch::Batch* TerrainPatch::createBatch(LevelData** data, unsigned int count)
+{
+    GP_ASSERT(data && count > 0);
 
     // Create mesh
     VertexFormat::Element elements[3];
     elements[0] = VertexFormat::Element(VertexFormat::POSITION, 3);
-    if (_terrain->_normalMap)
+    if (!data[0]->normals)
     {
         elements[1] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
     }
@@ -264,87 +381,221 @@ void TerrainPatch::addLOD(float* heights, unsigned int width, unsigned int heigh
         elements[1] = VertexFormat::Element(VertexFormat::NORMAL, 3);
         elements[2] = VertexFormat::Element(VertexFormat::TEXCOORD0, 2);
     }
-    VertexFormat format(elements, _terrain->_normalMap ? 2 : 3);
-    Mesh* mesh = Mesh::createMesh(format, vertexCount);
-    mesh->setVertexData(vertices);
-    mesh->setBoundingBox(BoundingBox(min, max));
-    mesh->setBoundingSphere(BoundingSphere(center, center.distance(max)));
+    VertexFormat format(elements, data[0]->normals ? 3 : 2);
 
-    // Add mesh part for indices
-    unsigned int indexCount =
-        (patchWidth * 2) *      // # indices per row of tris
-        (patchHeight - 1) +     // # rows of tris
-        (patchHeight-2) * 2;    // # degenerate tris
+    unsigned int vertexCount = 0;
+    unsigned int indexCount = 0;
+    BoundingBox bounds;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        GP_ASSERT(data[i]->normals == data[0]->normals);
+        vertexCount += data[i]->vertexCount;
+        indexCount += getIndexCount(data[i]->width, data[i]->height, data[i]->skirt) + 2;
+        bounds.merge(data[i]->bounds);
+    }
+    GP_ASSERT(vertexCount <= USHRT_MAX + 1);
 
-    // Support a maximum number of indices of USHRT_MAX. Any more indices we will require breaking up the
-    // terrain into smaller patches.
-    if (indexCount > USHRT_MAX)
+    Mesh* mesh = Mesh::createMesh(format, vertexCount);
+    unsigned int vertexStart = 0;
+    for (unsigned int i = 0; i < count; ++i)
     {
-        GP_WARN("Index count of %d for terrain patch exceeds the limit of 65535. Please specifiy a smaller patch size.", indexCount);
-        GP_ASSERT(indexCount <= USHRT_MAX);
+        mesh->setVertexData(data[i]->vertices, vertexStart, data[i]->vertexCount);
+        vertexStart += data[i]->vertexCount;
     }
+    Vector3 center(bounds.getCenter());
+    mesh->setBoundingBox(bounds);
+    mesh->setBoundingSphere(BoundingSphere(center, center.distance(bounds.max)));
+
+    Batch* batch = new Batch(mesh, indexCount);
+    mesh->release();
+    return batch;
+}
 
-    MeshPart* part = mesh->addPart(Mesh::TRIANGLE_STRIP, Mesh::INDEX16, indexCount);
-    unsigned short* indices = new unsigned short[indexCount];
-    index = 0;
-    for (unsigned int z = 0; z < patchHeight-1; ++z)
+unsigned int TerrainPatch::getIndexCount(unsigned int width, unsigned int height, bool skirt)
+{
+    if (skirt)
     {
-        unsigned int i1 = z * patchWidth;
-        unsigned int i2 = (z+1) * patchWidth;
+        width += 2;
+        height += 2;
+    }
+    return (width * 2) *        // # indices per row of tris
+           (height - 1) +       // # rows of tris
+           (height - 2) * 2;    // # degenerate tris
+}
+
+void TerrainPatch::requestTile()
+{
+    Terrain::Streaming* streaming = _terrain->_streaming;
+    GP_ASSERT(streaming);
+    GP_ASSERT(_tileState == TILE_COARSE);
 
-        // Move left to right for even rows and right to left for odd rows.
-        // Note that this results in two degenerate triangles between rows
-        // for stitching purposes, but actually does not require any extra
-        // indices to achieve this.
-        if (z % 2 == 0)
+    // Load the textures of the tile in the background while its heights are read
+    ResourceLoader* loader = Game::getInstance()->getResourceLoader();
+    if (!streaming->normalMapPath.empty())
+    {
+        std::string path = Terrain::getTilePath(streaming->normalMapPath, _row, _column);
+        _requests.push_back(loader->loadTexture(path.c_str(), true));
+    }
+    for (size_t i = 0, count = streaming->layers.size(); i < count; ++i)
+    {
+        const Terrain::TileLayer& layer = streaming->layers[i];
+        if ((layer.row == -1 || (int)_row == layer.row) && (layer.column == -1 || (int)_column == layer.column))
         {
-            if (z > 0)
-            {
-                // Add degenerate indices to connect strips
-                indices[index] = indices[index-1];
-                ++index;
-                indices[index++] = i1;
-            }
+            std::string path = Terrain::getTilePath(layer.blendPath, _row, _column);
+            _requests.push_back(loader->loadTexture(path.c_str(), true));
+        }
+    }
 
-            // Add row strip
-            for (unsigned int x = 0; x < patchWidth; ++x)
-            {
-                indices[index++] = i1 + x;
-                indices[index++] = i2 + x;
-            }
+    _tileState = TILE_LOADING;
+    streaming->readyMutex.lock();
+    streaming->loading++;
+    streaming->readyMutex.unlock();
+    Game::getInstance()->getWorkerPool()->submit(std::bind(&TerrainPatch::loadTile, this));
+}
+
+void TerrainPatch::loadTile()
+{
+    Terrain::Streaming* streaming = _terrain->_streaming;
+    GP_ASSERT(streaming);
+
+    // Read the heights of the tile and build its levels
+    unsigned int size = streaming->tileSize + 1;
+    std::string path = Terrain::getTilePath(streaming->tilePath, _row, _column);
+    _loadedHeights = HeightField::createFromRAW(path.c_str(), size, size, 0, 1);
+    if (_loadedHeights)
+    {
+        float xOffset = _column * streaming->tileSize - streaming->columns * streaming->tileSize * 0.5f;
+        float zOffset = _row * streaming->tileSize - streaming->rows * streaming->tileSize * 0.5f;
+        for (unsigned int step = 1; step <= streaming->maxStep; step *= 2)
+        {
+            LevelData* data = buildLOD(_loadedHeights->getArray(), size, size, 0, 0, size - 1, size - 1,
+                                       xOffset, zOffset, 1.0f, step, streaming->skirtScale, streaming->normalMapPath.empty());
+            if (data)
+                _levelData.push_back(data);
         }
+    }
+
+    // Notify while holding the lock, since the terrain (and the condition) may be destroyed once it is released.
+    streaming->readyMutex.lock();
+    streaming->ready.push_back(this);
+    if (--streaming->loading == 0)
+        streaming->loaded.notify_all();
+    streaming->readyMutex.unlock();
+}
+
+bool TerrainPatch::isTileLoaded() const
+{
+    for (size_t i = 0, count = _requests.size(); i < count; ++i)
+    {
+        if (!_requests[i]->isDone())
+            return false;
+    }
+    return true;
+}
+
+void TerrainPatch::finishTile()
+{
+    Terrain::Streaming* streaming = _terrain->_streaming;
+    GP_ASSERT(streaming);
+    GP_ASSERT(_tileState == TILE_LOADING);
+
+    bool loaded = _loadedHeights && !_levelData.empty();
+    for (size_t i = 0, count = _requests.size(); i < count; ++i)
+    {
+        if (_requests[i]->getState() != ResourceLoader::Request::LOADED)
+            loaded = false;
+    }
+
+    if (loaded && !streaming->normalMapPath.empty())
+    {
+        // The textures are in the texture cache
+        std::string path = Terrain::getTilePath(streaming->normalMapPath, _row, _column);
+        _normalMap = Texture::Sampler::create(path.c_str(), true);
+        if (_normalMap)
+            _normalMap->setWrapMode(Texture::CLAMP, Texture::CLAMP);
         else
+            loaded = false;
+    }
+
+    if (loaded)
+    {
+        // Replace the coarse level with the levels of the tile
+        _levels.clear();
+        for (size_t i = 0, count = _levelData.size(); i < count; ++i)
         {
-            // Add degenerate indices to connect strips
-            if (z > 0)
+            _levels.push_back(createLOD(_levelData[i]));
+        }
+        _heights = _loadedHeights;
+        _loadedHeights = NULL;
+
+        for (size_t i = 0, count = streaming->layers.size(); i < count; ++i)
+        {
+            const Terrain::TileLayer& layer = streaming->layers[i];
+            if ((layer.row == -1 || (int)_row == layer.row) && (layer.column == -1 || (int)_column == layer.column))
             {
-                indices[index] = indices[index-1];
-                ++index;
-                indices[index++] = i2 + ((int)patchWidth-1);
+                std::string blendPath = Terrain::getTilePath(layer.blendPath, _row, _column);
+                if (!setLayer(layer.index, layer.texturePath.c_str(), layer.textureRepeat, blendPath.c_str(), layer.blendChannel))
+                    GP_WARN("Failed to load terrain layer: %s", layer.texturePath.c_str());
             }
+        }
 
-            // Add row strip
-            for (int x = (int)patchWidth-1; x >= 0; --x)
+        _boundingBox.set(_levels[0]->bounds);
+        _bits |= TERRAINPATCH_DIRTY_ALL;
+        _level = 0;
+        _tileState = TILE_RESIDENT;
+    }
+    else
+    {
+        GP_WARN("Failed to load the tile of terrain patch at row %u, column %u.", _row, _column);
+        SAFE_RELEASE(_loadedHeights);
+        _tileState = TILE_FAILED;
+    }
+
+    for (size_t i = 0, count = _levelData.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_levelData[i]);
+    }
+    _levelData.clear();
+    for (size_t i = 0, count = _requests.size(); i < count; ++i)
+    {
+        SAFE_RELEASE(_requests[i]);
+    }
+    _requests.clear();
+}
+
+void TerrainPatch::evictTile()
+{
+    Terrain::Streaming* streaming = _terrain->_streaming;
+    GP_ASSERT(streaming);
+    GP_ASSERT(_tileState == TILE_RESIDENT);
+
+    // Remove the layers with a blend map per tile
+    for (size_t i = 0, count = streaming->layers.size(); i < count; ++i)
+    {
+        for (std::set<Layer*, LayerCompare>::iterator itr = _layers.begin(); itr != _layers.end(); ++itr)
+        {
+            if ((*itr)->index == streaming->layers[i].index)
             {
-                indices[index++] = i2 + x;
-                indices[index++] = i1 + x;
+                deleteLayer(*itr);
+                break;
             }
         }
     }
-    GP_ASSERT(index == indexCount);
-    part->setIndexData(indices, 0, indexCount);
-
-    SAFE_DELETE_ARRAY(vertices);
-    SAFE_DELETE_ARRAY(indices);
+    SAFE_RELEASE(_normalMap);
+    SAFE_RELEASE(_heights);
 
-    // Create model
-    Model* model = Model::create(mesh);
-    mesh->release();
+    // Draw the patch from the coarse level again
+    for (size_t i = 0, count = _levels.size(); i < count; ++i)
+    {
+        SAFE_DELETE(_levels[i]);
+    }
+    _levels.clear();
+    _levels.push_back(_coarseLevel);
 
-    // Add this level
-    Level* level = new Level();
-    level->model = model;
-    _levels.push_back(level);
+    _boundingBox.set(_coarseLevel->bounds);
+    _bits |= TERRAINPATCH_DIRTY_ALL;
+    _level = 0;
+    _tileState = TILE_COARSE;
 }
 
 void TerrainPatch::deleteLayer(Layer* layer)
@@ -374,6 +625,10 @@ void TerrainPatch::deleteLayer(Layer* layer)
         }
     }
 
+    // Drop the samplers released at the end of the list, so that they are not bound
+    while (!_samplers.empty() && _samplers.back() == NULL)
+        _samplers.pop_back();
+
     _layers.erase(layer);
     SAFE_DELETE(layer);
 }
@@ -405,7 +660,7 @@ int TerrainPatch::addSampler(const char* path)
         {
             firstAvailableIndex = (int)i;
         }
-        else if (sampler->getTexture() == texture)
+        else if (sampler && sampler->getTexture() == texture)
         {
             // A sampler was already added for this texture.
             // Increase the ref count for the sampler to indicate that a new
@@ -499,7 +754,7 @@ std::string TerrainPatch::passCreated(Pass* pass)
         pass->getParameter("u_column")->setFloat(_column);
     }
 
-    if (_terrain->_normalMap)
+    if (_terrain->_normalMap || _normalMap)
         defines << ";NORMAL_MAP";
 
     // Append texture and blend index constants to preprocessor definition.
@@ -570,28 +825,38 @@ void TerrainPatch::updateNodeBindings()
     __currentPatchIndex = -1;
 }
 
-unsigned int TerrainPatch::draw(bool wireframe)
+unsigned int TerrainPatch::draw(unsigned int indexStart, unsigned int indexCount, bool wireframe)
 {
-    Scene* scene = _terrain->_node ? _terrain->_node->getScene() : NULL;
-    Camera* camera = scene ? scene->getActiveCamera() : NULL;
-    if (!camera)
-        return 0;
-
-    // Get our world-space bounding box
-    BoundingBox bounds = getBoundingBox(true);
-
-    // If the box does not intersect the view frustum, cull it
-    if (_terrain->isFlagSet(Terrain::FRUSTUM_CULLING) && !camera->getFrustum().intersects(bounds))
+    // Draw a range of the indices of the batch of the current LOD, with the material of this patch
+    Level* level = _levels[_level];
+    GP_ASSERT(level->batch);
+    Material* material = level->model->getMaterial();
+    if (!material || indexCount == 0)
         return 0;
 
-    if (!updateMaterial())
-        return 0;
-
-    // Compute the LOD level from the camera's perspective
-    _level = computeLOD(camera, bounds);
-
-    // Draw the model for the current LOD
-    return _levels[_level]->model->draw(wireframe);
+    Technique* technique = material->getTechnique();
+    GP_ASSERT(technique);
+    for (unsigned int i = 0, passCount = technique->getPassCount(); i < passCount; ++i)
+    {
+        Pass* pass = technique->getPassByIndex(i);
+        GP_ASSERT(pass);
+        pass->bind();
+        GL_ASSERT( glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, level->batch->part->getIndexBuffer()) );
+        if (wireframe)
+        {
+            // Outline each triangle of the strip (as Model does for its wireframe).
+            for (unsigned int j = 2; j < indexCount; ++j)
+            {
+                GL_ASSERT( glDrawElements(GL_LINE_LOOP, 3, GL_UNSIGNED_SHORT, ((const GLvoid*)((indexStart + j - 2) * sizeof(unsigned short)))) );
+            }
+        }
+        else
+        {
+            GL_ASSERT( glDrawElements(GL_TRIANGLE_STRIP, indexCount, GL_UNSIGNED_SHORT, ((const GLvoid*)(indexStart * sizeof(unsigned short)))) );
+        }
+        pass->unbind();
+    }
+    return 1;
 }
 
 const BoundingBox& TerrainPatch::getBoundingBox(bool worldSpace) const
@@ -614,70 +879,6 @@ const BoundingBox& TerrainPatch::getBoundingBox(bool worldSpace) const
     return _boundingBoxWorld;
 }
 
-void TerrainPatch::cameraChanged(Camera* camera)
-{
-    _bits |= TERRAINPATCH_DIRTY_LEVEL;
-}
-
-unsigned int TerrainPatch::computeLOD(Camera* camera, const BoundingBox& worldBounds) 
-{
-    if (camera != _camera)
-    {
-        if (_camera != NULL)
-        {
-            _camera->removeListener(this);
-            _camera->release();
-        }
-        _camera = camera;
-        _camera->addRef();
-        _camera->addListener(this);
-        _bits |= TERRAINPATCH_DIRTY_LEVEL;
-    }
-
-    // base level
-    if (!_terrain->isFlagSet(Terrain::LEVEL_OF_DETAIL) || _levels.size() == 0)
-        return 0;
-
-    if (!(_bits & TERRAINPATCH_DIRTY_LEVEL))
-        return _level;
-
-    _bits &= ~TERRAINPATCH_DIRTY_LEVEL;
-
-    // Compute LOD to use based on very simple distance metric. TODO: Optimize me.
-    Game* game = Game::getInstance();
-    Rectangle vp(0, 0, game->getWidth(), game->getHeight());
-    Vector3 corners[8];
-    Vector2 min(FLT_MAX, FLT_MAX);
-    Vector2 max(-FLT_MAX, -FLT_MAX);
-    worldBounds.getCorners(corners);
-    for (unsigned int i = 0; i < 8; ++i)
-    {
-        const Vector3& corner = corners[i];
-        float x, y;
-        camera->project(vp, corners[i], &x, &y);
-        if (x < min.x)
-            min.x = x;
-        if (y < min.y)
-            min.y = y;
-        if (x > max.x)
-            max.x = x;
-        if (y > max.y)
-            max.y = y;
-    }
-    float area = (max.x - min.x) * (max.y - min.y);
-    float screenArea = game->getWidth() * game->getHeight() / 10.0f;
-    float error = screenArea / area;
-
-    // Level LOD based on distance from camera
-    size_t maxLod = _levels.size()-1;
-    size_t lod = (size_t)error;
-    lod = std::max(lod, (size_t)0);
-    lod = std::min(lod, maxLod);
-    _level = lod;
-
-    return _level;
-}
-
 const Vector3& TerrainPatch::getAmbientColor() const
 {
     Scene* scene = _terrain->_node ? _terrain->_node->getScene() : NULL;
@@ -689,7 +890,12 @@ void TerrainPatch::setMaterialDirty()
     _bits |= TERRAINPATCH_DIRTY_MATERIAL;
 }
 
-float TerrainPatch::computeHeight(float* heights, unsigned int width, unsigned int x, unsigned int z)
+void TerrainPatch::setBoundsDirty()
+{
+    _bits |= TERRAINPATCH_DIRTY_BOUNDS;
+}
+
+float TerrainPatch::computeHeight(const float* heights, unsigned int width, unsigned int x, unsigned int z) const
 {
     return heights[z * width + x] * _terrain->_localScale.y;
 }
@@ -703,10 +909,40 @@ TerrainPatch::Layer::~Layer()
 {
 }
 
-TerrainPatch::Level::Level() : model(NULL)
+TerrainPatch::Batch::Batch(Mesh* mesh, unsigned int indexCount) :
+    mesh(mesh), part(NULL), first(NULL), stamp(0)
+{
+    GP_ASSERT(mesh);
+    mesh->addRef();
+    part = mesh->addPart(Mesh::TRIANGLE_STRIP, Mesh::INDEX16, indexCount, true);
+}
+
+TerrainPatch::Batch::~Batch()
+{
+    SAFE_RELEASE(mesh);
+}
+
+TerrainPatch::Level::Level() :
+    model(NULL), batch(NULL), baseVertex(0), width(0), height(0), skirt(false), step(1.0f), error(0.0f)
 {
 }
 
+TerrainPatch::Level::~Level()
+{
+    SAFE_RELEASE(model);
+    SAFE_RELEASE(batch);
+}
+
+TerrainPatch::LevelData::LevelData() :
+    vertices(NULL), vertexCount(0), width(0), height(0), skirt(false), normals(true), step(1.0f), error(0.0f)
+{
+}
+
+TerrainPatch::LevelData::~LevelData()
+{
+    SAFE_DELETE_ARRAY(vertices);
+}
+
 bool TerrainPatch::LayerCompare::operator() (const Layer* lhs, const Layer* rhs) const
 {
     return (lhs->index < rhs->index);
@@ -740,8 +976,12 @@ bool TerrainAutoBindingResolver::resolveAutoBinding(const char* autoBinding, Nod
     }
     else if (strcmp(autoBinding, "TERRAIN_NORMAL_MAP") == 0)
     {
+        // The patches of a streaming terrain have a normal map per tile
+        TerrainPatch* patch = HelperFunctions::getPatch(node);
         Terrain* terrain = dynamic_cast<Terrain*>(node->getDrawable());
-        if (terrain && terrain->_normalMap)
+        if (patch && patch->_normalMap)
+            parameter->setValue(patch->_normalMap);
+        else if (terrain && terrain->_normalMap)
             parameter->setValue(terrain->_normalMap);
         return true;
     }
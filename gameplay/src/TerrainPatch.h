@@ -3,6 +3,8 @@
 
 #include "Model.h"
 #include "Camera.h"
+#include "HeightField.h"
+#include "ResourceLoader.h"
 
 namespace gameplay
 {
@@ -13,7 +15,7 @@ class TerrainAutoBindingResolver;
 /**
  * Defines a single patch for a Terrain.
  */
-class TerrainPatch : public Camera::Listener
+class TerrainPatch
 {
     friend class Terrain;
     friend class TerrainAutoBindingResolver;
@@ -28,8 +30,8 @@ public:
     unsigned int getMaterialCount() const;
 
     /**
-     * Gets the material for the specified level of detail index or -1 for the current level of detail
-     * based on the scene camera.
+     * Gets the material for the specified level of detail index or -1 for the level of detail
+     * selected when the terrain was last drawn.
      *
      * @param index The index for the level of detail to get the material for.
      */
@@ -40,11 +42,6 @@ public:
      */
     const BoundingBox& getBoundingBox(bool worldSpace) const;
 
-    /**
-     * @see Camera::Listener
-     */
-    void cameraChanged(Camera* camera);
-
     /**
      * Internal use only.
      *
@@ -93,11 +90,72 @@ private:
         int blendChannel;
     };
 
+    /**
+     * The vertices of a level of one or more patches, drawn from one index buffer.
+     *
+     * The indices of the visible patches are rebuilt each frame (and uploaded only when
+     * they change), so that the patches of a batch are drawn together.
+     */
+    struct Batch : public Ref
+    {
+        Batch(Mesh* mesh, unsigned int indexCount);
+
+        ~Batch();
+
+        Mesh* mesh;
+        MeshPart* part;
+        std::vector<unsigned short> indices;
+        std::vector<unsigned short> next;
+        TerrainPatch* first;
+        unsigned int stamp;
+    };
+
     struct Level
     {
+        Level();
+
+        ~Level();
+
         Model* model;
+        Batch* batch;
+        unsigned int baseVertex;
+        unsigned int width;
+        unsigned int height;
+        bool skirt;
+        float step;
+        float error;
+        BoundingBox bounds;
+    };
 
-        Level();
+    /**
+     * The vertex data of a level, built before its mesh is created.
+     */
+    struct LevelData
+    {
+        LevelData();
+
+        ~LevelData();
+
+        float* vertices;
+        unsigned int vertexCount;
+        unsigned int width;
+        unsigned int height;
+        bool skirt;
+        bool normals;
+        float step;
+        float error;
+        BoundingBox bounds;
+    };
+
+    /**
+     * The states of the tile of a streaming terrain patch.
+     */
+    enum TileState
+    {
+        TILE_COARSE,
+        TILE_LOADING,
+        TILE_RESIDENT,
+        TILE_FAILED
     };
 
     struct LayerCompare
@@ -111,9 +169,31 @@ private:
                                 unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
                                 float xOffset, float zOffset, unsigned int maxStep, float verticalSkirtSize);
 
-    void addLOD(float* heights, unsigned int width, unsigned int height,
-                unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
-                float xOffset, float zOffset, unsigned int step, float verticalSkirtSize);
+    static TerrainPatch* create(Terrain* terrain, unsigned int index, unsigned int row, unsigned int column,
+                                float xOffset, float zOffset, float verticalSkirtSize);
+
+    LevelData* buildLOD(const float* heights, unsigned int width, unsigned int height,
+                        unsigned int x1, unsigned int z1, unsigned int x2, unsigned int z2,
+                        float xOffset, float zOffset, float spacing, unsigned int step,
+                        float verticalSkirtSize, bool hasNormals) const;
+
+    Level* createLOD(LevelData* data);
+
+    static Level* createLOD(LevelData* data, Batch* batch, unsigned int baseVertex);
+
+    static Batch* createBatch(LevelData** data, unsigned int count);
+
+    static unsigned int getIndexCount(unsigned int width, unsigned int height, bool skirt);
+
+    void requestTile();
+
+    void loadTile();
+
+    bool isTileLoaded() const;
+
+    void finishTile();
+
+    void evictTile();
 
 
     bool setLayer(int index, const char* texturePath, const Vector2& textureRepeat, const char* blendPath, int blendChannel);
@@ -122,17 +202,17 @@ private:
 
     int addSampler(const char* path);
 
-    unsigned int draw(bool wireframe);
+    unsigned int draw(unsigned int indexStart, unsigned int indexCount, bool wireframe);
 
     bool updateMaterial();
 
-    unsigned int computeLOD(Camera* camera, const BoundingBox& worldBounds);
+    void setBoundsDirty();
 
     const Vector3& getAmbientColor() const;
 
     void setMaterialDirty();
 
-    float computeHeight(float* heights, unsigned int width, unsigned int x, unsigned int z);
+    float computeHeight(const float* heights, unsigned int width, unsigned int x, unsigned int z) const;
 
     void updateNodeBindings();
 
@@ -147,9 +227,18 @@ private:
     std::vector<Texture::Sampler*> _samplers;
     mutable BoundingBox _boundingBox;
     mutable BoundingBox _boundingBoxWorld;
-    mutable Camera* _camera;
-    mutable unsigned int _level;
+    unsigned int _level;
     mutable int _bits;
+    unsigned int _indexStart;
+    unsigned int _indexCount;
+    Level* _coarseLevel;
+    TileState _tileState;
+    HeightField* _heights;
+    Texture::Sampler* _normalMap;
+    std::vector<ResourceLoader::Request*> _requests;
+    HeightField* _loadedHeights;
+    std::vector<LevelData*> _levelData;
+    float _distance;
 };
 
 }
@@ -80,27 +80,9 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
     GP_ASSERT( path );
 
     // Search texture cache first.
-    for (size_t i = 0, count = __textureCache.size(); i < count; ++i)
-    {
-        Texture* t = __textureCache[i];
-        GP_ASSERT( t );
-        if (t->_path == path)
-        {
-            // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the
-            // texture to generate its mipmap chain if it hasn't already done so.
-            if (generateMipmaps)
-            {
-                t->generateMipmaps();
-            }
-
-            // Found a match.
-            t->addRef();
-
-            return t;
-        }
-    }
-
-    Texture* texture = NULL;
+    Texture* texture = findCached(path, generateMipmaps);
+    if (texture)
+        return texture;
 
     // Filter loading based on file extension.
     const char* ext = strrchr(FileSystem::resolvePath(path), '.');
@@ -145,6 +127,51 @@ Texture* Texture::create(const char* path, bool generateMipmaps)
     return NULL;
 }
 
+Texture* Texture::findCached(const char* path, bool generateMipmaps)
+{
+    GP_ASSERT( path );
+
+    for (size_t i = 0, count = __textureCache.size(); i < count; ++i)
+    {
+        Texture* t = __textureCache[i];
+        GP_ASSERT( t );
+        if (t->_path == path)
+        {
+            // If 'generateMipmaps' is true, call Texture::generateMipamps() to force the
+            // texture to generate its mipmap chain if it hasn't already done so.
+            if (generateMipmaps)
+            {
+                t->generateMipmaps();
+            }
+
+            // Found a match.
+            t->addRef();
+
+            return t;
+        }
+    }
+    return NULL;
+}
+
+Texture* Texture::createCached(const char* path, Image* image, bool generateMipmaps)
+{
+    GP_ASSERT( path );
+    GP_ASSERT( image );
+
+    Texture* texture = findCached(path, generateMipmaps);
+    if (texture)
+        return texture;
+
+    texture = create(image, generateMipmaps);
+    if (texture)
+    {
+        texture->_path = path;
+        texture->_cached = true;
+        __textureCache.push_back(texture);
+    }
+    return texture;
+}
+
 Texture* Texture::create(Image* image, bool generateMipmaps)
 {
     GP_ASSERT( image );
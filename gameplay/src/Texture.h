@@ -15,6 +15,7 @@ class Image;
 class Texture : public Ref
 {
     friend class Sampler;
+    friend class ResourceLoader;
 
 public:
 
@@ -322,6 +323,19 @@ private:
      */
     Texture& operator=(const Texture&);
 
+    /**
+     * Finds the texture loaded from the given path in the cache and adds a reference to it.
+     *
+     * @return The cached texture, or NULL if the path has not been loaded.
+     */
+    static Texture* findCached(const char* path, bool generateMipmaps);
+
+    /**
+     * Creates a texture from an image loaded from the given path and adds it to the cache,
+     * unless a texture has already been loaded from the path.
+     */
+    static Texture* createCached(const char* path, Image* image, bool generateMipmaps);
+
     static Texture* createCompressedPVRTC(const char* path);
 
     static Texture* createCompressedDDS(const char* path);
@@ -47,6 +47,14 @@ Transform::Transform(const Transform& copy)
 
 Transform::~Transform()
 {
+    // Clear our entry in the journal of suspended changes (it is kept for the whole frame, and the
+    // slot is nulled rather than erased since the journal may be being drained).
+    if (isDirty(DIRTY_NOTIFY))
+    {
+        std::vector<Transform*>::iterator itr = std::find(_transformsChanged.begin(), _transformsChanged.end(), this);
+        if (itr != _transformsChanged.end())
+            *itr = NULL;
+    }
     SAFE_DELETE(_listeners);
 }
 
@@ -67,8 +75,8 @@ void Transform::resumeTransformChanged()
         for (size_t i = 0; i < transformCount; i++)
         {
             Transform* t = _transformsChanged.at(i);
-            GP_ASSERT(t);
-            t->transformChanged();
+            if (t)
+                t->transformChanged();
         }
 
         // Go through list and reset DIRTY_NOTIFY bit. The list could potentially be larger here if the 
@@ -77,8 +85,8 @@ void Transform::resumeTransformChanged()
         for (size_t i = 0; i < transformCount; i++)
         {
             Transform* t = _transformsChanged.at(i);
-            GP_ASSERT(t);
-            t->_matrixDirtyBits &= ~DIRTY_NOTIFY;
+            if (t)
+                t->_matrixDirtyBits &= ~DIRTY_NOTIFY;
         }
 
         // empty list for next frame.
@@ -920,10 +928,13 @@ void Transform::dirty(char matrixDirtyBits)
     _matrixDirtyBits |= matrixDirtyBits;
     if (isTransformChangedSuspended())
     {
+        // Record the change in the journal once, but invalidate dependent state every
+        // time since it may have been resolved again since the last change.
         if (!isDirty(DIRTY_NOTIFY))
         {
             suspendTransformChange(this);
         }
+        transformInvalidated();
     }
     else
     {
@@ -987,6 +998,10 @@ void Transform::transformChanged()
     fireScriptEvent<void>(GP_GET_SCRIPT_EVENT(Transform, transformChanged), dynamic_cast<void*>(this));
 }
 
+void Transform::transformInvalidated()
+{
+}
+
 void Transform::cloneInto(Transform* transform, NodeCloneContext &context) const
 {
     GP_ASSERT(transform);
@@ -113,6 +113,9 @@ public:
 
     /**
      * Globally resumes all transform changed events.
+     *
+     * When the outermost suspension is resumed, every transform that changed while
+     * suspended is notified exactly once, in the order it first changed.
      */
     static void resumeTransformChanged();
 
@@ -852,6 +855,13 @@ protected:
      */
     virtual void transformChanged();
 
+    /**
+     * Called immediately each time the transform changes while transform changed events
+     * are suspended, so that derived classes can invalidate state that depends on this
+     * transform before the deferred transformChanged() notification is dispatched.
+     */
+    virtual void transformInvalidated();
+
     /**
      * Copies from data from this node into transform for the purpose of cloning.
      * 
@@ -0,0 +1,121 @@
+#include "Base.h"
+#include "UniformBuffer.h"
+
+namespace gameplay
+{
+
+// Binding points of uniform block names.
+static std::unordered_map<std::string, unsigned int> __bindingPoints;
+
+UniformBuffer::UniformBuffer(const char* name, unsigned int size)
+    : _name(name ? name : ""), _size(size), _bindingPoint(0), _handle(0), _data(NULL)
+{
+}
+
+UniformBuffer::~UniformBuffer()
+{
+#ifdef GP_USE_UBO
+    if (_handle)
+    {
+        GL_ASSERT( glDeleteBuffers(1, &_handle) );
+        _handle = 0;
+    }
+#endif
+    SAFE_DELETE_ARRAY(_data);
+}
+
+UniformBuffer* UniformBuffer::create(const char* name, unsigned int size)
+{
+    GP_ASSERT(name);
+    GP_ASSERT(size > 0);
+
+    if (!isSupported())
+    {
+        GP_WARN("Failed to create uniform buffer '%s'; uniform buffers are not supported.", name);
+        return NULL;
+    }
+
+#ifdef GP_USE_UBO
+    unsigned int bindingPoint = getBindingPoint(name);
+    GLint maxBindings = 0;
+    GL_ASSERT( glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings) );
+    if (bindingPoint >= (unsigned int)maxBindings)
+    {
+        GP_WARN("Failed to create uniform buffer '%s'; all %d uniform buffer binding points are in use.", name, maxBindings);
+        return NULL;
+    }
+
+    UniformBuffer* buffer = new UniformBuffer(name, size);
+    buffer->_bindingPoint = bindingPoint;
+    buffer->_data = new unsigned char[size];
+    memset(buffer->_data, 0, size);
+
+    GL_ASSERT( glGenBuffers(1, &buffer->_handle) );
+    GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, buffer->_handle) );
+    GL_ASSERT( glBufferData(GL_UNIFORM_BUFFER, size, buffer->_data, GL_DYNAMIC_DRAW) );
+    GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, 0) );
+    buffer->bind();
+
+    return buffer;
+#else
+    return NULL;
+#endif
+}
+
+bool UniformBuffer::isSupported()
+{
+#ifdef GP_USE_UBO
+    return GLEW_VERSION_3_1 || GLEW_ARB_uniform_buffer_object;
+#else
+    return false;
+#endif
+}
+
+const char* UniformBuffer::getName() const
+{
+    return _name.c_str();
+}
+
+unsigned int UniformBuffer::getSize() const
+{
+    return _size;
+}
+
+void UniformBuffer::setData(const void* data, unsigned int size, unsigned int offset)
+{
+    GP_ASSERT(data);
+    GP_ASSERT(offset + size <= _size);
+
+    // Skip the upload when the buffer already holds the data.
+    if (memcmp(_data + offset, data, size) == 0)
+        return;
+    memcpy(_data + offset, data, size);
+
+#ifdef GP_USE_UBO
+    GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, _handle) );
+    GL_ASSERT( glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data) );
+    GL_ASSERT( glBindBuffer(GL_UNIFORM_BUFFER, 0) );
+#endif
+}
+
+void UniformBuffer::bind()
+{
+#ifdef GP_USE_UBO
+    GL_ASSERT( glBindBufferBase(GL_UNIFORM_BUFFER, _bindingPoint, _handle) );
+#endif
+}
+
+unsigned int UniformBuffer::getBindingPoint(const char* name)
+{
+    GP_ASSERT(name);
+
+    std::unordered_map<std::string, unsigned int>::const_iterator itr = __bindingPoints.find(name);
+    if (itr != __bindingPoints.end())
+        return itr->second;
+
+    unsigned int bindingPoint = (unsigned int)__bindingPoints.size();
+    __bindingPoints[name] = bindingPoint;
+    return bindingPoint;
+}
+
+}
@@ -0,0 +1,122 @@
+#ifndef UNIFORMBUFFER_H_
+#define UNIFORMBUFFER_H_
+
+#include "Ref.h"
+
+namespace gameplay
+{
+
+/**
+ * Defines a buffer holding the values of a uniform block that is shared by
+ * all the effects declaring a block with the same name.
+ *
+ * Uniform buffers hold data that is the same for many draws, such as per-frame
+ * or per-camera matrices, so it is uploaded once instead of once per material.
+ * Each block name is given its own binding point, and every effect binds its
+ * blocks to the binding points of their names when it is created. Blocks should
+ * use the std140 layout so the data can be laid out without querying offsets:
+ *
+ * @code
+ * layout(std140) uniform CameraBlock
+ * {
+ *     mat4 u_viewProjectionMatrix;
+ *     vec4 u_cameraPosition;
+ * };
+ * @endcode
+ *
+ * Uniform buffers require OpenGL 3.1 (or the ARB_uniform_buffer_object extension)
+ * and are not available on OpenGL ES 2.0.
+ *
+ * @script{ignore}
+ */
+class UniformBuffer : public Ref
+{
+    friend class Effect;
+
+public:
+
+    /**
+     * Creates a uniform buffer for the uniform block with the given name.
+     *
+     * @param name The name of the uniform block in the shaders.
+     * @param size The size of the block, in bytes.
+     *
+     * @return The new uniform buffer, or NULL if uniform buffers are not supported.
+     */
+    static UniformBuffer* create(const char* name, unsigned int size);
+
+    /**
+     * Returns whether uniform buffers are supported by the rendering system.
+     *
+     * @return true if uniform buffers are supported, false otherwise.
+     */
+    static bool isSupported();
+
+    /**
+     * Gets the name of the uniform block of this buffer.
+     *
+     * @return The name of the uniform block.
+     */
+    const char* getName() const;
+
+    /**
+     * Gets the size of this buffer, in bytes.
+     *
+     * @return The size of the buffer.
+     */
+    unsigned int getSize() const;
+
+    /**
+     * Sets a range of the buffer's data.
+     *
+     * The data is only uploaded if it differs from what the buffer already holds.
+     *
+     * @param data The data to set.
+     * @param size The size of the data, in bytes.
+     * @param offset The offset in the buffer at which to set the data, in bytes.
+     */
+    void setData(const void* data, unsigned int size, unsigned int offset = 0);
+
+    /**
+     * Binds this buffer to the binding point of its block name, replacing any
+     * other buffer created for the same name.
+     */
+    void bind();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    UniformBuffer(const char* name, unsigned int size);
+
+    /**
+     * Destructor.
+     */
+    ~UniformBuffer();
+
+    /**
+     * Hidden copy constructor.
+     */
+    UniformBuffer(const UniformBuffer&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    UniformBuffer& operator=(const UniformBuffer&);
+
+    /**
+     * Gets the binding point assigned to a uniform block name.
+     */
+    static unsigned int getBindingPoint(const char* name);
+
+    std::string _name;
+    unsigned int _size;
+    unsigned int _bindingPoint;
+    GLuint _handle;
+    unsigned char* _data;
+};
+
+}
+
+#endif
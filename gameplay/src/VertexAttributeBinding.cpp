@@ -7,7 +7,12 @@ namespace gameplay
 {
 
 static GLuint __maxVertexAttribs = 0;
-static std::vector<VertexAttributeBinding*> __vertexAttributeBindingCache;
+static std::unordered_map<std::string, VertexAttributeBinding*> __vertexAttributeBindingCache;
+static VertexAttributeBinding::Statistics __statistics;
+static unsigned int __vaoCount = 0;
+
+static GLint getVertexAttribute(Effect* effect, VertexFormat::Usage usage);
+static void getSignature(Mesh* mesh, Effect* effect, std::string* key);
 
 VertexAttributeBinding::VertexAttributeBinding() :
     _handle(0), _attributes(NULL), _mesh(NULL), _effect(NULL)
@@ -17,10 +22,13 @@ VertexAttributeBinding::VertexAttributeBinding() :
 VertexAttributeBinding::~VertexAttributeBinding()
 {
     // Delete from the vertex attribute binding cache.
-    std::vector<VertexAttributeBinding*>::iterator itr = std::find(__vertexAttributeBindingCache.begin(), __vertexAttributeBindingCache.end(), this);
-    if (itr != __vertexAttributeBindingCache.end())
+    if (!_key.empty())
     {
-        __vertexAttributeBindingCache.erase(itr);
+        std::unordered_map<std::string, VertexAttributeBinding*>::iterator itr = __vertexAttributeBindingCache.find(_key);
+        if (itr != __vertexAttributeBindingCache.end() && itr->second == this)
+        {
+            __vertexAttributeBindingCache.erase(itr);
+        }
     }
 
     SAFE_RELEASE(_mesh);
@@ -31,33 +39,39 @@ VertexAttributeBinding::~VertexAttributeBinding()
     {
         GL_ASSERT( glDeleteVertexArrays(1, &_handle) );
         _handle = 0;
+        --__vaoCount;
     }
 }
 
 VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, Effect* effect)
 {
     GP_ASSERT(mesh);
+    GP_ASSERT(effect);
 
-    // Search for an existing vertex attribute binding that can be used.
-    VertexAttributeBinding* b;
-    for (size_t i = 0, count = __vertexAttributeBindingCache.size(); i < count; ++i)
+    // Search for an existing vertex attribute binding with the same signature.
+    std::string key;
+    getSignature(mesh, effect, &key);
+    ++__statistics.requestCount;
+    std::unordered_map<std::string, VertexAttributeBinding*>::const_iterator itr = __vertexAttributeBindingCache.find(key);
+    if (itr != __vertexAttributeBindingCache.end())
     {
-        b = __vertexAttributeBindingCache[i];
+        // Found a match!
+        VertexAttributeBinding* b = itr->second;
         GP_ASSERT(b);
-        if (b->_mesh == mesh && b->_effect == effect)
-        {
-            // Found a match!
-            b->addRef();
-            return b;
-        }
+        ++__statistics.hitCount;
+        if (b->_effect != effect)
+            ++__statistics.sharedCount;
+        b->addRef();
+        return b;
     }
 
-    b = create(mesh, mesh->getVertexFormat(), 0, effect);
+    VertexAttributeBinding* b = create(mesh, mesh->getVertexFormat(), 0, effect);
 
     // Add the new vertex attribute binding to the cache.
     if (b)
     {
-        __vertexAttributeBindingCache.push_back(b);
+        b->_key.swap(key);
+        __vertexAttributeBindingCache[b->_key] = b;
     }
 
     return b;
@@ -104,6 +118,7 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
             SAFE_DELETE(b);
             return NULL;
         }
+        ++__vaoCount;
 
         // Bind the new VAO.
         GL_ASSERT( glBindVertexArray(b->_handle) );
@@ -139,58 +154,11 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
     effect->addRef();
 
     // Call setVertexAttribPointer for each vertex element.
-    std::string name;
     size_t offset = 0;
     for (size_t i = 0, count = vertexFormat.getElementCount(); i < count; ++i)
     {
         const VertexFormat::Element& e = vertexFormat.getElement(i);
-        gameplay::VertexAttribute attrib;
-
-        // Constructor vertex attribute name expected in shader.
-        switch (e.usage)
-        {
-        case VertexFormat::POSITION:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_POSITION_NAME);
-            break;
-        case VertexFormat::NORMAL:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_NORMAL_NAME);
-            break;
-        case VertexFormat::COLOR:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_COLOR_NAME);
-            break;
-        case VertexFormat::TANGENT:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TANGENT_NAME);
-            break;
-        case VertexFormat::BINORMAL:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BINORMAL_NAME);
-            break;
-        case VertexFormat::BLENDWEIGHTS:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME);
-            break;
-        case VertexFormat::BLENDINDICES:
-            attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDINDICES_NAME);
-            break;
-        case VertexFormat::TEXCOORD0:
-            if ((attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME)) != -1)
-                break;
-
-        case VertexFormat::TEXCOORD1:
-        case VertexFormat::TEXCOORD2:
-        case VertexFormat::TEXCOORD3:
-        case VertexFormat::TEXCOORD4:
-        case VertexFormat::TEXCOORD5:
-        case VertexFormat::TEXCOORD6:
-        case VertexFormat::TEXCOORD7:
-            name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
-            name += '0' + (e.usage - VertexFormat::TEXCOORD0);
-            attrib = effect->getVertexAttribute(name.c_str());
-            break;
-        default:
-            // This happens whenever vertex data contains extra information (not an error).
-            attrib = -1;
-            break;
-        }
-
+        GLint attrib = getVertexAttribute(effect, e.usage);
         if (attrib == -1)
         {
             //GP_WARN("Warning: Vertex element with usage '%s' in mesh '%s' does not correspond to an attribute in effect '%s'.", VertexFormat::toString(e.usage), mesh->getUrl(), effect->getId());
@@ -212,6 +180,25 @@ VertexAttributeBinding* VertexAttributeBinding::create(Mesh* mesh, const VertexF
     return b;
 }
 
+VertexAttributeBinding::Statistics VertexAttributeBinding::getStatistics()
+{
+    Statistics statistics = __statistics;
+    statistics.bindingCount = (unsigned int)__vertexAttributeBindingCache.size();
+    statistics.vaoCount = __vaoCount;
+    statistics.hitRate = statistics.requestCount > 0 ? (float)statistics.hitCount / statistics.requestCount : 0.0f;
+    return statistics;
+}
+
+void VertexAttributeBinding::resetStatistics()
+{
+    __statistics = Statistics();
+}
+
+VertexAttributeBinding::Statistics::Statistics()
+    : bindingCount(0), vaoCount(0), requestCount(0), hitCount(0), sharedCount(0), hitRate(0.0f)
+{
+}
+
 void VertexAttributeBinding::setVertexAttribPointer(GLuint indx, GLint size, GLenum type, GLboolean normalize, GLsizei stride, void* pointer)
 {
     GP_ASSERT(indx < (GLuint)__maxVertexAttribs);
@@ -293,4 +280,75 @@ void VertexAttributeBinding::unbind()
     }
 }
 
+static GLint getVertexAttribute(Effect* effect, VertexFormat::Usage usage)
+{
+    GP_ASSERT(effect);
+
+    // Constructor vertex attribute name expected in shader.
+    GLint attrib;
+    std::string name;
+    switch (usage)
+    {
+    case VertexFormat::POSITION:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_POSITION_NAME);
+        break;
+    case VertexFormat::NORMAL:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_NORMAL_NAME);
+        break;
+    case VertexFormat::COLOR:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_COLOR_NAME);
+        break;
+    case VertexFormat::TANGENT:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TANGENT_NAME);
+        break;
+    case VertexFormat::BINORMAL:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BINORMAL_NAME);
+        break;
+    case VertexFormat::BLENDWEIGHTS:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDWEIGHTS_NAME);
+        break;
+    case VertexFormat::BLENDINDICES:
+        attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_BLENDINDICES_NAME);
+        break;
+    case VertexFormat::TEXCOORD0:
+        if ((attrib = effect->getVertexAttribute(VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME)) != -1)
+            break;
+
+    case VertexFormat::TEXCOORD1:
+    case VertexFormat::TEXCOORD2:
+    case VertexFormat::TEXCOORD3:
+    case VertexFormat::TEXCOORD4:
+    case VertexFormat::TEXCOORD5:
+    case VertexFormat::TEXCOORD6:
+    case VertexFormat::TEXCOORD7:
+        name = VERTEX_ATTRIBUTE_TEXCOORD_PREFIX_NAME;
+        name += '0' + (usage - VertexFormat::TEXCOORD0);
+        attrib = effect->getVertexAttribute(name.c_str());
+        break;
+    default:
+        // This happens whenever vertex data contains extra information (not an error).
+        attrib = -1;
+        break;
+    }
+    return attrib;
+}
+
+static void getSignature(Mesh* mesh, Effect* effect, std::string* key)
+{
+    GP_ASSERT(mesh);
+    GP_ASSERT(key);
+
+    // The mesh (whose vertex buffer a VAO captures), followed by the usage, size and
+    // attribute location of each element of its vertex format
+    const VertexFormat& vertexFormat = mesh->getVertexFormat();
+    key->reserve(sizeof(Mesh*) + vertexFormat.getElementCount() * 3 * sizeof(int));
+    key->assign((const char*)&mesh, sizeof(Mesh*));
+    for (size_t i = 0, count = vertexFormat.getElementCount(); i < count; ++i)
+    {
+        const VertexFormat::Element& e = vertexFormat.getElement(i);
+        int values[3] = { (int)e.usage, (int)e.size, (int)getVertexAttribute(effect, e.usage) };
+        key->append((const char*)values, sizeof(values));
+    }
+}
+
 }
@@ -28,17 +28,48 @@ class Effect;
  * should only be used when writing custom code that use client-side vertex
  * arrays, since it is slower than the server-side VAOs used by OpenGL
  * (when creating a VertexAttributeBinding between a Mesh and Effect).
+ *
+ * Bindings between a Mesh and an Effect are cached by the signature of the binding:
+ * the mesh, its vertex format and the attribute location each of its vertex elements
+ * is bound to in the effect. Effects that bind the elements of a mesh to the same
+ * locations (which is common for effects compiled from the same shaders with
+ * different defines) share a single binding, and a single VAO.
  */
 class VertexAttributeBinding : public Ref
 {
 public:
 
+    /**
+     * Defines the statistics of the cache of bindings between meshes and effects.
+     */
+    struct Statistics
+    {
+        /**
+         * Constructor.
+         */
+        Statistics();
+
+        /** The number of bindings in the cache. */
+        unsigned int bindingCount;
+        /** The number of VAOs (zero when VAOs are not used). */
+        unsigned int vaoCount;
+        /** The number of bindings requested between a mesh and an effect. */
+        unsigned int requestCount;
+        /** The number of requests returning a binding from the cache. */
+        unsigned int hitCount;
+        /** The number of requests returning a binding from the cache that was created for another effect. */
+        unsigned int sharedCount;
+        /** The ratio of hits to requests (zero if there were no requests). */
+        float hitRate;
+    };
+
     /**
      * Creates a new VertexAttributeBinding between the given Mesh and Effect.
      *
-     * If a VertexAttributeBinding matching the specified Mesh and Effect already
-     * exists, it will be returned. Otherwise, a new VertexAttributeBinding will
-     * be returned. If OpenGL VAOs are enabled, the a new VAO will be created and
+     * If a VertexAttributeBinding for the specified Mesh that binds its vertex
+     * elements to the same attribute locations as the specified Effect already
+     * exists (for this or another effect), it will be returned. Otherwise, a new
+     * VertexAttributeBinding will be returned. If OpenGL VAOs are enabled, the a new VAO will be created and
      * stored in the returned VertexAttributeBinding, otherwise a client-side
      * array of vertex attribute bindings will be stored.
      *
@@ -68,6 +99,22 @@ public:
      */
     static VertexAttributeBinding* create(const VertexFormat& vertexFormat, void* vertexPointer, Effect* effect);
 
+    /**
+     * Gets the statistics of the cache of bindings between meshes and effects.
+     *
+     * The number of bindings and VAOs are current; the request counts are those since the
+     * statistics were last reset.
+     *
+     * @return The statistics.
+     * @script{ignore}
+     */
+    static Statistics getStatistics();
+
+    /**
+     * Resets the request counts of the statistics.
+     */
+    static void resetStatistics();
+
     /**
      * Binds this vertex array object.
      */
@@ -114,6 +161,7 @@ private:
     VertexAttribute* _attributes;
     Mesh* _mesh;
     Effect* _effect;
+    std::string _key;
 };
 
 }
@@ -0,0 +1,175 @@
+#include "Base.h"
+#include "WorkerPool.h"
+
+// Maximum number of chunks a parallelFor is split into per thread (for load balancing).
+#define WORKER_CHUNKS_PER_THREAD 4
+
+namespace gameplay
+{
+
+WorkerPool::WorkerPool()
+    : _activeJobs(0), _running(false)
+{
+}
+
+WorkerPool::~WorkerPool()
+{
+    finalize();
+}
+
+void WorkerPool::initialize(unsigned int threadCount)
+{
+    GP_ASSERT(_threads.empty());
+
+    _running = true;
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        _threads.push_back(new std::thread(&WorkerPool::workerThreadProc, this));
+    }
+}
+
+void WorkerPool::finalize()
+{
+    if (_threads.empty())
+        return;
+
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _running = false;
+    }
+    _jobAvailable.notify_all();
+
+    for (size_t i = 0, count = _threads.size(); i < count; ++i)
+    {
+        _threads[i]->join();
+        SAFE_DELETE(_threads[i]);
+    }
+    _threads.clear();
+}
+
+unsigned int WorkerPool::getThreadCount() const
+{
+    return (unsigned int)_threads.size();
+}
+
+void WorkerPool::parallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& function)
+{
+    if (count == 0)
+        return;
+    if (grainSize == 0)
+        grainSize = 1;
+
+    unsigned int chunkCount = (count + grainSize - 1) / grainSize;
+    unsigned int maxChunks = (getThreadCount() + 1) * WORKER_CHUNKS_PER_THREAD;
+    if (chunkCount > maxChunks)
+        chunkCount = maxChunks;
+
+    // Run small ranges (or everything when there are no workers) inline.
+    if (_threads.empty() || chunkCount <= 1)
+    {
+        function(0, count);
+        return;
+    }
+
+    // Chunks are claimed from a shared counter rather than queued individually, so the
+    // calling thread only ever runs chunks of this loop and never unrelated jobs. Helper
+    // jobs that start after every chunk has been claimed return without doing anything,
+    // which is why the state they reference is shared rather than living on this stack.
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+    state->function = &function;
+    state->count = count;
+    state->chunkSize = (count + chunkCount - 1) / chunkCount;
+    state->chunkCount = (count + state->chunkSize - 1) / state->chunkSize;
+    state->nextChunk = 0;
+    state->completedChunks = 0;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (unsigned int i = 1; i < state->chunkCount; ++i)
+        {
+            _jobs.push_back([state]() { runChunks(*state); });
+        }
+    }
+    _jobAvailable.notify_all();
+
+    runChunks(*state);
+
+    // Every chunk is claimed at this point, so we only wait for those still running elsewhere.
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->done.wait(lock, [&state]() { return state->completedChunks == state->chunkCount; });
+}
+
+void WorkerPool::runChunks(ParallelForState& state)
+{
+    unsigned int completed = 0;
+    unsigned int chunk;
+    while ((chunk = state.nextChunk++) < state.chunkCount)
+    {
+        unsigned int begin = chunk * state.chunkSize;
+        unsigned int end = std::min(begin + state.chunkSize, state.count);
+        (*state.function)(begin, end);
+        ++completed;
+    }
+
+    if (completed > 0)
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.completedChunks += completed;
+        if (state.completedChunks == state.chunkCount)
+            state.done.notify_all();
+    }
+}
+
+void WorkerPool::submit(const Job& job)
+{
+    if (_threads.empty())
+    {
+        job();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(job);
+    }
+    _jobAvailable.notify_one();
+}
+
+void WorkerPool::wait()
+{
+    if (_threads.empty())
+        return;
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _jobsDone.wait(lock, [this]() { return _jobs.empty() && _activeJobs == 0; });
+}
+
+void WorkerPool::workerThreadProc(void* arg)
+{
+    WorkerPool* pool = (WorkerPool*)arg;
+    GP_ASSERT(pool);
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(pool->_mutex);
+            pool->_jobAvailable.wait(lock, [pool]() { return !pool->_running || !pool->_jobs.empty(); });
+            if (pool->_jobs.empty())
+                break;
+            job = pool->_jobs.front();
+            pool->_jobs.pop_front();
+            ++pool->_activeJobs;
+        }
+
+        job();
+
+        {
+            std::lock_guard<std::mutex> lock(pool->_mutex);
+            --pool->_activeJobs;
+        }
+        pool->_jobsDone.notify_all();
+    }
+}
+
+}
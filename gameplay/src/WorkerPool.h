@@ -0,0 +1,138 @@
+#ifndef WORKERPOOL_H_
+#define WORKERPOOL_H_
+
+namespace gameplay
+{
+
+/**
+ * Defines a pool of worker threads used by the engine to spread data parallel
+ * work (transform propagation, animation, skinning, particles, etc.) across cores.
+ *
+ * The main pool is owned by the Game and sized from the optional "workers" section
+ * of the game config; some subsystems own a private pool for their own work. When
+ * a pool has no worker threads, all work submitted to it is executed immediately
+ * on the calling thread.
+ *
+ * @script{ignore}
+ */
+class WorkerPool
+{
+    friend class Game;
+    friend class PhysicsController;
+    friend class ResourceLoader;
+
+public:
+
+    /**
+     * Defines a function that processes the items in the range [begin, end).
+     */
+    typedef std::function<void(unsigned int begin, unsigned int end)> RangeFunction;
+
+    /**
+     * Defines a job that is run asynchronously on a worker thread.
+     */
+    typedef std::function<void()> Job;
+
+    /**
+     * Gets the number of worker threads in the pool (not including the calling thread).
+     *
+     * @return The number of worker threads.
+     */
+    unsigned int getThreadCount() const;
+
+    /**
+     * Processes the range [0, count) by splitting it into chunks of at least grainSize
+     * items that are executed on the worker threads and the calling thread.
+     *
+     * This method does not return until every chunk has been processed. The calling
+     * thread only helps with the chunks of this call, never with other queued jobs, so
+     * it is safe to call from within a job or another parallelFor.
+     *
+     * @param count The number of items to process.
+     * @param grainSize The minimum number of items processed by a single chunk.
+     * @param function The function called for each chunk.
+     */
+    void parallelFor(unsigned int count, unsigned int grainSize, const RangeFunction& function);
+
+    /**
+     * Submits a job to be executed asynchronously on a worker thread.
+     *
+     * @param job The job to execute.
+     */
+    void submit(const Job& job);
+
+    /**
+     * Blocks until all submitted jobs have completed.
+     */
+    void wait();
+
+private:
+
+    /**
+     * Constructor.
+     */
+    WorkerPool();
+
+    /**
+     * Destructor.
+     */
+    ~WorkerPool();
+
+    /**
+     * Hidden copy constructor.
+     */
+    WorkerPool(const WorkerPool&);
+
+    /**
+     * Hidden copy assignment operator.
+     */
+    WorkerPool& operator=(const WorkerPool&);
+
+    /**
+     * Called during startup to spawn the worker threads.
+     *
+     * @param threadCount The number of worker threads to spawn.
+     */
+    void initialize(unsigned int threadCount);
+
+    /**
+     * Called during shutdown to join the worker threads.
+     */
+    void finalize();
+
+    /**
+     * Defines the state shared by the threads processing a single parallelFor.
+     */
+    struct ParallelForState
+    {
+        const RangeFunction* function;
+        unsigned int count;
+        unsigned int chunkSize;
+        unsigned int chunkCount;
+        std::atomic<unsigned int> nextChunk;
+        unsigned int completedChunks;
+        std::mutex mutex;
+        std::condition_variable done;
+    };
+
+    /**
+     * Claims and processes chunks of a parallelFor until none are left.
+     *
+     * @param state The state of the parallelFor.
+     */
+    static void runChunks(ParallelForState& state);
+
+    static void workerThreadProc(void* arg);
+
+    std::vector<std::thread*> _threads;
+    std::deque<Job> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _jobAvailable;
+    std::condition_variable _jobsDone;
+    unsigned int _activeJobs;
+    bool _running;
+};
+
+}
+
+#endif
@@ -11,6 +11,8 @@
 #include "Bundle.h"
 #include "MathUtil.h"
 #include "Logger.h"
+#include "WorkerPool.h"
+#include "ResourceLoader.h"
 
 // Math
 #include "Rectangle.h"
@@ -35,10 +37,12 @@
 #include "Effect.h"
 #include "Material.h"
 #include "RenderState.h"
+#include "UniformBuffer.h"
 #include "VertexFormat.h"
 #include "VertexAttributeBinding.h"
 #include "Drawable.h"
 #include "Model.h"
+#include "RenderQueue.h"
 #include "Camera.h"
 #include "Light.h"
 #include "Node.h"
@@ -50,6 +54,7 @@
 #include "Text.h"
 #include "TileSet.h"
 #include "ParticleEmitter.h"
+#include "ParticleEmitterPool.h"
 #include "FrameBuffer.h"
 #include "RenderTarget.h"
 #include "DepthStencilTarget.h"
@@ -120,10 +120,6 @@ static void* __convertTo(void* ptr, const char* typeName)
     {
         return reinterpret_cast<void*>(static_cast<AudioListener*>(ptrObject));
     }
-    else if (strcmp(typeName, "TerrainPatch") == 0)
-    {
-        return reinterpret_cast<void*>(static_cast<TerrainPatch*>(ptrObject));
-    }
 
     // No conversion available for 'typeName'
     return NULL;
@@ -79,7 +79,6 @@ void luaRegister_lua_Global()
     setHierarchyPair("Camera", "Ref");
     setHierarchyPair("Camera", "Transform::Listener");
     setHierarchyPair("Camera::Listener", "AudioListener");
-    setHierarchyPair("Camera::Listener", "TerrainPatch");
     setHierarchyPair("CheckBox", "Button");
     setHierarchyPair("Container", "Control");
     setHierarchyPair("Container", "Form");
@@ -215,7 +214,6 @@ void luaRegister_lua_Global()
     setHierarchyPair("Terrain", "Drawable");
     setHierarchyPair("Terrain", "Ref");
     setHierarchyPair("Terrain", "Transform::Listener");
-    setHierarchyPair("TerrainPatch", "Camera::Listener");
     setHierarchyPair("Text", "AnimationTarget");
     setHierarchyPair("Text", "Drawable");
     setHierarchyPair("Text", "Ref");
@@ -16,8 +16,6 @@
 namespace gameplay
 {
 
-extern void luaGlobal_Register_Conversion_Function(const char* className, void*(*func)(void*, const char*));
-
 static TerrainPatch* getInstance(lua_State* state)
 {
     void* userdata = luaL_checkudata(state, 1, "TerrainPatch");
@@ -25,48 +23,6 @@ static TerrainPatch* getInstance(lua_State* state)
     return (TerrainPatch*)((gameplay::ScriptUtil::LuaObject*)userdata)->instance;
 }
 
-static int lua_TerrainPatch_cameraChanged(lua_State* state)
-{
-    // Get the number of parameters.
-    int paramCount = lua_gettop(state);
-
-    // Attempt to match the parameters to a valid binding.
-    switch (paramCount)
-    {
-        case 2:
-        {
-            if ((lua_type(state, 1) == LUA_TUSERDATA) &&
-                (lua_type(state, 2) == LUA_TUSERDATA || lua_type(state, 2) == LUA_TTABLE || lua_type(state, 2) == LUA_TNIL))
-            {
-                // Get parameter 1 off the stack.
-                bool param1Valid;
-                gameplay::ScriptUtil::LuaArray<Camera> param1 = gameplay::ScriptUtil::getObjectPointer<Camera>(2, "Camera", false, &param1Valid);
-                if (!param1Valid)
-                {
-                    lua_pushstring(state, "Failed to convert parameter 1 to type 'Camera'.");
-                    lua_error(state);
-                }
-
-                TerrainPatch* instance = getInstance(state);
-                instance->cameraChanged(param1);
-                
-                return 0;
-            }
-
-            lua_pushstring(state, "lua_TerrainPatch_cameraChanged - Failed to match the given parameters to a valid function signature.");
-            lua_error(state);
-            break;
-        }
-        default:
-        {
-            lua_pushstring(state, "Invalid number of parameters (expected 2).");
-            lua_error(state);
-            break;
-        }
-    }
-    return 0;
-}
-
 static int lua_TerrainPatch_getBoundingBox(lua_State* state)
 {
     // Get the number of parameters.
@@ -224,67 +180,19 @@ static int lua_TerrainPatch_getMaterialCount(lua_State* state)
     return 0;
 }
 
-// Provides support for conversion to all known relative types of TerrainPatch
-static void* __convertTo(void* ptr, const char* typeName)
-{
-    TerrainPatch* ptrObject = reinterpret_cast<TerrainPatch*>(ptr);
-
-    if (strcmp(typeName, "Camera::Listener") == 0)
-    {
-        return reinterpret_cast<void*>(static_cast<Camera::Listener*>(ptrObject));
-    }
-
-    // No conversion available for 'typeName'
-    return NULL;
-}
-
-static int lua_TerrainPatch_to(lua_State* state)
-{
-    // There should be only a single parameter (this instance)
-    if (lua_gettop(state) != 2 || lua_type(state, 1) != LUA_TUSERDATA || lua_type(state, 2) != LUA_TSTRING)
-    {
-        lua_pushstring(state, "lua_TerrainPatch_to - Invalid number of parameters (expected 2).");
-        lua_error(state);
-        return 0;
-    }
-
-    TerrainPatch* instance = getInstance(state);
-    const char* typeName = gameplay::ScriptUtil::getString(2, false);
-    void* result = __convertTo((void*)instance, typeName);
-
-    if (result)
-    {
-        gameplay::ScriptUtil::LuaObject* object = (gameplay::ScriptUtil::LuaObject*)lua_newuserdata(state, sizeof(gameplay::ScriptUtil::LuaObject));
-        object->instance = (void*)result;
-        object->owns = false;
-        luaL_getmetatable(state, typeName);
-        lua_setmetatable(state, -2);
-    }
-    else
-    {
-        lua_pushnil(state);
-    }
-
-    return 1;
-}
-
 void luaRegister_TerrainPatch()
 {
     const luaL_Reg lua_members[] = 
     {
-        {"cameraChanged", lua_TerrainPatch_cameraChanged},
         {"getBoundingBox", lua_TerrainPatch_getBoundingBox},
         {"getMaterial", lua_TerrainPatch_getMaterial},
         {"getMaterialCount", lua_TerrainPatch_getMaterialCount},
-        {"to", lua_TerrainPatch_to},
         {NULL, NULL}
     };
     const luaL_Reg* lua_statics = NULL;
     std::vector<std::string> scopePath;
 
     gameplay::ScriptUtil::registerClass("TerrainPatch", lua_members, NULL, NULL, lua_statics, scopePath);
-
-    luaGlobal_Register_Conversion_Function("TerrainPatch", __convertTo);
 }
 
 }
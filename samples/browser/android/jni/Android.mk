@@ -40,6 +40,7 @@ LOCAL_SRC_FILES := ../../../gameplay/src/gameplay-main-android.cpp \
     MeshPrimitiveSample.cpp \
     ParticlesSample.cpp \
     PhysicsCollisionObjectSample.cpp \
+    PhysicsQuerySample.cpp \
     PostProcessSample.cpp \
     SceneCreateSample.cpp \
     SceneLoadSample.cpp \
@@ -25,6 +25,7 @@ SOURCES += src/Audio3DSample.cpp \
     src/MeshPrimitiveSample.cpp \
     src/ParticlesSample.cpp \
     src/PhysicsCollisionObjectSample.cpp \
+    src/PhysicsQuerySample.cpp \
     src/PostProcessSample.cpp \
     src/Sample.cpp \
     src/SamplesGame.cpp \
@@ -52,6 +53,7 @@ HEADERS += src/Audio3DSample.h \
     src/MeshPrimitiveSample.h \
     src/ParticlesSample.h \
     src/PhysicsCollisionObjectSample.h \
+    src/PhysicsQuerySample.h \
     src/PostProcessSample.h \
     src/Sample.h \
     src/SamplesGame.h \
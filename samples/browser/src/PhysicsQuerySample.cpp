@@ -0,0 +1,118 @@
+#include "PhysicsQuerySample.h"
+#include "SamplesGame.h"
+
+#if defined(ADD_SAMPLE)
+    ADD_SAMPLE("Physics", "Ray Test Batches", PhysicsQuerySample, 2);
+#endif
+
+// The number of collision objects along each side of the grid.
+#define GRID_SIZE 32
+
+// The number of rays tested each frame.
+#define RAY_COUNT 4096
+
+// The weight of the latest frame in the smoothed timings.
+#define TIMING_WEIGHT 0.05
+
+PhysicsQuerySample::PhysicsQuerySample()
+    : _font(NULL), _scene(NULL), _singleTime(0.0), _batchTime(0.0), _singleHits(0), _batchHits(0)
+{
+}
+
+void PhysicsQuerySample::initialize()
+{
+    // Create the font for drawing the framerate and timings.
+    _font = Font::create("res/ui/arial.gpb");
+
+    _scene = Scene::create();
+
+    // Create a camera looking down at the grid.
+    Camera* camera = Camera::createPerspective(45.0f, getAspectRatio(), 1.0f, 500.0f);
+    Node* cameraNode = _scene->addNode("camera");
+    cameraNode->setCamera(camera);
+    cameraNode->translate(0.0f, GRID_SIZE * 1.5f, GRID_SIZE * 2.0f);
+    cameraNode->rotateX(MATH_DEG_TO_RAD(-35.0f));
+    _scene->setActiveCamera(camera);
+    SAFE_RELEASE(camera);
+
+    // Create a grid of static boxes and spheres of random heights.
+    PhysicsRigidBody::Parameters parameters;
+    for (int z = 0; z < GRID_SIZE; z++)
+    {
+        for (int x = 0; x < GRID_SIZE; x++)
+        {
+            Node* node = _scene->addNode();
+            node->translate((float)(x * 2 - GRID_SIZE), MATH_RANDOM_0_1() * 4.0f, (float)(z * 2 - GRID_SIZE));
+            if ((x + z) % 2 == 0)
+                node->setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::box(Vector3(1.5f, 1.5f, 1.5f)), &parameters);
+            else
+                node->setCollisionObject(PhysicsCollisionObject::RIGID_BODY, PhysicsCollisionShape::sphere(0.75f), &parameters);
+        }
+    }
+
+    // Create the rays: half of them cast down at the grid and half of them across it.
+    _queries.resize(RAY_COUNT);
+    for (unsigned int i = 0; i < RAY_COUNT; i++)
+    {
+        Vector3 origin(MATH_RANDOM_MINUS1_1() * GRID_SIZE, 10.0f, MATH_RANDOM_MINUS1_1() * GRID_SIZE);
+        Vector3 direction(0.0f, -1.0f, 0.0f);
+        if (i % 2)
+        {
+            origin.set(-GRID_SIZE - 2.0f, MATH_RANDOM_0_1() * 4.0f, MATH_RANDOM_MINUS1_1() * GRID_SIZE);
+            direction.set(1.0f, 0.0f, MATH_RANDOM_MINUS1_1() * 0.25f);
+            direction.normalize();
+        }
+        _queries[i] = PhysicsController::RayQuery(Ray(origin, direction), GRID_SIZE * 2.0f + 4.0f);
+    }
+}
+
+void PhysicsQuerySample::finalize()
+{
+    SAFE_RELEASE(_font);
+    SAFE_RELEASE(_scene);
+}
+
+void PhysicsQuerySample::update(float elapsedTime)
+{
+    PhysicsController* physics = getPhysicsController();
+
+    // Time the rays tested one at a time. Individual tests only report the closest hit,
+    // so the batch is run in the same mode to compare like with like.
+    double start = Game::getAbsoluteTime();
+    _singleHits = 0;
+    for (unsigned int i = 0; i < RAY_COUNT; i++)
+    {
+        if (physics->rayTest(_queries[i].ray, _queries[i].distance))
+            _singleHits++;
+    }
+    double singleTime = Game::getAbsoluteTime() - start;
+
+    // Time the same rays tested as a batch.
+    start = Game::getAbsoluteTime();
+    _batchHits = physics->rayTestBatch(_queries, _results);
+    double batchTime = Game::getAbsoluteTime() - start;
+
+    _singleTime += (singleTime - _singleTime) * TIMING_WEIGHT;
+    _batchTime += (batchTime - _batchTime) * TIMING_WEIGHT;
+}
+
+void PhysicsQuerySample::render(float elapsedTime)
+{
+    // Clear the color and depth buffers
+    clear(CLEAR_COLOR_DEPTH, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0);
+
+    // Draw the collision objects.
+    getPhysicsController()->drawDebug(_scene->getActiveCamera()->getViewProjectionMatrix());
+
+    drawFrameRate(_font, Vector4(0, 0.5f, 1, 1), 5, 1, getFrameRate());
+
+    char buffer[128];
+    _font->start();
+    sprintf(buffer, "%u rays (closest hit)", RAY_COUNT);
+    _font->drawText(buffer, 5, 25, Vector4::one(), 18);
+    sprintf(buffer, "Individual tests: %.2f ms, %u hits", _singleTime, _singleHits);
+    _font->drawText(buffer, 5, 45, Vector4::one(), 18);
+    sprintf(buffer, "Batched tests: %.2f ms, %u hits", _batchTime, _batchHits);
+    _font->drawText(buffer, 5, 65, Vector4::one(), 18);
+    _font->finish();
+}
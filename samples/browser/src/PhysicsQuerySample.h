@@ -0,0 +1,40 @@
+#ifndef PHYSICSQUERYSAMPLE_H_
+#define PHYSICSQUERYSAMPLE_H_
+
+#include "gameplay.h"
+#include "Sample.h"
+
+using namespace gameplay;
+
+/**
+ * Sample comparing the cost of batched physics ray tests with individual ray tests.
+ */
+class PhysicsQuerySample : public Sample
+{
+public:
+
+    PhysicsQuerySample();
+
+protected:
+
+    void initialize();
+
+    void finalize();
+
+    void update(float elapsedTime);
+
+    void render(float elapsedTime);
+
+private:
+
+    Font* _font;
+    Scene* _scene;
+    std::vector<PhysicsController::RayQuery> _queries;
+    std::vector<PhysicsController::HitResult> _results;
+    double _singleTime;
+    double _batchTime;
+    unsigned int _singleHits;
+    unsigned int _batchHits;
+};
+
+#endif
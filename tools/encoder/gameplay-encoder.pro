@@ -44,6 +44,7 @@ SOURCES += src/Mesh.cpp \
     src/Node.cpp \
     src/NormalMapGenerator.cpp \
     src/Object.cpp \
+    src/PropertiesEncoder.cpp \
     src/Quaternion.cpp \
     src/Reference.cpp \
     src/ReferenceTable.cpp \
@@ -94,6 +95,7 @@ HEADERS += src/AnimationChannel.h \
     src/Node.h \
     src/NormalMapGenerator.h \
     src/Object.h \
+    src/PropertiesEncoder.h \
     src/Quaternion.h \
     src/Quaternion.inl \
     src/Reference.h \
@@ -119,6 +119,8 @@ std::string EncoderArguments::getOutputFileExtension() const
     {
     case FILEFORMAT_TMX:
         return ".scene";
+    case FILEFORMAT_PROPERTIES:
+        return ".gpp";
     case FILEFORMAT_PNG:
     case FILEFORMAT_RAW:
         if (_normalMap)
@@ -138,9 +140,9 @@ std::string EncoderArguments::getOutputFilePath() const
     }
     else
     {
-        // Generate an output file path
+        // Generate an output file path (compiled properties files keep the extension of the input file)
         int pos = _filePath.find_last_of('.');
-        std::string outputFilePath(pos > 0 ? _filePath.substr(0, pos) : _filePath);
+        std::string outputFilePath(pos > 0 && getFileFormat() != FILEFORMAT_PROPERTIES ? _filePath.substr(0, pos) : _filePath);
 
         // Modify the original file name if the output extension can be the same as the input
         if (_normalMap)
@@ -256,6 +258,7 @@ void EncoderArguments::printUsage() const
     "Supported file extensions:\n" \
     "  .fbx\t(FBX scenes)\n" \
     "  .ttf\t(TrueType fonts)\n" \
+    "  .material, .scene, .physics, .form, ...\t(Properties files, compiled to .gpp)\n" \
     "\n" \
     "General options:\n" \
     "  -v <verbosity>\tVerbosity level (0-4).\n" \
@@ -403,6 +406,13 @@ EncoderArguments::FileFormat EncoderArguments::getFileFormat() const
     {
         return FILEFORMAT_RAW;
     }
+    if (ext.compare("material") == 0 || ext.compare("scene") == 0 || ext.compare("physics") == 0 ||
+        ext.compare("form") == 0 || ext.compare("theme") == 0 || ext.compare("particle") == 0 ||
+        ext.compare("animation") == 0 || ext.compare("audio") == 0 || ext.compare("terrain") == 0 ||
+        ext.compare("properties") == 0)
+    {
+        return FILEFORMAT_PROPERTIES;
+    }
 
     return FILEFORMAT_UNKNOWN;
 }
@@ -722,6 +732,15 @@ void EncoderArguments::setOutputfilePath(const std::string& outputPath)
         {
             _fileOutputPath.assign(realPath);
         }
+        else if (getFileFormat() == FILEFORMAT_PROPERTIES)
+        {
+            // Compiled properties files are named after the whole input file name.
+            if (endsWith(outputPath.c_str(), "/"))
+                _fileOutputPath.assign(outputPath + getFilenameFromFilePath(_filePath));
+            else
+                _fileOutputPath.assign(realPath);
+            _fileOutputPath.append(ext);
+        }
         else if (endsWith(outputPath.c_str(), "/"))
         {
             std::string filenameNoExt = getFilenameNoExt(getFilenameFromFilePath(_filePath));
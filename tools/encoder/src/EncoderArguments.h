@@ -24,7 +24,8 @@ public:
         FILEFORMAT_OTF,
         FILEFORMAT_GPB,
         FILEFORMAT_PNG,
-        FILEFORMAT_RAW
+        FILEFORMAT_RAW,
+        FILEFORMAT_PROPERTIES
     };
 
     struct HeightmapOption
@@ -0,0 +1,269 @@
+#include "Base.h"
+#include "PropertiesEncoder.h"
+#include "FileIO.h"
+
+// Identifier at the start of a compiled properties file, followed by the major and minor version.
+// Must match the runtime's Properties class.
+static const unsigned char __binaryIdentifier[9] = { 0xAB, 'G', 'P', 'P', 0xBB, '\r', '\n', 0x1A, '\n' };
+#define PROPERTIES_BINARY_VERSION_MAJOR 1
+#define PROPERTIES_BINARY_VERSION_MINOR 0
+
+namespace gameplay
+{
+
+/**
+ * A namespace read from a properties file.
+ */
+struct PropertiesNamespace
+{
+    ~PropertiesNamespace()
+    {
+        for (size_t i = 0; i < namespaces.size(); ++i)
+            delete namespaces[i];
+    }
+
+    std::string name;
+    std::string id;
+    std::string parentId;
+    std::vector<std::pair<std::string, std::string> > properties;
+    std::vector<std::pair<std::string, std::string> > variables;
+    std::vector<PropertiesNamespace*> namespaces;
+};
+
+/**
+ * Reads the lines of a properties file, following the same rules as the runtime's text parser.
+ */
+class PropertiesReader
+{
+public:
+
+    PropertiesReader(const std::string& text) : _text(text), _position(0)
+    {
+    }
+
+    bool readNamespace(PropertiesNamespace& space);
+
+private:
+
+    void skipWhiteSpace()
+    {
+        while (_position < _text.size() && isspace((unsigned char)_text[_position]))
+            _position++;
+    }
+
+    std::string readLine()
+    {
+        size_t end = _text.find('\n', _position);
+        if (end == std::string::npos)
+            end = _text.size();
+        std::string line = _text.substr(_position, end - _position);
+        _position = end < _text.size() ? end + 1 : end;
+        return line;
+    }
+
+    const std::string& _text;
+    size_t _position;
+};
+
+static char* trimWhiteSpace(char* str)
+{
+    if (str == NULL)
+        return str;
+
+    while (isspace((unsigned char)*str))
+        str++;
+    if (*str == 0)
+        return str;
+
+    char* end = str + strlen(str) - 1;
+    while (end > str && isspace((unsigned char)*end))
+        end--;
+    *(end + 1) = 0;
+    return str;
+}
+
+static bool isVariable(const char* str, std::string& name)
+{
+    size_t len = strlen(str);
+    if (len > 3 && str[0] == '$' && str[1] == '{' && str[len - 1] == '}')
+    {
+        name.assign(str + 2, len - 3);
+        return true;
+    }
+    return false;
+}
+
+bool PropertiesReader::readNamespace(PropertiesNamespace& space)
+{
+    bool comment = false;
+    std::string variable;
+    while (true)
+    {
+        skipWhiteSpace();
+        if (_position >= _text.size())
+            return true;
+
+        std::string lineString = readLine();
+        std::vector<char> buffer(lineString.begin(), lineString.end());
+        buffer.push_back('\0');
+        char* line = &buffer[0];
+
+        // Ignore comments
+        if (comment)
+        {
+            // Check for end of multi-line comment at either start or end of line
+            if (strncmp(line, "*/", 2) == 0)
+            {
+                comment = false;
+            }
+            else
+            {
+                trimWhiteSpace(line);
+                size_t len = strlen(line);
+                if (len >= 2 && strncmp(line + (len - 2), "*/", 2) == 0)
+                    comment = false;
+            }
+            continue;
+        }
+        if (strncmp(line, "/*", 2) == 0)
+        {
+            comment = true;
+            continue;
+        }
+        if (strncmp(line, "//", 2) == 0)
+            continue;
+
+        if (strchr(line, '='))
+        {
+            // Name/value pair.
+            char* name = strtok(line, "=");
+            char* value = name ? strtok(NULL, "") : NULL;
+            if (name == NULL || value == NULL)
+            {
+                LOG(1, "Error: Failed to parse property '%s'.\n", lineString.c_str());
+                return false;
+            }
+            name = trimWhiteSpace(name);
+            value = trimWhiteSpace(value);
+            if (isVariable(name, variable))
+                space.variables.push_back(std::make_pair(variable, std::string(value)));
+            else
+                space.properties.push_back(std::make_pair(std::string(name), std::string(value)));
+            continue;
+        }
+
+        // The line begins or ends a namespace, or is a name/value pair without '='.
+        char* trimmed = trimWhiteSpace(line);
+        bool open = strchr(trimmed, '{') != NULL;
+        bool parent = strchr(trimmed, ':') != NULL;
+        bool closed = trimmed[0] != '\0' && trimmed[strlen(trimmed) - 1] == '}';
+
+        char* name = trimWhiteSpace(strtok(trimmed, " \t\n{"));
+        if (name == NULL)
+        {
+            LOG(1, "Error: Failed to parse line '%s'.\n", lineString.c_str());
+            return false;
+        }
+        if (name[0] == '}')
+        {
+            // End of namespace.
+            return true;
+        }
+        char* value = trimWhiteSpace(strtok(NULL, ":{"));
+        char* parentId = parent ? trimWhiteSpace(strtok(NULL, "{")) : NULL;
+
+        if (!open)
+        {
+            // Check if the next line starts with '{'.
+            skipWhiteSpace();
+            if (_position < _text.size() && _text[_position] == '{')
+            {
+                _position++;
+                open = true;
+                closed = false;
+            }
+            else
+            {
+                space.properties.push_back(std::make_pair(std::string(name), std::string(value ? value : "")));
+                continue;
+            }
+        }
+
+        PropertiesNamespace* child = new PropertiesNamespace();
+        space.namespaces.push_back(child);
+        child->name = name;
+        if (value && value[0] != '{')
+            child->id = value;
+        if (parentId)
+            child->parentId = parentId;
+
+        // A namespace closed on the line it is opened on is empty.
+        if (!closed && !readNamespace(*child))
+            return false;
+    }
+}
+
+static void writeNamespace(const PropertiesNamespace& space, FILE* file)
+{
+    write(space.name, file);
+    write(space.id, file);
+    write(space.parentId, file);
+
+    write((unsigned int)space.properties.size(), file);
+    for (size_t i = 0; i < space.properties.size(); ++i)
+    {
+        write(space.properties[i].first, file);
+        write(space.properties[i].second, file);
+    }
+
+    write((unsigned int)space.variables.size(), file);
+    for (size_t i = 0; i < space.variables.size(); ++i)
+    {
+        write(space.variables[i].first, file);
+        write(space.variables[i].second, file);
+    }
+
+    write((unsigned int)space.namespaces.size(), file);
+    for (size_t i = 0; i < space.namespaces.size(); ++i)
+    {
+        writeNamespace(*space.namespaces[i], file);
+    }
+}
+
+int writeProperties(const char* inFilePath, const char* outFilePath)
+{
+    std::ifstream in(inFilePath, std::ios::in | std::ios::binary);
+    if (!in)
+    {
+        LOG(1, "Error: Failed to open properties file: %s\n", inFilePath);
+        return -1;
+    }
+    std::ostringstream text;
+    text << in.rdbuf();
+    std::string textString = text.str();
+
+    PropertiesNamespace root;
+    PropertiesReader reader(textString);
+    if (!reader.readNamespace(root))
+    {
+        LOG(1, "Error: Failed to parse properties file: %s\n", inFilePath);
+        return -1;
+    }
+
+    FILE* file = fopen(outFilePath, "wb");
+    if (!file)
+    {
+        LOG(1, "Error: Failed to open file for writing: %s\n", outFilePath);
+        return -1;
+    }
+    fwrite(__binaryIdentifier, 1, sizeof(__binaryIdentifier), file);
+    write((unsigned char)PROPERTIES_BINARY_VERSION_MAJOR, file);
+    write((unsigned char)PROPERTIES_BINARY_VERSION_MINOR, file);
+    writeNamespace(root, file);
+    fclose(file);
+
+    LOG(1, "Wrote compiled properties file: %s\n", outFilePath);
+    return 0;
+}
+
+}
@@ -0,0 +1,22 @@
+#ifndef PROPERTIESENCODER_H_
+#define PROPERTIESENCODER_H_
+
+namespace gameplay
+{
+
+/**
+ * Writes the compiled binary form of a properties file (such as a .material, .scene,
+ * .physics or .form file), which the runtime loads with a single read instead of parsing text.
+ *
+ * Namespace inheritance is kept as written and resolved by the runtime when the file is loaded.
+ *
+ * @param inFilePath Input file path to the properties file.
+ * @param outFilePath Output file path to write the compiled file to.
+ *
+ * @return 0 if successful, -1 if error.
+ */
+int writeProperties(const char* inFilePath, const char* outFilePath);
+
+}
+
+#endif
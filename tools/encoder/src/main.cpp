@@ -5,6 +5,7 @@
 #include "GPBDecoder.h"
 #include "EncoderArguments.h"
 #include "NormalMapGenerator.h"
+#include "PropertiesEncoder.h"
 #include "Font.h"
 
 using namespace gameplay;
@@ -162,6 +163,12 @@ int main(int argc, const char** argv)
             }
             break;
         }
+    case EncoderArguments::FILEFORMAT_PROPERTIES:
+        {
+            if (writeProperties(arguments.getFilePath().c_str(), arguments.getOutputFilePath().c_str()) != 0)
+                return -1;
+            break;
+        }
    default:
         {
             LOG(1, "Error: Unsupported file format: %s\n", arguments.getFilePathPointer());